@@ -0,0 +1,96 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/asn.hpp>
+#include "bench.hpp"
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstdio>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t ROUTES_COUNT      {500000};
+inline const std::uint32_t ASN_LOOKUPS_COUNT {1 << 16};
+
+void asn_benchmarks(suite& s) noexcept
+{
+    if (!selected(s, "asn/"))
+        return;
+
+    char source[] = "/tmp/ntool-bench-routes-XXXXXX";
+    char path[]   = "/tmp/ntool-bench-asn-XXXXXX";
+    auto fd       = mkstemp(source);
+    auto db_fd    = mkstemp(path);
+
+    if (fd < 0 || db_fd < 0)
+        return;
+
+    close(db_fd);
+
+    // routing table like mix, mostly /24 with some shorter ones
+    auto file       = fdopen(fd, "w");
+    std::uint32_t x = 2463534242;
+
+    auto next = [&x]() noexcept {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    };
+
+    for (std::uint32_t i = 0; i < ROUTES_COUNT; i++) {
+        auto r      = next();
+        auto length = (r % 10 < 6) ? 24 : 8 + r % 16;
+        auto addr   = next();
+
+        std::fprintf(file, "%u.%u.%u.%u/%u %u\n", addr >> 24, (addr >> 16) & 0xFF,
+            (addr >> 8) & 0xFF, addr & 0xFF, length, 1 + next() % 65000
+        );
+    }
+
+    std::fclose(file);
+    asn_compile(source, path);
+    unlink(source);
+
+    run(s, "asn/open", 0, [&] {
+        asn_db db;
+        do_not_optimize(db.open(path));
+    });
+
+    asn_db db;
+
+    if (db.open(path)) {
+        std::vector<in_addr_t> addrs(ASN_LOOKUPS_COUNT);
+
+        for (auto& addr : addrs)
+            addr = htonl(next());
+
+        std::uint32_t i = 0;
+
+        run(s, "asn/lookup", 0, [&] {
+            do_not_optimize(db.lookup(addrs[i++ & (ASN_LOOKUPS_COUNT - 1)]));
+        });
+    }
+
+    unlink(path);
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,273 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  bench.hpp
+ * @brief Microbenchmark harness.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_BENCH_HPP_
+#define _NTOOL_BENCH_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+namespace ntool {
+namespace bench {
+
+/** Single benchmark measurement.*/
+struct result {
+    std::string   name;             // benchmark name
+    std::uint64_t iterations;       // number of measured operations
+    double        ns_per_op;        // best time per operation
+    double        bytes_per_op;     // heap bytes allocated per operation
+    double        allocs_per_op;    // heap allocations per operation
+    double        mb_per_s;         // processed data rate (0 if not sized)
+    double        misses_per_op;    // cache misses per operation (-1 if unknown)
+};
+
+/** Benchmark run parameters & collected results.*/
+struct suite {
+    const char          *filter   {nullptr};    // run only matching names
+    double              min_time  {0.2};        // seconds per sample
+    std::uint32_t       samples   {5};          // samples per benchmark
+    std::vector<result> results;
+};
+
+/** Heap allocation counters (updated by replaced operator new).*/
+struct alloc_counters {
+    std::uint64_t bytes;
+    std::uint64_t count;
+};
+
+/**
+ * @brief Get current heap allocation counters.
+ *
+ * @return allocation counters.
+ */
+alloc_counters allocations(void) noexcept;
+
+/**
+ * @brief Read hardware counter of last level cache misses of process.
+ *
+ * @param [out] count - given object to store number of misses.
+ * @return false if counter is not available (no PMU, virtual machine).
+ */
+bool cache_misses(std::uint64_t& count) noexcept;
+
+/**
+ * @brief Prevent compiler from optimizing away given value.
+ *
+ * @param [in] value - given value.
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) noexcept
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/** @brief Force compiler to assume that memory was changed.*/
+inline void clobber(void) noexcept
+{
+    asm volatile("" : : : "memory");
+}
+
+/**
+ * @brief Check whether benchmark should run.
+ *
+ * @param [in] s - given suite.
+ * @param [in] name - given benchmark name.
+ * @return true if benchmark name matches suite filter.
+ */
+bool selected(const suite& s, const std::string& name) noexcept;
+
+/**
+ * @brief Measure given operation.
+ *
+ * @param [in,out] s - given suite to store result.
+ * @param [in] name - given benchmark name.
+ * @param [in] bytes - given number of bytes processed per operation.
+ * @param [in] op - given operation to measure.
+ * @param [in] batch - given number of operations done by single op() call.
+ */
+template <typename F>
+void run(suite& s, const std::string& name, std::size_t bytes, F&& op,
+    std::uint64_t batch = 1) noexcept
+{
+    using clock = std::chrono::steady_clock;
+
+    if (!selected(s, name))
+        return;
+
+    auto measure = [&op](std::uint64_t n) noexcept {
+        auto begin = clock::now();
+
+        for (std::uint64_t i = 0; i < n; i++)
+            op();
+
+        auto end = clock::now();
+        return std::chrono::duration<double>(end - begin).count();
+    };
+
+    // calibrate number of iterations per sample
+    std::uint64_t n = 1;
+    double elapsed  = measure(n);
+
+    while (elapsed < s.min_time && n < (1ULL << 40)) {
+        auto scale = (elapsed > 0.0) ? (s.min_time / elapsed) * 1.2 : 100.0;
+        n = static_cast<std::uint64_t>(n * std::min(std::max(scale, 2.0), 100.0));
+        elapsed = measure(n);
+    }
+
+    // take the fastest sample, it is the least disturbed one
+    double best = elapsed;
+
+    std::uint64_t misses_before = 0, misses_after = 0;
+    bool counted = cache_misses(misses_before);
+
+    auto before = allocations();
+    for (std::uint32_t i = 1; i < s.samples; i++)
+        best = std::min(best, measure(n));
+    auto after  = allocations();
+
+    counted = counted && cache_misses(misses_after);
+
+    double ops = static_cast<double>(n * batch) * std::max(s.samples - 1, 1U);
+
+    result r;
+    r.name          = name;
+    r.iterations    = n * batch;
+    r.ns_per_op     = best * 1e9 / static_cast<double>(n * batch);
+    r.bytes_per_op  = static_cast<double>(after.bytes - before.bytes) / ops;
+    r.allocs_per_op = static_cast<double>(after.count - before.count) / ops;
+    r.mb_per_s      = bytes ? (bytes * n * batch / best) / 1e6 : 0.0;
+    r.misses_per_op = counted
+        ? static_cast<double>(misses_after - misses_before) / ops : -1.0;
+
+    s.results.push_back(r);
+}
+
+/**
+ * @brief Register checksum, packet build & parse benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void icmp_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register in-flight table & simulated engine benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void engine_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register statistics benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void utils_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register formatter & output ring benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void output_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register compressed time series benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void series_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register anomaly detection benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void detect_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register per-target state layout benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void targets_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register slab pool & arena benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void memory_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register address parser & target list loader benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void loader_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register longest prefix match benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void prefix_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register IP to origin AS database benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void asn_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register topology graph merge benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void topology_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register trace diff benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void tracediff_benchmarks(suite& s) noexcept;
+
+/**
+ * @brief Register coroutine scheduler benchmarks.
+ *
+ * @param [in,out] s - given suite.
+ */
+void coro_benchmarks(suite& s) noexcept;
+
+} // namespace bench
+} // namespace ntool
+
+#endif // _NTOOL_BENCH_HPP_
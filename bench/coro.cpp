@@ -0,0 +1,95 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/coro.hpp>
+#include <ntool/sim.hpp>
+#include "bench.hpp"
+
+
+namespace ntool {
+namespace bench {
+
+/**
+ * @brief Do nothing.
+ *
+ * @return coroutine.
+ */
+static task idle(void) noexcept
+{
+    co_return;
+}
+
+/**
+ * @brief Ping target for given number of rounds.
+ *
+ * @param [in] s - given scheduler.
+ * @param [in] addr - given target address.
+ * @param [in] rounds - given number of rounds.
+ * @param [out] replies - given reply counter.
+ * @return coroutine.
+ */
+static task pinger(scheduler& s, in_addr_t addr, std::uint32_t rounds,
+    std::uint64_t& replies) noexcept
+{
+    auto next = s.now();
+
+    for (std::uint32_t round = 0; round < rounds; round++) {
+        auto ticket = co_await s.send(addr, 64);
+        auto result = co_await s.reply(std::move(ticket));
+
+        replies += !result.timeout;
+        next    += 1000000000;
+        co_await s.sleep_until(next);
+    }
+}
+
+void coro_benchmarks(suite& s) noexcept
+{
+    sim_topology topology;
+    topology.targets         = 100000;
+    topology.model.loss      = 0.01;
+    topology.model.jitter_ns = 1000000;
+
+    sim_transport sim(topology.seed);
+    auto addrs = generate_topology(sim, topology);
+
+    // frame comes from pool & goes back to it, no heap allocation
+    scheduler idler(sim, 1, 0, 1000000000);
+
+    run(s, "coro/spawn+finish", 0, [&] {
+        idler.spawn(idle());
+        idler.run();
+    });
+
+    constexpr std::uint32_t ROUNDS {4};
+
+    // coroutine per target, op is complete run, so report time per probe
+    run(s, "coro/sim/100000", 0, [&] {
+        std::uint64_t replies = 0;
+        scheduler sched(sim, addrs.size(), 0, 1000000000);
+
+        for (auto addr : addrs)
+            sched.spawn(pinger(sched, addr, ROUNDS, replies));
+
+        sched.run();
+        do_not_optimize(replies);
+    }, static_cast<std::uint64_t>(addrs.size()) * ROUNDS);
+}
+
+} // namespace bench
+} // namespace ntool
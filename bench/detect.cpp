@@ -0,0 +1,46 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/detect.hpp>
+#include "bench.hpp"
+#include <cmath>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t DETECT_TARGETS {100000};
+
+void detect_benchmarks(suite& s) noexcept
+{
+    detector_config config;
+    anomaly_detector detector(DETECT_TARGETS, config);
+    std::uint64_t i = 0;
+
+    // round-robin over targets, so state does not stay in L1 cache
+    run(s, "detect/update", 0, [&] {
+        auto rtt = ((i * 7919) % 97 == 0) ? NAN : 20.0 + static_cast<double>((i * 31) % 400) / 100.0;
+        anomaly_event event;
+
+        do_not_optimize(detector.update(i % DETECT_TARGETS, rtt, event));
+        i++;
+    });
+}
+
+} // namespace bench
+} // namespace ntool
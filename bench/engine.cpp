@@ -0,0 +1,181 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/inflight.hpp>
+#include <ntool/recorder.hpp>
+#include <ntool/engine.hpp>
+#include <ntool/demux.hpp>
+#include <ntool/sim.hpp>
+#include "bench.hpp"
+
+
+namespace ntool {
+namespace bench {
+
+/**
+ * @brief Count probe outcomes.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given counter.
+ */
+static void count_result(const probe_result& result, void *ctx) noexcept
+{
+    *static_cast<std::uint64_t*>(ctx) += !result.timeout;
+}
+
+/**
+ * @brief Measure whole engine run over simulated network.
+ *
+ * @param [in,out] s - given suite.
+ * @param [in] name - given benchmark name.
+ * @param [in] targets - given number of targets.
+ * @param [in] hops - given number of TTLs probed per target (0 - ping).
+ * @param [in] instrument - given flag to time engine stages.
+ */
+static void engine_run(suite& s, const std::string& name,
+    std::uint32_t targets, std::uint8_t hops, bool instrument = false) noexcept
+{
+    constexpr std::uint32_t ROUNDS {4};
+
+    engine_config config;
+    config.count        = ROUNDS;
+    config.hops         = hops;
+    config.interval_ns  = 1000000000;
+    config.timeout_ns   = 1000000000;
+    config.max_inflight = 1 << 15;
+    config.instrument   = instrument;
+
+    sim_topology topology;
+    topology.targets         = targets;
+    topology.model.loss      = 0.01;
+    topology.model.jitter_ns = 1000000;
+
+    sim_transport sim(topology.seed);
+    auto addrs = generate_topology(sim, topology);
+
+    auto probes = static_cast<std::uint64_t>(targets) * ROUNDS *
+        std::max<std::uint8_t>(hops, 1);
+
+    // op is complete run, so report time per probe
+    run(s, name, 0, [&] {
+        std::uint64_t replies = 0;
+        engine e(sim, config, count_result, &replies);
+
+        for (auto addr : addrs)
+            e.add_target(addr);
+
+        e.run();
+        do_not_optimize(replies);
+    }, probes);
+}
+
+/**
+ * @brief Measure ping & trace engines sharing simulated network through
+ * demultiplexer.
+ *
+ * @param [in,out] s - given suite.
+ * @param [in] name - given benchmark name.
+ * @param [in] pings - given number of pinged targets.
+ * @param [in] traces - given number of traced targets.
+ * @param [in] hops - given number of TTLs probed per traced target.
+ */
+static void demux_run(suite& s, const std::string& name, std::uint32_t pings,
+    std::uint32_t traces, std::uint8_t hops) noexcept
+{
+    constexpr std::uint32_t ROUNDS {4};
+
+    engine_config config;
+    config.count        = ROUNDS;
+    config.interval_ns  = 1000000000;
+    config.timeout_ns   = 1000000000;
+    config.max_inflight = 1 << 15;
+
+    sim_topology topology;
+    topology.targets         = pings + traces;
+    topology.model.loss      = 0.01;
+    topology.model.jitter_ns = 1000000;
+
+    sim_transport sim(topology.seed);
+    auto addrs = generate_topology(sim, topology);
+
+    auto probes = static_cast<std::uint64_t>(pings + traces * hops) * ROUNDS;
+
+    run(s, name, 0, [&] {
+        std::uint64_t replies = 0;
+        icmp_demux demux(sim);
+
+        auto ping_config  = config;
+        auto trace_config = config;
+        trace_config.hops = hops;
+
+        demux.reserve(ping_config);
+        demux.reserve(trace_config);
+
+        engine pinger(sim, ping_config, count_result, &replies);
+        engine tracer(sim, trace_config, count_result, &replies);
+
+        for (std::uint32_t i = 0; i < pings; i++)
+            pinger.add_target(addrs[i]);
+
+        for (std::uint32_t i = pings; i < pings + traces; i++)
+            tracer.add_target(addrs[i]);
+
+        demux.attach(pinger);
+        demux.attach(tracer);
+        demux.run();
+        do_not_optimize(replies);
+    }, probes);
+}
+
+void engine_benchmarks(suite& s) noexcept
+{
+    // probe sent, answered after 1024 later probes & resolved
+    constexpr std::uint64_t LAG {1024};
+
+    inflight_table table(65536, 65536, false);
+    std::uint64_t  wire = 0;
+
+    for (std::uint64_t i = 0; i < LAG; i++)
+        table.push();
+
+    run(s, "inflight/push+find+resolve", 0, [&] {
+        auto& slot   = table.push();
+        slot.send_ns = wire;
+
+        if (auto found = table.find(wire++ & 0xFFFF))
+            table.resolve(*found);
+
+        do_not_optimize(table.oldest());
+    });
+
+    // always-on recording of sent probe
+    auto& flight = flight_recorder::local();
+
+    run(s, "flight/record", sizeof(flight_entry), [&] {
+        flight.record(flight_event::sent, wire, 0x0100007f, wire, 64);
+        wire++;
+    });
+
+    engine_run(s, "engine/sim/ping/10000", 10000, 0);
+    engine_run(s, "engine/sim/ping/10000+stats", 10000, 0, true);
+    engine_run(s, "engine/sim/trace/1000", 1000, 16);
+    demux_run(s, "engine/sim/demux/1000+100", 1000, 100, 16);
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,133 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/probe.hpp>
+#include <ntool/icmp.hpp>
+#include <netinet/ip.h>
+#include "bench.hpp"
+#include <cstring>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::size_t CHECKSUM_SIZES[] {20, 64, 512, 1500, 9000};
+
+/**
+ * @brief Measure next probe & parse of time exceeded quoting it.
+ *
+ * @param [in,out] s - given suite.
+ * @param [in] name - given probe kind name.
+ */
+template <typename P>
+static void probe_run(suite& s, const std::string& name) noexcept
+{
+    P probe;
+    probe.init(0x1234);
+
+    std::uint16_t seq = 0;
+
+    run(s, "probe/" + name + "/set", P::SIZE, [&] {
+        probe.set(++seq);
+        do_not_optimize(probe);
+    });
+
+    // router reply: IP, time exceeded, quoted IP & probe
+    std::uint8_t reply[2 * sizeof(iphdr) + sizeof(icmphdr) + P::SIZE] {};
+    iphdr ip {};
+    ip.ihl      = 5;
+    ip.version  = 4;
+    ip.ttl      = 64;
+    ip.protocol = IPPROTO_ICMP;
+
+    icmphdr error {};
+    error.type = ICMP_TIME_EXCEEDED;
+
+    iphdr quoted    = ip;
+    quoted.protocol = P::PROTOCOL;
+    quoted.daddr    = 0x0101a8c0;
+
+    auto p = reply;
+    std::memcpy(p, &ip, sizeof(ip));
+    std::memcpy(p += sizeof(ip), &error, sizeof(error));
+    std::memcpy(p += sizeof(error), &quoted, sizeof(quoted));
+    std::memcpy(p += sizeof(quoted), probe.packet(), P::SIZE);
+
+    reply_info info;
+
+    run(s, "probe/" + name + "/parse", sizeof(reply), [&] {
+        clobber();
+        do_not_optimize(P::parse(reply, sizeof(reply), info));
+        do_not_optimize(info);
+    });
+}
+
+void icmp_benchmarks(suite& s) noexcept
+{
+    static std::uint8_t buffer[9000];
+
+    for (std::size_t i = 0; i < sizeof(buffer); i++)
+        buffer[i] = static_cast<std::uint8_t>(i * 31 + 7);
+
+    for (auto size : CHECKSUM_SIZES) {
+        run(s, "checksum/" + std::to_string(size), size, [size] {
+            clobber();
+            do_not_optimize(checksum(buffer, size));
+        });
+    }
+
+    // build echo request from scratch
+    icmphdr header {};
+    header.type       = ICMP_ECHO;
+    header.un.echo.id = 0x1234;
+
+    std::uint8_t packet[ICMP_PACKET_SIZE];
+    std::uint16_t seq = 0;
+
+    run(s, "packet/set_packet", ICMP_PACKET_SIZE, [&] {
+        header.un.echo.sequence = ++seq;
+        set_packet(packet, header);
+        do_not_optimize(packet);
+    });
+
+    // patch prebuilt probe
+    probe_run<icmp_echo>(s, "icmp_echo");
+
+    // parse echo reply with IP header
+    std::uint8_t reply[sizeof(iphdr) + ICMP_PACKET_SIZE] {};
+    iphdr ip {};
+    ip.ihl      = 5;
+    ip.version  = 4;
+    ip.ttl      = 64;
+    ip.protocol = IPPROTO_ICMP;
+
+    header.type = ICMP_ECHOREPLY;
+    std::memcpy(reply, &ip, sizeof(ip));
+    set_packet(reply + sizeof(ip), header);
+
+    reply_info info;
+
+    run(s, "packet/parse_reply", sizeof(reply), [&] {
+        clobber();
+        do_not_optimize(parse_reply(reply, sizeof(reply), info));
+        do_not_optimize(info);
+    });
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,95 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/loader.hpp>
+#include "bench.hpp"
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t ADDRESSES_COUNT {4096};
+inline const std::uint32_t LOADER_TARGETS  {1000000};
+
+void loader_benchmarks(suite& s) noexcept
+{
+    if (!selected(s, "loader/"))
+        return;
+
+    // random addresses of all widths, one per line
+    std::string text;
+    std::vector<std::size_t> offsets;
+    std::uint32_t x = 2463534242;
+
+    for (std::uint32_t i = 0; i < ADDRESSES_COUNT; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+
+        offsets.push_back(text.size());
+        text += std::to_string(x >> 24) + "." + std::to_string((x >> 16) & 0xFF) + "." +
+            std::to_string((x >> 8) & 0xFF) + "." + std::to_string(x & 0xFF) + '\0';
+    }
+
+    std::uint32_t i = 0;
+    in_addr_t addr;
+
+    run(s, "loader/parse_ipv4", 0, [&] {
+        auto p = text.data() + offsets[i++ & (ADDRESSES_COUNT - 1)];
+        do_not_optimize(parse_ipv4(p, text.data() + text.size(), addr));
+        do_not_optimize(addr);
+    });
+
+    // compare with libc parser
+    run(s, "loader/inet_pton", 0, [&] {
+        auto p = text.data() + offsets[i++ & (ADDRESSES_COUNT - 1)];
+        do_not_optimize(inet_pton(AF_INET, p, &addr));
+        do_not_optimize(addr);
+    });
+
+    char path[] = "/tmp/ntool-bench-XXXXXX";
+    auto fd     = mkstemp(path);
+
+    if (fd < 0)
+        return;
+
+    auto file = fdopen(fd, "w");
+
+    for (std::uint32_t t = 0; t < LOADER_TARGETS; t++)
+        std::fprintf(file, "%s\n", text.data() + offsets[t & (ADDRESSES_COUNT - 1)]);
+
+    // whole file of mostly duplicate addresses, per line
+    auto size = static_cast<std::size_t>(ftell(file));
+    std::fclose(file);
+
+    run(s, "loader/load/" + std::to_string(LOADER_TARGETS), size / LOADER_TARGETS, [&] {
+        target_list list;
+        load_targets(path, 0, list);
+        do_not_optimize(list.addrs.data());
+    }, LOADER_TARGETS);
+
+    unlink(path);
+}
+
+} // namespace bench
+} // namespace ntool
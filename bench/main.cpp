@@ -0,0 +1,347 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/utils.hpp>
+#include <linux/perf_event.h>
+#include <sys/utsname.h>
+#include <sys/syscall.h>
+#include "bench.hpp"
+#include <getopt.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <new>
+
+
+static std::uint64_t allocated_bytes = 0;
+static std::uint64_t allocated_count = 0;
+
+void *operator new(std::size_t size)
+{
+    allocated_bytes += size;
+    allocated_count++;
+
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    std::abort();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace ntool {
+namespace bench {
+
+alloc_counters allocations(void) noexcept
+{
+    return {allocated_bytes, allocated_count};
+}
+
+bool cache_misses(std::uint64_t& count) noexcept
+{
+    static const std::int32_t fd = [] {
+        perf_event_attr attr {};
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.size           = sizeof(attr);
+        attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+
+        return static_cast<std::int32_t>(
+            syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0)
+        );
+    }();
+
+    return fd >= 0 && read(fd, &count, sizeof(count)) == sizeof(count);
+}
+
+bool selected(const suite& s, const std::string& name) noexcept
+{
+    return !s.filter || name.find(s.filter) != std::string::npos;
+}
+
+} // namespace bench
+} // namespace ntool
+
+/** Baseline entry loaded from previous JSON report.*/
+struct baseline_entry {
+    std::string name;
+    double      ns_per_op;
+    double      bytes_per_op;
+};
+
+static void help(void) noexcept
+{
+    std::puts(
+        "USAGE\n"
+        "    ntool_bench [options]\n\n"
+        "DESCRIPTION\n"
+        "    ntool_bench - hot path microbenchmarks, JSON report on stdout.\n\n"
+        "OPTIONS\n"
+        "    -f, --filter [S]        run benchmarks which names contain S\n"
+        "    -t, --min-time [SEC]    set minimal time per sample (0.2)\n"
+        "    -s, --samples [N]       set number of samples (5)\n"
+        "    -o, --output [FILE]     write JSON report to FILE\n"
+        "    -b, --baseline [FILE]   compare against stored JSON report\n"
+        "    -r, --threshold [PCT]   set allowed slowdown in percents (10)\n"
+        "    -h, --help              display list of commands\n"
+        "\n"
+        "EXAMPLES\n"
+        "    ntool_bench -o baseline.json\n"
+        "    ntool_bench -f checksum -b baseline.json -r 5\n"
+    );
+    std::exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief Write JSON report.
+ *
+ * @param [in] out - given output stream.
+ * @param [in] s - given suite with results.
+ */
+static void report(std::FILE *out, const ntool::bench::suite& s) noexcept
+{
+    utsname host {};
+    uname(&host);
+
+    char date[32] {};
+    auto now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::fprintf(out, "{\n  \"context\": {\"date\": \"%s\", \"host\": \"%s\", "
+        "\"machine\": \"%s\", \"cpus\": %ld},\n  \"benchmarks\": [\n",
+        date, host.nodename, host.machine, sysconf(_SC_NPROCESSORS_ONLN)
+    );
+
+    // one benchmark per line keeps baseline parsing trivial
+    for (std::size_t i = 0; i < s.results.size(); i++) {
+        const auto& r = s.results[i];
+
+        std::fprintf(out, "    {\"name\": \"%s\", \"iterations\": %lu, "
+            "\"ns_per_op\": %.3f, \"bytes_per_op\": %.3f, "
+            "\"allocs_per_op\": %.3f, \"mb_per_s\": %.1f, "
+            "\"misses_per_op\": %.3f}%s\n",
+            r.name.c_str(), r.iterations, r.ns_per_op, r.bytes_per_op,
+            r.allocs_per_op, r.mb_per_s, r.misses_per_op,
+            (i + 1 < s.results.size()) ? "," : ""
+        );
+    }
+
+    std::fputs("  ]\n}\n", out);
+}
+
+/**
+ * @brief Get numeric field of JSON line.
+ *
+ * @param [in] line - given line of JSON report.
+ * @param [in] key - given quoted key.
+ * @return field value.
+ */
+static double field(const char *line, const char *key) noexcept
+{
+    auto pos = std::strstr(line, key);
+
+    if (!pos)
+        return 0.0;
+
+    return std::strtod(pos + std::strlen(key) + 1, nullptr);
+}
+
+/**
+ * @brief Load JSON report produced by report().
+ *
+ * @param [in] path - given report path.
+ * @return list of baseline entries.
+ */
+static std::vector<baseline_entry> load(const char *path) noexcept
+{
+    std::vector<baseline_entry> entries;
+    auto file = std::fopen(path, "r");
+
+    if (!file)
+        ntool::utils::error("ntool_bench: cannot open baseline file");
+
+    char line[512];
+
+    while (std::fgets(line, sizeof(line), file)) {
+        auto name = std::strstr(line, "\"name\": \"");
+
+        if (!name)
+            continue;
+
+        name += std::strlen("\"name\": \"");
+        auto end = std::strchr(name, '"');
+
+        if (!end)
+            continue;
+
+        baseline_entry entry;
+        entry.name         = std::string(name, end);
+        entry.ns_per_op    = field(line, "\"ns_per_op\":");
+        entry.bytes_per_op = field(line, "\"bytes_per_op\":");
+        entries.push_back(entry);
+    }
+
+    std::fclose(file);
+    return entries;
+}
+
+/**
+ * @brief Compare results with baseline.
+ *
+ * @param [in] s - given suite with results.
+ * @param [in] path - given baseline path.
+ * @param [in] threshold - given allowed slowdown in percents.
+ * @return number of regressions.
+ */
+static std::uint32_t compare(const ntool::bench::suite& s, const char *path,
+    double threshold) noexcept
+{
+    auto baseline = load(path);
+    std::uint32_t regressions = 0;
+
+    std::fprintf(stderr, "%-40s %12s %12s %9s\n",
+        "benchmark", "base ns/op", "ns/op", "delta");
+
+    for (const auto& r : s.results) {
+        auto it = std::find_if(baseline.begin(), baseline.end(),
+            [&r](const baseline_entry& e) { return e.name == r.name; }
+        );
+
+        if (it == baseline.end()) {
+            std::fprintf(stderr, "%-40s %12s %12.3f %9s\n",
+                r.name.c_str(), "-", r.ns_per_op, "new");
+            continue;
+        }
+
+        auto delta = (it->ns_per_op > 0.0)
+            ? (r.ns_per_op - it->ns_per_op) / it->ns_per_op * 100.0 : 0.0;
+
+        // any new allocation on hot path is a regression too
+        bool slower  = delta > threshold;
+        bool heavier = r.bytes_per_op > it->bytes_per_op + 0.5;
+
+        if (slower || heavier)
+            regressions++;
+
+        std::fprintf(stderr, "%-40s %12.3f %12.3f %+8.1f%%%s\n",
+            r.name.c_str(), it->ns_per_op, r.ns_per_op, delta,
+            slower ? "  SLOWER" : (heavier ? "  ALLOCS" : "")
+        );
+    }
+
+    return regressions;
+}
+
+int main(std::int32_t argc, char **argv)
+{
+    using namespace ntool::bench;
+
+    static option long_options[] {
+        {"filter", required_argument, 0, 'f'},
+        {"min-time", required_argument, 0, 't'},
+        {"samples", required_argument, 0, 's'},
+        {"output", required_argument, 0, 'o'},
+        {"baseline", required_argument, 0, 'b'},
+        {"threshold", required_argument, 0, 'r'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    suite s;
+    const char *output   = nullptr;
+    const char *baseline = nullptr;
+    double threshold     = 10.0;
+    std::int32_t opt;
+
+    while ((opt = getopt_long(argc, argv, "f:t:s:o:b:r:h", long_options, 0)) != -1) {
+        switch (opt) {
+        case 'f':
+            s.filter = optarg;
+            break;
+
+        case 't':
+            s.min_time = std::atof(optarg);
+            break;
+
+        case 's':
+            s.samples = std::max(std::atoi(optarg), 1);
+            break;
+
+        case 'o':
+            output = optarg;
+            break;
+
+        case 'b':
+            baseline = optarg;
+            break;
+
+        case 'r':
+            threshold = std::atof(optarg);
+            break;
+
+        case 'h':
+            help();
+            break;
+
+        default:
+            ntool::utils::error("Use -h or --help for usage.");
+            break;
+        }
+    }
+
+    icmp_benchmarks(s);
+    engine_benchmarks(s);
+    utils_benchmarks(s);
+    output_benchmarks(s);
+    series_benchmarks(s);
+    detect_benchmarks(s);
+    targets_benchmarks(s);
+    memory_benchmarks(s);
+    loader_benchmarks(s);
+    prefix_benchmarks(s);
+    asn_benchmarks(s);
+    topology_benchmarks(s);
+    tracediff_benchmarks(s);
+    coro_benchmarks(s);
+
+    auto out = output ? std::fopen(output, "w") : stdout;
+
+    if (!out)
+        ntool::utils::error("ntool_bench: cannot open output file");
+
+    report(out, s);
+
+    if (out != stdout)
+        std::fclose(out);
+
+    if (baseline && compare(s, baseline, threshold) > 0)
+        return EXIT_FAILURE;
+
+    return 0;
+}
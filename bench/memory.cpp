@@ -0,0 +1,66 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/memory.hpp>
+#include "bench.hpp"
+
+
+namespace ntool {
+namespace bench {
+
+/** Session sized object.*/
+struct session {
+    std::uint64_t id;
+    char          data[120];
+};
+
+void memory_benchmarks(suite& s) noexcept
+{
+    std::uint64_t id = 0;
+
+    // object with independent lifetime, general purpose heap
+    run(s, "memory/new+delete", sizeof(session), [&] {
+        auto object = new session;
+        object->id  = id++;
+        do_not_optimize(object);
+        delete object;
+    });
+
+    // same object from slab pool free list
+    auto& pool = object_pool<session>::local();
+
+    run(s, "memory/slab", sizeof(session), [&] {
+        auto object = pool.create();
+        object->id  = id++;
+        do_not_optimize(object);
+        pool.destroy(object);
+    });
+
+    // per-run strings, freed with arena
+    arena names;
+
+    run(s, "memory/arena/copy", 16, [&] {
+        if ((++id & 4095) == 0)
+            names.reset();
+
+        do_not_optimize(names.copy("192.168.100.200"));
+    });
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,247 @@
+#!/usr/bin/env bash
+#
+# Multifunctional network analyser tool.
+# Copyright (C) 2024  Alexander (@alkuzin).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# Probe engine throughput harness.
+#
+# Builds chain of network namespaces connected with veth pairs:
+#
+#   ntool-src --- ntool-r1 --- ... --- ntool-rH --- ntool-dst
+#
+# & runs ping at increasing rates (and traceroute with increasing number
+# of queries) from ntool-src to ntool-dst. Optional netem delay & loss is
+# applied on egress of ntool-src, so every hop is expected to answer with
+# configured delay. Results are printed as CSV.
+
+set -euo pipefail
+
+NTOOL="$(dirname "$0")/../build/_gate_build/ntool"
+HOPS=2
+DELAY_MS=0
+LOSS_PCT=0
+SECONDS_PER_STEP=2
+RATES="100 1000 5000 10000 20000 50000"
+QUERIES="1 3 10"
+PREFIX="ntool"
+OUTPUT=/dev/stdout
+
+usage() {
+    cat <<EOF
+USAGE
+    sudo $0 [options]
+
+OPTIONS
+    -b [PATH]     ntool binary ($NTOOL)
+    -H [N]        number of routers between source & destination ($HOPS)
+    -d [MS]       netem delay in milliseconds ($DELAY_MS)
+    -l [PCT]      netem loss in percents ($LOSS_PCT)
+    -r [RATES]    ping rates in packets per second ("$RATES")
+    -q [QUERIES]  traceroute queries per hop ("$QUERIES")
+    -t [SEC]      duration of each ping step ($SECONDS_PER_STEP)
+    -o [FILE]     write CSV to FILE
+    -h            display this help
+
+COLUMNS
+    mode          ping or traceroute
+    rate          requested packets per second (queries per hop for traceroute)
+    sent          probes sent by ntool
+    received      replies reported by ntool
+    net_loss      loss seen by ntool in percents
+    ntool_loss    replies delivered by kernel but lost inside ntool in percents
+    pps           achieved probes per second
+    cpu_us        CPU time (user + system) per probe in microseconds
+    rtt_avg       average RTT in milliseconds
+    rtt_error     average RTT minus configured delay in milliseconds
+EOF
+    exit 0
+}
+
+while getopts "b:H:d:l:r:q:t:o:h" opt; do
+    case "$opt" in
+        b) NTOOL="$OPTARG" ;;
+        H) HOPS="$OPTARG" ;;
+        d) DELAY_MS="$OPTARG" ;;
+        l) LOSS_PCT="$OPTARG" ;;
+        r) RATES="$OPTARG" ;;
+        q) QUERIES="$OPTARG" ;;
+        t) SECONDS_PER_STEP="$OPTARG" ;;
+        o) OUTPUT="$OPTARG" ;;
+        *) usage ;;
+    esac
+done
+
+if [[ $EUID -ne 0 ]]; then
+    echo "netns.sh: root rights required" >&2
+    exit 1
+fi
+
+if [[ ! -x "$NTOOL" ]]; then
+    echo "netns.sh: ntool binary not found: $NTOOL" >&2
+    exit 1
+fi
+
+NODES=("$PREFIX-src")
+for ((i = 1; i <= HOPS; i++)); do
+    NODES+=("$PREFIX-r$i")
+done
+NODES+=("$PREFIX-dst")
+
+DST_ADDR="10.77.$HOPS.2"
+
+cleanup() {
+    for node in "${NODES[@]}"; do
+        ip netns del "$node" 2>/dev/null || true
+    done
+}
+
+# node k owns 10.77.(k-1).2 on its left link & 10.77.k.1 on its right link
+setup() {
+    cleanup
+
+    for node in "${NODES[@]}"; do
+        ip netns add "$node"
+        ip -n "$node" link set lo up
+        ip netns exec "$node" sysctl -qw net.ipv4.ip_forward=1
+        ip netns exec "$node" sysctl -qw net.ipv4.icmp_ratelimit=0
+    done
+
+    local last=$((${#NODES[@]} - 1))
+
+    for ((k = 0; k < last; k++)); do
+        local left="${NODES[$k]}" right="${NODES[$((k + 1))]}"
+
+        ip link add "nt$k-l" netns "$left" type veth peer name "nt$k-r" netns "$right"
+        ip -n "$left" addr add "10.77.$k.1/24" dev "nt$k-l"
+        ip -n "$right" addr add "10.77.$k.2/24" dev "nt$k-r"
+        ip -n "$left" link set "nt$k-l" up
+        ip -n "$right" link set "nt$k-r" up
+    done
+
+    for ((k = 0; k <= last; k++)); do
+        local node="${NODES[$k]}"
+
+        # towards destination
+        if ((k < last)); then
+            ip -n "$node" route add default via "10.77.$k.2"
+        fi
+
+        # back to source
+        if ((k > 1)); then
+            ip -n "$node" route add 10.77.0.0/24 via "10.77.$((k - 1)).1"
+        fi
+    done
+
+    if [[ "$DELAY_MS" != 0 || "$LOSS_PCT" != 0 ]]; then
+        if ! ip netns exec "$PREFIX-src" tc qdisc add dev nt0-l root netem \
+            delay "${DELAY_MS}ms" loss "${LOSS_PCT}%" 2>/dev/null; then
+            echo "netns.sh: netem is not available, running without delay & loss" >&2
+            DELAY_MS=0
+            LOSS_PCT=0
+        fi
+    fi
+}
+
+# print sum of kernel ICMP counters of source namespace
+kernel_counter() {
+    ip netns exec "$PREFIX-src" nstat -az "$@" | awk '
+        $1 ~ /^Icmp/ { sum += $2 } END { print sum + 0 }'
+}
+
+# run command in source namespace, print "user sys" CPU seconds on fd 3
+timed() {
+    local TIMEFORMAT="%U %S"
+    { time ip netns exec "$PREFIX-src" "$@" >"$LOG" 2>&1 || true; } 2>&3
+}
+
+report() {
+    local mode=$1 rate=$2 sent=$3 received=$4 kernel=$5 elapsed_ms=$6 cpu=$7 rtt=$8
+
+    awk -v mode="$mode" -v rate="$rate" -v sent="$sent" -v received="$received" \
+        -v kernel="$kernel" -v elapsed="$elapsed_ms" -v cpu="$cpu" -v rtt="$rtt" \
+        -v delay="$DELAY_MS" 'BEGIN {
+        split(cpu, t, " ")
+        net_loss   = sent ? 100 * (sent - received) / sent : 0
+        ntool_loss = kernel ? 100 * (kernel - received) / kernel : 0
+        pps        = elapsed ? sent * 1000 / elapsed : 0
+        cpu_us     = sent ? (t[1] + t[2]) * 1e6 / sent : 0
+        printf "%s,%s,%d,%d,%.2f,%.2f,%.0f,%.2f,%.3f,%.3f\n", mode, rate,
+            sent, received, net_loss, (ntool_loss < 0 ? 0 : ntool_loss), pps,
+            cpu_us, rtt, rtt - delay
+    }' >>"$OUTPUT"
+}
+
+run_ping() {
+    local rate=$1
+    local count=$((rate * SECONDS_PER_STEP))
+    local interval
+    interval=$(awk -v r="$rate" 'BEGIN { printf "%.6f", 1 / r }')
+
+    local before after cpu
+    before=$(kernel_counter IcmpInEchoReps)
+    cpu=$(timed "$NTOOL" --ping -n "$count" -i "$interval" -W 1 --quiet "$DST_ADDR" 3>&1)
+    after=$(kernel_counter IcmpInEchoReps)
+
+    # "N packets transmitted, M received, L% packet loss, time Tms"
+    local stats sent received elapsed rtt
+    stats=$(grep "packets transmitted" "$LOG")
+    sent=$(awk '{ print $1 }' <<<"$stats")
+    received=$(awk '{ print $4 }' <<<"$stats")
+    elapsed=$(sed -E 's/.*time ([0-9]+)ms.*/\1/' <<<"$stats")
+    rtt=$(awk -F'[ /]' '/^rtt/ { print $8 }' "$LOG")
+
+    report ping "$rate" "$sent" "$received" "$((after - before))" \
+        "$elapsed" "$cpu" "${rtt:-0}"
+}
+
+run_traceroute() {
+    local queries=$1
+
+    local before after cpu start end
+    before=$(kernel_counter IcmpInEchoReps IcmpInTimeExcds)
+    start=$(date +%s%N)
+    cpu=$(timed "$NTOOL" --tr -m $((HOPS + 1)) -q "$queries" "$DST_ADDR" 3>&1)
+    end=$(date +%s%N)
+    after=$(kernel_counter IcmpInEchoReps IcmpInTimeExcds)
+
+    # hop lines: " N  host (ip)  X.XXX ms Y.YYY ms ..."
+    local sent received rtt
+    received=$( (grep -o "[0-9.]\+ ms" "$LOG" || true) | wc -l)
+    sent=$(((HOPS + 1) * queries))
+    rtt=$( (grep -o "[0-9.]\+ ms" "$LOG" || true) | awk '{ s += $1 } END { print NR ? s / NR : 0 }')
+
+    report traceroute "$queries" "$sent" "$received" "$((after - before))" \
+        "$(((end - start) / 1000000))" "$cpu" "$rtt"
+}
+
+LOG=$(mktemp)
+trap 'cleanup; rm -f "$LOG"' EXIT
+
+setup
+
+if [[ "$OUTPUT" != /dev/stdout ]]; then
+    : >"$OUTPUT"
+fi
+
+echo "mode,rate,sent,received,net_loss,ntool_loss,pps,cpu_us,rtt_avg,rtt_error" >>"$OUTPUT"
+
+for rate in $RATES; do
+    run_ping "$rate"
+done
+
+for queries in $QUERIES; do
+    run_traceroute "$queries"
+done
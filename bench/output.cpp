@@ -0,0 +1,115 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/resultlog.hpp>
+#include <ntool/output.hpp>
+#include <ntool/feed.hpp>
+#include <ntool/ring.hpp>
+#include "bench.hpp"
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstdio>
+
+
+namespace ntool {
+namespace bench {
+
+void output_benchmarks(suite& s) noexcept
+{
+    static char buffer[512];
+    std::uint64_t value = 1295787659310;
+    in_addr_t addr      = 0x0101a8c0;   // 192.168.1.1
+
+    run(s, "format/u64", 0, [&] {
+        do_not_optimize(format_u64(buffer, value++));
+        clobber();
+    });
+
+    run(s, "format/ip", 0, [&] {
+        do_not_optimize(format_ip(buffer, addr++));
+        clobber();
+    });
+
+    output_record record {};
+    record.target           = 0x0100007f;
+    record.result.from      = 0x0100007f;
+    record.result.seq       = 1;
+    record.result.ttl       = 64;
+    record.result.reply_ttl = 64;
+    record.result.send_ns   = value;
+    record.result.recv_ns   = value + 57341;
+
+    // compare with printf-based formatting of same line
+    run(s, "format/snprintf", 0, [&] {
+        record.result.seq++;
+        do_not_optimize(std::snprintf(buffer, sizeof(buffer),
+            "64 bytes from %s: icmp_seq=%u ttl=%u rtt=%.3lf ms\n",
+            "127.0.0.1", record.result.seq, record.result.reply_ttl,
+            (record.result.recv_ns - record.result.send_ns) / 1e6
+        ));
+        clobber();
+    });
+
+    run(s, "format/jsonl", 0, [&] {
+        record.result.seq++;
+        do_not_optimize(format_jsonl(buffer, record));
+        clobber();
+    });
+
+    run(s, "format/csv", 0, [&] {
+        record.result.seq++;
+        do_not_optimize(format_csv(buffer, record));
+        clobber();
+    });
+
+    // archive append with 1 MB writes, mostly record conversion & copy
+    auto null = open("/dev/null", O_WRONLY);
+    log_writer log(null, record_kind::ping, {record.target}, false);
+
+    run(s, "log/append", sizeof(log_record), [&] {
+        record.result.seq++;
+        log.append(record.result);
+    });
+
+    log.close();
+    close(null);
+
+    // shared memory broadcast, record is published & read back by consumer
+    feed_writer feed("ntool-bench", FEED_CAPACITY);
+    feed_reader reader;
+    feed_record published;
+
+    if (reader.open("ntool-bench", false)) {
+        run(s, "feed/publish+read", sizeof(feed_record), [&] {
+            record.result.seq++;
+            feed.publish(record.result, record.target, record_kind::ping);
+            do_not_optimize(reader.read(&published, 1));
+        });
+    }
+
+    spsc_ring<output_record> ring(1024);
+
+    run(s, "ring/push+pop", sizeof(record), [&] {
+        ring.push(record);
+        ring.pop(record);
+        do_not_optimize(record);
+    });
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,71 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/prefix.hpp>
+#include "bench.hpp"
+#include <arpa/inet.h>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t PREFIXES_COUNT {100000};
+inline const std::uint32_t LOOKUPS_COUNT  {1 << 16};
+
+void prefix_benchmarks(suite& s) noexcept
+{
+    if (!selected(s, "prefix/"))
+        return;
+
+    // routing table like mix, mostly /24 with some shorter & longer ones
+    std::vector<prefix_entry> prefixes;
+    std::uint32_t x = 2463534242;
+
+    auto next = [&x]() noexcept {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    };
+
+    for (std::uint32_t i = 0; i < PREFIXES_COUNT; i++) {
+        auto r      = next();
+        auto length = (r % 10 < 6) ? 24 : (r % 10 < 8) ? 16 + r % 8 : 25 + r % 8;
+        prefixes.push_back({htonl(next()), static_cast<std::uint8_t>(length), i});
+    }
+
+    std::vector<in_addr_t> addrs(LOOKUPS_COUNT);
+
+    for (auto& addr : addrs)
+        addr = htonl(next());
+
+    run(s, "prefix/build/" + std::to_string(PREFIXES_COUNT), 0, [&] {
+        prefix_table table(prefixes, false);
+        do_not_optimize(table.lookup(addrs[0]));
+    }, PREFIXES_COUNT);
+
+    prefix_table table(prefixes, false);
+    std::uint32_t i = 0;
+
+    run(s, "prefix/lookup", 0, [&] {
+        do_not_optimize(table.lookup(addrs[i++ & (LOOKUPS_COUNT - 1)]));
+    });
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,75 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/series.hpp>
+#include "bench.hpp"
+#include <cmath>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t SERIES_TARGETS {1024};
+
+void series_benchmarks(suite& s) noexcept
+{
+    series_config config;
+    config.retention = 3600;
+
+    series_store store(SERIES_TARGETS, config);
+    std::uint64_t i  = 0;
+
+    // 1 Hz samples with scheduling jitter & RTT around 20 ms
+    auto sample = [](std::uint64_t n, std::int64_t& time, double& rtt) noexcept {
+        auto round = static_cast<std::int64_t>(n / SERIES_TARGETS);
+        time = 1700000000000 + round * 1000 + static_cast<std::int64_t>((n * 7) % 3);
+        rtt  = ((n * 7919) % 97 == 0) ? NAN : 20.0 + static_cast<double>((n * 31) % 400) / 100.0;
+    };
+
+    // decoding is measured over one hour of history
+    for (; i < 3600 * SERIES_TARGETS; i++) {
+        std::int64_t time;
+        double rtt;
+
+        sample(i, time, rtt);
+        store.append(i % SERIES_TARGETS, time, rtt);
+    }
+
+    run(s, "series/append", sizeof(series_point), [&] {
+        std::int64_t time;
+        double rtt;
+
+        sample(i, time, rtt);
+        store.append(i % SERIES_TARGETS, time, rtt);
+        i++;
+    });
+
+    run(s, "series/decode", sizeof(series_point), [&] {
+        series_decoder decoder(store, i++ % SERIES_TARGETS);
+        series_point point;
+        std::uint64_t count = 0;
+
+        while (decoder.next(point))
+            count++;
+
+        do_not_optimize(count);
+    }, std::max<std::uint64_t>(store.samples() / SERIES_TARGETS, 1));
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,197 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/engine.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/sim.hpp>
+#include <getopt.h>
+#include <cstdlib>
+#include <cstdio>
+
+
+/** Digest & totals of probe outcomes.*/
+struct sim_summary {
+    std::uint64_t digest {0xCBF29CE484222325ULL};   // FNV-1a of outcomes
+    std::uint64_t replies;
+    std::uint64_t timeouts;
+    std::uint64_t exceeded;
+};
+
+static void help(void) noexcept
+{
+    std::puts(
+        "USAGE\n"
+        "    ntool_sim [options]\n\n"
+        "DESCRIPTION\n"
+        "    ntool_sim - run probe engine over deterministic simulated network.\n"
+        "    Same options & seed always produce the same digest.\n\n"
+        "OPTIONS\n"
+        "    -t [N]       number of targets (100000)\n"
+        "    -n [N]       number of rounds (10)\n"
+        "    -H [N]       probe TTL 1..N per target, 0 - ping (0)\n"
+        "    -i [SEC]     interval between rounds (1.0)\n"
+        "    -W [SEC]     reply waiting time (1.0)\n"
+        "    -w [N]       max in-flight probes (262144)\n"
+        "    -R [MS]      max base RTT of target (200)\n"
+        "    -j [MS]      mean RTT jitter (1)\n"
+        "    -l [P]       probe loss probability (0.01)\n"
+        "    -d [P]       duplicated reply probability (0)\n"
+        "    -r [P]       late reply probability (0)\n"
+        "    -s [N]       random seed (1)\n"
+        "    -h           display list of commands\n"
+    );
+    std::exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief Fold probe outcome into summary.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given summary.
+ */
+static void handle_result(const ntool::probe_result& result, void *ctx) noexcept
+{
+    auto summary = static_cast<sim_summary*>(ctx);
+    std::uint64_t fields[] {
+        result.target, result.seq, result.ttl, result.timeout,
+        result.from, result.recv_ns - result.send_ns
+    };
+
+    for (auto field : fields) {
+        summary->digest ^= field;
+        summary->digest *= 0x100000001B3ULL;
+    }
+
+    if (result.timeout)
+        summary->timeouts++;
+    else if (result.type == ICMP_TIME_EXCEEDED)
+        summary->exceeded++;
+    else
+        summary->replies++;
+}
+
+int main(std::int32_t argc, char **argv)
+{
+    using namespace ntool;
+
+    engine_config config;
+    config.count        = 10;
+    config.timeout_ns   = 1000000000;
+    config.max_inflight = 1 << 18;
+
+    sim_topology topology;
+    topology.targets         = 100000;
+    topology.model.jitter_ns = 1000000;
+    topology.model.loss      = 0.01;
+
+    std::int32_t opt;
+
+    while ((opt = getopt(argc, argv, "t:n:H:i:W:w:R:j:l:d:r:s:h")) != -1) {
+        switch (opt) {
+        case 't':
+            topology.targets = std::atoi(optarg);
+            break;
+
+        case 'n':
+            config.count = std::atoi(optarg);
+            break;
+
+        case 'H':
+            config.hops = std::atoi(optarg);
+            break;
+
+        case 'i':
+            config.interval_ns = std::atof(optarg) * 1e9;
+            break;
+
+        case 'W':
+            config.timeout_ns = std::atof(optarg) * 1e9;
+            break;
+
+        case 'w':
+            config.max_inflight = std::atoi(optarg);
+            break;
+
+        case 'R':
+            topology.max_rtt_ns = std::atof(optarg) * 1e6;
+            break;
+
+        case 'j':
+            topology.model.jitter_ns = std::atof(optarg) * 1e6;
+            break;
+
+        case 'l':
+            topology.model.loss = std::atof(optarg);
+            break;
+
+        case 'd':
+            topology.model.duplicate = std::atof(optarg);
+            break;
+
+        case 'r':
+            topology.model.reorder = std::atof(optarg);
+            break;
+
+        case 's':
+            topology.seed = std::strtoull(optarg, nullptr, 10);
+            break;
+
+        case 'h':
+            help();
+            break;
+
+        default:
+            utils::error("Use -h for usage.");
+            break;
+        }
+    }
+
+    if (config.count == 0)
+        utils::error("ntool_sim: number of rounds must be positive");
+
+    topology.max_rtt_ns = std::max(topology.max_rtt_ns, topology.min_rtt_ns);
+
+    sim_transport sim(topology.seed);
+    auto targets = generate_topology(sim, topology);
+
+    sim_summary summary {};
+    engine e(sim, config, handle_result, &summary);
+
+    for (auto addr : targets)
+        e.add_target(addr);
+
+    auto begin = utils::clock_ns();
+    e.run();
+    auto elapsed = (utils::clock_ns() - begin) / 1e9;
+
+    const auto& counters = e.counters();
+
+    std::printf("probes     %lu\n", counters.sent);
+    std::printf("replies    %lu\n", summary.replies);
+    std::printf("exceeded   %lu\n", summary.exceeded);
+    std::printf("timeouts   %lu\n", summary.timeouts);
+    std::printf("foreign    %lu\n", counters.foreign);
+    std::printf("filtered   %lu\n", counters.filtered);
+    std::printf("stalls     %lu\n", counters.stalls);
+    std::printf("virtual    %.3f s\n", sim.now() / 1e9);
+    std::printf("wall       %.3f s\n", elapsed);
+    std::printf("rate       %.0f probes/s\n", counters.sent / elapsed);
+    std::printf("digest     %016lx\n", summary.digest);
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/targets.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/icmp.hpp>
+#include "bench.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t TARGETS_COUNT {1000000};
+
+/** Object per target, layout which flat table replaces.*/
+struct heap_target {
+    std::string          name;
+    in_addr_t            addr;
+    std::uint64_t        sent;
+    std::uint64_t        received;
+    std::uint64_t        errors;
+    std::uint32_t        last_seq;
+    utils::running_stats rtt;
+};
+
+void targets_benchmarks(suite& s) noexcept
+{
+    if (!selected(s, "targets/"))
+        return;
+
+    std::vector<std::string> names(TARGETS_COUNT);
+    std::vector<const char*> pointers(TARGETS_COUNT);
+
+    for (std::uint32_t i = 0; i < TARGETS_COUNT; i++) {
+        names[i]    = "10." + std::to_string(i >> 16) + "." +
+            std::to_string((i >> 8) & 0xFF) + "." + std::to_string(i & 0xFF);
+        pointers[i] = names[i].c_str();
+    }
+
+    std::vector<std::unique_ptr<heap_target>> heap(TARGETS_COUNT);
+
+    for (std::uint32_t i = 0; i < TARGETS_COUNT; i++) {
+        heap[i]       = std::make_unique<heap_target>();
+        heap[i]->name = names[i];
+        heap[i]->addr = utils::get_ip_address(names[i]);
+    }
+
+    target_table table(pointers);
+
+    probe_result result {};
+    result.type    = ICMP_ECHOREPLY;
+    result.send_ns = 1000000000;
+    std::uint64_t i = 0;
+
+    // outcomes arrive in schedule order, round-robin over targets
+    run(s, "targets/update/heap", 0, [&] {
+        result.target  = i % TARGETS_COUNT;
+        result.recv_ns = result.send_ns + 20000000 + (i * 31) % 400000;
+
+        auto& t = *heap[result.target];
+        t.sent++;
+        t.last_seq = ++result.seq;
+
+        if (result.type == ICMP_ECHOREPLY) {
+            t.received++;
+            utils::update(t.rtt, (result.recv_ns - result.send_ns) / 1e6);
+        }
+        else
+            t.errors++;
+
+        i++;
+    });
+
+    i = 0;
+
+    run(s, "targets/update/flat", 0, [&] {
+        result.target  = i % TARGETS_COUNT;
+        result.recv_ns = result.send_ns + 20000000 + (i * 31) % 400000;
+        result.seq++;
+
+        table.update(result);
+        i++;
+    });
+
+    // summary & metrics sweeps over all targets
+    run(s, "targets/sweep/heap", 0, [&] {
+        std::uint64_t lost = 0;
+
+        for (const auto& t : heap)
+            lost += t->sent - t->received;
+
+        do_not_optimize(lost);
+    }, TARGETS_COUNT);
+
+    run(s, "targets/sweep/flat", 0, [&] {
+        std::uint64_t lost = 0;
+
+        for (std::uint32_t t = 0; t < table.size(); t++)
+            lost += table.stats(t).sent - table.stats(t).received;
+
+        do_not_optimize(lost);
+    }, TARGETS_COUNT);
+}
+
+} // namespace bench
+} // namespace ntool
@@ -0,0 +1,98 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/resultlog.hpp>
+#include <ntool/topology.hpp>
+#include "bench.hpp"
+#include <arpa/inet.h>
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::uint32_t TRACES_COUNT  {10000};
+inline const std::uint32_t TRACE_HOPS    {16};
+inline const std::uint32_t TRACE_QUERIES {3};
+
+void topology_benchmarks(suite& s) noexcept
+{
+    if (!selected(s, "topology/"))
+        return;
+
+    // tree of routers: traces share more hops the nearer they are to source
+    std::vector<probe_result> results;
+    std::uint32_t x = 2463534242;
+
+    auto next = [&x]() noexcept {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    };
+
+    for (std::uint32_t t = 0; t < TRACES_COUNT; t++) {
+        auto dest = next();
+
+        for (std::uint32_t hop = 1; hop <= TRACE_HOPS; hop++) {
+            auto branch = dest >> (32 - 2 * hop);
+            auto ecmp   = (hop % 4 == 0);   // queries take parallel links
+
+            for (std::uint32_t q = 1; q <= TRACE_QUERIES; q++) {
+                probe_result r {};
+                r.seq     = q;
+                r.ttl     = hop;
+                r.from    = htonl((hop << 24) ^ (branch + ecmp * (q % 2)) * 2654435761U);
+                r.send_ns = 0;
+                r.recv_ns = hop * 1000000 + next() % 100000;
+                results.push_back(r);
+            }
+        }
+    }
+
+    const auto per_trace = TRACE_HOPS * TRACE_QUERIES;
+
+    run(s, "topology/build/" + std::to_string(TRACES_COUNT), 0, [&] {
+        topology graph;
+
+        for (std::size_t i = 0; i < results.size(); i++) {
+            if (i % per_trace == 0)
+                graph.begin();
+
+            graph.add(results[i]);
+        }
+
+        do_not_optimize(graph.nodes());
+    }, results.size());
+
+    // merged again into graph which already has all routes
+    topology graph;
+    std::uint32_t t = 0;
+
+    run(s, "topology/merge", sizeof(log_record), [&] {
+        auto first = (t++ % TRACES_COUNT) * per_trace;
+        graph.begin();
+
+        for (auto i = first; i < first + per_trace; i++) {
+            graph.prefetch(results[(i + TOPOLOGY_PREFETCH) % results.size()].from);
+            graph.add(results[i]);
+        }
+    }, per_trace);
+}
+
+} // namespace bench
+} // namespace ntool
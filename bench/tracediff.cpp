@@ -0,0 +1,60 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/tracediff.hpp>
+#include "bench.hpp"
+#include <arpa/inet.h>
+
+
+namespace ntool {
+namespace bench {
+
+void tracediff_benchmarks(suite& s) noexcept
+{
+    if (!selected(s, "tracediff/"))
+        return;
+
+    // 16 hops, 3 routers replaced in middle of path, one hop anonymous
+    route before {}, after {};
+    before.length = after.length = 16;
+
+    for (std::uint8_t hop = 0; hop < 16; hop++) {
+        before.hops[hop][0] = htonl((10 << 24) | hop);
+        after.hops[hop][0]  = (hop >= 6 && hop < 9) ? htonl((11 << 24) | hop) : before.hops[hop][0];
+    }
+
+    after.hops[12][0] = 0;
+    route_finish(before);
+    route_finish(after);
+
+    hop_change changes[ROUTE_MAX_HOPS + 1];
+
+    // unchanged paths cost only fingerprint computation
+    run(s, "tracediff/fingerprint", 0, [&] {
+        do_not_optimize(route_fingerprint(after));
+        clobber();
+    });
+
+    run(s, "tracediff/align", 0, [&] {
+        do_not_optimize(align_routes(before, after, changes));
+        clobber();
+    });
+}
+
+} // namespace bench
+} // namespace ntool
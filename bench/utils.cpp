@@ -0,0 +1,60 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/utils.hpp>
+#include "bench.hpp"
+
+
+namespace ntool {
+namespace bench {
+
+inline const std::size_t SAMPLES_COUNTS[] {16, 1024, 65536};
+
+void utils_benchmarks(suite& s) noexcept
+{
+    for (auto count : SAMPLES_COUNTS) {
+        std::vector<double> rtt(count);
+
+        for (std::size_t i = 0; i < count; i++)
+            rtt[i] = 0.5 + static_cast<double>((i * 7919) % 1000) / 100.0;
+
+        auto suffix = "/" + std::to_string(count);
+        auto bytes  = count * sizeof(double);
+
+        // batch statistics over stored samples
+        run(s, "stats/mean+mdev" + suffix, bytes, [&rtt] {
+            clobber();
+            do_not_optimize(utils::mean(rtt));
+            do_not_optimize(utils::mdev(rtt));
+        });
+
+        // streaming statistics updated per sample
+        run(s, "stats/running" + suffix, bytes, [&rtt] {
+            utils::running_stats stats;
+
+            for (auto value : rtt)
+                utils::update(stats, value);
+
+            do_not_optimize(stats.mean);
+            do_not_optimize(utils::stddev(stats));
+        });
+    }
+}
+
+} // namespace bench
+} // namespace ntool
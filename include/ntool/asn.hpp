@@ -0,0 +1,146 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  asn.hpp
+ * @brief Offline IP to origin AS database.
+ *
+ * Prefix to origin AS table (routing table dump or CSV) is compiled once
+ * into flat file: nested prefixes are flattened into sorted disjoint
+ * address ranges, first 16 bits of address index root array which bounds
+ * binary search to ranges of that /16. Database is mapped read-only as is,
+ * so opening it costs no parsing & pages are shared between processes.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_ASN_HPP_
+#define _NTOOL_ASN_HPP_
+
+#include <netinet/in.h>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ntool {
+
+inline const char          ASN_MAGIC[8] {'N', 'T', 'O', 'O', 'L', 'A', 'S', 'N'};
+inline const std::uint16_t ASN_VERSION  {1};
+inline const std::uint32_t ASN_ROOT     {(1U << 16) + 1};  // root entries (with sentinel)
+inline const std::uint32_t ASN_UNKNOWN  {0};               // address is not routed
+
+/** Database file header (host byte order), followed by root & ranges.*/
+struct asn_header {
+    char          magic[8];     // ASN_MAGIC
+    std::uint16_t version;      // ASN_VERSION
+    std::uint16_t reserved;
+    std::uint32_t ranges;       // number of ranges
+    std::uint64_t prefixes;     // prefixes compiled
+};
+
+static_assert(sizeof(asn_header) == 24);
+
+/** Addresses from start up to start of next range.*/
+struct asn_range {
+    std::uint32_t start;    // first address (host byte order)
+    std::uint32_t asn;      // origin AS (ASN_UNKNOWN - not routed)
+};
+
+class asn_db {
+public:
+    asn_db(void) noexcept = default;
+    ~asn_db(void) noexcept;
+
+    asn_db(const asn_db&)            = delete;
+    asn_db& operator=(const asn_db&) = delete;
+
+    /**
+     * @brief Map database file.
+     *
+     * @param [in] path - given database path.
+     * @return false if file is not database or cannot be read.
+     */
+    bool open(const char *path) noexcept;
+
+    /**
+     * @brief Find origin AS of address.
+     *
+     * @param [in] addr - given address in network byte order.
+     * @return origin AS or ASN_UNKNOWN.
+     */
+    std::uint32_t lookup(in_addr_t addr) const noexcept
+    {
+        auto host  = ntohl(addr);
+        auto block = host >> 16;
+
+        // root holds last range starting at or before each /16
+        auto lo = m_root[block];
+        auto hi = m_root[block + 1];
+
+        while (lo < hi) {
+            auto mid = (lo + hi + 1) / 2;
+
+            if (m_ranges[mid].start <= host)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+
+        return m_ranges[lo].asn;
+    }
+
+    /**
+     * @brief Get number of ranges.
+     *
+     * @return ranges.
+     */
+    std::uint32_t ranges(void) const noexcept;
+
+private:
+    void                *m_data   {nullptr};
+    std::size_t         m_size    {0};          // mapping size
+    const std::uint32_t *m_root   {nullptr};
+    const asn_range     *m_ranges {nullptr};
+};
+
+/** Database compilation summary. */
+struct asn_compile_stats {
+    std::size_t   prefixes {0}; // routes read from source
+    std::size_t   ranges   {0}; // flattened address ranges
+    std::size_t   bytes    {0}; // database size
+    std::uint64_t skipped  {0}; // comments & IPv6 lines
+    std::uint64_t invalid  {0}; // unparseable lines
+};
+
+/**
+ * @brief Compile prefix to origin AS list into database.
+ *
+ * Line is either "prefix AS" (separated by whitespace or comma, AS may have
+ * "AS" prefix) or routing table entry of "bgpdump -m" (origin is last AS
+ * of path). Duplicate prefixes keep first origin, IPv6 entries are skipped.
+ *
+ * @param [in] source - given source path.
+ * @param [in] path - given database path.
+ * @return compilation summary.
+ */
+asn_compile_stats asn_compile(const char *source, const char *path) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_ASN_HPP_
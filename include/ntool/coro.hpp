@@ -0,0 +1,560 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  coro.hpp
+ * @brief Coroutine runtime of multi-step measurements.
+ *
+ * Measurement is written as straight-line coroutine which awaits probe
+ * sends, replies (with timeout) & sleeps, scheduler resumes it from its
+ * event loop. Coroutine frames come from size class slab pools, so
+ * starting & finishing measurements does no malloc() in steady state.
+ *
+ * Reply timeout is armed when probe is sent & in-flight slot is freed as
+ * soon as probe is resolved, its outcome waits in ticket record until
+ * task takes it. So tasks holding tickets while awaiting more sends can't
+ * starve each other of slots. Ticket dropped without awaiting reply (or
+ * destroyed with its task) frees record itself.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_CORO_HPP_
+#define _NTOOL_CORO_HPP_
+
+#include <ntool/transport.hpp>
+#include <ntool/memory.hpp>
+#include <ntool/engine.hpp>
+#include <ntool/probe.hpp>
+#include <netinet/in.h>
+#include <coroutine>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+
+namespace ntool {
+
+inline const std::size_t FRAME_CLASS {64};      // frame size class step
+inline const std::size_t FRAME_MAX   {4096};    // largest pooled frame
+
+/** Coroutine frame memory of calling thread (size class slab pools).*/
+class frame_pool {
+public:
+    /**
+     * @brief Get pool of calling thread.
+     *
+     * @return pool.
+     */
+    static frame_pool& local(void) noexcept;
+
+    /**
+     * @brief Take frame memory.
+     *
+     * @param [in] size - given frame size in bytes.
+     * @return uninitialized frame memory.
+     */
+    void *allocate(std::size_t size) noexcept;
+
+    /**
+     * @brief Return frame memory.
+     *
+     * @param [in] ptr - given frame memory taken from this pool.
+     * @param [in] size - given frame size in bytes.
+     */
+    void release(void *ptr, std::size_t size) noexcept;
+
+    /**
+     * @brief Get number of live frames.
+     *
+     * @return number of frames.
+     */
+    std::uint64_t frames(void) const noexcept
+    {
+        return m_frames;
+    }
+
+    /**
+     * @brief Get bytes of live frames (rounded up to size class).
+     *
+     * @return size in bytes.
+     */
+    std::uint64_t bytes(void) const noexcept
+    {
+        return m_bytes;
+    }
+
+private:
+    std::unique_ptr<slab_pool> m_classes[FRAME_MAX / FRAME_CLASS];
+    std::uint64_t              m_frames {0};
+    std::uint64_t              m_bytes  {0};
+};
+
+class scheduler;
+
+/**
+ * Measurement coroutine. Task starts when it is spawned on scheduler or
+ * awaited by another task, results are stored through its arguments.
+ */
+class task {
+public:
+    struct promise_type;
+    using handle = std::coroutine_handle<promise_type>;
+
+    /** Resumes awaiting task or releases spawned one.*/
+    struct final_awaiter {
+        bool await_ready(void) const noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(handle h) noexcept;
+
+        void await_resume(void) const noexcept
+        {}
+    };
+
+    struct promise_type {
+        std::coroutine_handle<> continuation;       // awaiting task
+        scheduler               *owner {nullptr};   // scheduler of spawned task
+        promise_type            *prev  {nullptr};   // spawned tasks list
+        promise_type            *next  {nullptr};
+
+        task get_return_object(void) noexcept
+        {
+            return task(handle::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend(void) const noexcept
+        {
+            return {};
+        }
+
+        final_awaiter final_suspend(void) const noexcept
+        {
+            return {};
+        }
+
+        void return_void(void) const noexcept
+        {}
+
+        void unhandled_exception(void) const noexcept
+        {
+            std::abort();
+        }
+
+        static void *operator new(std::size_t size) noexcept
+        {
+            return frame_pool::local().allocate(size);
+        }
+
+        static void operator delete(void *ptr, std::size_t size) noexcept
+        {
+            frame_pool::local().release(ptr, size);
+        }
+
+        static task get_return_object_on_allocation_failure(void) noexcept
+        {
+            return task(nullptr);
+        }
+    };
+
+    explicit task(handle h) noexcept
+        : m_handle(h)
+    {}
+
+    task(task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    {}
+
+    task(const task&)            = delete;
+    task& operator=(const task&) = delete;
+    task& operator=(task&&)      = delete;
+
+    ~task(void) noexcept
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready(void) const noexcept
+    {
+        return !m_handle || m_handle.done();
+    }
+
+    /**
+     * @brief Start awaited task, awaiting one resumes when it finishes.
+     *
+     * @param [in] awaiting - given awaiting coroutine.
+     * @return awaited task to run.
+     */
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+
+    void await_resume(void) const noexcept
+    {}
+
+    /**
+     * @brief Take ownership of coroutine.
+     *
+     * @return coroutine handle.
+     */
+    handle release(void) noexcept
+    {
+        return std::exchange(m_handle, nullptr);
+    }
+
+private:
+    handle m_handle;
+};
+
+/**
+ * Sent probe to await reply of. Ticket owns outcome record of probe, which
+ * is freed when reply is awaited or ticket is destroyed.
+ */
+class probe_ticket {
+public:
+    probe_ticket(void) noexcept = default;
+
+    probe_ticket(scheduler& owner, std::uint32_t record) noexcept
+        : m_owner(&owner), m_record(record)
+    {}
+
+    probe_ticket(probe_ticket&& other) noexcept
+        : m_owner(std::exchange(other.m_owner, nullptr)), m_record(other.m_record)
+    {}
+
+    probe_ticket& operator=(probe_ticket&& other) noexcept;
+
+    probe_ticket(const probe_ticket&)            = delete;
+    probe_ticket& operator=(const probe_ticket&) = delete;
+
+    ~probe_ticket(void) noexcept;
+
+private:
+    friend class scheduler;
+
+    scheduler     *m_owner  {nullptr};  // nullptr - no record
+    std::uint32_t m_record  {0};        // outcome record of probe
+};
+
+/** Scheduler counters.*/
+struct scheduler_counters {
+    std::uint64_t spawned;      // spawned tasks
+    std::uint64_t finished;     // finished spawned tasks
+    std::uint64_t sent;         // sent probes
+    std::uint64_t received;     // matched replies
+    std::uint64_t timeouts;     // unanswered probes
+    std::uint64_t foreign;      // replies not matching any probe in flight
+    std::uint64_t filtered;     // received packets which are not replies
+    std::uint64_t resumes;      // coroutine resumptions by event loop
+};
+
+class scheduler {
+public:
+    /** Awaitable send of probe, paced by probe rate & free in-flight slots.*/
+    struct send_awaiter {
+        scheduler               &s;
+        in_addr_t               dst;
+        std::uint8_t            ttl;
+        std::uint64_t           at;                 // send time given by pacing
+        std::coroutine_handle<> h        {};
+        bool                    promised {false};   // slot kept for this send
+
+        bool await_ready(void) const noexcept
+        {
+            return at <= s.now() && s.m_free.size() > s.m_promised;
+        }
+
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            h = awaiting;
+            s.wait_send(*this);
+        }
+
+        probe_ticket await_resume(void) noexcept
+        {
+            s.m_promised -= promised;
+            return s.send_now(dst, ttl);
+        }
+    };
+
+    /** Awaitable reply of sent probe or its timeout.*/
+    struct reply_awaiter {
+        scheduler     &s;
+        probe_ticket  ticket;
+
+        bool await_ready(void) const noexcept
+        {
+            return s.m_records[ticket.m_record].done;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            s.m_records[ticket.m_record].waiter = h;
+        }
+
+        probe_result await_resume(void) noexcept
+        {
+            return s.take(ticket);
+        }
+    };
+
+    /** Awaitable sleep until given time.*/
+    struct sleep_awaiter {
+        scheduler     &s;
+        std::uint64_t deadline;
+
+        bool await_ready(void) const noexcept
+        {
+            return deadline <= s.now();
+        }
+
+        void await_suspend(std::coroutine_handle<> h) noexcept
+        {
+            s.wake_at(deadline, h);
+        }
+
+        void await_resume(void) const noexcept
+        {}
+    };
+
+    /**
+     * @brief Construct scheduler.
+     *
+     * @param [in] io - given packet transport.
+     * @param [in] max_inflight - given max probes in flight.
+     * @param [in] rate - given max probes per second (0 - unlimited).
+     * @param [in] timeout_ns - given reply waiting time since send.
+     */
+    scheduler(transport& io, std::uint32_t max_inflight, std::uint64_t rate,
+        std::uint64_t timeout_ns) noexcept;
+    ~scheduler(void) noexcept;
+
+    scheduler(const scheduler&)            = delete;
+    scheduler& operator=(const scheduler&) = delete;
+
+    /**
+     * @brief Start task on next run of event loop.
+     *
+     * @param [in] t - given task.
+     */
+    void spawn(task&& t) noexcept;
+
+    /** @brief Run event loop until all spawned tasks finish or stopped.*/
+    void run(void) noexcept;
+
+    /** @brief Stop event loop (async-signal-safe).*/
+    void stop(void) noexcept;
+
+    /**
+     * @brief Send probe.
+     *
+     * @param [in] dst - given destination address.
+     * @param [in] ttl - given probe time to live.
+     * @return awaitable giving ticket of sent probe.
+     */
+    send_awaiter send(in_addr_t dst, std::uint8_t ttl) noexcept;
+
+    /**
+     * @brief Wait for reply of sent probe or its timeout.
+     *
+     * @param [in] ticket - given ticket of sent probe (moved from).
+     * @return awaitable giving probe outcome.
+     */
+    reply_awaiter reply(probe_ticket ticket) noexcept
+    {
+        return {*this, std::move(ticket)};
+    }
+
+    /**
+     * @brief Sleep until given time.
+     *
+     * @param [in] deadline - given wake up time (transport clock).
+     * @return awaitable.
+     */
+    sleep_awaiter sleep_until(std::uint64_t deadline) noexcept
+    {
+        return {*this, deadline};
+    }
+
+    /**
+     * @brief Get current time of transport.
+     *
+     * @return time in nanoseconds.
+     */
+    std::uint64_t now(void) noexcept
+    {
+        return m_io.now();
+    }
+
+    /**
+     * @brief Get scheduler counters.
+     *
+     * @return scheduler counters.
+     */
+    const scheduler_counters& counters(void) const noexcept;
+
+    /**
+     * @brief Get memory of in-flight slots, ticket records, timers & ready
+     * queue.
+     *
+     * @return size in bytes.
+     */
+    std::size_t memory(void) const noexcept;
+
+private:
+    /** Probe in flight.*/
+    struct slot {
+        in_addr_t     dst;
+        std::uint32_t record;       // outcome record of probe
+        std::uint32_t generation;   // reuses of slot
+        bool          used;
+    };
+
+    /** Outcome of sent probe, kept until task takes it.*/
+    struct record {
+        std::coroutine_handle<> waiter;     // task awaiting reply
+        probe_result            result;
+        bool                    done;       // reply received or timed out
+        bool                    abandoned;  // ticket dropped before resolve
+    };
+
+    /** Wake up time of sleeping coroutine, paced send or reply timeout.*/
+    struct timer {
+        std::uint64_t           deadline;
+        std::coroutine_handle<> h;          // sleeping coroutine
+        send_awaiter            *sender;    // paced send
+        std::uint32_t           slot;       // reply timeout (both above nullptr)
+        std::uint32_t           generation; // generation of slot when sent
+
+        bool operator>(const timer& other) const noexcept
+        {
+            return deadline > other.deadline;
+        }
+    };
+
+    /**
+     * @brief Resume coroutine at given time.
+     *
+     * @param [in] deadline - given wake up time.
+     * @param [in] h - given coroutine.
+     */
+    void wake_at(std::uint64_t deadline, std::coroutine_handle<> h) noexcept;
+
+    /**
+     * @brief Suspend send until its pacing time & free slot.
+     *
+     * @param [in,out] sender - given suspended send.
+     */
+    void wait_send(send_awaiter& sender) noexcept;
+
+    /**
+     * @brief Keep free slot for waiting send & resume it.
+     *
+     * @param [in,out] sender - given waiting send.
+     */
+    void grant(send_awaiter& sender) noexcept;
+
+    /**
+     * @brief Send probe in free slot & arm its reply timeout.
+     *
+     * @param [in] dst - given destination address.
+     * @param [in] ttl - given probe time to live.
+     * @return ticket of sent probe.
+     */
+    probe_ticket send_now(in_addr_t dst, std::uint8_t ttl) noexcept;
+
+    /**
+     * @brief Complete outcome record of probe, wake its task & free slot
+     * for longest waiting send.
+     *
+     * @param [in] index - given in-flight slot of probe.
+     */
+    void resolve(std::uint32_t index) noexcept;
+
+    /**
+     * @brief Resolve probe dropped by transport as timeout.
+     *
+     * @param [in] packet - given ICMP packet of probe.
+     * @param [in] size - given ICMP packet size in bytes.
+     * @param [in] error - given errno of failed send.
+     * @param [in] ctx - given scheduler.
+     */
+    static void handle_drop(const std::uint8_t *packet, std::size_t size,
+        std::int32_t error, void *ctx) noexcept;
+
+    /**
+     * @brief Take outcome of probe & free its record.
+     *
+     * @param [in,out] ticket - given ticket of resolved probe.
+     * @return probe outcome.
+     */
+    probe_result take(probe_ticket& ticket) noexcept;
+
+    /**
+     * @brief Free record of dropped ticket, at once or when its probe is
+     * resolved.
+     *
+     * @param [in] r - given outcome record.
+     */
+    void abandon(std::uint32_t r) noexcept;
+
+    /** @brief Receive & match all pending replies.*/
+    void receive(void) noexcept;
+
+    /** @brief Fire timers which time has come.*/
+    void expire(void) noexcept;
+
+    /** @brief Resume ready coroutines.*/
+    void resume_ready(void) noexcept;
+
+    friend struct task::final_awaiter;
+    friend class probe_ticket;
+
+    transport                            &m_io;
+    std::vector<icmp_echo>               m_templates;   // request per echo id
+    std::vector<slot>                    m_slots;       // wire number -> probe
+    std::vector<std::uint32_t>           m_free;        // free slots
+    std::vector<record>                  m_records;     // outcomes of tickets
+    std::vector<std::uint32_t>           m_free_records;
+    std::vector<send_awaiter*>           m_senders;     // sends waiting for slot
+    std::size_t                          m_sender   {0};        // first waiting send
+    std::size_t                          m_promised {0};        // slots kept for sends
+    std::vector<timer>                   m_timers;      // min-heap
+    std::vector<std::coroutine_handle<>> m_ready;
+    task::promise_type                   *m_tasks   {nullptr};  // spawned tasks list
+    std::uint64_t                        m_active   {0};        // spawned & alive
+    std::uint64_t                        m_timeout  {0};        // reply waiting time
+    std::uint64_t                        m_step_ns  {0};        // delay between probes
+    std::uint64_t                        m_next_ns  {0};        // next paced send time
+    std::uint16_t                        m_base_id  {0};        // first echo identifier
+    scheduler_counters                   m_counters {};
+    volatile std::sig_atomic_t           m_stopped  {0};
+    std::uint8_t                         m_buffer[RECV_BUFFER_SIZE];   // reply
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_CORO_HPP_
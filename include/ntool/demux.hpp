@@ -0,0 +1,132 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  demux.hpp
+ * @brief Shared ICMP reply demultiplexer of probe engines.
+ *
+ * Engines of process share one raw socket. Each received packet is
+ * parsed once & dispatched by its echo identifier to the engine which
+ * owns it, instead of every engine reading & parsing every packet.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_DEMUX_HPP_
+#define _NTOOL_DEMUX_HPP_
+
+#include <ntool/transport.hpp>
+#include <ntool/engine.hpp>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+/** Demultiplexer counters.*/
+struct demux_counters {
+    std::uint64_t received;     // received packets
+    std::uint64_t parsed;       // parsed replies
+    std::uint64_t dispatched;   // replies passed to owning engine
+    std::uint64_t foreign;      // replies of no engine of process
+    std::uint64_t filtered;     // received packets which are not replies
+    std::uint64_t truncated;    // received packets filling receive buffer
+};
+
+class icmp_demux {
+public:
+    /**
+     * @brief Construct demultiplexer.
+     *
+     * @param [in] io - given packet transport shared by engines.
+     */
+    explicit icmp_demux(transport& io) noexcept;
+
+    icmp_demux(const icmp_demux&)            = delete;
+    icmp_demux& operator=(const icmp_demux&) = delete;
+
+    /**
+     * @brief Reserve echo identifiers for engine to be constructed.
+     *
+     * @param [in,out] config - given engine configuration.
+     */
+    void reserve(engine_config& config) noexcept;
+
+    /**
+     * @brief Route replies & dropped probes with echo identifiers of
+     * engine to it. First attached engine also counts filtered &
+     * truncated packets of shared socket.
+     *
+     * @param [in] session - given engine constructed with reserved
+     * configuration on shared transport.
+     */
+    void attach(engine& session) noexcept;
+
+    /** @brief Run attached engines until all of them are finished.*/
+    void run(void) noexcept;
+
+    /**
+     * @brief Get demultiplexer counters.
+     *
+     * @return demultiplexer counters.
+     */
+    const demux_counters& counters(void) const noexcept;
+
+    /**
+     * @brief Get number of attached engines.
+     *
+     * @return number of engines.
+     */
+    std::size_t sessions(void) const noexcept;
+
+private:
+    /** @brief Receive, parse & dispatch all pending replies.*/
+    void receive(void) noexcept;
+
+    /**
+     * @brief Get engine owning echo identifier.
+     *
+     * @param [in] id - given echo identifier.
+     * @return engine or nullptr if identifier is not reserved.
+     */
+    engine *owner(std::uint16_t id) const noexcept;
+
+    /**
+     * @brief Pass probe dropped by shared transport to its engine.
+     *
+     * @param [in] packet - given ICMP packet of probe.
+     * @param [in] size - given ICMP packet size in bytes.
+     * @param [in] error - given errno of failed send.
+     * @param [in] ctx - given demultiplexer.
+     */
+    static void dispatch_drop(const std::uint8_t *packet, std::size_t size,
+        std::int32_t error, void *ctx) noexcept;
+
+    transport            &m_io;
+    std::vector<engine*> m_sessions;
+    std::vector<engine*> m_owners;          // engine per echo identifier offset
+    std::uint16_t        m_base_id  {0};    // first echo identifier of process
+    std::uint32_t        m_next_id  {0};    // offset of next free identifier
+    demux_counters       m_counters {};
+    std::uint8_t         m_buffer[RECV_BUFFER_SIZE];   // reply
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_DEMUX_HPP_
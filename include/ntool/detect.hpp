@@ -0,0 +1,145 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  detect.hpp
+ * @brief Streaming latency & loss change detection.
+ *
+ * Every target keeps EWMA mean & variance of RTT, two-sided CUSUM of
+ * RTT normalized by EWMA deviation & EWMA of loss. Each sample updates
+ * fixed size state in O(1) without history, samples out of EWMA band
+ * are clamped to it, so single spikes do not move the baseline.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_DETECT_HPP_
+#define _NTOOL_DETECT_HPP_
+
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+/** Detector configuration.*/
+struct detector_config {
+    float         alpha      {0.05f};   // EWMA weight of RTT sample
+    float         band       {4.0f};    // EWMA band in deviations
+    float         drift      {0.5f};    // CUSUM slack in deviations
+    float         threshold  {8.0f};    // CUSUM alarm level in deviations
+    float         min_dev    {0.05f};   // minimal deviation relative to mean
+    float         loss_alpha {0.1f};    // EWMA weight of loss sample
+    float         loss_rate  {0.2f};    // loss rate alarm level
+    std::uint32_t burst      {3};       // consecutive losses of burst
+    std::uint32_t warmup     {16};      // samples before alarms
+};
+
+/** Anomaly type.*/
+enum class anomaly_kind : std::uint8_t {
+    latency_up,     // RTT level shifted up
+    latency_down,   // RTT level shifted down
+    loss_burst,     // consecutive probes lost
+    loss_rate,      // loss rate crossed alarm level
+    recovered,      // reply after loss burst
+};
+
+/** Detected anomaly.*/
+struct anomaly_event {
+    anomaly_kind  kind;
+    std::uint32_t target;       // target index
+    float         value;        // RTT in ms, lost probes or loss rate
+    float         baseline;     // RTT mean in ms or loss rate before event
+};
+
+/** Detector state of target (24 bytes).*/
+struct detector_state {
+    float         mean;         // EWMA of RTT in ms
+    float         var;          // EWMA variance of RTT
+    float         up;           // upper CUSUM
+    float         down;         // lower CUSUM
+    float         loss;         // EWMA of loss
+    std::uint16_t samples;      // replies seen (saturating)
+    std::uint8_t  losses;       // consecutive losses (saturating)
+    std::uint8_t  alarms;       // active loss alarms
+};
+
+class anomaly_detector {
+public:
+    /**
+     * @brief Allocate state of all targets.
+     *
+     * @param [in] targets - given number of targets.
+     * @param [in] config - given detector configuration.
+     */
+    anomaly_detector(std::size_t targets, const detector_config& config) noexcept;
+
+    /**
+     * @brief Update target state with probe outcome.
+     *
+     * @param [in] target - given target index.
+     * @param [in] rtt - given RTT in milliseconds (NaN - lost probe).
+     * @param [out] event - given object to store detected anomaly.
+     * @return true if anomaly was detected.
+     */
+    bool update(std::uint32_t target, double rtt, anomaly_event& event) noexcept;
+
+    /**
+     * @brief Get target state.
+     *
+     * @param [in] target - given target index.
+     * @return detector state.
+     */
+    const detector_state& state(std::uint32_t target) const noexcept;
+
+private:
+    /**
+     * @brief Update target state with reply.
+     *
+     * @param [in,out] s - given target state.
+     * @param [in] rtt - given RTT in milliseconds.
+     * @param [out] event - given object to store detected anomaly.
+     * @return true if anomaly was detected.
+     */
+    bool reply(detector_state& s, float rtt, anomaly_event& event) noexcept;
+
+    /**
+     * @brief Update target state with lost probe.
+     *
+     * @param [in,out] s - given target state.
+     * @param [out] event - given object to store detected anomaly.
+     * @return true if anomaly was detected.
+     */
+    bool lost(detector_state& s, anomaly_event& event) noexcept;
+
+    detector_config             m_config;
+    std::vector<detector_state> m_states;
+};
+
+/**
+ * @brief Get anomaly name.
+ *
+ * @param [in] kind - given anomaly type.
+ * @return anomaly name.
+ */
+const char *anomaly_name(anomaly_kind kind) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_DETECT_HPP_
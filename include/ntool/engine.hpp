@@ -0,0 +1,342 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  engine.hpp
+ * @brief Asynchronous ICMP echo probe engine.
+ *
+ * Probes are paced by schedule instead of waiting for each reply, so
+ * probing rate does not depend on round-trip time. Each round sends one
+ * probe per target, or one probe per TTL 1..hops per target when tracing.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_ENGINE_HPP_
+#define _NTOOL_ENGINE_HPP_
+
+#include <ntool/instrument.hpp>
+#include <ntool/transport.hpp>
+#include <ntool/recorder.hpp>
+#include <ntool/inflight.hpp>
+#include <ntool/probe.hpp>
+#include <ntool/icmp.hpp>
+#include <netinet/in.h>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+
+namespace ntool {
+
+/** Probe engine configuration.*/
+struct engine_config {
+    std::uint64_t interval_ns  {1000000000};   // delay between rounds
+    std::uint64_t timeout_ns   {2000000000};   // reply waiting time
+    std::uint32_t count        {0};            // rounds (0 - until stopped)
+    std::uint32_t max_inflight {65536};        // in-flight table capacity
+    std::uint8_t  ttl          {64};           // probes time to live
+    std::uint8_t  hops         {0};            // probe TTL 1..hops (trace)
+    std::uint8_t  samples      {0};            // TTLs sampled per target & round
+                                               // (trace, 0 - all hops)
+    std::uint32_t first_round  {0};            // sampling position of first round
+    std::int32_t  first_id     {-1};           // first echo identifier
+                                               // (-1 - process id)
+    bool          instrument   {false};        // time engine stages
+    bool          huge_pages   {false};        // in-flight table on huge pages
+};
+
+/** Single probe outcome.*/
+struct probe_result {
+    std::uint32_t target;       // target index
+    std::uint32_t seq;          // probe sequence of target (from 1)
+    std::uint8_t  ttl;          // probe time to live
+    std::uint8_t  reply_ttl;    // time to live of reply
+    std::uint8_t  type;         // reply ICMP type
+    std::uint8_t  code;         // reply ICMP sub-code
+    bool          timeout;      // true if reply was not received
+    in_addr_t     from;         // reply source address
+    std::uint64_t send_ns;      // probe send time
+    std::uint64_t recv_ns;      // reply receive time
+};
+
+/** Engine counters.*/
+struct engine_counters {
+    std::uint64_t sent;         // sent probes
+    std::uint64_t received;     // matched replies
+    std::uint64_t timeouts;     // unanswered probes
+    std::uint64_t foreign;      // replies not matching any probe in flight
+    std::uint64_t stalls;       // sends delayed by full in-flight table
+    std::uint64_t filtered;     // received packets which are not replies
+    std::uint64_t truncated;    // received packets filling receive buffer
+    std::uint64_t send_errors;  // probes dropped by transport
+};
+
+/**
+ * @brief Handle probe outcome.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given user context.
+ */
+using result_handler = void (*)(const probe_result& result, void *ctx) noexcept;
+
+/**
+ * @brief Handle event loop activity outside of probing.
+ *
+ * @param [in] ctx - given user context.
+ */
+using poll_handler = void (*)(void *ctx) noexcept;
+
+inline const std::uint64_t POLL_PERIOD_NS   {10000000};  // poll handler period
+inline const std::uint32_t RECV_BUFFER_SIZE {1500};      // max reply size
+
+/**
+ * @brief Get number of echo identifiers needed for in-flight probes.
+ *
+ * @param [in] capacity - given in-flight table capacity.
+ * @return number of echo identifiers.
+ */
+std::uint32_t echo_ids(std::uint32_t capacity) noexcept;
+
+class engine {
+public:
+    /**
+     * @brief Construct engine.
+     *
+     * @param [in] io - given packet transport.
+     * @param [in] config - given engine configuration.
+     * @param [in] handler - given probe outcome handler.
+     * @param [in] ctx - given handler context.
+     */
+    engine(transport& io, const engine_config& config, result_handler handler,
+        void *ctx) noexcept;
+
+    engine(const engine&)            = delete;
+    engine& operator=(const engine&) = delete;
+
+    /**
+     * @brief Add target to probe.
+     *
+     * @param [in] addr - given target address.
+     * @return target index.
+     */
+    std::uint32_t add_target(in_addr_t addr) noexcept;
+
+    /**
+     * @brief Add target with its own path length. Sampled TTLs of target
+     * cycle through 1..hops, round after round.
+     *
+     * @param [in] addr - given target address.
+     * @param [in] hops - given path length of target (from 1).
+     * @return target index.
+     */
+    std::uint32_t add_target(in_addr_t addr, std::uint8_t hops) noexcept;
+
+    /**
+     * @brief Set handler called from event loop when descriptor becomes
+     * readable & at least every POLL_PERIOD_NS.
+     *
+     * @param [in] fd - given file descriptor to watch (-1 - none).
+     * @param [in] handler - given handler (must not block).
+     * @param [in] ctx - given handler context.
+     */
+    void set_poll(std::int32_t fd, poll_handler handler, void *ctx) noexcept;
+
+    /** @brief Probe targets until all rounds are resolved or stopped.*/
+    void run(void) noexcept;
+
+    /**
+     * @brief Start schedule of probes. Used instead of run() when replies
+     * are received by shared demultiplexer (see demux.hpp).
+     */
+    void start(void) noexcept;
+
+    /** @brief Send probes which send time has come.*/
+    void send_due(void) noexcept;
+
+    /**
+     * @brief Match parsed reply with probe in flight & report outcome.
+     *
+     * @param [in] info - given parsed reply.
+     * @param [in] recv_ns - given reply receive time.
+     * @param [in] recv_tsc - given time stamp counter at receive, start of
+     * parse stage (see instrument.hpp).
+     */
+    void deliver(const reply_info& info, std::uint64_t recv_ns,
+        std::uint64_t recv_tsc) noexcept;
+
+    /**
+     * @brief Count packet which shared demultiplexer did not deliver.
+     *
+     * @param [in] filtered - given flag of packet which is not a reply.
+     * @param [in] truncated - given flag of packet filling receive buffer.
+     */
+    void count_packet(bool filtered, bool truncated) noexcept
+    {
+        m_counters.filtered  += filtered;
+        m_counters.truncated += truncated;
+    }
+
+    /**
+     * @brief Report expired probes & call poll handler when due.
+     *
+     * @return next wake up time (UINT64_MAX - none) or 0 if all rounds
+     * are resolved or engine is stopped.
+     */
+    std::uint64_t service(void) noexcept;
+
+    /**
+     * @brief Get first echo identifier of engine.
+     *
+     * @return echo identifier.
+     */
+    std::uint16_t first_id(void) const noexcept
+    {
+        return m_base_id;
+    }
+
+    /**
+     * @brief Get number of echo identifiers used by engine.
+     *
+     * @return number of echo identifiers.
+     */
+    std::uint32_t ids(void) const noexcept
+    {
+        return m_templates.size();
+    }
+
+    /** @brief Stop probing (async-signal-safe).*/
+    void stop(void) noexcept;
+
+    /**
+     * @brief Count probe which transport failed to send after queueing it.
+     * Probe stays in flight & is reported as timeout.
+     *
+     * @param [in] packet - given ICMP packet of probe.
+     * @param [in] error - given errno of failed send.
+     */
+    void drop(const std::uint8_t *packet, std::int32_t error) noexcept;
+
+    /**
+     * @brief Get engine counters.
+     *
+     * @return engine counters.
+     */
+    const engine_counters& counters(void) const noexcept;
+
+    /**
+     * @brief Get memory used by targets, echo templates & in-flight table.
+     *
+     * @return size in bytes.
+     */
+    std::size_t memory(void) const noexcept;
+
+    /**
+     * @brief Get memory used by echo templates & in-flight table, which
+     * does not depend on number of targets.
+     *
+     * @return size in bytes.
+     */
+    std::size_t fixed_memory(void) const noexcept;
+
+    /**
+     * @brief Get stage time histograms.
+     *
+     * @return stage statistics or nullptr if engine is not instrumented.
+     */
+    const engine_stats *stats(void) const noexcept;
+
+    /**
+     * @brief Record time since end of previous stage (result handler).
+     *
+     * @param [in] s - given stage which has just ended.
+     */
+    void lap(stage s) noexcept
+    {
+        if (m_stats)
+            m_stats->record(s);
+    }
+
+private:
+    /**
+     * @brief Restore target, sequence & TTL of probe from its number.
+     *
+     * @param [in] probe - given probe number.
+     * @param [out] result - given object to store probe identity.
+     */
+    void identify(std::uint64_t probe, probe_result& result) const noexcept;
+
+    /**
+     * @brief Send next scheduled probe.
+     *
+     * @param [in] now - given current time.
+     */
+    void send_probe(std::uint64_t now) noexcept;
+
+    /** @brief Receive & match all pending replies.*/
+    void receive(void) noexcept;
+
+    /**
+     * @brief Report unanswered probes which waiting time is over.
+     *
+     * @param [in] now - given current time.
+     */
+    void expire(std::uint64_t now) noexcept;
+
+    transport                     &m_io;
+    engine_config                 m_config;
+    result_handler                m_handler;
+    void                          *m_ctx;
+    std::vector<in_addr_t>        m_targets;
+    std::vector<std::uint8_t>     m_hops;          // path length per target
+    std::vector<icmp_echo>        m_templates;     // request per echo id
+    inflight_table                m_inflight;
+    std::uint64_t                 m_probes   {1};  // probes per target round
+    std::uint64_t                 m_next_ns  {0};  // next probe send time
+    std::uint64_t                 m_step_ns  {0};  // delay between probes
+    std::uint64_t                 m_step_rem {0};  // step remainder
+    std::uint64_t                 m_rem_acc  {0};  // accumulated remainder
+    std::uint16_t                 m_base_id  {0};  // first echo identifier
+    std::uint64_t                 m_total    {0};  // probes of all rounds
+    bool                          m_more     {false};  // probes left to send
+    bool                          m_stalled  {false};  // in-flight table full
+    engine_counters               m_counters {};
+    std::unique_ptr<engine_stats> m_stats;
+    flight_recorder               &m_flight;        // recorder of engine thread
+    poll_handler                  m_poll     {nullptr};
+    void                          *m_poll_ctx {nullptr};
+    std::uint64_t                 m_poll_ns  {0};  // next periodic poll time
+    volatile std::sig_atomic_t    m_stopped  {0};
+    std::uint8_t                  m_buffer[RECV_BUFFER_SIZE];  // reply
+};
+
+/**
+ * @brief Print engine counters & stage time percentiles (if engine is
+ * instrumented).
+ *
+ * @param [in] stream - given output stream.
+ * @param [in] e - given engine.
+ */
+void print_engine_stats(std::FILE *stream, const engine& e) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_ENGINE_HPP_
@@ -0,0 +1,188 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  feed.hpp
+ * @brief Shared memory feed of probe outcomes for local consumers.
+ *
+ * Single writer publishes fixed size records into broadcast ring in
+ * POSIX shared memory, any number of readers tail it independently.
+ * Each slot is guarded by its own sequence number (seqlock): odd while
+ * slot is written, 2 * (position + 1) when record at position is ready.
+ * Readers never block writer, reader which is lapped detects it by slot
+ * sequence & skips lost records. Neither side makes system calls per
+ * record.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_FEED_HPP_
+#define _NTOOL_FEED_HPP_
+
+#include <ntool/resultlog.hpp>
+#include <ntool/engine.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+
+
+namespace ntool {
+
+inline const char          FEED_MAGIC[8]  {'N', 'T', 'O', 'O', 'L', 'S', 'H', 'M'};
+inline const std::uint16_t FEED_VERSION   {1};
+inline const std::uint32_t FEED_CAPACITY  {65536};  // default records in ring
+
+/** Published probe outcome.*/
+struct feed_record {
+    std::uint64_t send_ns;      // probe send time (CLOCK_MONOTONIC)
+    std::uint64_t recv_ns;      // reply receive time (0 - timeout)
+    in_addr_t     target;       // target address
+    in_addr_t     from;         // reply source address
+    std::uint32_t index;        // target index
+    std::uint32_t seq;          // probe sequence of target
+    std::uint8_t  kind;         // record_kind
+    std::uint8_t  ttl;          // probe time to live
+    std::uint8_t  reply_ttl;    // time to live of reply
+    std::uint8_t  type;         // reply ICMP type
+    std::uint8_t  code;         // reply ICMP sub-code
+    std::uint8_t  reserved[3];
+};
+
+static_assert(sizeof(feed_record) == 40);
+
+/** Ring slot (one cache line).*/
+struct alignas(64) feed_slot {
+    std::atomic<std::uint64_t> seq;     // slot sequence
+    feed_record                record;
+};
+
+/** Shared memory header, followed by slots.*/
+struct alignas(64) feed_header {
+    char                       magic[8];    // FEED_MAGIC
+    std::uint16_t              version;     // FEED_VERSION
+    std::uint16_t              slot_size;   // sizeof(feed_slot)
+    std::uint32_t              capacity;    // slots (power of 2)
+    std::uint64_t              created_ns;  // CLOCK_REALTIME of creation
+    std::uint64_t              clock_ns;    // CLOCK_MONOTONIC of creation
+    std::atomic<std::uint32_t> closed;      // writer has finished
+    alignas(64) std::atomic<std::uint64_t> head;    // next position
+};
+
+class feed_writer {
+public:
+    /**
+     * @brief Create shared memory feed.
+     *
+     * @param [in] name - given feed name.
+     * @param [in] capacity - given ring size (rounded up to power of 2).
+     */
+    feed_writer(const char *name, std::uint32_t capacity) noexcept;
+    ~feed_writer(void) noexcept;
+
+    feed_writer(const feed_writer&)            = delete;
+    feed_writer& operator=(const feed_writer&) = delete;
+
+    /**
+     * @brief Publish probe outcome.
+     *
+     * @param [in] result - given probe outcome.
+     * @param [in] target - given target address.
+     * @param [in] kind - given mode which produced outcome.
+     */
+    void publish(const probe_result& result, in_addr_t target, record_kind kind) noexcept;
+
+private:
+    std::string   m_name;
+    feed_header   *m_header {nullptr};
+    feed_slot     *m_slots  {nullptr};
+    std::size_t   m_size    {0};        // mapping size
+    std::uint64_t m_head    {0};        // next position
+    std::uint64_t m_mask    {0};
+};
+
+class feed_reader {
+public:
+    feed_reader(void) noexcept = default;
+    ~feed_reader(void) noexcept;
+
+    feed_reader(const feed_reader&)            = delete;
+    feed_reader& operator=(const feed_reader&) = delete;
+
+    /**
+     * @brief Attach to shared memory feed.
+     *
+     * @param [in] name - given feed name.
+     * @param [in] oldest - given flag to start from oldest record kept in
+     * ring instead of next published one.
+     * @return false if feed does not exist or is not valid.
+     */
+    bool open(const char *name, bool oldest) noexcept;
+
+    /**
+     * @brief Read published records without blocking.
+     *
+     * @param [out] records - given array to store records.
+     * @param [in] max - given array size.
+     * @return number of records read.
+     */
+    std::size_t read(feed_record *records, std::size_t max) noexcept;
+
+    /**
+     * @brief Check whether writer has finished & all records were read.
+     *
+     * @return true if feed is drained.
+     */
+    bool finished(void) const noexcept;
+
+    /**
+     * @brief Get number of records overwritten before they were read.
+     *
+     * @return lost records.
+     */
+    std::uint64_t lost(void) const noexcept;
+
+    /**
+     * @brief Get feed header.
+     *
+     * @return shared memory header.
+     */
+    const feed_header& header(void) const noexcept;
+
+private:
+    const feed_header *m_header {nullptr};
+    const feed_slot   *m_slots  {nullptr};
+    std::size_t       m_size    {0};        // mapping size
+    std::uint64_t     m_next    {0};        // next position to read
+    std::uint64_t     m_mask    {0};
+    std::uint64_t     m_lost    {0};
+};
+
+/**
+ * @brief Convert feed record to probe outcome.
+ *
+ * @param [in] record - given feed record.
+ * @return probe outcome.
+ */
+probe_result to_result(const feed_record& record) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_FEED_HPP_
@@ -0,0 +1,153 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  histogram.hpp
+ * @brief Log-linear histogram with bounded relative error.
+ *
+ * Values below 128 have own buckets, larger values share bucket with
+ * other values of the same 8 most significant bits, so percentiles are
+ * within 0.8% of exact ones in constant memory.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_HISTOGRAM_HPP_
+#define _NTOOL_HISTOGRAM_HPP_
+
+#include <cstdint>
+#include <array>
+#include <bit>
+
+
+namespace ntool {
+
+inline const std::uint32_t HISTOGRAM_SUB_BITS {7};
+inline const std::uint32_t HISTOGRAM_SUB      {1U << HISTOGRAM_SUB_BITS};
+inline const std::uint32_t HISTOGRAM_BUCKETS  {(32 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB};
+
+class log_histogram {
+public:
+    /**
+     * @brief Get bucket of value.
+     *
+     * @param [in] value - given value.
+     * @return bucket index.
+     */
+    static constexpr std::uint32_t bucket(std::uint32_t value) noexcept
+    {
+        if (value < HISTOGRAM_SUB)
+            return value;
+
+        auto shift = std::bit_width(value) - HISTOGRAM_SUB_BITS - 1;
+        return (shift + 1) * HISTOGRAM_SUB + ((value >> shift) - HISTOGRAM_SUB);
+    }
+
+    /**
+     * @brief Get lowest value of bucket.
+     *
+     * @param [in] index - given bucket index.
+     * @return lowest value.
+     */
+    static constexpr std::uint64_t lower(std::uint32_t index) noexcept
+    {
+        if (index < HISTOGRAM_SUB)
+            return index;
+
+        auto shift = index / HISTOGRAM_SUB - 1;
+        return static_cast<std::uint64_t>(HISTOGRAM_SUB + index % HISTOGRAM_SUB) << shift;
+    }
+
+    /**
+     * @brief Add value.
+     *
+     * @param [in] value - given value.
+     */
+    void add(std::uint32_t value) noexcept
+    {
+        m_counts[bucket(value)]++;
+        m_total++;
+    }
+
+    /**
+     * @brief Add all values of other histogram.
+     *
+     * @param [in] other - given histogram.
+     */
+    void merge(const log_histogram& other) noexcept
+    {
+        for (std::uint32_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+            m_counts[i] += other.m_counts[i];
+
+        m_total += other.m_total;
+    }
+
+    /**
+     * @brief Get number of values.
+     *
+     * @return number of values.
+     */
+    std::uint64_t total(void) const noexcept
+    {
+        return m_total;
+    }
+
+    /**
+     * @brief Get number of values in bucket.
+     *
+     * @param [in] index - given bucket index.
+     * @return number of values.
+     */
+    std::uint64_t count(std::uint32_t index) const noexcept
+    {
+        return m_counts[index];
+    }
+
+    /**
+     * @brief Estimate percentile.
+     *
+     * @param [in] q - given quantile in [0, 1].
+     * @return middle of bucket which contains quantile (0 if empty).
+     */
+    double percentile(double q) const noexcept
+    {
+        if (m_total == 0)
+            return 0.0;
+
+        auto rank = static_cast<std::uint64_t>(q * (m_total - 1)) + 1;
+        std::uint64_t seen = 0;
+
+        for (std::uint32_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            seen += m_counts[i];
+
+            if (seen >= rank)
+                return (lower(i) + lower(i + 1) - 1) / 2.0;
+        }
+
+        return static_cast<double>(lower(HISTOGRAM_BUCKETS - 1));
+    }
+
+private:
+    std::array<std::uint64_t, HISTOGRAM_BUCKETS> m_counts {};
+    std::uint64_t                                m_total  {0};
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_HISTOGRAM_HPP_
@@ -0,0 +1,63 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  hops.hpp
+ * @brief Per-hop loss & latency of paths measured by coroutines.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_HOPS_HPP_
+#define _NTOOL_HOPS_HPP_
+
+#include <ntool/transport.hpp>
+#include <ntool/routes.hpp>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+inline const std::uint32_t HOPS_MAX_INFLIGHT {1 << 20};  // probes in flight
+
+/** Hop statistics options.*/
+struct hops_options {
+    std::uint32_t count    {10};    // rounds
+    double        interval {1.0};   // delay between rounds in seconds
+    double        timeout  {2.0};   // reply waiting time in seconds
+    std::uint8_t  hops     {ROUTE_MAX_HOPS};    // max hops
+    std::uint64_t rate     {ROUTE_TRACE_RATE};  // max probes per second
+    bool          quiet    {false}; // print summary only
+    io_backend    io       {io_backend::raw};
+    const char    *file    {nullptr};   // target list file
+};
+
+/**
+ * @brief Probe every hop of paths to targets each round & print loss
+ * & RTT of hops. Each target is measured by its own coroutine.
+ *
+ * @param [in] names - given targets (without target list file).
+ * @param [in] options - given hop statistics options.
+ */
+void hop_statistics(const std::vector<const char*>& names, const hops_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_HOPS_HPP_
@@ -28,6 +28,7 @@
 #define _NTOOL_ICMP_HPP_
 
 #include <netinet/ip_icmp.h>
+#include <netinet/in.h>
 #include <cstdint>
 
 
@@ -53,6 +54,39 @@ const char *unreach_decription(std::uint8_t code) noexcept;
  */
 std::uint16_t checksum(void *buffer, std::size_t size) noexcept;
 
+/**
+ * @brief Set the ICMP packet.
+ *
+ * @param [out] packet - given packet buffer of ICMP_PACKET_SIZE bytes.
+ * @param [in] header - given ICMP header.
+ */
+void set_packet(std::uint8_t *packet, const icmphdr& header) noexcept;
+
+/** Probe identity & outcome carried by received ICMP packet.*/
+struct reply_info {
+    std::uint8_t  type;     // ICMP type
+    std::uint8_t  code;     // ICMP sub-code
+    std::uint8_t  ttl;      // time to live of received packet
+    std::uint16_t id;       // echo identifier of probe
+    std::uint16_t seq;      // echo sequence of probe
+    in_addr_t     from;     // reply source address
+    in_addr_t     target;   // probe destination address
+};
+
+/**
+ * @brief Parse received packet as reply to echo request probe.
+ *
+ * Echo reply carries probe identity directly. Time exceeded & destination
+ * unreachable carry it inside quoted original IP & ICMP headers.
+ *
+ * @param [in] packet - given received packet (IP header included).
+ * @param [in] size - given received packet size in bytes.
+ * @param [out] info - given object to store reply info.
+ * @return true if packet is reply to echo request, false otherwise.
+ */
+bool parse_reply(const std::uint8_t *packet, std::size_t size,
+    reply_info& info) noexcept;
+
 } // namespace ntool
 
 #endif // _NTOOL_ICMP_HPP_
\ No newline at end of file
@@ -0,0 +1,180 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  inflight.hpp
+ * @brief Table of probes waiting for reply.
+ *
+ * Probes are numbered in send order & stored in ring indexed by number,
+ * so lookup by identity carried in reply is a single array access, and
+ * the oldest probe is always the first one to time out. Target, sequence
+ * & TTL follow from probe number, so slot keeps only number & send time.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_INFLIGHT_HPP_
+#define _NTOOL_INFLIGHT_HPP_
+
+#include <ntool/memory.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <bit>
+
+
+namespace ntool {
+
+/** In-flight probe record.*/
+struct inflight_slot {
+    std::uint64_t probe;    // probe number + 1 (0 - free slot)
+    std::uint64_t send_ns;  // probe send time
+};
+
+static_assert(sizeof(inflight_slot) == 16);
+
+class inflight_table {
+public:
+    /**
+     * @brief Construct table.
+     *
+     * @param [in] capacity - given max number of in-flight probes.
+     * @param [in] wire_span - given number of distinct on-wire identities.
+     * @param [in] huge - given flag to back table by huge pages.
+     */
+    inflight_table(std::uint64_t capacity, std::uint64_t wire_span, bool huge) noexcept
+        : m_mask(std::bit_ceil(std::max<std::uint64_t>(capacity, 1)) - 1),
+          m_wire_mask(std::bit_ceil(std::max(wire_span, m_mask + 1)) - 1),
+          m_buffer((m_mask + 1) * sizeof(inflight_slot), huge),
+          m_slots(static_cast<inflight_slot*>(m_buffer.data()))
+    {}
+
+    /**
+     * @brief Get number of sent probes.
+     *
+     * @return next probe number.
+     */
+    std::uint64_t sent(void) const noexcept
+    {
+        return m_sent;
+    }
+
+    /**
+     * @brief Get number of probes waiting for reply.
+     *
+     * @return in-flight probes.
+     */
+    std::uint64_t pending(void) const noexcept
+    {
+        return m_pending;
+    }
+
+    /**
+     * @brief Get table capacity.
+     *
+     * @return max number of in-flight probes.
+     */
+    std::uint64_t capacity(void) const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    /**
+     * @brief Check whether next probe would overwrite unresolved one.
+     *
+     * @return true if table is full.
+     */
+    bool full(void) const noexcept
+    {
+        return m_sent - m_expired > m_mask;
+    }
+
+    /**
+     * @brief Allocate slot for next probe.
+     *
+     * @return slot with probe number set.
+     */
+    inflight_slot& push(void) noexcept
+    {
+        auto& slot = m_slots[m_sent & m_mask];
+        slot.probe = ++m_sent;
+        m_pending++;
+
+        return slot;
+    }
+
+    /**
+     * @brief Find unresolved probe by on-wire identity.
+     *
+     * @param [in] wire - given probe number modulo wire span.
+     * @return slot or nullptr if probe is resolved or unknown.
+     */
+    inflight_slot *find(std::uint64_t wire) noexcept
+    {
+        auto& slot = m_slots[wire & m_mask];
+
+        if (!slot.probe || ((slot.probe - 1) & m_wire_mask) != wire)
+            return nullptr;
+
+        return &slot;
+    }
+
+    /**
+     * @brief Mark probe as resolved.
+     *
+     * @param [in,out] slot - given unresolved probe slot.
+     */
+    void resolve(inflight_slot& slot) noexcept
+    {
+        slot.probe = 0;
+        m_pending--;
+    }
+
+    /**
+     * @brief Get oldest unresolved probe.
+     *
+     * @return slot or nullptr if there are no unresolved probes.
+     */
+    inflight_slot *oldest(void) noexcept
+    {
+        // skip probes which replies were already matched
+        while (m_expired < m_sent) {
+            auto& slot = m_slots[m_expired & m_mask];
+
+            if (slot.probe)
+                return &slot;
+
+            m_expired++;
+        }
+
+        return nullptr;
+    }
+
+private:
+    std::uint64_t m_mask;
+    std::uint64_t m_wire_mask;
+    page_buffer   m_buffer;         // zero-filled slots
+    inflight_slot *m_slots;
+    std::uint64_t m_sent    {0};    // sent probes
+    std::uint64_t m_expired {0};    // oldest unresolved probe
+    std::uint64_t m_pending {0};    // in-flight probes
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_INFLIGHT_HPP_
@@ -0,0 +1,137 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  instrument.hpp
+ * @brief Self-instrumentation of probe engine.
+ *
+ * Time spent in each stage of probe & reply handling is measured with
+ * time stamp counter, which is read in a few cycles without system call.
+ * Stage is timed as lap since end of previous stage, so each reply costs
+ * only one counter read per stage. Only every STATS_SAMPLE-th probe &
+ * reply is timed, which keeps overhead well below 1% even where reading
+ * counter is slow (virtual machines).
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_INSTRUMENT_HPP_
+#define _NTOOL_INSTRUMENT_HPP_
+
+#include <ntool/histogram.hpp>
+#include <ntool/utils.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+namespace ntool {
+
+/**
+ * @brief Read time stamp counter.
+ *
+ * @return counter value (nanoseconds on architectures without TSC).
+ */
+inline std::uint64_t read_tsc(void) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return utils::clock_ns();
+#endif
+}
+
+/** Engine stage.*/
+enum class stage : std::uint8_t {
+    schedule,   // scheduled send time -> probe sent (nanoseconds)
+    send,       // transport send
+    parse,      // reply received -> parsed & matched to probe
+    stats,      // matched -> statistics updated by handler
+    output,     // statistics updated -> handler returned (output queued)
+    count,
+};
+
+inline const std::uint32_t STAGES       {static_cast<std::uint32_t>(stage::count)};
+inline const std::uint64_t STATS_SAMPLE {32};  // timed probes & replies ratio
+
+/** Stage time histograms.*/
+struct engine_stats {
+    log_histogram stages[STAGES];   // cycles (nanoseconds for schedule)
+    std::uint64_t lap      {0};     // end of previous stage in cycles
+    bool          active   {false}; // current probe or reply is timed
+    std::uint64_t tsc_base {0};     // counter at start of run
+    std::uint64_t ns_base  {0};     // time at start of run
+
+    /**
+     * @brief Start timing probe or reply if it is sampled.
+     *
+     * @param [in] n - given probe or reply number.
+     * @param [in] begin - given counter value of stage start (0 - now).
+     */
+    void start(std::uint64_t n, std::uint64_t begin = 0) noexcept
+    {
+        active = n % STATS_SAMPLE == 0;
+
+        if (active)
+            lap = begin ? begin : read_tsc();
+    }
+
+    /**
+     * @brief Record time since previous lap as given stage.
+     *
+     * @param [in] s - given stage.
+     */
+    void record(stage s) noexcept
+    {
+        if (!active)
+            return;
+
+        auto now = read_tsc();
+        add(s, now - lap);
+        lap = now;
+    }
+
+    /**
+     * @brief Record stage duration.
+     *
+     * @param [in] s - given stage.
+     * @param [in] value - given duration.
+     */
+    void add(stage s, std::uint64_t value) noexcept
+    {
+        stages[static_cast<std::uint32_t>(s)].add(
+            static_cast<std::uint32_t>(std::min<std::uint64_t>(value, UINT32_MAX))
+        );
+    }
+};
+
+/**
+ * @brief Get stage name.
+ *
+ * @param [in] s - given stage.
+ * @return stage name.
+ */
+const char *stage_name(stage s) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_INSTRUMENT_HPP_
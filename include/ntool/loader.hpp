@@ -0,0 +1,93 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  loader.hpp
+ * @brief Bulk loader of target lists.
+ *
+ * Target file is mapped privately & split into chunks at line boundaries,
+ * chunks are parsed by worker threads in place (names & tags are
+ * terminated by overwriting separators, so they are never copied).
+ * Dotted-quad addresses are classified 16 bytes at a time & parsed
+ * without inet_pton(). Only names which are not address literals are
+ * sent to resolver, CIDR prefixes inside other prefixes are not expanded.
+ * Line format:
+ *
+ *   # comment
+ *   <IP | IP/prefix | name> [tag]
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_LOADER_HPP_
+#define _NTOOL_LOADER_HPP_
+
+#include <ntool/memory.hpp>
+#include <netinet/in.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+inline const std::uint32_t LOADER_MAX_THREADS {16};
+inline const std::uint8_t  LOADER_MIN_PREFIX  {8};  // shortest CIDR prefix
+
+/** Target list loading counters.*/
+struct load_counters {
+    std::uint64_t lines;        // target lines
+    std::uint64_t duplicates;   // targets dropped as duplicates
+    std::uint64_t invalid;      // malformed lines
+    std::uint64_t names;        // distinct names sent to resolver
+    std::uint64_t unresolved;   // names which were not resolved
+};
+
+/** Unique targets in file order.*/
+struct target_list {
+    std::vector<in_addr_t>   addrs;
+    std::vector<const char*> names;     // names as given in file
+    std::vector<const char*> tags;      // tags (empty if file has none)
+    page_buffer              text;      // file copy names & tags point to
+    page_buffer              generated; // names of CIDR hosts
+    load_counters            counters;
+};
+
+/**
+ * @brief Parse dotted-quad IPv4 address.
+ *
+ * @param [in] p - given address start.
+ * @param [in] end - given end of readable memory.
+ * @param [out] addr - given object to store address in network byte order.
+ * @return address length or 0 if there is no valid address at given start.
+ */
+std::size_t parse_ipv4(const char *p, const char *end, in_addr_t& addr) noexcept;
+
+/**
+ * @brief Load target list file.
+ *
+ * @param [in] path - given file path.
+ * @param [in] threads - given number of parse & resolve threads (0 - CPUs).
+ * @param [out] list - given object to store targets.
+ */
+void load_targets(const char *path, std::uint32_t threads, target_list& list) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_LOADER_HPP_
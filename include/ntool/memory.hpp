@@ -0,0 +1,276 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  memory.hpp
+ * @brief Page buffers, arenas & slab pools.
+ *
+ * Long lived tables & packet buffers are mapped directly from kernel,
+ * optionally on huge pages to save TLB misses on large tables. Per-run
+ * data (target names, resolved addresses) is bump allocated from arena
+ * & freed all at once. Objects with independent lifetimes (sessions,
+ * frames) are taken from fixed size slab pools, so steady state does no
+ * malloc() or free() at all.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_MEMORY_HPP_
+#define _NTOOL_MEMORY_HPP_
+
+#include <string_view>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <new>
+
+
+namespace ntool {
+
+inline const std::size_t HUGE_PAGE_SIZE {1 << 21};  // 2 MB
+inline const std::size_t ARENA_CHUNK    {1 << 16};  // default arena chunk
+inline const std::size_t SLAB_OBJECTS   {64};       // objects per slab
+
+/** Memory subsystem counters (all threads).*/
+struct memory_counters {
+    std::uint64_t mapped;       // bytes of mapped pages
+    std::uint64_t huge;         // bytes of mapped huge pages
+    std::uint64_t arena;        // bytes allocated from arenas
+    std::uint64_t slab_allocs;  // objects taken from slab pools
+    std::uint64_t slab_frees;   // objects returned to slab pools
+};
+
+/**
+ * @brief Get memory subsystem counters.
+ *
+ * @return counters snapshot.
+ */
+memory_counters memory_stats(void) noexcept;
+
+/** Zero-filled memory mapped from kernel.*/
+class page_buffer {
+public:
+    page_buffer(void) noexcept = default;
+
+    /**
+     * @brief Map memory.
+     *
+     * @param [in] size - given size in bytes.
+     * @param [in] huge - given flag to back memory by huge pages if
+     * possible (reserved ones, then transparent ones).
+     */
+    page_buffer(std::size_t size, bool huge) noexcept;
+    ~page_buffer(void) noexcept;
+
+    page_buffer(page_buffer&& other) noexcept;
+    page_buffer& operator=(page_buffer&& other) noexcept;
+
+    page_buffer(const page_buffer&)            = delete;
+    page_buffer& operator=(const page_buffer&) = delete;
+
+    /**
+     * @brief Get mapped memory.
+     *
+     * @return memory start.
+     */
+    void *data(void) const noexcept
+    {
+        return m_data;
+    }
+
+    /**
+     * @brief Get mapped size.
+     *
+     * @return size in bytes.
+     */
+    std::size_t size(void) const noexcept
+    {
+        return m_size;
+    }
+
+private:
+    void        *m_data {nullptr};
+    std::size_t m_size  {0};
+    bool        m_huge  {false};    // backed by reserved huge pages
+};
+
+/** Bump allocator, memory is freed all at once.*/
+class arena {
+public:
+    /**
+     * @brief Construct empty arena.
+     *
+     * @param [in] chunk - given min size of mapped chunk.
+     */
+    explicit arena(std::size_t chunk = ARENA_CHUNK) noexcept;
+    ~arena(void) noexcept;
+
+    arena(const arena&)            = delete;
+    arena& operator=(const arena&) = delete;
+
+    /**
+     * @brief Allocate memory.
+     *
+     * @param [in] size - given size in bytes.
+     * @param [in] align - given alignment (power of 2).
+     * @return zero-filled memory.
+     */
+    void *allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) noexcept
+    {
+        auto pos = (m_pos + align - 1) & ~(align - 1);
+
+        if (pos + size > m_end) {
+            grow(size + align);
+            pos = (m_pos + align - 1) & ~(align - 1);
+        }
+
+        m_pos   = pos + size;
+        m_used += size;
+        return reinterpret_cast<void*>(pos);
+    }
+
+    /**
+     * @brief Copy string.
+     *
+     * @param [in] str - given string.
+     * @return null-terminated copy.
+     */
+    const char *copy(std::string_view str) noexcept;
+
+    /** @brief Free all allocated memory.*/
+    void reset(void) noexcept;
+
+    /**
+     * @brief Get allocated bytes.
+     *
+     * @return size in bytes.
+     */
+    std::size_t used(void) const noexcept
+    {
+        return m_used;
+    }
+
+private:
+    /**
+     * @brief Map new chunk.
+     *
+     * @param [in] size - given min chunk size.
+     */
+    void grow(std::size_t size) noexcept;
+
+    std::vector<page_buffer> m_chunks;
+    std::size_t              m_chunk;
+    std::uintptr_t           m_pos   {0};   // next free byte
+    std::uintptr_t           m_end   {0};   // end of current chunk
+    std::size_t              m_used  {0};
+};
+
+/** Free list of fixed size objects carved from arena.*/
+class slab_pool {
+public:
+    /**
+     * @brief Construct empty pool.
+     *
+     * @param [in] size - given object size.
+     * @param [in] align - given object alignment.
+     * @param [in] objects - given number of objects per mapped slab.
+     */
+    slab_pool(std::size_t size, std::size_t align,
+        std::size_t objects = SLAB_OBJECTS) noexcept;
+
+    slab_pool(const slab_pool&)            = delete;
+    slab_pool& operator=(const slab_pool&) = delete;
+
+    /**
+     * @brief Take object memory.
+     *
+     * @return uninitialized object memory.
+     */
+    void *allocate(void) noexcept;
+
+    /**
+     * @brief Return object memory.
+     *
+     * @param [in] ptr - given object memory taken from this pool.
+     */
+    void release(void *ptr) noexcept;
+
+private:
+    /** Free object.*/
+    struct node {
+        node *next;
+    };
+
+    arena       m_arena;
+    node        *m_free {nullptr};
+    std::size_t m_size;
+    std::size_t m_align;
+};
+
+/** Typed slab pool.*/
+template <typename T>
+class object_pool {
+public:
+    object_pool(void) noexcept
+        : m_pool(std::max(sizeof(T), sizeof(void*)), std::max(alignof(T), alignof(void*)))
+    {}
+
+    /**
+     * @brief Get pool of calling thread.
+     *
+     * @return pool.
+     */
+    static object_pool& local(void) noexcept
+    {
+        thread_local object_pool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Construct object.
+     *
+     * @param [in] args - given constructor arguments.
+     * @return object.
+     */
+    template <typename... Args>
+    T *create(Args&&... args) noexcept
+    {
+        return new (m_pool.allocate()) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Destroy object.
+     *
+     * @param [in] object - given object created by this pool.
+     */
+    void destroy(T *object) noexcept
+    {
+        object->~T();
+        m_pool.release(object);
+    }
+
+private:
+    slab_pool m_pool;
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_MEMORY_HPP_
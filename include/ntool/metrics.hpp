@@ -0,0 +1,175 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  metrics.hpp
+ * @brief Prometheus exporter of continuous runs.
+ *
+ * Probing thread updates per-target counters with relaxed atomic stores
+ * (plain moves on x86), so snapshots are read lock-free by serializer
+ * thread. Text exposition format 0.0.4 is served on 127.0.0.1.
+ *
+ * Serializer renders text exposition into one of two buffers, while
+ * event loop serves scrapes from the other one with non-blocking sends,
+ * so rendering of large snapshots never stalls probing.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_METRICS_HPP_
+#define _NTOOL_METRICS_HPP_
+
+#include <ntool/engine.hpp>
+#include <ntool/memory.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+
+
+namespace ntool {
+
+inline const std::uint32_t METRICS_BUCKETS {11};    // RTT histogram buckets
+
+/** RTT histogram bucket upper bounds in microseconds (last - +Inf).*/
+inline const std::uint64_t METRICS_BOUNDS[METRICS_BUCKETS - 1] {
+    500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000,
+};
+
+/** Counters of target.*/
+struct target_metrics {
+    std::atomic<std::uint64_t> probes;                      // resolved probes
+    std::atomic<std::uint64_t> replies;                     // echo replies
+    std::atomic<std::uint64_t> timeouts;                    // unanswered probes
+    std::atomic<std::uint64_t> rtt_sum;                     // RTT sum in us
+    std::atomic<std::uint64_t> buckets[METRICS_BUCKETS];    // non-cumulative
+};
+
+class metrics_registry {
+public:
+    /**
+     * @brief Allocate counters of all targets.
+     *
+     * @param [in] targets - given target addresses.
+     */
+    explicit metrics_registry(const std::vector<in_addr_t>& targets) noexcept;
+
+    /**
+     * @brief Count probe outcome (single writer).
+     *
+     * @param [in] result - given probe outcome.
+     */
+    void record(const probe_result& result) noexcept;
+
+    /**
+     * @brief Publish engine counters (single writer).
+     *
+     * @param [in] counters - given engine counters.
+     */
+    void update(const engine_counters& counters) noexcept;
+
+    /**
+     * @brief Render text exposition of current values.
+     *
+     * @param [out] out - given string to store exposition.
+     */
+    void render(std::string& out) const noexcept;
+
+private:
+    std::vector<in_addr_t>            m_targets;
+    std::unique_ptr<target_metrics[]> m_metrics;
+    std::atomic<std::uint64_t>        m_engine[8] {};   // engine_counters
+};
+
+inline const std::uint32_t METRICS_MAX_CLIENTS {16};         // open connections
+inline const std::size_t   METRICS_SEND_BUDGET {1 << 22};    // bytes per poll
+
+class metrics_exporter {
+public:
+    /**
+     * @brief Listen on local port & start serializer thread.
+     *
+     * @param [in] registry - given metrics registry.
+     * @param [in] port - given TCP port on 127.0.0.1.
+     */
+    metrics_exporter(const metrics_registry& registry, std::uint16_t port) noexcept;
+    ~metrics_exporter(void) noexcept;
+
+    metrics_exporter(const metrics_exporter&)            = delete;
+    metrics_exporter& operator=(const metrics_exporter&) = delete;
+
+    /**
+     * @brief Get listening socket.
+     *
+     * @return file descriptor.
+     */
+    std::int32_t fd(void) const noexcept;
+
+    /** @brief Accept, read & answer scrapes without blocking (event loop).*/
+    void poll(void) noexcept;
+
+private:
+    /** Scrape connection.*/
+    struct client {
+        std::int32_t fd;
+        std::uint8_t state;         // client_state
+        std::uint8_t buffer;        // snapshot being sent
+        std::size_t  received;      // request bytes
+        std::size_t  sent;          // response bytes
+        std::string  header;        // response header
+        char         request[512];
+    };
+
+    /** @brief Serializer thread loop.*/
+    void serialize(void) noexcept;
+
+    /**
+     * @brief Read request of client.
+     *
+     * @param [in,out] c - given client.
+     */
+    void read(client& c) noexcept;
+
+    /**
+     * @brief Send response to client.
+     *
+     * @param [in,out] c - given client.
+     * @param [in,out] budget - given bytes allowed to send.
+     */
+    void write(client& c, std::size_t& budget) noexcept;
+
+    const metrics_registry &m_registry;
+    std::int32_t           m_fd        {-1};
+    std::vector<client*>   m_clients;           // sessions from pool
+    object_pool<client>    m_pool;
+    std::string            m_buffers[2];          // double-buffered snapshot
+    std::uint8_t           m_front     {0};       // snapshot served to clients
+    bool                   m_rendering {false};   // render was requested
+    std::atomic<bool>      m_request   {false};   // render back buffer
+    std::atomic<bool>      m_ready     {false};   // back buffer is rendered
+    std::atomic<bool>      m_running   {true};
+    std::thread            m_thread;
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_METRICS_HPP_
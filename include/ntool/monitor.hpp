@@ -0,0 +1,72 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  monitor.hpp
+ * @brief Continuous monitoring of multiple targets.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_MONITOR_HPP_
+#define _NTOOL_MONITOR_HPP_
+
+#include <ntool/transport.hpp>
+#include <ntool/detect.hpp>
+#include <ntool/output.hpp>
+#include <ntool/series.hpp>
+#include <ntool/routes.hpp>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+/** Monitor options.*/
+struct monitor_options {
+    std::uint32_t   count        {0};     // rounds (0 - until interrupted)
+    double          interval     {1.0};   // delay between rounds in seconds
+    double          timeout      {2.0};   // reply waiting time in seconds
+    bool            quiet        {false}; // print summary only
+    io_backend      io           {io_backend::raw};
+    output_options  output;               // replies output
+    series_config   series;               // RTT history
+    bool            detect       {true};  // report latency & loss anomalies
+    detector_config detector;             // anomaly detection
+    std::uint16_t   metrics      {0};     // exporter port (0 - disabled)
+    bool            engine_stats {false}; // time engine stages
+    bool            huge_pages   {false}; // huge pages for tables & buffers
+    const char      *file        {nullptr};   // target list file
+    const char      *prefixes    {nullptr};   // prefix groups file
+    std::uint8_t    rollup       {0};     // group by /rollup (0 - none)
+    std::uint32_t   trace        {0};     // rounds between traces (0 - none)
+    std::uint8_t    hops         {ROUTE_MAX_HOPS};  // max hops of traces
+};
+
+/**
+ * @brief Probe targets continuously & keep their RTT history.
+ *
+ * @param [in] names - given targets to monitor (without target list file).
+ * @param [in] options - given monitor options.
+ */
+void monitor(const std::vector<const char*>& names, const monitor_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_MONITOR_HPP_
@@ -0,0 +1,277 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  output.hpp
+ * @brief Buffered structured output of probe outcomes.
+ *
+ * Measurement thread only copies records into lock-free ring, formatting
+ * & writes are done by dedicated writer thread in large chunks.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_OUTPUT_HPP_
+#define _NTOOL_OUTPUT_HPP_
+
+#include <ntool/resultlog.hpp>
+#include <ntool/detect.hpp>
+#include <ntool/engine.hpp>
+#include <ntool/store.hpp>
+#include <ntool/feed.hpp>
+#include <ntool/ring.hpp>
+#include <ntool/asn.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+namespace ntool {
+
+/** Output format.*/
+enum class output_format : std::uint8_t {
+    human,  // classic ping & traceroute lines
+    jsonl,  // JSON object per line
+    csv,    // comma separated values with header
+    binary, // result log (see resultlog.hpp)
+};
+
+/** Output options.*/
+struct output_options {
+    output_format format    {output_format::human};
+    const char    *path     {nullptr};          // output file (nullptr - stdout)
+    bool          direct    {false};            // bypass page cache (binary)
+    const char    *store    {nullptr};          // segment store directory
+    std::uint32_t segment   {SEGMENT_SPAN};     // seconds per store segment
+    const char    *feed     {nullptr};          // shared memory feed name
+    std::uint32_t feed_size {FEED_CAPACITY};    // records in feed ring
+    const asn_db  *asn      {nullptr};          // origin AS of routers (trace)
+};
+
+/** Probe outcome or anomaly event queued for output.*/
+struct output_record {
+    probe_result  result;
+    in_addr_t     target;       // target address
+    record_kind   kind;
+    bool          last;         // last query of hop (trace)
+    bool          silent;       // store only, not printed
+    anomaly_event event {};     // detected anomaly (event)
+    std::uint32_t asn   {0};    // origin AS of router (trace, 0 - unknown)
+};
+
+/**
+ * @brief Parse output format name.
+ *
+ * @param [in] name - given format name.
+ * @param [out] format - given object to store format.
+ * @return false if format is unknown.
+ */
+bool parse_format(const char *name, output_format& format) noexcept;
+
+/**
+ * @brief Write string.
+ *
+ * @param [out] p - given output position.
+ * @param [in] str - given null-terminated string.
+ * @return position after written characters.
+ */
+char *format_str(char *p, const char *str) noexcept;
+
+/**
+ * @brief Write unsigned integer.
+ *
+ * @param [out] p - given output position.
+ * @param [in] value - given value.
+ * @return position after written characters.
+ */
+char *format_u64(char *p, std::uint64_t value) noexcept;
+
+/**
+ * @brief Write fixed point number.
+ *
+ * @param [out] p - given output position.
+ * @param [in] value - given value scaled by 10^digits.
+ * @param [in] digits - given number of fraction digits (up to 9).
+ * @return position after written characters.
+ */
+char *format_fixed(char *p, std::uint64_t value, std::uint32_t digits) noexcept;
+
+/**
+ * @brief Write IPv4 address in dotted decimal notation.
+ *
+ * @param [out] p - given output position.
+ * @param [in] addr - given address in network byte order.
+ * @return position after written characters.
+ */
+char *format_ip(char *p, in_addr_t addr) noexcept;
+
+/**
+ * @brief Write record as JSON line.
+ *
+ * @param [out] p - given output position.
+ * @param [in] record - given record.
+ * @return position after written characters.
+ */
+char *format_jsonl(char *p, const output_record& record) noexcept;
+
+/**
+ * @brief Write anomaly event as JSON line.
+ *
+ * @param [out] p - given output position.
+ * @param [in] record - given event record.
+ * @return position after written characters.
+ */
+char *format_event_jsonl(char *p, const output_record& record) noexcept;
+
+/**
+ * @brief Write anomaly event as text line.
+ *
+ * @param [out] p - given output position.
+ * @param [in] record - given event record.
+ * @return position after written characters.
+ */
+char *format_event(char *p, const output_record& record) noexcept;
+
+/**
+ * @brief Write record as CSV line.
+ *
+ * @param [out] p - given output position.
+ * @param [in] record - given record.
+ * @return position after written characters.
+ */
+char *format_csv(char *p, const output_record& record) noexcept;
+
+inline const std::size_t OUTPUT_RING_SIZE   {65536};    // queued records
+inline const std::size_t OUTPUT_BUFFER_SIZE {1 << 16};  // bytes per write
+
+class output_writer {
+public:
+    /**
+     * @brief Open output & start writer thread.
+     *
+     * @param [in] options - given output options.
+     * @param [in] kind - given mode which produces records.
+     * @param [in] targets - given target addresses.
+     */
+    output_writer(const output_options& options, record_kind kind,
+        const std::vector<in_addr_t>& targets) noexcept;
+    ~output_writer(void) noexcept;
+
+    output_writer(const output_writer&)            = delete;
+    output_writer& operator=(const output_writer&) = delete;
+
+    /**
+     * @brief Publish record to shared memory feed & queue it without
+     * blocking.
+     *
+     * @param [in] record - given record.
+     * @return false if ring is full & record was dropped.
+     */
+    bool push(const output_record& record) noexcept;
+
+    /**
+     * @brief Queue record, waiting for free space (offline use).
+     *
+     * @param [in] record - given record.
+     */
+    void push_wait(const output_record& record) noexcept;
+
+    /**
+     * @brief Request anomaly dump of flight recorders, which is written by
+     * writer thread, so probing thread does not wait for it.
+     */
+    void request_dump(void) noexcept;
+
+    /** @brief Write all queued records & stop writer thread.*/
+    void close(void) noexcept;
+
+    /**
+     * @brief Get number of records dropped because of full ring.
+     *
+     * @return dropped records.
+     */
+    std::uint64_t dropped(void) const noexcept;
+
+private:
+    /** @brief Writer thread loop.*/
+    void run(void) noexcept;
+
+    /**
+     * @brief Format record into buffer.
+     *
+     * @param [in] record - given record.
+     */
+    void format(const output_record& record) noexcept;
+
+    /**
+     * @brief Format record as classic ping or traceroute output.
+     *
+     * @param [out] p - given output position.
+     * @param [in] record - given record.
+     * @return position after written characters.
+     */
+    char *format_human(char *p, const output_record& record) noexcept;
+
+    /**
+     * @brief Append ping record to segment store.
+     *
+     * @param [in] record - given record.
+     */
+    void store(const output_record& record) noexcept;
+
+    /** @brief Write buffered bytes.*/
+    void flush(void) noexcept;
+
+    output_options                  m_options;
+    std::int32_t                    m_fd       {-1};
+    std::unique_ptr<log_writer>     m_log;          // binary format
+    std::unique_ptr<segment_writer> m_store;        // segment store
+    std::unique_ptr<feed_writer>    m_feed;         // shared memory feed
+    spsc_ring<output_record>        m_ring;
+    std::thread                     m_thread;
+    std::atomic<bool>               m_running  {true};
+    std::atomic<bool>               m_dump     {false}; // anomaly dump requested
+    std::uint64_t                   m_dropped  {0};
+    std::size_t                     m_size     {0}; // buffered bytes
+    in_addr_t                       m_prev     {0}; // previous router (trace)
+    char                            m_buffer[OUTPUT_BUFFER_SIZE];
+};
+
+/**
+ * @brief Print result log in given format.
+ *
+ * @param [in] path - given result log path.
+ * @param [in] options - given output options.
+ */
+void decode_log(const char *path, const output_options& options) noexcept;
+
+/**
+ * @brief Print records of shared memory feed until its writer finishes.
+ *
+ * @param [in] name - given feed name.
+ * @param [in] options - given output options.
+ */
+void tail_feed(const char *name, const output_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_OUTPUT_HPP_
@@ -28,17 +28,32 @@
 #ifndef _NTOOL_PING_HPP_
 #define _NTOOL_PING_HPP_
 
+#include <ntool/transport.hpp>
+#include <ntool/output.hpp>
+#include <string_view>
 #include <cstdint>
 
 namespace ntool {
 
+/** Ping options.*/
+struct ping_options {
+    std::uint32_t  count        {0};     // number of pings (0 - default)
+    double         interval     {1.0};   // delay between pings in seconds
+    double         timeout      {2.0};   // reply waiting time in seconds
+    bool           quiet        {false}; // print summary only
+    io_backend     io           {io_backend::raw};   // raw socket I/O backend
+    output_options output;                          // replies output
+    bool           engine_stats {false}; // time engine stages
+    bool           huge_pages   {false}; // huge pages for tables & buffers
+};
+
 /**
  * @brief Ping given target.
  *
  * @param [in] target - given target to ping.
- * @param [in] n - given number of ping.
+ * @param [in] options - given ping options.
  */
-void ping(const std::string_view& target, std::uint16_t n) noexcept;
+void ping(const std::string_view& target, const ping_options& options) noexcept;
 
 } // namespace ntool
 
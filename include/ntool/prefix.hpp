@@ -0,0 +1,211 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  prefix.hpp
+ * @brief Longest prefix match table & per-prefix aggregation.
+ *
+ * Table is DIR-24-8: first 24 bits of address index flat array of 2^24
+ * entries, prefixes longer than /24 extend entry into group of 256
+ * entries indexed by last byte. Lookup is one or two array accesses, the
+ * first array is mapped lazily, so only ranges covered by prefixes take
+ * memory. Targets are matched once, replies update statistics of their
+ * group through per-target group index.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_PREFIX_HPP_
+#define _NTOOL_PREFIX_HPP_
+
+#include <ntool/targets.hpp>
+#include <ntool/memory.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace ntool {
+
+inline const std::uint32_t PREFIX_NONE     {UINT32_MAX};    // no matching prefix
+inline const std::uint32_t PREFIX_EXTENDED {1U << 31};      // entry is /25-/32 group
+
+/** Prefix with value returned by lookup.*/
+struct prefix_entry {
+    in_addr_t     network;  // network address (host bits are ignored)
+    std::uint8_t  length;   // prefix length
+    std::uint32_t value;    // value (below PREFIX_EXTENDED - 1)
+};
+
+class prefix_table {
+public:
+    /**
+     * @brief Build table.
+     *
+     * @param [in] prefixes - given prefixes (first one wins among equal ones).
+     * @param [in] huge - given flag to back table by huge pages.
+     */
+    prefix_table(std::vector<prefix_entry> prefixes, bool huge) noexcept;
+
+    /**
+     * @brief Find longest prefix matching address.
+     *
+     * @param [in] addr - given address in network byte order.
+     * @return value of prefix or PREFIX_NONE.
+     */
+    std::uint32_t lookup(in_addr_t addr) const noexcept
+    {
+        auto host  = ntohl(addr);
+        auto entry = m_tbl24[host >> 8];
+
+        if (entry & PREFIX_EXTENDED)
+            entry = m_tbl8[((entry & ~PREFIX_EXTENDED) << 8) | (host & 0xFF)];
+
+        // values are stored + 1, so empty entry wraps to PREFIX_NONE
+        return entry - 1;
+    }
+
+    /**
+     * @brief Get memory used by table.
+     *
+     * @return size in bytes (touched part of first array).
+     */
+    std::size_t memory(void) const noexcept;
+
+private:
+    page_buffer                m_buffer;    // 2^24 entries
+    std::uint32_t              *m_tbl24;
+    std::vector<std::uint32_t> m_tbl8;      // groups of 256 entries
+    std::size_t                m_touched {0};   // filled first array bytes
+};
+
+/** Targets rolled up by prefix groups.*/
+class prefix_groups {
+public:
+    /**
+     * @brief Load prefix file, line is "IP/prefix [group]" (group name is
+     * prefix itself if omitted, prefixes of same group are aggregated).
+     *
+     * @param [in] path - given prefix file path.
+     * @param [in] targets - given target addresses.
+     */
+    prefix_groups(const char *path, const std::vector<in_addr_t>& targets) noexcept;
+
+    /**
+     * @brief Group targets by network of given length.
+     *
+     * @param [in] length - given prefix length.
+     * @param [in] targets - given target addresses.
+     */
+    prefix_groups(std::uint8_t length, const std::vector<in_addr_t>& targets) noexcept;
+
+    /**
+     * @brief Get number of groups.
+     *
+     * @return number of groups.
+     */
+    std::uint32_t size(void) const noexcept
+    {
+        return m_labels.size();
+    }
+
+    /**
+     * @brief Get group of target.
+     *
+     * @param [in] target - given target index.
+     * @return group or PREFIX_NONE.
+     */
+    std::uint32_t group(std::uint32_t target) const noexcept
+    {
+        return m_groups[target];
+    }
+
+    /**
+     * @brief Get group name.
+     *
+     * @param [in] group - given group.
+     * @return name.
+     */
+    const char *label(std::uint32_t group) const noexcept
+    {
+        return m_labels[group].c_str();
+    }
+
+    /**
+     * @brief Get number of targets in group.
+     *
+     * @param [in] group - given group.
+     * @return number of targets.
+     */
+    std::uint32_t targets(std::uint32_t group) const noexcept
+    {
+        return m_targets[group];
+    }
+
+    /**
+     * @brief Get aggregated statistics of group.
+     *
+     * @param [in] group - given group.
+     * @return statistics.
+     */
+    const target_stats& stats(std::uint32_t group) const noexcept
+    {
+        return m_stats[group];
+    }
+
+    /**
+     * @brief Update statistics of target group with probe outcome.
+     *
+     * @param [in] result - given probe outcome.
+     */
+    void update(const probe_result& result) noexcept
+    {
+        auto group = m_groups[result.target];
+
+        if (group != PREFIX_NONE)
+            ntool::update(m_stats[group], result);
+    }
+
+    /**
+     * @brief Get memory used by groups.
+     *
+     * @return size in bytes.
+     */
+    std::size_t memory(void) const noexcept;
+
+private:
+    std::vector<std::uint32_t> m_groups;    // group per target
+    std::vector<target_stats>  m_stats;     // per group
+    std::vector<std::uint32_t> m_targets;   // targets per group
+    std::vector<std::string>   m_labels;
+};
+
+/**
+ * @brief Parse "IP/prefix" notation.
+ *
+ * @param [in] str - given null-terminated string.
+ * @param [out] prefix - given object to store network & length.
+ * @return false if string is not valid prefix.
+ */
+bool parse_prefix(const char *str, prefix_entry& prefix) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_PREFIX_HPP_
@@ -0,0 +1,217 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  probe.hpp
+ * @brief Compile-time specialized probe packets.
+ *
+ * Layout of probe kind (protocol, size & field offsets) is constexpr,
+ * probe<Layout> is instantiated for it. Setting sequence of next probe &
+ * parsing reply are then straight-line code without virtual calls. Only
+ * ICMP echo is sent by engine, as transport is raw ICMP socket.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_PROBE_HPP_
+#define _NTOOL_PROBE_HPP_
+
+#include <ntool/icmp.hpp>
+#include <netinet/ip.h>
+#include <netinet/in.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+
+namespace ntool {
+
+/** ICMP echo request.*/
+struct icmp_echo_layout {
+    static constexpr std::uint8_t  PROTOCOL   {IPPROTO_ICMP};
+    static constexpr std::uint8_t  TYPE       {ICMP_ECHO};         // ICMP type of request
+    static constexpr std::uint8_t  REPLY      {ICMP_ECHOREPLY};    // ICMP type of direct reply
+    static constexpr std::size_t   SIZE       {ICMP_PACKET_SIZE};
+    static constexpr std::size_t   SUM_OFFSET {2};
+    static constexpr std::size_t   ID_OFFSET  {4};  // echo identifier
+    static constexpr std::size_t   SEQ_OFFSET {6};  // echo sequence
+
+    /**
+     * @brief Write header & payload.
+     *
+     * @param [out] packet - given zeroed packet buffer.
+     */
+    static void header(std::uint8_t *packet) noexcept
+    {
+        icmphdr hdr {};
+        hdr.type = TYPE;
+        set_packet(packet, hdr);
+    }
+};
+
+/**
+ * Prebuilt probe packet. Header is written once, so next probe costs only
+ * sequence store & incremental checksum update (RFC 1624).
+ */
+template <typename Layout>
+class probe {
+public:
+    static constexpr std::uint8_t PROTOCOL {Layout::PROTOCOL};
+    static constexpr std::size_t  SIZE     {Layout::SIZE};
+
+    static_assert(std::max(Layout::ID_OFFSET, Layout::SEQ_OFFSET) + 2 <= 8,
+        "identity must be in first 8 bytes quoted by ICMP errors");
+
+    /**
+     * @brief Build probe.
+     *
+     * @param [in] id - given probe identifier.
+     */
+    void init(std::uint16_t id) noexcept
+    {
+        std::memset(m_packet, 0, sizeof(m_packet));
+        Layout::header(m_packet);
+
+        std::memset(m_packet + Layout::SUM_OFFSET, 0, 2);
+        std::memcpy(m_packet + Layout::ID_OFFSET, &id, sizeof(id));
+
+        // stored sum is complemented checksum of probe with sequence = 0
+        m_sum = static_cast<std::uint16_t>(~checksum(m_packet, SIZE));
+    }
+
+    /**
+     * @brief Set sequence of next probe.
+     *
+     * @param [in] seq - given sequence number.
+     */
+    void set(std::uint16_t seq) noexcept
+    {
+        std::memcpy(m_packet + Layout::SEQ_OFFSET, &seq, sizeof(seq));
+
+        std::uint16_t result = ~fold(static_cast<std::uint32_t>(m_sum) + seq);
+        std::memcpy(m_packet + Layout::SUM_OFFSET, &result, sizeof(result));
+    }
+
+    /**
+     * @brief Get probe packet.
+     *
+     * @return SIZE bytes of packet (without IP header).
+     */
+    const std::uint8_t *packet(void) const noexcept
+    {
+        return m_packet;
+    }
+
+    /**
+     * @brief Parse received ICMP packet as reply to probe of this kind.
+     *
+     * Direct reply carries probe identity itself. Time exceeded & destination
+     * unreachable carry it inside quoted original IP & transport headers.
+     *
+     * @param [in] packet - given received packet (IP header included).
+     * @param [in] size - given received packet size in bytes.
+     * @param [out] info - given object to store reply info.
+     * @return true if packet is reply to probe of this kind, false otherwise.
+     */
+    static bool parse(const std::uint8_t *packet, std::size_t size, reply_info& info) noexcept
+    {
+        iphdr   ip_hdr;
+        icmphdr icmp_hdr;
+
+        if (size < sizeof(iphdr))
+            return false;
+
+        std::memcpy(&ip_hdr, packet, sizeof(ip_hdr));
+        std::size_t offset = ip_hdr.ihl * 4;
+
+        if (ip_hdr.protocol != IPPROTO_ICMP || size < offset + sizeof(icmphdr))
+            return false;
+
+        std::memcpy(&icmp_hdr, packet + offset, sizeof(icmp_hdr));
+
+        info.type   = icmp_hdr.type;
+        info.code   = icmp_hdr.code;
+        info.ttl    = ip_hdr.ttl;
+        info.from   = ip_hdr.saddr;
+        info.target = ip_hdr.saddr;
+
+        if (icmp_hdr.type == Layout::REPLY) {
+            identify(packet + offset, info);
+            return true;
+        }
+
+        // echo requests (seen on loopback) & other messages
+        if (icmp_hdr.type != ICMP_TIME_EXCEEDED && icmp_hdr.type != ICMP_DEST_UNREACH)
+            return false;
+
+        // handle quoted original datagram
+        iphdr quoted_ip;
+        offset += sizeof(icmphdr);
+
+        if (size < offset + sizeof(iphdr))
+            return false;
+
+        std::memcpy(&quoted_ip, packet + offset, sizeof(quoted_ip));
+        offset += quoted_ip.ihl * 4;
+
+        if (quoted_ip.protocol != PROTOCOL || size < offset + 8 ||
+            packet[offset] != Layout::TYPE)
+            return false;
+
+        identify(packet + offset, info);
+        info.target = quoted_ip.daddr;
+
+        return true;
+    }
+
+private:
+    /**
+     * @brief Read probe identity from transport header.
+     *
+     * @param [in] header - given transport header of probe or reply.
+     * @param [out] info - given object to store identifier & sequence.
+     */
+    static void identify(const std::uint8_t *header, reply_info& info) noexcept
+    {
+        std::memcpy(&info.id, header + Layout::ID_OFFSET, sizeof(info.id));
+        std::memcpy(&info.seq, header + Layout::SEQ_OFFSET, sizeof(info.seq));
+    }
+
+    /**
+     * @brief Fold 32-bit sum into 16 bits.
+     *
+     * @param [in] sum - given sum.
+     * @return folded sum.
+     */
+    static std::uint16_t fold(std::uint32_t sum) noexcept
+    {
+        sum = (sum >> 0x10) + (sum & 0xFFFF);
+        sum += (sum >> 0x10);
+        return static_cast<std::uint16_t>(sum);
+    }
+
+    std::uint8_t  m_packet[SIZE];
+    std::uint16_t m_sum {0};    // folded sum with sequence = 0
+};
+
+using icmp_echo = probe<icmp_echo_layout>;
+
+} // namespace ntool
+
+#endif // _NTOOL_PROBE_HPP_
@@ -0,0 +1,188 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  recorder.hpp
+ * @brief Flight recorder of engine events for post-mortem analysis.
+ *
+ * Every probing thread appends compact binary events (probe sent, reply,
+ * timeout, send error, ...) into its own lock-free ring. Recording is
+ * always on: event reuses timestamp which engine has already taken, so
+ * it costs single store of 24 bytes. Rings are dumped to file on SIGUSR1,
+ * fatal error or signal & detected anomaly, and dump is converted to
+ * Chrome trace (Perfetto) JSON to see what engine did around incident.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_RECORDER_HPP_
+#define _NTOOL_RECORDER_HPP_
+
+#include <netinet/in.h>
+#include <cstdint>
+#include <atomic>
+
+
+namespace ntool {
+
+struct output_options;
+
+inline const char          FLIGHT_MAGIC[8]  {'N', 'T', 'O', 'O', 'L', 'F', 'L', 'T'};
+inline const std::uint16_t FLIGHT_VERSION   {1};
+inline const std::uint64_t FLIGHT_CAPACITY  {65536};        // events per thread
+inline const std::uint32_t FLIGHT_THREADS   {16};           // dumped threads
+inline const std::uint64_t FLIGHT_DUMP_GAP  {60000000000};  // anomaly dumps gap
+inline const char          *FLIGHT_DIR      {"/tmp"};       // dump directory
+
+/** Recorded event.*/
+enum class flight_event : std::uint8_t {
+    sent,       // probe sent
+    reply,      // reply matched to probe (value - RTT in microseconds)
+    timeout,    // probe unanswered
+    send_error, // probe dropped by transport (value - errno)
+    foreign,    // reply not matching any probe in flight
+    stall,      // send delayed by full in-flight table
+    anomaly,    // anomaly detected (value - anomaly_kind)
+};
+
+/** Recorder entry.*/
+struct flight_entry {
+    std::uint64_t time_ns;      // event time (CLOCK_MONOTONIC)
+    in_addr_t     addr;         // target or reply source address
+    std::uint32_t seq;          // probe sequence of target
+    std::uint32_t value;        // event specific value
+    flight_event  kind;
+    std::uint8_t  ttl;          // probe time to live
+    std::uint8_t  reserved[2];
+};
+
+static_assert(sizeof(flight_entry) == 24);
+
+/** Dump reason.*/
+enum class flight_reason : std::uint8_t {
+    signal,     // SIGUSR1
+    error,      // fatal error
+    crash,      // fatal signal
+    anomaly,    // detected anomaly
+};
+
+/** Dump file header, followed by threads.*/
+struct flight_file_header {
+    char          magic[8];     // FLIGHT_MAGIC
+    std::uint16_t version;      // FLIGHT_VERSION
+    std::uint16_t entry_size;   // sizeof(flight_entry)
+    std::uint16_t threads;      // dumped threads
+    std::uint8_t  reason;       // flight_reason
+    std::uint8_t  reserved;
+    std::uint64_t dump_ns;      // CLOCK_MONOTONIC of dump
+    std::uint64_t wall_ns;      // CLOCK_REALTIME of dump
+    std::uint32_t pid;          // process identifier
+    std::uint32_t reserved2;
+};
+
+/** Dumped thread header, followed by entries from oldest.*/
+struct flight_thread_header {
+    std::uint32_t tid;          // thread identifier
+    std::uint32_t reserved;
+    std::uint64_t count;        // entries
+};
+
+/** Single writer ring of events of one thread.*/
+class flight_recorder {
+public:
+    /**
+     * @brief Get recorder of calling thread, creating it on first use.
+     *
+     * @return recorder.
+     */
+    static flight_recorder& local(void) noexcept;
+
+    flight_recorder(const flight_recorder&)            = delete;
+    flight_recorder& operator=(const flight_recorder&) = delete;
+
+    /**
+     * @brief Record event.
+     *
+     * @param [in] kind - given event.
+     * @param [in] time_ns - given event time.
+     * @param [in] addr - given target or reply source address.
+     * @param [in] seq - given probe sequence.
+     * @param [in] ttl - given probe time to live.
+     * @param [in] value - given event specific value.
+     */
+    void record(flight_event kind, std::uint64_t time_ns, in_addr_t addr,
+        std::uint32_t seq, std::uint8_t ttl, std::uint32_t value = 0) noexcept
+    {
+        auto head  = m_head.load(std::memory_order_relaxed);
+        auto& e    = m_entries[head & (FLIGHT_CAPACITY - 1)];
+        e.time_ns  = time_ns;
+        e.addr     = addr;
+        e.seq      = seq;
+        e.value    = value;
+        e.kind     = kind;
+        e.ttl      = ttl;
+
+        // dumping signal handler sees only complete entries
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Write events from oldest (async-signal-safe).
+     *
+     * @param [in] fd - given file descriptor.
+     * @return false in case of write error.
+     */
+    bool dump(std::int32_t fd) const noexcept;
+
+private:
+    flight_recorder(void) noexcept = default;
+
+    flight_entry               m_entries[FLIGHT_CAPACITY];
+    std::atomic<std::uint64_t> m_head {0};  // next position
+    std::uint32_t              m_tid  {0};  // owner thread identifier
+};
+
+/**
+ * @brief Set dump directory & dump recorders on SIGUSR1, fatal error &
+ * fatal signal.
+ *
+ * @param [in] dir - given dump directory.
+ */
+void flight_install(const char *dir) noexcept;
+
+/**
+ * @brief Dump recorders of all threads to new file (async-signal-safe).
+ * Anomaly dumps are done at most once per FLIGHT_DUMP_GAP.
+ *
+ * @param [in] reason - given dump reason.
+ * @return false if recorder was not dumped.
+ */
+bool flight_dump(flight_reason reason) noexcept;
+
+/**
+ * @brief Convert recorder dump to Chrome trace JSON.
+ *
+ * @param [in] path - given dump path.
+ * @param [in] options - given output options (path).
+ */
+void flight_convert(const char *path, const output_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_RECORDER_HPP_
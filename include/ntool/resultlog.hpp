@@ -0,0 +1,252 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  resultlog.hpp
+ * @brief Binary archive of probe outcomes.
+ *
+ * File layout (all integers little-endian):
+ *
+ *   log_header | target addresses | padding | log_record ...
+ *
+ * Records start at 64 byte aligned offset & have fixed size, so mapped
+ * file is read as plain array without any parsing or copying.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_RESULTLOG_HPP_
+#define _NTOOL_RESULTLOG_HPP_
+
+#include <ntool/engine.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <bit>
+
+
+namespace ntool {
+
+/** Mode which produced records.*/
+enum class record_kind : std::uint8_t {
+    ping,
+    trace,
+    event,  // anomaly event (output only, not logged)
+};
+
+inline const char          LOG_MAGIC[8]  {'N', 'T', 'O', 'O', 'L', 'L', 'O', 'G'};
+inline const std::uint16_t LOG_VERSION   {1};
+inline const std::size_t   LOG_ALIGNMENT {64};     // records offset alignment
+
+/** Result log file header.*/
+struct log_header {
+    char          magic[8];         // LOG_MAGIC
+    std::uint16_t version;          // LOG_VERSION
+    std::uint16_t header_size;      // sizeof(log_header)
+    std::uint16_t record_size;      // sizeof(log_record)
+    std::uint8_t  mode;             // record_kind
+    std::uint8_t  reserved0;
+    std::uint32_t targets;          // number of target addresses
+    std::uint32_t reserved1;
+    std::uint64_t records_offset;   // first record offset
+    std::uint64_t records;          // number of records (0 - until end of file)
+    std::uint64_t created_ns;       // creation time (CLOCK_REALTIME)
+    std::uint64_t clock_ns;         // creation time (CLOCK_MONOTONIC)
+    std::uint64_t reserved2;
+};
+
+/** Single probe outcome record.*/
+struct log_record {
+    std::uint64_t send_ns;      // probe send time (CLOCK_MONOTONIC)
+    std::uint64_t recv_ns;      // reply receive time (0 - timeout)
+    std::uint32_t target;       // index in target table
+    std::uint32_t seq;          // probe sequence of target (from 1)
+    in_addr_t     from;         // reply source address (network order)
+    std::uint8_t  ttl;          // probe time to live (hop for trace)
+    std::uint8_t  reply_ttl;    // time to live of reply
+    std::uint8_t  type;         // reply ICMP type
+    std::uint8_t  code;         // reply ICMP sub-code
+};
+
+static_assert(sizeof(log_header) == 64);
+static_assert(sizeof(log_record) == 32);
+
+/**
+ * @brief Convert between host & little-endian byte order.
+ *
+ * @param [in] value - given value.
+ * @return converted value.
+ */
+template <typename T>
+constexpr T le(T value) noexcept
+{
+    if constexpr (std::endian::native == std::endian::big)
+        return std::byteswap(value);
+    else
+        return value;
+}
+
+/**
+ * @brief Convert probe outcome to log record.
+ *
+ * @param [in] result - given probe outcome.
+ * @return log record.
+ */
+log_record to_record(const probe_result& result) noexcept;
+
+/**
+ * @brief Convert log record to probe outcome.
+ *
+ * @param [in] record - given log record.
+ * @return probe outcome.
+ */
+probe_result to_result(const log_record& record) noexcept;
+
+inline const std::size_t LOG_BUFFER_SIZE {1 << 20};    // bytes per append
+inline const std::size_t LOG_BLOCK_SIZE  {4096};       // O_DIRECT alignment
+
+class log_writer {
+public:
+    /**
+     * @brief Write log header & target table.
+     *
+     * @param [in] fd - given output file descriptor.
+     * @param [in] mode - given mode which produces records.
+     * @param [in] targets - given target addresses.
+     * @param [in] direct - given flag to bypass page cache (O_DIRECT).
+     */
+    log_writer(std::int32_t fd, record_kind mode,
+        const std::vector<in_addr_t>& targets, bool direct) noexcept;
+    ~log_writer(void) noexcept;
+
+    log_writer(const log_writer&)            = delete;
+    log_writer& operator=(const log_writer&) = delete;
+
+    /**
+     * @brief Append probe outcome.
+     *
+     * @param [in] result - given probe outcome.
+     */
+    void append(const probe_result& result) noexcept;
+
+    /** @brief Write buffered records & update header record count.*/
+    void close(void) noexcept;
+
+    /**
+     * @brief Get number of appended records.
+     *
+     * @return number of records.
+     */
+    std::uint64_t records(void) const noexcept;
+
+private:
+    /**
+     * @brief Write buffered bytes.
+     *
+     * @param [in] size - given number of bytes to write.
+     */
+    void write_buffer(std::size_t size) noexcept;
+
+    std::int32_t  m_fd      {-1};
+    bool          m_direct  {false};
+    bool          m_closed  {false};
+    std::uint8_t  *m_buffer {nullptr};  // LOG_BLOCK_SIZE aligned
+    std::size_t   m_size    {0};        // buffered bytes
+    std::uint64_t m_records {0};
+};
+
+class log_reader {
+public:
+    log_reader(void) noexcept = default;
+    ~log_reader(void) noexcept;
+
+    log_reader(const log_reader&)            = delete;
+    log_reader& operator=(const log_reader&) = delete;
+
+    /**
+     * @brief Map log file read-only & validate header.
+     *
+     * @param [in] path - given log file path.
+     * @return false if file cannot be mapped or is not a result log.
+     */
+    bool open(const char *path) noexcept;
+
+    /**
+     * @brief Get log header.
+     *
+     * @return log header.
+     */
+    const log_header& header(void) const noexcept;
+
+    /**
+     * @brief Get target table.
+     *
+     * @return target addresses (network order).
+     */
+    std::span<const in_addr_t> targets(void) const noexcept;
+
+    /**
+     * @brief Get records without copying.
+     *
+     * @return mapped records.
+     */
+    std::span<const log_record> records(void) const noexcept;
+
+private:
+    const std::uint8_t *m_data {nullptr};
+    std::size_t        m_size  {0};
+};
+
+/**
+ * @brief Visit records of trace log, marking first record of each trace.
+ *
+ * Log holds traces one after another, each in hop order, so new trace
+ * starts when target changes or TTL decreases. Records of targets out of
+ * target table are skipped.
+ *
+ * @param [in] log - given opened trace log.
+ * @param [in] visit - given function called with record index, probe
+ * outcome & flag of first record of trace.
+ */
+template <typename F>
+void for_each_trace_record(const log_reader& log, F&& visit) noexcept
+{
+    auto targets         = log.targets();
+    auto records         = log.records();
+    std::uint32_t target = UINT32_MAX;
+    std::uint8_t ttl     = 0;
+
+    for (std::uint64_t i = 0; i < records.size(); i++) {
+        auto result = to_result(records[i]);
+
+        if (result.target >= targets.size())
+            continue;
+
+        bool first = result.target != target || result.ttl < ttl;
+        target     = result.target;
+        ttl        = result.ttl;
+
+        visit(i, result, first);
+    }
+}
+
+} // namespace ntool
+
+#endif // _NTOOL_RESULTLOG_HPP_
@@ -0,0 +1,141 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  ring.hpp
+ * @brief Lock-free single producer single consumer ring.
+ *
+ * Producer & consumer positions are free-running counters on separate
+ * cache lines, each side caches the other one's position, so the shared
+ * line is touched only when ring looks full (or empty).
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_RING_HPP_
+#define _NTOOL_RING_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <bit>
+
+
+namespace ntool {
+
+inline const std::size_t CACHE_LINE_SIZE {64};
+
+template <typename T>
+class spsc_ring {
+public:
+    /**
+     * @brief Construct ring.
+     *
+     * @param [in] capacity - given min number of elements.
+     */
+    explicit spsc_ring(std::size_t capacity) noexcept
+        : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+          m_mask(m_slots.size() - 1)
+    {}
+
+    spsc_ring(const spsc_ring&)            = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    /**
+     * @brief Append element (producer side).
+     *
+     * @param [in] value - given element.
+     * @return false if ring is full.
+     */
+    bool push(const T& value) noexcept
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+
+        if (head - m_tail_cache > m_mask) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+            if (head - m_tail_cache > m_mask)
+                return false;
+        }
+
+        m_slots[head & m_mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief Take oldest element (consumer side).
+     *
+     * @param [out] value - given object to store element.
+     * @return false if ring is empty.
+     */
+    bool pop(T& value) noexcept
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail == m_head_cache) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+
+            if (tail == m_head_cache)
+                return false;
+        }
+
+        value = m_slots[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief Get number of queued elements (approximate).
+     *
+     * @return number of elements.
+     */
+    std::size_t size(void) const noexcept
+    {
+        return m_head.load(std::memory_order_relaxed) -
+            m_tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get ring capacity.
+     *
+     * @return max number of elements.
+     */
+    std::size_t capacity(void) const noexcept
+    {
+        return m_slots.size();
+    }
+
+private:
+    std::vector<T> m_slots;
+    std::size_t    m_mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head {0};
+    std::size_t m_tail_cache {0};   // producer copy of m_tail
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail {0};
+    std::size_t m_head_cache {0};   // consumer copy of m_head
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_RING_HPP_
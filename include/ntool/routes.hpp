@@ -0,0 +1,130 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  routes.hpp
+ * @brief Route change detection with path fingerprints.
+ *
+ * Paths of all targets are traced once in parallel & reduced to their
+ * ordered hop lists with fingerprint hash. Then every round sends only a
+ * few probes per target with rotating TTL & compares repliers with stored
+ * hops. Only targets with unexpected replier are traced again (also in
+ * parallel), their new fingerprint tells whether route changed.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_ROUTES_HPP_
+#define _NTOOL_ROUTES_HPP_
+
+#include <ntool/transport.hpp>
+#include <ntool/engine.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+namespace ntool {
+
+inline const std::uint8_t  ROUTE_MAX_HOPS   {30};
+inline const std::uint8_t  ROUTE_WIDTH      {4};        // routers kept per hop
+inline const std::uint8_t  ROUTE_SAMPLES    {2};        // TTLs sampled per round
+inline const std::uint32_t ROUTE_TRACE_RATE {100000};   // full trace probes per second
+
+/** Traced path of target.*/
+struct route {
+    in_addr_t     hops[ROUTE_MAX_HOPS][ROUTE_WIDTH];    // routers of hop (0 - none)
+    std::uint64_t fingerprint;  // hash of ordered hop list
+    std::uint8_t  length;       // hops up to destination or last reply
+    bool          reached;      // destination replied
+};
+
+/** Route monitor options.*/
+struct route_options {
+    std::uint32_t count    {0};     // sampling rounds (0 - until interrupted)
+    double        interval {1.0};   // delay between rounds in seconds
+    double        timeout  {2.0};   // reply waiting time in seconds
+    std::uint8_t  hops     {ROUTE_MAX_HOPS};    // max hops of full trace
+    std::uint8_t  queries  {3};     // queries per hop of full trace
+    std::uint8_t  samples  {ROUTE_SAMPLES};     // TTLs sampled per target & round
+    io_backend    io       {io_backend::raw};
+    const char    *file    {nullptr};   // target list file
+};
+
+/**
+ * @brief Add probe outcome of full trace to route.
+ *
+ * @param [in,out] r - given route.
+ * @param [in] result - given probe outcome.
+ * @param [in] target - given target address.
+ */
+void route_add(route& r, const probe_result& result, in_addr_t target) noexcept;
+
+/**
+ * @brief Finish route after all its outcomes were added: cut it at
+ * destination or last hop which replied & compute its fingerprint.
+ *
+ * @param [in,out] r - given route.
+ */
+void route_finish(route& r) noexcept;
+
+/**
+ * @brief Compute fingerprint of route from its ordered hop list.
+ *
+ * @param [in] r - given route.
+ * @return fingerprint.
+ */
+std::uint64_t route_fingerprint(const route& r) noexcept;
+
+/**
+ * @brief Check whether reply of sampled probe agrees with route.
+ *
+ * @param [in] r - given route.
+ * @param [in] ttl - given probe time to live.
+ * @param [in] from - given replying router.
+ * @param [in] target - given target address.
+ * @return false if replier differs from stored routers of hop.
+ */
+bool route_expects(const route& r, std::uint8_t ttl, in_addr_t from, in_addr_t target) noexcept;
+
+/**
+ * @brief Compare new trace of path with stored route. Changed route is
+ * printed & replaced, otherwise routers of new trace are remembered
+ * (load balanced or anonymous hops).
+ *
+ * @param [in] stream - given output stream.
+ * @param [in] target - given target address.
+ * @param [in,out] old - given stored route.
+ * @param [in] now - given route of new trace.
+ * @return true if route changed.
+ */
+bool route_update(std::FILE *stream, in_addr_t target, route& old, const route& now) noexcept;
+
+/**
+ * @brief Trace targets & report route changes found by sampled probes.
+ *
+ * @param [in] names - given targets (without target list file).
+ * @param [in] options - given route monitor options.
+ */
+void monitor_routes(const std::vector<const char*>& names, const route_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_ROUTES_HPP_
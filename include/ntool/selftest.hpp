@@ -0,0 +1,54 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  selftest.hpp
+ * @brief Measurement capacity self test.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_SELFTEST_HPP_
+#define _NTOOL_SELFTEST_HPP_
+
+#include <cstdint>
+
+
+namespace ntool {
+
+/** Capacity self test options.*/
+struct selftest_options {
+    double duration  {1.0};     // seconds per rate step
+    double timeout   {1.0};     // reply waiting time in seconds
+    double max_loss  {0.1};     // allowed loss in percents
+    double max_error {0.5};     // allowed RTT error in milliseconds
+};
+
+/**
+ * @brief Probe target at increasing rates with every I/O backend & print
+ * highest rate at which ntool adds less than allowed loss & RTT error.
+ *
+ * @param [in] target - given target (loopback or namespace peer).
+ * @param [in] options - given self test options.
+ */
+void selftest_capacity(const char *target, const selftest_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_SELFTEST_HPP_
@@ -0,0 +1,204 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  series.hpp
+ * @brief Compressed in-memory RTT time series.
+ *
+ * Samples are encoded Gorilla-style: timestamps as delta-of-delta with
+ * variable length buckets, values as XOR with previous value, storing
+ * only meaningful bits. Every target owns a circular list of fixed size
+ * blocks taken from shared slab pool. Blocks are recycled once all their
+ * samples are older than retention, so memory follows actual bits per
+ * sample instead of estimate, & appending is O(1). Optional memory limit
+ * makes targets recycle their oldest blocks early instead of growing.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_SERIES_HPP_
+#define _NTOOL_SERIES_HPP_
+
+#include <ntool/memory.hpp>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+/** Time series store configuration.*/
+struct series_config {
+    double      retention  {3600.0};  // seconds of history to keep
+    double      resolution {0.01};    // RTT resolution in milliseconds
+    std::size_t memory     {0};       // max bytes of blocks (0 - no limit)
+};
+
+/** Decoded sample.*/
+struct series_point {
+    std::int64_t time_ms;   // sample time in milliseconds
+    double       rtt;       // RTT in milliseconds (NaN - lost probe)
+};
+
+inline const std::size_t SERIES_BLOCK_WORDS {29};      // 256 byte blocks
+inline const std::size_t SERIES_SLAB_BLOCKS {8192};    // 2 MB slabs
+
+/** Compressed block of consecutive samples.*/
+struct series_block {
+    std::int64_t  start_ms;                     // first sample time
+    std::uint16_t count;                        // number of samples
+    std::uint16_t bits;                         // used bits
+    series_block  *next;                        // next newer block (newest
+                                                // block - oldest one)
+    std::uint64_t words[SERIES_BLOCK_WORDS];    // MSB-first bit stream
+};
+
+/** Encoder state of target.*/
+struct series_state {
+    series_block  *last;        // newest block (nullptr - no samples)
+    std::int64_t  prev_time;    // previous sample time
+    std::int64_t  prev_delta;   // previous time delta
+    std::uint64_t prev_value;   // previous value bits
+    std::uint8_t  leading;      // XOR window leading zeros
+    std::uint8_t  trailing;     // XOR window trailing zeros
+};
+
+class series_store {
+public:
+    /**
+     * @brief Construct empty store.
+     *
+     * @param [in] targets - given number of targets.
+     * @param [in] config - given store configuration.
+     */
+    series_store(std::uint32_t targets, const series_config& config) noexcept;
+
+    /**
+     * @brief Append sample.
+     *
+     * @param [in] target - given target index.
+     * @param [in] time_ms - given sample time in milliseconds.
+     * @param [in] rtt - given RTT in milliseconds (NaN - lost probe).
+     */
+    void append(std::uint32_t target, std::int64_t time_ms, double rtt) noexcept;
+
+    /**
+     * @brief Get store configuration.
+     *
+     * @return store configuration.
+     */
+    const series_config& config(void) const noexcept;
+
+    /**
+     * @brief Get memory used by blocks (peak, slabs are not unmapped).
+     *
+     * @return size in bytes.
+     */
+    std::size_t memory(void) const noexcept;
+
+    /**
+     * @brief Get history kept by target with shortest one.
+     *
+     * @return seconds of history (at most retention).
+     */
+    double coverage(void) const noexcept;
+
+    /**
+     * @brief Get number of samples kept in blocks.
+     *
+     * @return number of samples.
+     */
+    std::uint64_t samples(void) const noexcept;
+
+    /**
+     * @brief Get number of bits used by encoded samples.
+     *
+     * @return number of bits.
+     */
+    std::uint64_t encoded_bits(void) const noexcept;
+
+private:
+    friend class series_decoder;
+
+    /**
+     * @brief Start new block of target, recycling its expired blocks.
+     *
+     * @param [in,out] state - given target state.
+     * @param [in] time_ms - given first sample time.
+     * @return zeroed block.
+     */
+    series_block& start_block(series_state& state, std::int64_t time_ms) noexcept;
+
+    /**
+     * @brief Return oldest block of target to pool.
+     *
+     * @param [in,out] state - given target state with blocks.
+     */
+    void release_oldest(series_state& state) noexcept;
+
+    series_config             m_config;
+    slab_pool                 m_pool;
+    std::size_t               m_limit  {0};    // max blocks (0 - no limit)
+    std::size_t               m_blocks {0};    // blocks in use
+    std::size_t               m_peak   {0};    // max blocks in use
+    std::vector<series_state> m_states;
+};
+
+/** Sequential decoder of target samples (oldest first).*/
+class series_decoder {
+public:
+    /**
+     * @brief Start decoding.
+     *
+     * @param [in] store - given time series store.
+     * @param [in] target - given target index.
+     */
+    series_decoder(const series_store& store, std::uint32_t target) noexcept;
+
+    /**
+     * @brief Decode next sample.
+     *
+     * @param [out] point - given object to store sample.
+     * @return false if there are no more samples.
+     */
+    bool next(series_point& point) noexcept;
+
+private:
+    /**
+     * @brief Read bits from current block.
+     *
+     * @param [in] count - given number of bits (up to 64).
+     * @return bits value.
+     */
+    std::uint64_t read(std::uint32_t count) noexcept;
+
+    const series_store  &m_store;
+    const series_block  *m_block      {nullptr};
+    std::uint32_t       m_target;
+    std::uint32_t       m_remaining   {0};    // samples left in block
+    std::uint32_t       m_pos         {0};    // bit position in block
+    std::int64_t        m_prev_time   {0};
+    std::int64_t        m_prev_delta  {0};
+    std::uint64_t       m_prev_value  {0};
+    std::uint8_t        m_leading     {0};
+    std::uint8_t        m_trailing    {0};
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_SERIES_HPP_
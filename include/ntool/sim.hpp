@@ -0,0 +1,177 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  sim.hpp
+ * @brief Deterministic in-process network simulator.
+ *
+ * Simulated transport answers probes on virtual clock according to
+ * per-target latency & loss model and router path, so engine scheduling,
+ * timeouts & reply matching can be tested at any scale and every run with
+ * the same seed is reproduced exactly.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_SIM_HPP_
+#define _NTOOL_SIM_HPP_
+
+#include <ntool/transport.hpp>
+#include <unordered_map>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+/** Latency & loss model of simulated target.*/
+struct sim_model {
+    std::uint64_t rtt_ns    {10000000};    // base round-trip time to target
+    std::uint64_t jitter_ns {0};           // mean of exponential jitter
+    double        loss      {0.0};         // probability of probe loss
+    double        duplicate {0.0};         // probability of duplicated reply
+    double        reorder   {0.0};         // probability of late reply
+};
+
+/** Simulator counters.*/
+struct sim_counters {
+    std::uint64_t probes;       // received probes
+    std::uint64_t dropped;      // lost probes (model loss or unknown target)
+    std::uint64_t replies;      // delivered replies
+};
+
+/** Parameters of generated topology.*/
+struct sim_topology {
+    std::uint32_t targets    {1000};        // number of targets
+    std::uint32_t min_hops   {4};           // min routers to target
+    std::uint32_t max_hops   {12};          // max routers to target
+    std::uint64_t min_rtt_ns {1000000};     // min base RTT of target
+    std::uint64_t max_rtt_ns {200000000};   // max base RTT of target
+    sim_model     model;                    // jitter, loss, etc. of targets
+    std::uint64_t seed       {1};           // generator seed
+};
+
+class sim_transport;
+
+/**
+ * @brief Populate simulator with tree-like router topology.
+ *
+ * Targets are 10.0.0.1 onwards, routers of level k are 172.(16+k).x.y, so
+ * targets share nearest routers & diverge further away.
+ *
+ * @param [in,out] sim - given simulator.
+ * @param [in] topology - given topology parameters.
+ * @return target addresses.
+ */
+std::vector<in_addr_t> generate_topology(sim_transport& sim,
+    const sim_topology& topology) noexcept;
+
+class sim_transport final : public transport {
+public:
+    /**
+     * @brief Construct simulator.
+     *
+     * @param [in] seed - given random generator seed.
+     */
+    explicit sim_transport(std::uint64_t seed) noexcept;
+
+    /**
+     * @brief Add router which answers expired probes with time exceeded.
+     *
+     * @param [in] addr - given router address.
+     * @return router index.
+     */
+    std::uint32_t add_router(in_addr_t addr) noexcept;
+
+    /**
+     * @brief Add target reachable through given routers.
+     *
+     * @param [in] addr - given target address.
+     * @param [in] model - given latency & loss model.
+     * @param [in] path - given router indexes from nearest one.
+     * @param [in] hops - given number of routers in path.
+     */
+    void add_target(in_addr_t addr, const sim_model& model,
+        const std::uint32_t *path, std::size_t hops) noexcept;
+
+    /**
+     * @brief Get simulator counters.
+     *
+     * @return simulator counters.
+     */
+    const sim_counters& counters(void) const noexcept;
+
+    std::uint64_t now(void) noexcept override;
+
+    bool send(in_addr_t dst, std::uint8_t ttl, const std::uint8_t *packet,
+        std::size_t size) noexcept override;
+
+    std::ptrdiff_t recv(std::uint8_t *buffer, std::size_t size,
+        std::uint64_t& time) noexcept override;
+
+    void wait(std::uint64_t deadline) noexcept override;
+
+private:
+    /** Simulated target.*/
+    struct sim_target {
+        in_addr_t     addr;
+        sim_model     model;
+        std::uint32_t path;     // offset of path in m_paths
+        std::uint32_t hops;     // number of routers in path
+    };
+
+    /** Reply scheduled for delivery.*/
+    struct delivery {
+        std::uint64_t time;     // arrival time
+        std::uint64_t order;    // tie breaker keeping FIFO order
+        in_addr_t     from;     // reply source
+        in_addr_t     dst;      // probe destination
+        std::uint8_t  type;     // reply ICMP type
+        std::uint8_t  ttl;      // reply time to live
+        std::uint8_t  probe[8]; // probe ICMP header
+    };
+
+    /**
+     * @brief Schedule reply delivery.
+     *
+     * @param [in] d - given delivery with unset order.
+     */
+    void schedule(delivery d) noexcept;
+
+    /**
+     * @brief Get uniform random number in [0, 1).
+     *
+     * @return random number.
+     */
+    double uniform(void) noexcept;
+
+    std::unordered_map<in_addr_t, std::uint32_t> m_index;
+    std::vector<sim_target>     m_targets;
+    std::vector<in_addr_t>      m_routers;
+    std::vector<std::uint32_t>  m_paths;
+    std::vector<delivery>       m_queue;        // min-heap by arrival time
+    std::uint64_t               m_now   {0};    // virtual clock
+    std::uint64_t               m_order {0};
+    std::uint64_t               m_state;        // random generator state
+    sim_counters                m_counters {};
+};
+
+} // namespace ntool
+
+#endif // _NTOOL_SIM_HPP_
@@ -0,0 +1,154 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  store.hpp
+ * @brief Append-only segmented measurement store.
+ *
+ * Results are buffered in memory & written as immutable segment files
+ * named by their time range (<first_ms>-<last_ms>-<n>.nts), so queries
+ * skip unrelated segments without opening them. Segment layout:
+ *
+ *   segment_header | target dictionary | block index | columns
+ *
+ * Rows are sorted by time, block index keeps time range of every
+ * SEGMENT_BLOCK_ROWS rows. Columns are stored with the narrowest fixed
+ * width fitting segment values (time as offset from segment start,
+ * target as dictionary index, RTT in microseconds), so they are scanned
+ * in place with simple loops the compiler vectorizes.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_STORE_HPP_
+#define _NTOOL_STORE_HPP_
+
+#include <netinet/in.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace ntool {
+
+inline const char          SEGMENT_MAGIC[8]    {'N', 'T', 'O', 'O', 'L', 'S', 'E', 'G'};
+inline const std::uint16_t SEGMENT_VERSION     {1};
+inline const std::uint32_t SEGMENT_BLOCK_ROWS  {4096};
+inline const std::uint32_t SEGMENT_LOST        {UINT32_MAX};    // RTT of lost probe
+inline const std::size_t   SEGMENT_MAX_ROWS    {1 << 22};       // rows per segment
+inline const std::uint32_t SEGMENT_SPAN        {600};           // seconds per segment
+
+/** Segment file header (host byte order).*/
+struct segment_header {
+    char          magic[8];         // SEGMENT_MAGIC
+    std::uint16_t version;          // SEGMENT_VERSION
+    std::uint8_t  target_width;     // bytes per target index (1, 2, 4)
+    std::uint8_t  rtt_width;        // bytes per RTT (2, 4)
+    std::uint32_t block_rows;       // rows per index block
+    std::uint64_t rows;             // number of rows
+    std::uint32_t targets;          // dictionary size
+    std::uint32_t blocks;           // index size
+    std::int64_t  start_ms;         // first row time
+    std::int64_t  end_ms;           // last row time
+    std::uint64_t dict_offset;      // in_addr_t[targets]
+    std::uint64_t index_offset;     // segment_block[blocks]
+    std::uint64_t time_offset;      // uint32_t[rows], ms from start_ms
+    std::uint64_t target_offset;    // target_width[rows]
+    std::uint64_t rtt_offset;       // rtt_width[rows], max value - lost
+    std::uint64_t reserved;
+};
+
+/** Time range of index block.*/
+struct segment_block {
+    std::int64_t min_ms;
+    std::int64_t max_ms;
+};
+
+class segment_writer {
+public:
+    /**
+     * @brief Construct writer.
+     *
+     * @param [in] dir - given store directory (created if missing).
+     * @param [in] span - given seconds of results per segment.
+     */
+    segment_writer(const char *dir, std::uint32_t span) noexcept;
+    ~segment_writer(void) noexcept;
+
+    segment_writer(const segment_writer&)            = delete;
+    segment_writer& operator=(const segment_writer&) = delete;
+
+    /**
+     * @brief Append result.
+     *
+     * @param [in] target - given target address.
+     * @param [in] time_ms - given probe time (milliseconds since epoch).
+     * @param [in] rtt_us - given RTT in microseconds (SEGMENT_LOST - lost).
+     */
+    void append(in_addr_t target, std::int64_t time_ms, std::uint32_t rtt_us) noexcept;
+
+    /** @brief Write buffered results.*/
+    void close(void) noexcept;
+
+private:
+    /** @brief Write buffered results as segment.*/
+    void flush(void) noexcept;
+
+    /** Buffered result.*/
+    struct row {
+        std::int64_t  time_ms;
+        in_addr_t     target;
+        std::uint32_t rtt_us;
+    };
+
+    std::string      m_dir;
+    std::int64_t     m_span_ms;
+    std::int64_t     m_partition {0};  // current segment time partition
+    std::uint32_t    m_sequence  {0};  // segments written
+    std::vector<row> m_rows;
+};
+
+/** Store query.*/
+struct query_options {
+    in_addr_t     target  {0};            // 0 - all targets
+    std::int64_t  from_ms {INT64_MIN};    // range start (inclusive)
+    std::int64_t  to_ms   {INT64_MAX};    // range end (exclusive)
+    std::uint32_t threads {0};            // 0 - number of CPUs
+};
+
+/**
+ * @brief Parse query time.
+ *
+ * @param [in] str - given time (epoch seconds or YYYY-MM-DD[ HH:MM[:SS]]).
+ * @param [out] time_ms - given object to store milliseconds since epoch.
+ * @return false if time cannot be parsed.
+ */
+bool parse_time(const char *str, std::int64_t& time_ms) noexcept;
+
+/**
+ * @brief Print count, loss & RTT percentiles of stored results.
+ *
+ * @param [in] dir - given store directory.
+ * @param [in] options - given query options.
+ */
+void query_store(const char *dir, const query_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_STORE_HPP_
@@ -0,0 +1,172 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  targets.hpp
+ * @brief Flat per-target state of monitor.
+ *
+ * Targets are numbered by dense index & their state is kept in arrays
+ * indexed by it instead of object per target. Fields touched by every
+ * probe outcome are packed into 32 byte records (two per cache line), so
+ * outcome handling costs single cache line & statistics sweep streams
+ * through memory. Cold data (names, addresses) lives in separate arrays
+ * & is read only when printing, names are copied into arena.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_TARGETS_HPP_
+#define _NTOOL_TARGETS_HPP_
+
+#include <ntool/loader.hpp>
+#include <ntool/engine.hpp>
+#include <ntool/memory.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+/** Hot statistics of target.*/
+struct target_stats {
+    std::uint32_t sent;         // resolved probes
+    std::uint32_t received;     // echo replies
+    std::uint32_t errors;       // ICMP errors (unreachable, ...)
+    std::uint32_t last_seq;     // sequence of last resolved probe
+    float         rtt_min;      // min RTT in ms
+    float         rtt_max;      // max RTT in ms
+    float         rtt_mean;     // running mean of RTT
+    float         rtt_m2;       // sum of squared deviations from mean
+};
+
+static_assert(sizeof(target_stats) == 32);
+
+class target_table {
+public:
+    /**
+     * @brief Resolve targets.
+     *
+     * @param [in] names - given target names or addresses.
+     */
+    explicit target_table(const std::vector<const char*>& names) noexcept;
+
+    /**
+     * @brief Take targets loaded from file.
+     *
+     * @param [in] list - given loaded targets.
+     */
+    explicit target_table(target_list&& list) noexcept;
+
+    /**
+     * @brief Get number of targets.
+     *
+     * @return number of targets.
+     */
+    std::uint32_t size(void) const noexcept
+    {
+        return m_addrs.size();
+    }
+
+    /**
+     * @brief Get target addresses.
+     *
+     * @return addresses indexed by target.
+     */
+    const std::vector<in_addr_t>& addrs(void) const noexcept
+    {
+        return m_addrs;
+    }
+
+    /**
+     * @brief Get target name.
+     *
+     * @param [in] target - given target index.
+     * @return name given by user.
+     */
+    const char *name(std::uint32_t target) const noexcept
+    {
+        return m_names[target];
+    }
+
+    /**
+     * @brief Get target tag.
+     *
+     * @param [in] target - given target index.
+     * @return tag or nullptr if target has no tag.
+     */
+    const char *tag(std::uint32_t target) const noexcept
+    {
+        return m_tags.empty() ? nullptr : m_tags[target];
+    }
+
+    /**
+     * @brief Get target statistics.
+     *
+     * @param [in] target - given target index.
+     * @return statistics.
+     */
+    const target_stats& stats(std::uint32_t target) const noexcept
+    {
+        return m_stats[target];
+    }
+
+    /**
+     * @brief Update target statistics with probe outcome.
+     *
+     * @param [in] result - given probe outcome.
+     */
+    void update(const probe_result& result) noexcept;
+
+    /**
+     * @brief Get memory used by table.
+     *
+     * @return size in bytes.
+     */
+    std::size_t memory(void) const noexcept;
+
+private:
+    std::vector<target_stats> m_stats;  // hot
+    std::vector<in_addr_t>    m_addrs;  // cold
+    std::vector<const char*>  m_names;  // cold
+    std::vector<const char*>  m_tags;   // cold (empty - no tags)
+    arena                     m_arena;  // name strings
+    page_buffer               m_text;   // loaded target list
+    page_buffer               m_hosts;  // names of CIDR hosts
+};
+
+/**
+ * @brief Update statistics with probe outcome.
+ *
+ * @param [in,out] stats - given statistics.
+ * @param [in] result - given probe outcome.
+ */
+void update(target_stats& stats, const probe_result& result) noexcept;
+
+/**
+ * @brief Calculate standard deviation of target RTT.
+ *
+ * @param [in] stats - given target statistics.
+ * @return standard deviation in ms.
+ */
+double stddev(const target_stats& stats) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_TARGETS_HPP_
@@ -0,0 +1,250 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  topology.hpp
+ * @brief Interface-level graph merged from many traces.
+ *
+ * Routers are nodes, replies of consecutive hops of same query are edges
+ * with latency statistics (RTT growth between hops). Nodes & edges are
+ * kept in flat arrays with open addressing indexes, so merging trace is a
+ * couple of probes per hop & graph can be updated as traces finish.
+ * Snapshot stores edges in CSR order (sorted by source node with offsets
+ * per node), so its readers can walk adjacency without building indexes.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_TOPOLOGY_HPP_
+#define _NTOOL_TOPOLOGY_HPP_
+
+#include <ntool/engine.hpp>
+#include <ntool/asn.hpp>
+#include <netinet/in.h>
+#include <cstdint>
+#include <vector>
+
+
+namespace ntool {
+
+inline const char          TOPOLOGY_MAGIC[8] {'N', 'T', 'O', 'O', 'L', 'T', 'O', 'P'};
+inline const std::uint16_t TOPOLOGY_VERSION  {1};
+inline const std::size_t   TOPOLOGY_PREFETCH {8};   // outcomes prefetched ahead of merge
+
+/**
+ * Snapshot header (host byte order), followed by node addresses,
+ * CSR offsets (nodes + 1) & edges.
+ */
+struct topology_header {
+    char          magic[8];     // TOPOLOGY_MAGIC
+    std::uint16_t version;      // TOPOLOGY_VERSION
+    std::uint16_t edge_size;    // sizeof(topology_edge)
+    std::uint32_t nodes;        // number of nodes
+    std::uint64_t edges;        // number of edges
+    std::uint64_t traces;       // merged traces
+};
+
+static_assert(sizeof(topology_header) == 32);
+
+/** Link between routers of consecutive hops.*/
+struct topology_edge {
+    std::uint32_t from;     // node of nearer router
+    std::uint32_t to;       // node of farther router
+    std::uint32_t min_us;   // minimum RTT growth
+    std::uint32_t max_us;   // maximum RTT growth
+    std::uint64_t samples;  // queries which crossed edge
+    std::uint64_t sum_us;   // sum of RTT growth
+};
+
+static_assert(sizeof(topology_edge) == 32);
+
+class topology {
+public:
+    topology(void) noexcept;
+
+    /** @brief Start merging next trace.*/
+    void begin(void) noexcept;
+
+    /**
+     * @brief Merge probe outcome of current trace.
+     *
+     * Outcomes of each query must come in hop order, timeouts break path
+     * of their query.
+     *
+     * @param [in] result - given probe outcome.
+     */
+    void add(const probe_result& result) noexcept;
+
+    /**
+     * @brief Prefetch node index slot of router.
+     *
+     * @param [in] addr - given router address of later outcome.
+     */
+    void prefetch(in_addr_t addr) const noexcept;
+
+    /**
+     * @brief Merge traces of result log.
+     *
+     * @param [in] path - given result log path.
+     * @return false if file is not trace result log.
+     */
+    bool merge_log(const char *path) noexcept;
+
+    /**
+     * @brief Replace graph by snapshot.
+     *
+     * @param [in] path - given snapshot path.
+     * @return false if file is not snapshot or cannot be read.
+     */
+    bool load(const char *path) noexcept;
+
+    /**
+     * @brief Write snapshot.
+     *
+     * @param [in] path - given snapshot path.
+     */
+    void save(const char *path) const noexcept;
+
+    /**
+     * @brief Write graph in Graphviz DOT format.
+     *
+     * @param [in] path - given output path.
+     * @param [in] asn - given origin AS database of node labels (nullptr - none).
+     */
+    void write_dot(const char *path, const asn_db *asn) const noexcept;
+
+    /**
+     * @brief Get router address of node.
+     *
+     * @param [in] node - given node index.
+     * @return address in network byte order.
+     */
+    in_addr_t address(std::uint32_t node) const noexcept;
+
+    /**
+     * @brief Get edges in order of creation.
+     *
+     * @return edges.
+     */
+    const std::vector<topology_edge>& edges(void) const noexcept;
+
+    /**
+     * @brief Get number of nodes.
+     *
+     * @return nodes.
+     */
+    std::uint32_t nodes(void) const noexcept;
+
+    /**
+     * @brief Get number of merged traces.
+     *
+     * @return traces.
+     */
+    std::uint64_t traces(void) const noexcept;
+
+private:
+    /**
+     * @brief Find or insert node of router.
+     *
+     * @param [in] addr - given router address.
+     * @return node index.
+     */
+    std::uint32_t node(in_addr_t addr) noexcept;
+
+    /**
+     * @brief Find or insert edge between nodes.
+     *
+     * @param [in] from - given node of nearer router.
+     * @param [in] to - given node of farther router.
+     * @return edge.
+     */
+    topology_edge& edge(std::uint32_t from, std::uint32_t to) noexcept;
+
+    /**
+     * @brief Rebuild indexes for given number of nodes & edges.
+     *
+     * @param [in] nodes - given expected number of nodes.
+     * @param [in] edges - given expected number of edges.
+     */
+    void reindex(std::size_t nodes, std::size_t edges) noexcept;
+
+    /** Node index slot, keys are kept inline to avoid extra miss.*/
+    struct node_slot {
+        in_addr_t     addr;
+        std::uint32_t node;     // node + 1 (0 - empty)
+    };
+
+    /** Edge index slot.*/
+    struct edge_slot {
+        std::uint32_t from;
+        std::uint32_t to;
+        std::uint32_t edge;     // edge + 1 (0 - empty)
+    };
+
+    /** Last reply of query in current trace.*/
+    struct path_state {
+        std::uint8_t  ttl;      // hop (0 - none)
+        std::uint32_t node;
+        std::uint64_t rtt_ns;
+    };
+
+    std::vector<in_addr_t>     m_addrs;         // node addresses
+    std::vector<node_slot>     m_node_slots;
+    std::vector<topology_edge> m_edges;
+    std::vector<edge_slot>     m_edge_slots;
+    std::vector<path_state>    m_paths;         // per query of current trace
+    std::uint64_t              m_traces {0};
+    std::uint32_t              m_recent_node {0};   // queries of hop mostly share
+    std::uint32_t              m_recent_edge {0};   // router & edge
+};
+
+/** Topology snapshot & export options.*/
+struct topology_options {
+    const char   *snapshot {nullptr};   // graph snapshot (read if exists, written back)
+    const char   *dot      {nullptr};   // DOT output path (nullptr - none)
+    const asn_db *asn      {nullptr};   // origin AS of node labels
+};
+
+/**
+ * @brief Read snapshot into graph if snapshot file exists.
+ *
+ * @param [out] graph - given graph.
+ * @param [in] options - given topology options.
+ */
+void topology_restore(topology& graph, const topology_options& options) noexcept;
+
+/**
+ * @brief Write snapshot & DOT export of graph.
+ *
+ * @param [in] graph - given graph.
+ * @param [in] options - given topology options.
+ */
+void topology_export(const topology& graph, const topology_options& options) noexcept;
+
+/**
+ * @brief Merge trace result logs into snapshot.
+ *
+ * @param [in] logs - given result log paths.
+ * @param [in] options - given topology options.
+ */
+void merge_topology(const std::vector<const char*>& logs, const topology_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_TOPOLOGY_HPP_
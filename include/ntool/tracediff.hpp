@@ -0,0 +1,82 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  tracediff.hpp
+ * @brief Comparison of two sets of stored traces.
+ *
+ * Every stored trace is reduced to fingerprint of its path in parallel,
+ * fingerprints of latest traces of each destination are joined & only
+ * destinations with different fingerprints are traced back to their
+ * records, aligned hop by hop (longest common subsequence) & reported.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_TRACEDIFF_HPP_
+#define _NTOOL_TRACEDIFF_HPP_
+
+#include <ntool/routes.hpp>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ntool {
+
+inline const std::uint32_t DIFF_TOP {20};   // aggregated changes shown
+
+/** Trace diff options.*/
+struct trace_diff_options {
+    std::uint32_t threads {0};          // 0 - number of CPUs
+    std::uint32_t top     {DIFF_TOP};   // aggregated changes shown
+    bool          quiet   {false};      // aggregated changes only
+};
+
+/** Run of differing hops between aligned routes.*/
+struct hop_change {
+    std::uint8_t old_hop;       // first hop of run in old route (from 1)
+    std::uint8_t old_count;     // hops of old route in run
+    std::uint8_t new_hop;       // first hop of run in new route (from 1)
+    std::uint8_t new_count;     // hops of new route in run
+};
+
+/**
+ * @brief Align routes hop by hop & find runs of differing hops.
+ * Anonymous hop matches any hop, hops match if they share router.
+ *
+ * @param [in] before - given old route.
+ * @param [in] after - given new route.
+ * @param [out] changes - given array to store runs (ROUTE_MAX_HOPS + 1).
+ * @return number of runs.
+ */
+std::size_t align_routes(const route& before, const route& after, hop_change *changes) noexcept;
+
+/**
+ * @brief Compare latest traces of each destination in two sets of trace
+ * result logs & print changed paths.
+ *
+ * @param [in] before - given result log or directory of result logs.
+ * @param [in] after - given result log or directory of result logs.
+ * @param [in] options - given trace diff options.
+ */
+void trace_diff(const char *before, const char *after, const trace_diff_options& options) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_TRACEDIFF_HPP_
@@ -28,6 +28,8 @@
 #ifndef _NTOOL_TRACEROUTE_HPP_
 #define _NTOOL_TRACEROUTE_HPP_
 
+#include <ntool/topology.hpp>
+#include <ntool/output.hpp>
 #include <cstdint>
 
 
@@ -39,8 +41,12 @@ namespace ntool {
  * @param [in] target - given target to display.
  * @param [in] h - given max number of hops.
  * @param [in] q - given max number of queries.
+ * @param [in] output - given hops output options.
+ * @param [in] stats - given flag to time engine stages.
+ * @param [in,out] graph - given graph to merge route into (nullptr - none).
  */
-void traceroute(const char *target, std::int32_t h, std::int32_t q) noexcept;
+void traceroute(const char *target, std::int32_t h, std::int32_t q,
+    const output_options& output, bool stats, topology *graph) noexcept;
 
 } // namespace ntool
 
@@ -0,0 +1,278 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  transport.hpp
+ * @brief Packet I/O interface of probe engine.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_TRANSPORT_HPP_
+#define _NTOOL_TRANSPORT_HPP_
+
+#include <ntool/memory.hpp>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace ntool {
+
+/**
+ * @brief Handle packet which transport accepted but failed to send.
+ *
+ * @param [in] packet - given ICMP packet.
+ * @param [in] size - given ICMP packet size in bytes.
+ * @param [in] error - given errno of failed send.
+ * @param [in] ctx - given user context.
+ */
+using drop_handler = void (*)(const std::uint8_t *packet, std::size_t size,
+    std::int32_t error, void *ctx) noexcept;
+
+/** Source & sink of ICMP packets with its own notion of time.*/
+class transport {
+public:
+    virtual ~transport(void) noexcept = default;
+
+    /**
+     * @brief Get current time of transport.
+     *
+     * @return time in nanoseconds.
+     */
+    virtual std::uint64_t now(void) noexcept = 0;
+
+    /**
+     * @brief Send ICMP packet.
+     *
+     * @param [in] dst - given destination address.
+     * @param [in] ttl - given packet time to live.
+     * @param [in] packet - given ICMP packet.
+     * @param [in] size - given ICMP packet size in bytes.
+     * @return true if packet was sent, false if dropped locally (full
+     * device queue, unreachable or filtered destination).
+     */
+    virtual bool send(in_addr_t dst, std::uint8_t ttl,
+        const std::uint8_t *packet, std::size_t size) noexcept = 0;
+
+    /**
+     * @brief Receive pending packet without blocking.
+     *
+     * @param [out] buffer - given buffer to store packet (IP header included).
+     * @param [in] size - given buffer size in bytes.
+     * @param [out] time - given object to store receive time.
+     * @return packet size or -1 if there is no pending packet.
+     */
+    virtual std::ptrdiff_t recv(std::uint8_t *buffer, std::size_t size,
+        std::uint64_t& time) noexcept = 0;
+
+    /**
+     * @brief Wait until packet is pending or deadline is reached.
+     *
+     * @param [in] deadline - given wake up time (UINT64_MAX - no deadline).
+     */
+    virtual void wait(std::uint64_t deadline) noexcept = 0;
+
+    /**
+     * @brief Get number of system calls made by transport.
+     *
+     * @return number of system calls.
+     */
+    virtual std::uint64_t syscalls(void) const noexcept
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Also end wait() when given descriptor becomes readable.
+     *
+     * @param [in] fd - given file descriptor (-1 - none).
+     */
+    void watch(std::int32_t fd) noexcept
+    {
+        m_watch_fd = fd;
+    }
+
+    /**
+     * @brief Check & reset readiness of watched descriptor.
+     *
+     * @return true if watched descriptor was readable after last wait().
+     */
+    bool watched(void) noexcept
+    {
+        auto ready    = m_watch_ready;
+        m_watch_ready = false;
+        return ready;
+    }
+
+    /**
+     * @brief Set handler of packets dropped after send() returned true
+     * (batching transports send queued packets later).
+     *
+     * @param [in] handler - given handler (nullptr - none, must not send).
+     * @param [in] ctx - given handler context.
+     */
+    void on_drop(drop_handler handler, void *ctx) noexcept
+    {
+        m_drop     = handler;
+        m_drop_ctx = ctx;
+    }
+
+protected:
+    /**
+     * @brief Report queued packet which was not sent.
+     *
+     * @param [in] packet - given ICMP packet.
+     * @param [in] size - given ICMP packet size in bytes.
+     * @param [in] error - given errno of failed send.
+     */
+    void dropped(const std::uint8_t *packet, std::size_t size, std::int32_t error) noexcept
+    {
+        if (m_drop)
+            m_drop(packet, size, error, m_drop_ctx);
+    }
+
+    std::int32_t m_watch_fd    {-1};
+    bool         m_watch_ready {false};
+    drop_handler m_drop        {nullptr};
+    void         *m_drop_ctx   {nullptr};
+};
+
+/** Raw ICMP socket transport.*/
+class raw_transport final : public transport {
+public:
+    raw_transport(void) noexcept;
+    ~raw_transport(void) noexcept override;
+
+    raw_transport(const raw_transport&)            = delete;
+    raw_transport& operator=(const raw_transport&) = delete;
+
+    std::uint64_t now(void) noexcept override;
+
+    bool send(in_addr_t dst, std::uint8_t ttl, const std::uint8_t *packet,
+        std::size_t size) noexcept override;
+
+    std::ptrdiff_t recv(std::uint8_t *buffer, std::size_t size,
+        std::uint64_t& time) noexcept override;
+
+    void wait(std::uint64_t deadline) noexcept override;
+
+    std::uint64_t syscalls(void) const noexcept override;
+
+private:
+    std::int32_t  m_sockfd   {-1};
+    std::uint64_t m_syscalls {0};
+};
+
+inline const std::uint32_t MMSG_BATCH_SIZE {64};    // packets per syscall
+
+/**
+ * Raw ICMP socket transport with batched I/O. Probes are queued and sent
+ * with single sendmmsg() before next receive or wait, replies are read
+ * with recvmmsg() in batches. Queued probes which sendmmsg() fails to
+ * send are reported to drop handler.
+ */
+class mmsg_transport final : public transport {
+public:
+    /**
+     * @brief Open socket & map packet buffers.
+     *
+     * @param [in] huge - given flag to back packet buffers by huge pages.
+     */
+    explicit mmsg_transport(bool huge) noexcept;
+    ~mmsg_transport(void) noexcept override;
+
+    mmsg_transport(const mmsg_transport&)            = delete;
+    mmsg_transport& operator=(const mmsg_transport&) = delete;
+
+    std::uint64_t now(void) noexcept override;
+
+    bool send(in_addr_t dst, std::uint8_t ttl, const std::uint8_t *packet,
+        std::size_t size) noexcept override;
+
+    std::ptrdiff_t recv(std::uint8_t *buffer, std::size_t size,
+        std::uint64_t& time) noexcept override;
+
+    void wait(std::uint64_t deadline) noexcept override;
+
+    std::uint64_t syscalls(void) const noexcept override;
+
+private:
+    /** @brief Send all queued packets.*/
+    void flush(void) noexcept;
+
+    inline static const std::size_t PACKET_SIZE  {1500};
+    inline static const std::size_t CONTROL_SIZE {32};
+
+    /** Queued outgoing packet.*/
+    struct tx_slot {
+        sockaddr_in  addr;
+        std::uint8_t control[CONTROL_SIZE];
+        std::uint8_t packet[PACKET_SIZE];
+    };
+
+    std::int32_t  m_sockfd   {-1};
+    std::uint64_t m_syscalls {0};
+    std::uint32_t m_tx_count {0};   // queued packets
+    std::uint32_t m_rx_count {0};   // received packets in batch
+    std::uint32_t m_rx_pos   {0};   // next packet to hand out
+    std::uint64_t m_rx_time  {0};   // batch receive time
+
+    /** Packet buffers & message headers of batch.*/
+    struct batch {
+        tx_slot      tx[MMSG_BATCH_SIZE];
+        mmsghdr      tx_msgs[MMSG_BATCH_SIZE];
+        iovec        tx_iov[MMSG_BATCH_SIZE];
+        std::uint8_t rx[MMSG_BATCH_SIZE][PACKET_SIZE];
+        mmsghdr      rx_msgs[MMSG_BATCH_SIZE];
+        iovec        rx_iov[MMSG_BATCH_SIZE];
+    };
+
+    page_buffer   m_pages;
+    batch         &m_batch;
+};
+
+/** Raw socket I/O backend.*/
+enum class io_backend : std::uint8_t {
+    raw,    // sendmsg() & recv() per packet
+    mmsg,   // batched sendmmsg() & recvmmsg()
+};
+
+/**
+ * @brief Create raw socket transport.
+ *
+ * @param [in] backend - given I/O backend.
+ * @param [in] huge - given flag to back packet buffers by huge pages.
+ * @return transport.
+ */
+std::unique_ptr<transport> make_transport(io_backend backend, bool huge) noexcept;
+
+/**
+ * @brief Get I/O backend name.
+ *
+ * @param [in] backend - given I/O backend.
+ * @return backend name.
+ */
+const char *backend_name(io_backend backend) noexcept;
+
+} // namespace ntool
+
+#endif // _NTOOL_TRANSPORT_HPP_
@@ -0,0 +1,142 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file  usdt.hpp
+ * @brief USDT static tracepoints of probe engine.
+ *
+ * Probes are emitted in the same ELF note format as sys/sdt.h produces
+ * (.note.stapsdt), so bpftrace, perf & SystemTap find them without any
+ * library or header at build or run time:
+ *
+ *     bpftrace -e 'usdt:./ntool:ntool:reply { @[str(arg0)] = hist(arg3); }'
+ *
+ * Each probe is guarded by semaphore which tracer increments while it is
+ * attached. Disabled probe costs single load & never taken branch, its
+ * arguments are not even computed. Probes compile to nothing on
+ * architectures other than x86-64 & AArch64.
+ *
+ * @author Alexander Kuzin (<a href="https://github.com/alkuzin">alkuzin</a>)
+ * @date   17.10.2026
+ */
+
+#ifndef _NTOOL_USDT_HPP_
+#define _NTOOL_USDT_HPP_
+
+#include <type_traits>
+
+
+/**
+ * Probes of provider "ntool" (arguments):
+ *     schedule - target, seq, lateness (ns), probes in flight
+ *     send     - target, seq, ttl, sent (0 - dropped by transport)
+ *     reply    - target, seq, ttl, RTT (ns), reply source
+ *     timeout  - target, seq, ttl, probes in flight
+ *     output   - target, seq, record kind, output queue depth
+ *
+ * Addresses are IPv4 in network byte order.
+ */
+#define NTOOL_USDT_PROBES(X) \
+    X(schedule)              \
+    X(send)                  \
+    X(reply)                 \
+    X(timeout)               \
+    X(output)
+
+#define _NTOOL_USDT_SEMAPHORE(name) ntool_##name##_semaphore
+
+#define _NTOOL_USDT_DECLARE(name) \
+    extern "C" volatile unsigned short _NTOOL_USDT_SEMAPHORE(name);
+
+NTOOL_USDT_PROBES(_NTOOL_USDT_DECLARE)
+
+/**
+ * @brief Check whether tracer is attached to probe.
+ *
+ * @param [in] name - given probe name.
+ */
+#define NTOOL_USDT_ENABLED(name) \
+    __builtin_expect(_NTOOL_USDT_SEMAPHORE(name) != 0, 0)
+
+#if defined(__x86_64__) || defined(__aarch64__)
+
+// argument size, negative for signed (printed negated by %n)
+#define _NTOOL_USDT_SIZE(x) \
+    ((std::is_signed_v<std::remove_cvref_t<decltype(x)>> ? 1 : -1) * \
+        static_cast<int>(sizeof(x)))
+
+#define _NTOOL_USDT_OP(n, x) \
+    [_s##n] "n" (_NTOOL_USDT_SIZE(x)), [_a##n] "nor" (x)
+
+#define _NTOOL_USDT_ARG1 "%n[_s1]@%[_a1]"
+#define _NTOOL_USDT_ARG2 _NTOOL_USDT_ARG1 " %n[_s2]@%[_a2]"
+#define _NTOOL_USDT_ARG3 _NTOOL_USDT_ARG2 " %n[_s3]@%[_a3]"
+#define _NTOOL_USDT_ARG4 _NTOOL_USDT_ARG3 " %n[_s4]@%[_a4]"
+#define _NTOOL_USDT_ARG5 _NTOOL_USDT_ARG4 " %n[_s5]@%[_a5]"
+
+// probe site is nop, its address & arguments locations are kept in note
+#define _NTOOL_USDT_ASM(name, args, ...)                                    \
+    __asm__ __volatile__(                                                   \
+        "990: nop\n"                                                        \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                       \
+        ".balign 4\n"                                                       \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                  \
+        "991: .asciz \"stapsdt\"\n"                                         \
+        "992: .balign 4\n"                                                  \
+        "993: .8byte 990b\n"                                                \
+        ".8byte _.stapsdt.base\n"                                           \
+        ".8byte ntool_" #name "_semaphore\n"                                \
+        ".asciz \"ntool\"\n"                                                \
+        ".asciz \"" #name "\"\n"                                            \
+        ".asciz \"" args "\"\n"                                             \
+        "994: .balign 4\n"                                                  \
+        ".popsection\n"                                                     \
+        ".ifndef _.stapsdt.base\n"                                          \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n"                                            \
+        ".hidden _.stapsdt.base\n"                                          \
+        "_.stapsdt.base: .space 1\n"                                        \
+        ".size _.stapsdt.base, 1\n"                                         \
+        ".popsection\n"                                                     \
+        ".endif\n"                                                          \
+        :: __VA_ARGS__                                                      \
+    )
+
+#define _NTOOL_USDT(name, args, ...)                \
+    do {                                            \
+        if (NTOOL_USDT_ENABLED(name))               \
+            _NTOOL_USDT_ASM(name, args, __VA_ARGS__); \
+    } while (0)
+
+#define NTOOL_USDT4(name, a1, a2, a3, a4)                               \
+    _NTOOL_USDT(name, _NTOOL_USDT_ARG4, _NTOOL_USDT_OP(1, a1),          \
+        _NTOOL_USDT_OP(2, a2), _NTOOL_USDT_OP(3, a3), _NTOOL_USDT_OP(4, a4))
+
+#define NTOOL_USDT5(name, a1, a2, a3, a4, a5)                           \
+    _NTOOL_USDT(name, _NTOOL_USDT_ARG5, _NTOOL_USDT_OP(1, a1),          \
+        _NTOOL_USDT_OP(2, a2), _NTOOL_USDT_OP(3, a3), _NTOOL_USDT_OP(4, a4), \
+        _NTOOL_USDT_OP(5, a5))
+
+#else
+
+#define NTOOL_USDT4(name, a1, a2, a3, a4)       do {} while (0)
+#define NTOOL_USDT5(name, a1, a2, a3, a4, a5)   do {} while (0)
+
+#endif
+
+#endif // _NTOOL_USDT_HPP_
@@ -28,9 +28,12 @@
 #define _NTOOL_UTILS_HPP_
 
 #include <netinet/in.h>
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
 
 
 namespace ntool {
@@ -46,6 +49,28 @@ void terminate_if_not_root(void) noexcept;
  */
 void error(const std::string_view& msg) noexcept;
 
+/**
+ * @brief Set function called by error() before exit.
+ *
+ * @param [in] hook - given function (nullptr - none).
+ */
+void on_error(void (*hook)(void) noexcept) noexcept;
+
+/**
+ * @brief Get monotonic time.
+ *
+ * @return time in nanoseconds.
+ */
+std::uint64_t clock_ns(void) noexcept;
+
+/**
+ * @brief Convert monotonic time to wall clock time.
+ *
+ * @param [in] ns - given monotonic time in nanoseconds (see clock_ns()).
+ * @return milliseconds since epoch.
+ */
+std::int64_t realtime_ms(std::uint64_t ns) noexcept;
+
 /**
  * @brief Calculate mean value of given vector.
  *
@@ -62,6 +87,45 @@ double mean(const std::vector<double>& vec) noexcept;
  */
 double mdev(const std::vector<double>& vec) noexcept;
 
+/** Streaming replacement of mean() & mdev() with constant memory.*/
+struct running_stats {
+    std::size_t count {0};      // number of samples
+    double      min   {0.0};    // minimal sample
+    double      max   {0.0};    // maximal sample
+    double      mean  {0.0};    // running mean
+    double      m2    {0.0};    // sum of squared deviations from mean
+};
+
+/**
+ * @brief Add sample to running statistics (Welford's algorithm).
+ *
+ * @param [in,out] stats - given running statistics.
+ * @param [in] value - given sample.
+ */
+void update(running_stats& stats, double value) noexcept;
+
+/**
+ * @brief Calculate standard deviation of running statistics.
+ *
+ * @param [in] stats - given running statistics.
+ * @return standard deviation.
+ */
+double stddev(const running_stats& stats) noexcept;
+
+/**
+ * @brief Add to statistics counter without locked instruction.
+ *
+ * Counter must have single writer or tolerate lost updates, readers of
+ * other threads see consistent values.
+ *
+ * @param [in,out] counter - given counter.
+ * @param [in] value - given value.
+ */
+inline void counter_add(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
 /**
  * @brief Dump memory.
  *
@@ -78,6 +142,41 @@ void memdump(const std::uint8_t *addr, std::size_t size) noexcept;
  */
 in_addr_t get_ip_address(const std::string_view& target) noexcept;
 
+/**
+ * @brief Run function over range of indexes in parallel.
+ *
+ * @param [in] count - given number of indexes.
+ * @param [in] threads - given max number of threads.
+ * @param [in] work - given function called with index.
+ */
+template <typename F>
+void parallel_for(std::size_t count, std::uint32_t threads, F&& work) noexcept
+{
+    threads = std::clamp<std::uint32_t>(threads, 1, std::max<std::size_t>(count, 1));
+
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> next {0};
+
+    auto run = [&]() noexcept {
+        for (;;) {
+            auto i = next.fetch_add(1, std::memory_order_relaxed);
+
+            if (i >= count)
+                break;
+
+            work(i);
+        }
+    };
+
+    for (std::uint32_t i = 1; i < threads; i++)
+        workers.emplace_back(run);
+
+    run();
+
+    for (auto& w : workers)
+        w.join();
+}
+
 } // namespace utils
 } // namespace ntool
 
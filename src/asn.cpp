@@ -0,0 +1,356 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/prefix.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/asn.hpp>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <cstdio>
+#include <vector>
+
+
+namespace ntool {
+
+/** Outcome of source line parsing.*/
+enum class asn_line : std::uint8_t {
+    route,      // prefix & origin
+    skipped,    // comment, empty or IPv6
+    invalid,
+};
+
+/**
+ * @brief Parse origin AS.
+ *
+ * @param [in] str - given AS number, optionally prefixed by "AS" or "{".
+ * @param [out] asn - given object to store AS number.
+ * @return false if AS number is invalid.
+ */
+static bool parse_asn(const char *str, std::uint32_t& asn) noexcept;
+
+/**
+ * @brief Parse source line.
+ *
+ * @param [in,out] line - given null-terminated line (modified).
+ * @param [out] route - given object to store prefix & origin.
+ * @return outcome of parsing.
+ */
+static asn_line parse_line(char *line, prefix_entry& route) noexcept;
+
+/**
+ * @brief Flatten nested prefixes into disjoint ranges.
+ *
+ * @param [in] routes - given prefixes with origin (first one wins among equal ones).
+ * @return ranges sorted by start, first one starting at 0.
+ */
+static std::vector<asn_range> flatten(std::vector<prefix_entry> routes) noexcept;
+
+
+asn_db::~asn_db(void) noexcept
+{
+    if (m_data)
+        munmap(m_data, m_size);
+}
+
+bool asn_db::open(const char *path) noexcept
+{
+    auto fd = ::open(path, O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(asn_header)) {
+        close(fd);
+        return false;
+    }
+
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    auto header = static_cast<const asn_header*>(data);
+    auto root   = reinterpret_cast<const std::uint32_t*>(header + 1);
+    auto size   = sizeof(asn_header) + ASN_ROOT * sizeof(std::uint32_t) +
+        std::uint64_t(header->ranges) * sizeof(asn_range);
+
+    bool valid = std::memcmp(header->magic, ASN_MAGIC, sizeof(ASN_MAGIC)) == 0 &&
+        header->version == ASN_VERSION && header->ranges > 0 &&
+        size == static_cast<std::size_t>(st.st_size);
+
+    // root must bound every search within ranges
+    for (std::uint32_t i = 0; valid && i < ASN_ROOT; i++)
+        valid = root[i] < header->ranges && (i == 0 || root[i - 1] <= root[i]);
+
+    if (!valid) {
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    if (m_data)
+        munmap(m_data, m_size);
+
+    m_data   = data;
+    m_size   = st.st_size;
+    m_root   = root;
+    m_ranges = reinterpret_cast<const asn_range*>(root + ASN_ROOT);
+
+    return true;
+}
+
+std::uint32_t asn_db::ranges(void) const noexcept
+{
+    return m_data ? static_cast<const asn_header*>(m_data)->ranges : 0;
+}
+
+asn_compile_stats asn_compile(const char *source, const char *path) noexcept
+{
+    auto file = std::fopen(source, "r");
+
+    if (!file)
+        utils::error("ntool: asn: cannot open source file");
+
+    std::vector<prefix_entry> routes;
+    std::uint64_t skipped = 0, invalid = 0;
+
+    char *line       = nullptr;
+    std::size_t size = 0;
+
+    while (getline(&line, &size, file) != -1) {
+        prefix_entry route {};
+
+        switch (parse_line(line, route)) {
+        case asn_line::route:
+            routes.push_back(route);
+            break;
+
+        case asn_line::skipped:
+            skipped++;
+            break;
+
+        case asn_line::invalid:
+            invalid++;
+            break;
+        }
+    }
+
+    std::free(line);
+    std::fclose(file);
+
+    if (routes.empty())
+        utils::error("ntool: asn: source file has no IPv4 routes");
+
+    auto prefixes = routes.size();
+    auto ranges   = flatten(std::move(routes));
+
+    // root entry is last range starting at or before its /16
+    std::vector<std::uint32_t> root(ASN_ROOT);
+    std::uint32_t r = 0;
+
+    for (std::uint32_t block = 0; block + 1 < ASN_ROOT; block++) {
+        while (r + 1 < ranges.size() && ranges[r + 1].start <= (block << 16))
+            r++;
+
+        root[block] = r;
+    }
+
+    root[ASN_ROOT - 1] = ranges.size() - 1;
+
+    asn_header header {};
+    std::memcpy(header.magic, ASN_MAGIC, sizeof(ASN_MAGIC));
+    header.version  = ASN_VERSION;
+    header.ranges   = ranges.size();
+    header.prefixes = prefixes;
+
+    auto out = std::fopen(path, "w");
+
+    if (!out)
+        utils::error("ntool: asn: cannot open output file");
+
+    bool written = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+        std::fwrite(root.data(), sizeof(std::uint32_t), root.size(), out) == root.size() &&
+        std::fwrite(ranges.data(), sizeof(asn_range), ranges.size(), out) == ranges.size();
+
+    if (std::fclose(out) != 0 || !written)
+        utils::error("ntool: asn: cannot write database");
+
+    auto bytes = sizeof(header) + root.size() * sizeof(std::uint32_t) +
+        ranges.size() * sizeof(asn_range);
+
+    asn_compile_stats stats;
+    stats.prefixes = prefixes;
+    stats.ranges   = ranges.size();
+    stats.bytes    = bytes;
+    stats.skipped  = skipped;
+    stats.invalid  = invalid;
+
+    return stats;
+}
+
+static bool parse_asn(const char *str, std::uint32_t& asn) noexcept
+{
+    // AS set of aggregated route, take its first member
+    if (*str == '{')
+        str++;
+    else if ((str[0] == 'A' || str[0] == 'a') && (str[1] == 'S' || str[1] == 's'))
+        str += 2;
+
+    if (*str < '0' || *str > '9')
+        return false;
+
+    char *end  = nullptr;
+    auto value = std::strtoul(str, &end, 10);
+
+    if (value > UINT32_MAX || (*end && *end != ',' && *end != '}'))
+        return false;
+
+    asn = static_cast<std::uint32_t>(value);
+    return true;
+}
+
+static asn_line parse_line(char *line, prefix_entry& route) noexcept
+{
+    line[std::strcspn(line, "\r\n")] = '\0';
+
+    auto start = line + std::strspn(line, " \t");
+
+    if (*start == '\0' || *start == '#')
+        return asn_line::skipped;
+
+    const char *prefix = nullptr;
+    const char *origin = nullptr;
+
+    if (std::strchr(start, '|')) {
+        // bgpdump -m: TABLE_DUMP2|time|B|peer IP|peer AS|prefix|AS path|...
+        char *field = start;
+
+        for (auto i = 0; field && i <= 6; i++) {
+            auto next = std::strchr(field, '|');
+
+            if (next)
+                *next++ = '\0';
+
+            if (i == 5)
+                prefix = field;
+            else if (i == 6)
+                origin = field;
+
+            field = next;
+        }
+
+        // origin is last AS of path or AS set ending it
+        if (origin) {
+            auto set  = std::strrchr(origin, '{');
+            auto last = std::strrchr(origin, ' ');
+            origin    = set ? set : (last ? last + 1 : origin);
+        }
+    }
+    else {
+        char *state = nullptr;
+        prefix      = strtok_r(start, " \t,", &state);
+        origin      = strtok_r(nullptr, " \t,", &state);
+    }
+
+    if (!prefix || !origin)
+        return asn_line::invalid;
+
+    if (std::strchr(prefix, ':'))
+        return asn_line::skipped;
+
+    if (!parse_prefix(prefix, route) || !parse_asn(origin, route.value))
+        return asn_line::invalid;
+
+    return asn_line::route;
+}
+
+static std::vector<asn_range> flatten(std::vector<prefix_entry> routes) noexcept
+{
+    for (auto& r : routes) {
+        auto mask = r.length ? ~0U << (32 - r.length) : 0;
+        r.network = ntohl(r.network) & mask;
+    }
+
+    // enclosing prefixes go before prefixes they contain
+    std::stable_sort(routes.begin(), routes.end(), [](const auto& a, const auto& b) {
+        return a.network < b.network || (a.network == b.network && a.length < b.length);
+    });
+
+    auto last = std::unique(routes.begin(), routes.end(), [](const auto& a, const auto& b) {
+        return a.network == b.network && a.length == b.length;
+    });
+
+    routes.erase(last, routes.end());
+
+    std::vector<asn_range> ranges;
+
+    // start new range, later range of same start replaces earlier one
+    auto emit = [&ranges](std::uint64_t start, std::uint32_t asn) {
+        if (start > UINT32_MAX)
+            return;
+
+        if (!ranges.empty() && ranges.back().start == start) {
+            ranges.back().asn = asn;
+
+            if (ranges.size() > 1 && ranges[ranges.size() - 2].asn == asn)
+                ranges.pop_back();
+            return;
+        }
+
+        if (ranges.empty() || ranges.back().asn != asn)
+            ranges.push_back({static_cast<std::uint32_t>(start), asn});
+    };
+
+    /** Enclosing prefix still open.*/
+    struct open_route {
+        std::uint64_t end;  // first address after prefix
+        std::uint32_t asn;
+    };
+
+    std::vector<open_route> stack;
+
+    // address space after prefix returns to enclosing prefix
+    auto close_until = [&](std::uint64_t addr) {
+        while (!stack.empty() && stack.back().end <= addr) {
+            auto end = stack.back().end;
+            stack.pop_back();
+            emit(end, stack.empty() ? ASN_UNKNOWN : stack.back().asn);
+        }
+    };
+
+    emit(0, ASN_UNKNOWN);
+
+    for (const auto& r : routes) {
+        close_until(r.network);
+        emit(r.network, r.value);
+        stack.push_back({r.network + (std::uint64_t(1) << (32 - r.length)), r.value});
+    }
+
+    close_until(UINT64_MAX);
+
+    return ranges;
+}
+
+} // namespace ntool
@@ -0,0 +1,460 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/coro.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/icmp.hpp>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <bit>
+
+
+namespace ntool {
+
+inline const std::uint32_t SLOT_IDS_SPAN {1 << 16};     // slots per echo id
+
+frame_pool& frame_pool::local(void) noexcept
+{
+    thread_local frame_pool pool;
+    return pool;
+}
+
+void *frame_pool::allocate(std::size_t size) noexcept
+{
+    auto index = (size + FRAME_CLASS - 1) / FRAME_CLASS - 1;
+
+    // unusually large frames are not pooled
+    if (index >= std::size(m_classes)) {
+        auto ptr = std::malloc(size);
+
+        if (!ptr)
+            utils::error("ntool: coroutine: frame allocation error");
+
+        return ptr;
+    }
+
+    if (!m_classes[index])
+        m_classes[index] = std::make_unique<slab_pool>((index + 1) * FRAME_CLASS, alignof(std::max_align_t));
+
+    m_frames++;
+    m_bytes += (index + 1) * FRAME_CLASS;
+    return m_classes[index]->allocate();
+}
+
+void frame_pool::release(void *ptr, std::size_t size) noexcept
+{
+    auto index = (size + FRAME_CLASS - 1) / FRAME_CLASS - 1;
+
+    if (index >= std::size(m_classes)) {
+        std::free(ptr);
+        return;
+    }
+
+    m_frames--;
+    m_bytes -= (index + 1) * FRAME_CLASS;
+    m_classes[index]->release(ptr);
+}
+
+std::coroutine_handle<> task::final_awaiter::await_suspend(handle h) noexcept
+{
+    auto& promise = h.promise();
+
+    // awaited task is destroyed by its owner in awaiting frame
+    if (!promise.owner)
+        return promise.continuation ? promise.continuation : std::noop_coroutine();
+
+    auto& s = *promise.owner;
+
+    if (promise.prev)
+        promise.prev->next = promise.next;
+    else
+        s.m_tasks = promise.next;
+
+    if (promise.next)
+        promise.next->prev = promise.prev;
+
+    s.m_active--;
+    s.m_counters.finished++;
+    h.destroy();
+
+    return std::noop_coroutine();
+}
+
+probe_ticket& probe_ticket::operator=(probe_ticket&& other) noexcept
+{
+    if (this != &other) {
+        if (m_owner)
+            m_owner->abandon(m_record);
+
+        m_owner  = std::exchange(other.m_owner, nullptr);
+        m_record = other.m_record;
+    }
+
+    return *this;
+}
+
+probe_ticket::~probe_ticket(void) noexcept
+{
+    if (m_owner)
+        m_owner->abandon(m_record);
+}
+
+scheduler::scheduler(transport& io, std::uint32_t max_inflight, std::uint64_t rate,
+    std::uint64_t timeout_ns) noexcept
+    : m_io(io), m_timeout(timeout_ns), m_base_id(static_cast<std::uint16_t>(getpid()))
+{
+    auto capacity = std::bit_ceil(std::max<std::uint32_t>(max_inflight, 1));
+    auto ids      = std::max<std::uint32_t>(capacity / SLOT_IDS_SPAN, 1);
+
+    m_templates.resize(ids);
+    for (std::uint32_t i = 0; i < ids; i++)
+        m_templates[i].init(m_base_id + i);
+
+    m_slots.resize(capacity, slot {});
+    m_free.resize(capacity);
+
+    // lowest slots are taken first
+    for (std::uint32_t i = 0; i < capacity; i++)
+        m_free[i] = capacity - 1 - i;
+
+    m_records.reserve(capacity);
+    m_timers.reserve(capacity);
+    m_ready.reserve(capacity);
+    m_step_ns = rate ? 1000000000 / rate : 0;
+
+    // probes lost by batching transport are resolved like failed sends
+    m_io.on_drop(handle_drop, this);
+}
+
+scheduler::~scheduler(void) noexcept
+{
+    m_io.on_drop(nullptr, nullptr);
+
+    // tasks left by stop(), their awaited tasks are destroyed with them
+    while (m_tasks) {
+        auto next = m_tasks->next;
+        task::handle::from_promise(*m_tasks).destroy();
+        m_tasks = next;
+    }
+}
+
+void scheduler::spawn(task&& t) noexcept
+{
+    auto h = t.release();
+
+    if (!h)
+        return;
+
+    auto& promise = h.promise();
+    promise.owner = this;
+    promise.next  = m_tasks;
+
+    if (m_tasks)
+        m_tasks->prev = &promise;
+
+    m_tasks = &promise;
+    m_active++;
+    m_counters.spawned++;
+    m_ready.push_back(h);
+}
+
+void scheduler::run(void) noexcept
+{
+    m_next_ns = now();
+
+    while (!m_stopped) {
+        resume_ready();
+        receive();
+        expire();
+        resume_ready();
+
+        if (!m_active || m_stopped)
+            break;
+
+        auto deadline = m_timers.empty() ? UINT64_MAX : m_timers.front().deadline;
+        m_io.wait(m_ready.empty() ? deadline : 0);
+    }
+}
+
+void scheduler::stop(void) noexcept
+{
+    m_stopped = 1;
+}
+
+scheduler::send_awaiter scheduler::send(in_addr_t dst, std::uint8_t ttl) noexcept
+{
+    if (!m_step_ns)
+        return {*this, dst, ttl, 0};
+
+    // probes of all tasks share one pace
+    auto at   = std::max(m_next_ns, now());
+    m_next_ns = at + m_step_ns;
+
+    return {*this, dst, ttl, at};
+}
+
+const scheduler_counters& scheduler::counters(void) const noexcept
+{
+    return m_counters;
+}
+
+std::size_t scheduler::memory(void) const noexcept
+{
+    return m_templates.capacity() * sizeof(icmp_echo) + m_slots.capacity() * sizeof(slot) +
+        m_free.capacity() * sizeof(std::uint32_t) + m_records.capacity() * sizeof(record) +
+        m_free_records.capacity() * sizeof(std::uint32_t) +
+        m_timers.capacity() * sizeof(timer) +
+        m_ready.capacity() * sizeof(std::coroutine_handle<>) +
+        m_senders.capacity() * sizeof(send_awaiter*);
+}
+
+void scheduler::wake_at(std::uint64_t deadline, std::coroutine_handle<> h) noexcept
+{
+    m_timers.push_back({deadline, h, nullptr, 0, 0});
+    std::push_heap(m_timers.begin(), m_timers.end(), std::greater<> {});
+}
+
+void scheduler::wait_send(send_awaiter& sender) noexcept
+{
+    if (sender.at > now()) {
+        m_timers.push_back({sender.at, nullptr, &sender, 0, 0});
+        std::push_heap(m_timers.begin(), m_timers.end(), std::greater<> {});
+        return;
+    }
+
+    if (m_free.size() > m_promised)
+        grant(sender);
+    else
+        m_senders.push_back(&sender);
+}
+
+void scheduler::grant(send_awaiter& sender) noexcept
+{
+    m_promised++;
+    sender.promised = true;
+    m_ready.push_back(sender.h);
+}
+
+probe_ticket scheduler::send_now(in_addr_t dst, std::uint8_t ttl) noexcept
+{
+    std::uint32_t r;
+
+    if (m_free_records.empty()) {
+        r = m_records.size();
+        m_records.push_back({});
+    }
+    else {
+        r = m_free_records.back();
+        m_free_records.pop_back();
+    }
+
+    auto index = m_free.back();
+    m_free.pop_back();
+
+    auto& s   = m_slots[index];
+    auto& rec = m_records[r];
+    auto& t   = m_templates[index / SLOT_IDS_SPAN];
+
+    s.used   = true;
+    s.dst    = dst;
+    s.record = r;
+
+    rec.done      = false;
+    rec.abandoned = false;
+    rec.waiter    = nullptr;
+    rec.result    = {};
+
+    rec.result.seq     = index;
+    rec.result.ttl     = ttl;
+    rec.result.send_ns = now();
+
+    // timeout frees slot even if task never awaits reply
+    m_timers.push_back({rec.result.send_ns + m_timeout, nullptr, nullptr, index,
+        s.generation});
+    std::push_heap(m_timers.begin(), m_timers.end(), std::greater<> {});
+
+    t.set(static_cast<std::uint16_t>(index));
+    m_counters.sent++;
+
+    // probe dropped locally is resolved at once as timeout
+    if (!m_io.send(dst, ttl, t.packet(), icmp_echo::SIZE)) {
+        m_records[r].result.timeout = true;
+        m_counters.timeouts++;
+        resolve(index);
+    }
+
+    return {*this, r};
+}
+
+void scheduler::resolve(std::uint32_t index) noexcept
+{
+    auto& s   = m_slots[index];
+    auto& rec = m_records[s.record];
+
+    rec.done = true;
+
+    // nobody will take outcome of dropped ticket
+    if (rec.abandoned)
+        m_free_records.push_back(s.record);
+    else if (rec.waiter)
+        m_ready.push_back(rec.waiter);  // reply may come before task awaits it
+
+    s.used = false;
+    s.generation++;
+    m_free.push_back(index);
+
+    // freed slot goes to longest waiting send
+    if (m_sender < m_senders.size() && m_free.size() > m_promised) {
+        grant(*m_senders[m_sender++]);
+
+        if (m_sender == m_senders.size()) {
+            m_senders.clear();
+            m_sender = 0;
+        }
+    }
+}
+
+void scheduler::handle_drop(const std::uint8_t *packet, [[maybe_unused]] std::size_t size,
+    [[maybe_unused]] std::int32_t error, void *ctx) noexcept
+{
+    auto& self = *static_cast<scheduler*>(ctx);
+    std::uint16_t id, seq;
+
+    std::memcpy(&id, packet + icmp_echo_layout::ID_OFFSET, sizeof(id));
+    std::memcpy(&seq, packet + icmp_echo_layout::SEQ_OFFSET, sizeof(seq));
+
+    std::uint64_t id_index = static_cast<std::uint16_t>(id - self.m_base_id);
+    auto index             = id_index * SLOT_IDS_SPAN + seq;
+
+    if (index >= self.m_slots.size() || !self.m_slots[index].used)
+        return;
+
+    self.m_records[self.m_slots[index].record].result.timeout = true;
+    self.m_counters.timeouts++;
+    self.resolve(index);
+}
+
+probe_result scheduler::take(probe_ticket& ticket) noexcept
+{
+    auto& rec   = m_records[ticket.m_record];
+    auto result = rec.result;
+
+    rec.waiter     = nullptr;
+    ticket.m_owner = nullptr;
+    m_free_records.push_back(ticket.m_record);
+
+    return result;
+}
+
+void scheduler::abandon(std::uint32_t r) noexcept
+{
+    auto& rec = m_records[r];
+
+    // task awaiting reply may be destroyed by stop()
+    rec.waiter = nullptr;
+
+    if (rec.done)
+        m_free_records.push_back(r);
+    else
+        rec.abandoned = true;
+}
+
+void scheduler::receive(void) noexcept
+{
+    std::uint64_t recv_ns;
+    std::ptrdiff_t size;
+
+    while ((size = m_io.recv(m_buffer, sizeof(m_buffer), recv_ns)) >= 0) {
+        reply_info info;
+
+        if (!parse_reply(m_buffer, size, info)) {
+            m_counters.filtered++;
+            continue;
+        }
+
+        // restore slot from echo identifier & sequence
+        std::uint64_t id_index = static_cast<std::uint16_t>(info.id - m_base_id);
+        auto index             = id_index * SLOT_IDS_SPAN + info.seq;
+
+        // late or duplicated reply, slot is already resolved or reused
+        if (index >= m_slots.size() || !m_slots[index].used ||
+            m_slots[index].dst != info.target) {
+            m_counters.foreign++;
+            continue;
+        }
+
+        auto& result     = m_records[m_slots[index].record].result;
+        result.reply_ttl = info.ttl;
+        result.type      = info.type;
+        result.code      = info.code;
+        result.from      = info.from;
+        result.recv_ns   = recv_ns;
+        m_counters.received++;
+
+        resolve(index);
+    }
+}
+
+void scheduler::expire(void) noexcept
+{
+    auto time = now();
+
+    while (!m_timers.empty() && m_timers.front().deadline <= time) {
+        std::pop_heap(m_timers.begin(), m_timers.end(), std::greater<> {});
+        auto t = m_timers.back();
+        m_timers.pop_back();
+
+        if (t.h) {
+            m_ready.push_back(t.h);
+            continue;
+        }
+
+        if (t.sender) {
+            if (m_free.size() > m_promised)
+                grant(*t.sender);
+            else
+                m_senders.push_back(t.sender);
+
+            continue;
+        }
+
+        // timer of resolved or reused slot
+        auto& s = m_slots[t.slot];
+
+        if (!s.used || s.generation != t.generation)
+            continue;
+
+        m_records[s.record].result.timeout = true;
+        m_counters.timeouts++;
+        resolve(t.slot);
+    }
+}
+
+void scheduler::resume_ready(void) noexcept
+{
+    // resumed coroutines may make more coroutines ready
+    for (std::size_t i = 0; i < m_ready.size(); i++) {
+        m_counters.resumes++;
+        m_ready[i].resume();
+    }
+
+    m_ready.clear();
+}
+
+} // namespace ntool
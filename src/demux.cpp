@@ -0,0 +1,154 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/demux.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/icmp.hpp>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+
+
+namespace ntool {
+
+inline const std::uint32_t ECHO_IDS {1 << 16};  // echo identifiers of process
+
+icmp_demux::icmp_demux(transport& io) noexcept
+    : m_io(io), m_base_id(static_cast<std::uint16_t>(getpid()))
+{}
+
+void icmp_demux::reserve(engine_config& config) noexcept
+{
+    auto ids = echo_ids(config.max_inflight);
+
+    if (m_next_id + ids > ECHO_IDS)
+        utils::error("ntool: demux: out of echo identifiers");
+
+    config.first_id  = static_cast<std::uint16_t>(m_base_id + m_next_id);
+    m_next_id       += ids;
+}
+
+void icmp_demux::attach(engine& session) noexcept
+{
+    std::uint32_t offset = static_cast<std::uint16_t>(session.first_id() - m_base_id);
+
+    if (m_owners.size() < offset + session.ids())
+        m_owners.resize(offset + session.ids(), nullptr);
+
+    std::fill_n(m_owners.begin() + offset, session.ids(), &session);
+    m_sessions.push_back(&session);
+
+    // engine constructor took drop handler of shared transport
+    m_io.on_drop(dispatch_drop, this);
+}
+
+void icmp_demux::run(void) noexcept
+{
+    for (auto session : m_sessions)
+        session->start();
+
+    while (true) {
+        for (auto session : m_sessions)
+            session->send_due();
+
+        receive();
+
+        // finished engines stay attached, their late replies are dropped
+        std::uint64_t deadline = UINT64_MAX;
+        bool active            = false;
+
+        for (auto session : m_sessions) {
+            if (auto next = session->service()) {
+                deadline = std::min(deadline, next);
+                active   = true;
+            }
+        }
+
+        if (!active)
+            break;
+
+        m_io.wait(deadline);
+    }
+}
+
+const demux_counters& icmp_demux::counters(void) const noexcept
+{
+    return m_counters;
+}
+
+std::size_t icmp_demux::sessions(void) const noexcept
+{
+    return m_sessions.size();
+}
+
+void icmp_demux::receive(void) noexcept
+{
+    std::uint64_t recv_ns;
+    std::ptrdiff_t size;
+
+    while ((size = m_io.recv(m_buffer, sizeof(m_buffer), recv_ns)) >= 0) {
+        reply_info info;
+        auto recv_tsc = read_tsc();
+        m_counters.received++;
+
+        bool truncated = static_cast<std::size_t>(size) >= sizeof(m_buffer);
+        bool filtered  = !parse_reply(m_buffer, size, info);
+
+        m_counters.truncated += truncated;
+
+        // socket counters go to first engine, like engine without demux
+        if (filtered || truncated)
+            m_sessions.front()->count_packet(filtered, truncated);
+
+        if (filtered) {
+            m_counters.filtered++;
+            continue;
+        }
+
+        m_counters.parsed++;
+
+        // echo identifier tells owning engine without parsing again
+        auto session = owner(info.id);
+
+        if (!session) {
+            m_counters.foreign++;
+            continue;
+        }
+
+        m_counters.dispatched++;
+        session->deliver(info, recv_ns, recv_tsc);
+    }
+}
+
+void icmp_demux::dispatch_drop(const std::uint8_t *packet,
+    [[maybe_unused]] std::size_t size, std::int32_t error, void *ctx) noexcept
+{
+    std::uint16_t id;
+    std::memcpy(&id, packet + icmp_echo_layout::ID_OFFSET, sizeof(id));
+
+    if (auto session = static_cast<icmp_demux*>(ctx)->owner(id))
+        session->drop(packet, error);
+}
+
+engine *icmp_demux::owner(std::uint16_t id) const noexcept
+{
+    std::uint32_t offset = static_cast<std::uint16_t>(id - m_base_id);
+    return (offset < m_owners.size()) ? m_owners[offset] : nullptr;
+}
+
+} // namespace ntool
@@ -0,0 +1,156 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/detect.hpp>
+#include <algorithm>
+#include <cmath>
+
+
+namespace ntool {
+
+inline const std::uint8_t ALARM_BURST {1 << 0};     // loss burst reported
+inline const std::uint8_t ALARM_RATE  {1 << 1};     // loss rate reported
+
+
+anomaly_detector::anomaly_detector(std::size_t targets, const detector_config& config) noexcept
+    : m_config(config), m_states(targets, detector_state {})
+{
+}
+
+bool anomaly_detector::update(std::uint32_t target, double rtt, anomaly_event& event) noexcept
+{
+    auto& s      = m_states[target];
+    event.target = target;
+
+    if (std::isnan(rtt))
+        return lost(s, event);
+
+    return reply(s, static_cast<float>(rtt), event);
+}
+
+const detector_state& anomaly_detector::state(std::uint32_t target) const noexcept
+{
+    return m_states[target];
+}
+
+bool anomaly_detector::reply(detector_state& s, float rtt, anomaly_event& event) noexcept
+{
+    const auto& c = m_config;
+    bool detected = false;
+
+    s.loss -= c.loss_alpha * s.loss;
+
+    if (s.alarms & ALARM_BURST) {
+        event.kind     = anomaly_kind::recovered;
+        event.value    = s.losses;
+        event.baseline = s.loss;
+        detected       = true;
+    }
+
+    s.losses = 0;
+    s.alarms &= ~ALARM_BURST;
+
+    // rearm loss rate alarm with hysteresis
+    if (s.loss < c.loss_rate * 0.5f)
+        s.alarms &= ~ALARM_RATE;
+
+    // running average until warmup is over, then exponential
+    auto alpha = std::max(c.alpha, 1.0f / (s.samples + 1));
+    auto diff  = rtt - s.mean;
+
+    if (s.samples >= c.warmup) {
+        auto dev = std::max({std::sqrt(s.var), c.min_dev * s.mean, 1e-3f});
+        diff     = std::clamp(diff, -c.band * dev, c.band * dev);
+
+        auto z = diff / dev;
+        s.up   = std::max(0.0f, s.up + z - c.drift);
+        s.down = std::max(0.0f, s.down - z - c.drift);
+
+        if ((s.up > c.threshold || s.down > c.threshold) && !detected) {
+            event.kind     = (s.up > c.threshold) ? anomaly_kind::latency_up
+                                                  : anomaly_kind::latency_down;
+            event.value    = rtt;
+            event.baseline = s.mean;
+            detected       = true;
+
+            // new level becomes baseline
+            s.mean = rtt;
+            s.up   = 0.0f;
+            s.down = 0.0f;
+            return detected;
+        }
+    }
+
+    s.mean += alpha * diff;
+    s.var   = (1.0f - alpha) * (s.var + alpha * diff * diff);
+
+    if (s.samples < UINT16_MAX)
+        s.samples++;
+
+    return detected;
+}
+
+bool anomaly_detector::lost(detector_state& s, anomaly_event& event) noexcept
+{
+    const auto& c = m_config;
+
+    s.loss += c.loss_alpha * (1.0f - s.loss);
+
+    if (s.losses < UINT8_MAX)
+        s.losses++;
+
+    if (s.losses >= c.burst && !(s.alarms & ALARM_BURST)) {
+        s.alarms      |= ALARM_BURST;
+        event.kind     = anomaly_kind::loss_burst;
+        event.value    = s.losses;
+        event.baseline = s.loss;
+        return true;
+    }
+
+    if (s.loss >= c.loss_rate && !(s.alarms & ALARM_RATE)) {
+        s.alarms      |= ALARM_RATE;
+        event.kind     = anomaly_kind::loss_rate;
+        event.value    = s.loss;
+        event.baseline = c.loss_rate;
+        return true;
+    }
+
+    return false;
+}
+
+const char *anomaly_name(anomaly_kind kind) noexcept
+{
+    switch (kind) {
+    case anomaly_kind::latency_up:
+        return "latency_up";
+
+    case anomaly_kind::latency_down:
+        return "latency_down";
+
+    case anomaly_kind::loss_burst:
+        return "loss_burst";
+
+    case anomaly_kind::loss_rate:
+        return "loss_rate";
+
+    default:
+        return "recovered";
+    }
+}
+
+} // namespace ntool
@@ -0,0 +1,462 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/engine.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/usdt.hpp>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+
+namespace ntool {
+
+inline const std::uint32_t SEND_BURST    {64};       // sends per loop
+inline const std::uint64_t ECHO_IDS_SPAN {1 << 16};  // probes per id
+
+std::uint32_t echo_ids(std::uint32_t capacity) noexcept
+{
+    return std::max<std::uint64_t>(std::bit_ceil<std::uint64_t>(capacity) / ECHO_IDS_SPAN, 1);
+}
+
+/**
+ * @brief Handle probe dropped by transport.
+ *
+ * @param [in] packet - given ICMP packet of probe.
+ * @param [in] size - given ICMP packet size in bytes.
+ * @param [in] error - given errno of failed send.
+ * @param [in] ctx - given engine.
+ */
+static void handle_drop(const std::uint8_t *packet,
+    [[maybe_unused]] std::size_t size, std::int32_t error, void *ctx) noexcept
+{
+    static_cast<engine*>(ctx)->drop(packet, error);
+}
+
+engine::engine(transport& io, const engine_config& config,
+    result_handler handler, void *ctx) noexcept
+    : m_io(io), m_config(config), m_handler(handler), m_ctx(ctx),
+      m_inflight(config.max_inflight,
+          echo_ids(config.max_inflight) * ECHO_IDS_SPAN, config.huge_pages),
+      m_flight(flight_recorder::local())
+{
+    auto ids  = echo_ids(config.max_inflight);
+    m_base_id = static_cast<std::uint16_t>((config.first_id < 0) ? getpid() : config.first_id);
+    m_probes  = std::max<std::uint64_t>(config.samples ? config.samples : config.hops, 1);
+
+    if (config.instrument)
+        m_stats = std::make_unique<engine_stats>();
+
+    // shared demultiplexer routes drops by echo identifier instead
+    m_io.on_drop(handle_drop, this);
+
+    // each echo identifier covers 65536 sequence numbers
+    m_templates.resize(ids);
+    for (std::uint64_t i = 0; i < ids; i++)
+        m_templates[i].init(m_base_id + i);
+}
+
+std::uint32_t engine::add_target(in_addr_t addr) noexcept
+{
+    return add_target(addr, std::max<std::uint8_t>(m_config.hops, 1));
+}
+
+std::uint32_t engine::add_target(in_addr_t addr, std::uint8_t hops) noexcept
+{
+    m_targets.push_back(addr);
+    m_hops.push_back(std::max<std::uint8_t>(hops, 1));
+    return m_targets.size() - 1;
+}
+
+void engine::set_poll(std::int32_t fd, poll_handler handler, void *ctx) noexcept
+{
+    m_io.watch(fd);
+    m_poll     = handler;
+    m_poll_ctx = ctx;
+}
+
+void engine::run(void) noexcept
+{
+    if (m_targets.empty())
+        return;
+
+    start();
+
+    while (true) {
+        send_due();
+        receive();
+
+        auto deadline = service();
+
+        if (!deadline)
+            break;
+
+        m_io.wait(deadline);
+    }
+}
+
+void engine::start(void) noexcept
+{
+    std::uint64_t round = std::max<std::uint64_t>(m_targets.size() * m_probes, 1);
+    m_total             = m_config.count * round;
+
+    // spread each round of probes evenly over interval
+    m_next_ns  = m_io.now();
+    m_step_ns  = m_config.interval_ns / round;
+    m_step_rem = m_config.interval_ns % round;
+    m_rem_acc  = 0;
+    m_more     = !m_targets.empty();
+
+    if (m_stats) {
+        m_stats->tsc_base = read_tsc();
+        m_stats->ns_base  = utils::clock_ns();
+    }
+}
+
+void engine::send_due(void) noexcept
+{
+    auto now  = m_io.now();
+    m_more    = !m_targets.empty() && (m_config.count == 0 || m_inflight.sent() < m_total);
+    m_stalled = false;
+
+    for (std::uint32_t i = 0; m_more && !m_stopped && i < SEND_BURST; i++) {
+        if (m_next_ns > now)
+            break;
+
+        // oldest probe is still in flight, its slot can't be reused
+        if (m_inflight.full()) {
+            m_counters.stalls++;
+            m_flight.record(flight_event::stall, now, 0, 0, 0);
+            m_stalled = true;
+            break;
+        }
+
+        send_probe(now);
+        m_more = m_config.count == 0 || m_inflight.sent() < m_total;
+    }
+}
+
+std::uint64_t engine::service(void) noexcept
+{
+    expire(m_io.now());
+
+    if (m_poll && (m_io.watched() || m_io.now() >= m_poll_ns)) {
+        m_poll(m_poll_ctx);
+        m_poll_ns = m_io.now() + POLL_PERIOD_NS;
+    }
+
+    if (m_stopped || (!m_more && m_inflight.pending() == 0))
+        return 0;
+
+    auto deadline = m_poll ? m_poll_ns : UINT64_MAX;
+
+    if (m_more && !m_stalled)
+        deadline = std::min(deadline, m_next_ns);
+
+    if (auto oldest = m_inflight.oldest())
+        deadline = std::min(deadline, oldest->send_ns + m_config.timeout_ns);
+
+    return deadline;
+}
+
+void engine::stop(void) noexcept
+{
+    m_stopped = 1;
+}
+
+const engine_counters& engine::counters(void) const noexcept
+{
+    return m_counters;
+}
+
+std::size_t engine::memory(void) const noexcept
+{
+    return m_targets.capacity() * sizeof(in_addr_t) + m_hops.capacity() + fixed_memory();
+}
+
+std::size_t engine::fixed_memory(void) const noexcept
+{
+    return m_templates.capacity() * sizeof(icmp_echo) +
+        m_inflight.capacity() * sizeof(inflight_slot);
+}
+
+const engine_stats *engine::stats(void) const noexcept
+{
+    return m_stats.get();
+}
+
+void engine::identify(std::uint64_t probe, probe_result& result) const noexcept
+{
+    auto round    = m_targets.size() * m_probes;
+    auto index    = probe % round;
+    result.target = index / m_probes;
+    result.seq    = probe / round + 1;
+    result.ttl    = m_config.hops ? index % m_probes + 1 : m_config.ttl;
+
+    if (!m_config.samples)
+        return;
+
+    // each round continues sampling where previous one stopped
+    auto step  = (result.seq - 1 + m_config.first_round) * m_probes + index % m_probes;
+    result.ttl = step % m_hops[result.target] + 1;
+}
+
+void engine::send_probe(std::uint64_t now) noexcept
+{
+    probe_result id;
+    auto probe = m_inflight.sent();
+    auto& tmpl = m_templates[(probe / ECHO_IDS_SPAN) % m_templates.size()];
+
+    identify(probe, id);
+    tmpl.set(static_cast<std::uint16_t>(probe));
+
+    auto addr    = m_targets[id.target];
+    auto& slot   = m_inflight.push();
+    slot.send_ns = m_io.now();
+
+    if (m_stats) {
+        m_stats->start(m_counters.sent);
+
+        if (m_stats->active)
+            m_stats->add(stage::schedule, slot.send_ns - std::min(slot.send_ns, m_next_ns));
+    }
+
+    NTOOL_USDT4(schedule, addr, id.seq,
+        slot.send_ns - std::min(slot.send_ns, m_next_ns), m_inflight.pending()
+    );
+
+    // lost probe will be reported as timeout
+    bool sent = m_io.send(addr, id.ttl, tmpl.packet(), icmp_echo::SIZE);
+
+    if (sent)
+        m_flight.record(flight_event::sent, slot.send_ns, addr, id.seq, id.ttl);
+    else {
+        m_counters.send_errors++;
+        m_flight.record(flight_event::send_error, slot.send_ns, addr, id.seq, id.ttl, errno);
+    }
+
+    NTOOL_USDT4(send, addr, id.seq, id.ttl, sent);
+
+    m_counters.sent++;
+    lap(stage::send);
+
+    // advance schedule, distributing interval remainder
+    m_next_ns += m_step_ns;
+    m_rem_acc += m_step_rem;
+
+    if (m_rem_acc >= m_targets.size() * m_probes) {
+        m_rem_acc -= m_targets.size() * m_probes;
+        m_next_ns++;
+    }
+
+    // keep schedule from bursting after long stall
+    if (m_next_ns + m_config.interval_ns < now)
+        m_next_ns = now;
+}
+
+void engine::receive(void) noexcept
+{
+    std::uint64_t recv_ns;
+    std::ptrdiff_t size;
+
+    while ((size = m_io.recv(m_buffer, sizeof(m_buffer), recv_ns)) >= 0) {
+        reply_info info;
+        auto recv_tsc = m_stats ? read_tsc() : 0;
+
+        if (static_cast<std::size_t>(size) >= sizeof(m_buffer))
+            m_counters.truncated++;
+
+        if (!parse_reply(m_buffer, size, info)) {
+            m_counters.filtered++;
+            continue;
+        }
+
+        deliver(info, recv_ns, recv_tsc);
+    }
+}
+
+void engine::deliver(const reply_info& info, std::uint64_t recv_ns,
+    std::uint64_t recv_tsc) noexcept
+{
+    if (m_stats)
+        m_stats->start(m_counters.received, recv_tsc);
+
+    // restore on-wire probe number from echo identifier & sequence
+    std::uint64_t id_index = static_cast<std::uint16_t>(info.id - m_base_id);
+
+    if (id_index >= m_templates.size()) {
+        m_counters.foreign++;
+        m_flight.record(flight_event::foreign, recv_ns, info.from, info.seq, info.ttl);
+        return;
+    }
+
+    auto slot = m_inflight.find((id_index * ECHO_IDS_SPAN) | info.seq);
+    probe_result result;
+
+    if (slot)
+        identify(slot->probe - 1, result);
+
+    // late or duplicated reply, slot is already resolved or reused
+    if (!slot || m_targets[result.target] != info.target) {
+        m_counters.foreign++;
+        m_flight.record(flight_event::foreign, recv_ns, info.from, info.seq, info.ttl);
+        return;
+    }
+
+    result.reply_ttl = info.ttl;
+    result.type      = info.type;
+    result.code      = info.code;
+    result.timeout   = false;
+    result.from      = info.from;
+    result.send_ns   = slot->send_ns;
+    result.recv_ns   = recv_ns;
+
+    m_inflight.resolve(*slot);
+    m_counters.received++;
+    m_flight.record(flight_event::reply, recv_ns, info.from, result.seq, result.ttl,
+        static_cast<std::uint32_t>(std::min<std::uint64_t>(
+            (recv_ns - result.send_ns) / 1000, UINT32_MAX))
+    );
+    lap(stage::parse);
+
+    NTOOL_USDT5(reply, m_targets[result.target], result.seq, result.ttl,
+        recv_ns - result.send_ns, result.from
+    );
+
+    m_handler(result, m_ctx);
+    lap(stage::output);
+}
+
+void engine::drop(const std::uint8_t *packet, std::int32_t error) noexcept
+{
+    std::uint16_t id, seq;
+    std::memcpy(&id, packet + icmp_echo_layout::ID_OFFSET, sizeof(id));
+    std::memcpy(&seq, packet + icmp_echo_layout::SEQ_OFFSET, sizeof(seq));
+
+    std::uint64_t id_index = static_cast<std::uint16_t>(id - m_base_id);
+
+    if (id_index >= m_templates.size())
+        return;
+
+    auto slot = m_inflight.find((id_index * ECHO_IDS_SPAN) | seq);
+
+    // probe may be already resolved
+    if (!slot)
+        return;
+
+    probe_result result;
+    identify(slot->probe - 1, result);
+
+    m_counters.send_errors++;
+    m_flight.record(flight_event::send_error, slot->send_ns, m_targets[result.target],
+        result.seq, result.ttl, error
+    );
+}
+
+void engine::expire(std::uint64_t now) noexcept
+{
+    while (auto slot = m_inflight.oldest()) {
+        if (slot->send_ns + m_config.timeout_ns > now)
+            break;
+
+        probe_result result {};
+        identify(slot->probe - 1, result);
+        result.timeout = true;
+        result.send_ns = slot->send_ns;
+
+        m_inflight.resolve(*slot);
+        m_counters.timeouts++;
+        m_flight.record(flight_event::timeout, now, m_targets[result.target], result.seq,
+            result.ttl
+        );
+
+        NTOOL_USDT4(timeout, m_targets[result.target], result.seq, result.ttl,
+            m_inflight.pending()
+        );
+
+        if (m_stats)
+            m_stats->start(m_counters.timeouts);
+
+        m_handler(result, m_ctx);
+        lap(stage::output);
+    }
+}
+
+const char *stage_name(stage s) noexcept
+{
+    switch (s) {
+    case stage::schedule:
+        return "schedule->send";
+
+    case stage::send:
+        return "send";
+
+    case stage::parse:
+        return "recv->parse";
+
+    case stage::stats:
+        return "parse->stats";
+
+    default:
+        return "stats->output";
+    }
+}
+
+void print_engine_stats(std::FILE *stream, const engine& e) noexcept
+{
+    const auto& c = e.counters();
+
+    std::fprintf(stream, "\n--- engine statistics ---\n");
+    std::fprintf(stream, "sent %lu, received %lu, timeouts %lu, send errors %lu, stalls %lu\n",
+        c.sent, c.received, c.timeouts, c.send_errors, c.stalls
+    );
+    std::fprintf(stream, "filtered %lu, foreign %lu, truncated %lu\n",
+        c.filtered, c.foreign, c.truncated
+    );
+
+    auto m = memory_stats();
+    std::fprintf(stream, "mapped %lu kB (huge %lu kB), arena %lu kB, slab allocs %lu, frees %lu\n",
+        m.mapped >> 10, m.huge >> 10, m.arena >> 10, m.slab_allocs, m.slab_frees
+    );
+
+    auto stats = e.stats();
+
+    if (!stats)
+        return;
+
+    // calibrate counter against clock over whole run
+    auto ns     = utils::clock_ns() - stats->ns_base;
+    auto cycles = read_tsc() - stats->tsc_base;
+    auto scale  = (cycles > 0) ? static_cast<double>(ns) / cycles : 1.0;
+
+    std::fprintf(stream, "%-16s %10s %10s %10s %10s %12s\n", "stage (us)", "p50", "p90",
+        "p99", "p99.9", "sampled");
+
+    for (std::uint32_t i = 0; i < STAGES; i++) {
+        const auto& h = stats->stages[i];
+        auto unit     = (i == static_cast<std::uint32_t>(stage::schedule)) ? 1e-3 : scale * 1e-3;
+
+        std::fprintf(stream, "%-16s %10.3f %10.3f %10.3f %10.3f %12lu\n",
+            stage_name(static_cast<stage>(i)), h.percentile(0.5) * unit,
+            h.percentile(0.9) * unit, h.percentile(0.99) * unit,
+            h.percentile(0.999) * unit, h.total()
+        );
+    }
+}
+
+} // namespace ntool
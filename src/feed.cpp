@@ -0,0 +1,241 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/feed.hpp>
+#include <ntool/utils.hpp>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <fcntl.h>
+#include <ctime>
+#include <bit>
+
+
+namespace ntool {
+
+/**
+ * @brief Get POSIX shared memory object name of feed.
+ *
+ * @param [in] name - given feed name.
+ * @return object name starting with slash.
+ */
+static std::string object_name(const char *name) noexcept;
+
+
+feed_writer::feed_writer(const char *name, std::uint32_t capacity) noexcept
+    : m_name(object_name(name))
+{
+    capacity = std::bit_ceil(std::max<std::uint32_t>(capacity, 64));
+    m_size   = sizeof(feed_header) + capacity * sizeof(feed_slot);
+    m_mask   = capacity - 1;
+
+    // attached readers keep previous feed, new ones see this one
+    shm_unlink(m_name.c_str());
+    auto fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    if (fd < 0)
+        utils::error("ntool: feed: cannot create shared memory");
+
+    if (ftruncate(fd, m_size) == -1)
+        utils::error("ntool: feed: cannot allocate shared memory");
+
+    auto data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        utils::error("ntool: feed: cannot map shared memory");
+
+    m_header = static_cast<feed_header*>(data);
+    m_slots  = reinterpret_cast<feed_slot*>(m_header + 1);
+
+    timespec now {};
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    m_header->version    = FEED_VERSION;
+    m_header->slot_size  = sizeof(feed_slot);
+    m_header->capacity   = capacity;
+    m_header->created_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+    m_header->clock_ns   = utils::clock_ns();
+
+    // readers check magic, so it is written last
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, FEED_MAGIC, sizeof(FEED_MAGIC));
+}
+
+feed_writer::~feed_writer(void) noexcept
+{
+    if (!m_header)
+        return;
+
+    m_header->closed.store(1, std::memory_order_release);
+    munmap(m_header, m_size);
+    shm_unlink(m_name.c_str());
+}
+
+void feed_writer::publish(const probe_result& result, in_addr_t target, record_kind kind) noexcept
+{
+    auto& slot = m_slots[m_head & m_mask];
+
+    // odd sequence marks slot as being written
+    slot.seq.store(2 * m_head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto& r     = slot.record;
+    r.send_ns   = result.send_ns;
+    r.recv_ns   = result.timeout ? 0 : result.recv_ns;
+    r.target    = target;
+    r.from      = result.from;
+    r.index     = result.target;
+    r.seq       = result.seq;
+    r.kind      = static_cast<std::uint8_t>(kind);
+    r.ttl       = result.ttl;
+    r.reply_ttl = result.reply_ttl;
+    r.type      = result.type;
+    r.code      = result.code;
+
+    slot.seq.store(2 * (m_head + 1), std::memory_order_release);
+    m_head++;
+    m_header->head.store(m_head, std::memory_order_release);
+}
+
+feed_reader::~feed_reader(void) noexcept
+{
+    if (m_header)
+        munmap(const_cast<feed_header*>(m_header), m_size);
+}
+
+bool feed_reader::open(const char *name, bool oldest) noexcept
+{
+    auto fd = shm_open(object_name(name).c_str(), O_RDONLY, 0);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(feed_header)) {
+        close(fd);
+        return false;
+    }
+
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    auto header = static_cast<const feed_header*>(data);
+    auto size   = sizeof(feed_header) + std::uint64_t(header->capacity) * sizeof(feed_slot);
+
+    if (std::memcmp(header->magic, FEED_MAGIC, sizeof(FEED_MAGIC)) != 0 ||
+        header->version != FEED_VERSION || header->slot_size != sizeof(feed_slot) ||
+        !std::has_single_bit(header->capacity) || size > static_cast<std::size_t>(st.st_size)) {
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    m_header = header;
+    m_slots  = reinterpret_cast<const feed_slot*>(header + 1);
+    m_size   = st.st_size;
+    m_mask   = header->capacity - 1;
+
+    auto head = header->head.load(std::memory_order_acquire);
+    m_next    = oldest ? head - std::min<std::uint64_t>(head, header->capacity) : head;
+
+    return true;
+}
+
+std::size_t feed_reader::read(feed_record *records, std::size_t max) noexcept
+{
+    auto head     = m_header->head.load(std::memory_order_acquire);
+    auto capacity = m_mask + 1;
+
+    // writer has lapped reader, oldest records are gone
+    if (head - m_next > capacity) {
+        m_lost += head - capacity - m_next;
+        m_next  = head - capacity;
+    }
+
+    std::size_t count = 0;
+
+    while (count < max && m_next < head) {
+        const auto& slot = m_slots[m_next & m_mask];
+        auto expected    = 2 * (m_next + 1);
+
+        if (slot.seq.load(std::memory_order_acquire) == expected) {
+            records[count] = slot.record;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // record is valid only if slot was not rewritten during copy
+            if (slot.seq.load(std::memory_order_relaxed) == expected)
+                count++;
+            else
+                m_lost++;
+        }
+        else
+            m_lost++;
+
+        m_next++;
+    }
+
+    return count;
+}
+
+bool feed_reader::finished(void) const noexcept
+{
+    return m_header->closed.load(std::memory_order_acquire) &&
+        m_next >= m_header->head.load(std::memory_order_acquire);
+}
+
+std::uint64_t feed_reader::lost(void) const noexcept
+{
+    return m_lost;
+}
+
+const feed_header& feed_reader::header(void) const noexcept
+{
+    return *m_header;
+}
+
+probe_result to_result(const feed_record& record) noexcept
+{
+    probe_result result {};
+    result.target    = record.index;
+    result.seq       = record.seq;
+    result.ttl       = record.ttl;
+    result.reply_ttl = record.reply_ttl;
+    result.type      = record.type;
+    result.code      = record.code;
+    result.timeout   = record.recv_ns == 0;
+    result.from      = record.from;
+    result.send_ns   = record.send_ns;
+    result.recv_ns   = record.recv_ns;
+
+    return result;
+}
+
+static std::string object_name(const char *name) noexcept
+{
+    return (name[0] == '/') ? std::string(name) : "/" + std::string(name);
+}
+
+} // namespace ntool
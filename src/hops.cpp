@@ -0,0 +1,243 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/targets.hpp>
+#include <ntool/loader.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/coro.hpp>
+#include <ntool/hops.hpp>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <csignal>
+#include <memory>
+#include <cstdio>
+
+
+namespace ntool {
+
+/** Statistics of hop.*/
+struct hop_stats {
+    in_addr_t     router;       // last responding router (0 - none)
+    std::uint32_t sent;
+    std::uint32_t received;
+    std::uint64_t rtt_min;      // in nanoseconds
+    std::uint64_t rtt_max;
+    std::uint64_t rtt_sum;
+};
+
+/** Targets measured by coroutines & their hops.*/
+struct hops_job {
+    const std::vector<in_addr_t> *addrs;
+    std::vector<hop_stats>       stats;     // max hops per target
+    std::vector<std::uint8_t>    lengths;   // probed hops of target
+    std::vector<std::uint8_t>    reached;   // target replied
+    std::uint32_t                count;
+    std::uint8_t                 hops;
+    std::uint64_t                interval_ns;
+    std::uint64_t                timeout_ns;
+};
+
+/**
+ * @brief Measure hops of target.
+ *
+ * @param [in] s - given scheduler.
+ * @param [in,out] job - given targets & their hops.
+ * @param [in] t - given target index.
+ * @return coroutine.
+ */
+static task measure(scheduler& s, hops_job& job, std::uint32_t t) noexcept;
+
+/**
+ * @brief Print hops of target.
+ *
+ * @param [in] job - given measured targets.
+ * @param [in] t - given target index.
+ */
+static void print_hops(const hops_job& job, std::uint32_t t) noexcept;
+
+/**
+ * @brief Handle keyboard interrupt.
+ *
+ * @param [in] sig - given signal number.
+ */
+static void sigint_handler(int sig) noexcept;
+
+static scheduler *active = nullptr;
+
+
+void hop_statistics(const std::vector<const char*>& names, const hops_options& options) noexcept
+{
+    std::unique_ptr<target_table> table;
+
+    if (options.file) {
+        target_list list;
+        load_targets(options.file, 0, list);
+
+        if (list.addrs.empty())
+            utils::error("ntool: target list has no targets");
+
+        table = std::make_unique<target_table>(std::move(list));
+    }
+    else
+        table = std::make_unique<target_table>(names);
+
+    const auto& addrs = table->addrs();
+    auto hops         = std::clamp<std::uint8_t>(options.hops, 1, ROUTE_MAX_HOPS);
+
+    hops_job job;
+    job.addrs       = &addrs;
+    job.count       = std::max<std::uint32_t>(options.count, 1);
+    job.hops        = hops;
+    job.interval_ns = static_cast<std::uint64_t>(options.interval * 1e9);
+    job.timeout_ns  = static_cast<std::uint64_t>(options.timeout * 1e9);
+    job.stats.resize(addrs.size() * hops, hop_stats {});
+    job.lengths.resize(addrs.size(), hops);
+    job.reached.resize(addrs.size(), 0);
+
+    // coroutines beyond in-flight slots wait for slots freed by replies
+    // & timeouts of others
+    auto inflight = std::min<std::uint64_t>(addrs.size() * hops, HOPS_MAX_INFLIGHT);
+
+    auto io = make_transport(options.io, false);
+    // probes of all TTLs of all targets are due at once every round,
+    // pacing keeps first hop routers from rate limiting replies
+    scheduler s(*io, inflight, options.rate, job.timeout_ns);
+
+    auto& frames = frame_pool::local();
+    auto begin   = utils::clock_ns();
+
+    for (std::uint32_t t = 0; t < addrs.size(); t++)
+        s.spawn(measure(s, job, t));
+
+    auto frame_bytes = frames.bytes();
+
+    std::printf("Measuring %u hops of %zu targets, %u rounds every %.3f s, "
+        "%lu probes/s max\n", hops, addrs.size(), job.count, options.interval, options.rate
+    );
+
+    active = &s;
+    std::signal(SIGINT, sigint_handler);
+    s.run();
+    active = nullptr;
+
+    // interrupted coroutines are destroyed with scheduler, partial statistics are kept
+    auto elapsed = (utils::clock_ns() - begin) / 1e9;
+
+    if (!options.quiet) {
+        for (std::uint32_t t = 0; t < addrs.size(); t++)
+            print_hops(job, t);
+    }
+
+    const auto& c = s.counters();
+    auto reached  = std::count(job.reached.begin(), job.reached.end(), 1);
+
+    std::printf("\n--- hops statistics ---\n");
+    std::printf("%zu targets (%ld reached) in %.3f s, %lu coroutines\n", addrs.size(),
+        reached, elapsed, c.spawned
+    );
+    std::printf("probes: %lu sent, %lu received, %lu timeouts, %lu foreign, %lu resumes\n",
+        c.sent, c.received, c.timeouts, c.foreign, c.resumes
+    );
+    std::printf("memory: %.1f bytes/coroutine of frames, %.1f KB of in-flight state\n",
+        static_cast<double>(frame_bytes) / std::max<std::size_t>(addrs.size(), 1),
+        s.memory() / 1e3
+    );
+}
+
+static task measure(scheduler& s, hops_job& job, std::uint32_t t) noexcept
+{
+    probe_ticket tickets[ROUTE_MAX_HOPS];
+
+    auto addr   = (*job.addrs)[t];
+    auto *stats = &job.stats[static_cast<std::size_t>(t) * job.hops];
+    auto next   = s.now();
+
+    for (std::uint32_t round = 0; round < job.count; round++) {
+        auto length = job.lengths[t];
+
+        // all hops are probed at once, replies are taken in TTL order
+        for (std::uint8_t i = 0; i < length; i++)
+            tickets[i] = co_await s.send(addr, i + 1);
+
+        for (std::uint8_t i = 0; i < length; i++) {
+            auto result = co_await s.reply(std::move(tickets[i]));
+            auto& hop   = stats[i];
+
+            hop.sent++;
+
+            if (result.timeout)
+                continue;
+
+            auto rtt = result.recv_ns - result.send_ns;
+
+            hop.rtt_min = hop.received ? std::min(hop.rtt_min, rtt) : rtt;
+            hop.rtt_max = std::max(hop.rtt_max, rtt);
+            hop.rtt_sum += rtt;
+            hop.router  = result.from;
+            hop.received++;
+
+            // hops behind target are not probed anymore
+            if (result.type == icmp_echo_layout::REPLY) {
+                job.reached[t] = 1;
+                job.lengths[t] = std::min<std::uint8_t>(job.lengths[t], i + 1);
+            }
+        }
+
+        if (round + 1 < job.count) {
+            next += job.interval_ns;
+            co_await s.sleep_until(next);
+        }
+    }
+}
+
+static void print_hops(const hops_job& job, std::uint32_t t) noexcept
+{
+    char target_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &(*job.addrs)[t], target_str, sizeof(target_str));
+
+    std::printf("\nhops to %s (%u hops%s):\n", target_str, job.lengths[t],
+        job.reached[t] ? "" : ", not reached"
+    );
+    std::printf("%4s  %-16s %8s %8s %7s  %s\n", "hop", "router", "sent", "received",
+        "loss%", "rtt min/avg/max ms");
+
+    const auto *stats = &job.stats[static_cast<std::size_t>(t) * job.hops];
+
+    for (std::uint8_t i = 0; i < job.lengths[t]; i++) {
+        const auto& hop = stats[i];
+        char router_str[INET_ADDRSTRLEN] = "*";
+
+        if (hop.router)
+            inet_ntop(AF_INET, &hop.router, router_str, sizeof(router_str));
+
+        std::printf("%4u  %-16s %8u %8u %7.2f  %.3f/%.3f/%.3f\n", i + 1, router_str,
+            hop.sent, hop.received,
+            hop.sent ? 100.0 * (hop.sent - hop.received) / hop.sent : 0.0,
+            hop.rtt_min / 1e6, hop.received ? hop.rtt_sum / 1e6 / hop.received : 0.0,
+            hop.rtt_max / 1e6
+        );
+    }
+}
+
+static void sigint_handler(int) noexcept
+{
+    if (active)
+        active->stop();
+}
+
+} // namespace ntool
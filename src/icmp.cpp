@@ -16,7 +16,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <ntool/probe.hpp>
 #include <ntool/icmp.hpp>
+#include <cstring>
 
 
 namespace ntool {
@@ -64,4 +66,31 @@ std::uint16_t checksum(void *buffer, std::size_t size) noexcept
     return result;
 }
 
+// default ICMP payload
+inline const std::uint8_t payload[ICMP_PAYLOAD_SIZE]
+{
+    "!!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUV"
+};
+
+void set_packet(std::uint8_t *packet, const icmphdr& header) noexcept
+{
+    icmphdr hdr  = header;
+    hdr.checksum = 0;
+
+    // copy ICMP header & payload into the packet
+    std::memcpy(packet, &hdr, sizeof(icmphdr));
+    std::memcpy(packet + sizeof(icmphdr), &payload, ICMP_PAYLOAD_SIZE);
+
+    // calculate packet checksum
+    hdr.checksum = checksum(packet, ICMP_PACKET_SIZE);
+    packet[2]    = hdr.checksum & 0xFFFF;
+    packet[3]    = hdr.checksum >> 0x8;
+}
+
+bool parse_reply(const std::uint8_t *packet, std::size_t size,
+    reply_info& info) noexcept
+{
+    return icmp_echo::parse(packet, size, info);
+}
+
 } // namespace ntool
\ No newline at end of file
@@ -0,0 +1,537 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/loader.hpp>
+#include <ntool/output.hpp>
+#include <ntool/utils.hpp>
+#include <unordered_map>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <netdb.h>
+#include <fcntl.h>
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace ntool {
+
+/** Kind of target line.*/
+enum entry_kind : std::uint8_t {
+    ENTRY_ADDRESS,  // IP address literal
+    ENTRY_PREFIX,   // CIDR prefix
+    ENTRY_NAME,     // name for resolver
+    ENTRY_COVERED,  // CIDR prefix inside other prefix of list
+};
+
+inline const std::uint32_t NO_TAG            {UINT32_MAX};
+inline const std::size_t   PREFETCH_DISTANCE {16};  // entries ahead of insert
+
+/** Parsed target line.*/
+struct entry {
+    in_addr_t     addr;     // address or name index (ENTRY_NAME)
+    std::uint32_t name;     // name offset in text
+    std::uint32_t tag;      // tag offset in text (NO_TAG - none)
+    std::uint8_t  kind;     // entry_kind
+    std::uint8_t  prefix;   // prefix length (ENTRY_PREFIX)
+};
+
+static_assert(sizeof(entry) == 16);
+
+/** Open addressing set of addresses (0 - empty slot).*/
+class address_set {
+public:
+    /**
+     * @brief Construct empty set.
+     *
+     * @param [in] count - given expected number of addresses.
+     */
+    explicit address_set(std::uint64_t count) noexcept
+        : m_bits(std::bit_width(std::bit_ceil(std::max<std::uint64_t>(count * 2, 16))) - 1),
+          m_mask((1ULL << m_bits) - 1),
+          m_buffer((m_mask + 1) * sizeof(in_addr_t), true),
+          m_slots(static_cast<in_addr_t*>(m_buffer.data()))
+    {}
+
+    /**
+     * @brief Get home slot of address.
+     *
+     * @param [in] addr - given address.
+     * @return slot index.
+     */
+    std::uint64_t slot(in_addr_t addr) const noexcept
+    {
+        return (addr * 0x9e3779b97f4a7c15ULL) >> (64 - m_bits);
+    }
+
+    /**
+     * @brief Prefetch home slot of address.
+     *
+     * @param [in] addr - given address.
+     */
+    void prefetch(in_addr_t addr) const noexcept
+    {
+        __builtin_prefetch(m_slots + slot(addr), 1);
+    }
+
+    /**
+     * @brief Insert address.
+     *
+     * @param [in] addr - given non-zero address.
+     * @return false if address is already in set.
+     */
+    bool insert(in_addr_t addr) noexcept
+    {
+        for (auto i = slot(addr);; i = (i + 1) & m_mask) {
+            if (m_slots[i] == addr)
+                return false;
+
+            if (!m_slots[i]) {
+                m_slots[i] = addr;
+                return true;
+            }
+        }
+    }
+
+private:
+    std::uint32_t m_bits;
+    std::uint64_t m_mask;
+    page_buffer   m_buffer;
+    in_addr_t     *m_slots;
+};
+
+/**
+ * @brief Find digits & dots among 16 bytes.
+ *
+ * @param [in] p - given bytes.
+ * @param [out] values - given object to store digit values (0 - not digit).
+ * @param [out] digits - given object to store bit mask of digits.
+ * @param [out] dots - given object to store bit mask of dots.
+ */
+static void classify(const char *p, std::uint8_t *values, std::uint32_t& digits,
+    std::uint32_t& dots) noexcept;
+
+/**
+ * @brief Parse lines of file chunk.
+ *
+ * @param [in,out] text - given file contents.
+ * @param [in] begin - given chunk start.
+ * @param [in] end - given chunk end.
+ * @param [in] size - given file size.
+ * @param [out] entries - given object to store parsed lines.
+ * @return number of malformed lines.
+ */
+static std::uint64_t parse_chunk(char *text, std::size_t begin, std::size_t end,
+    std::size_t size, std::vector<entry>& entries) noexcept;
+
+/**
+ * @brief Resolve name.
+ *
+ * @param [in] name - given host name.
+ * @return address or 0 if name was not resolved.
+ */
+static in_addr_t resolve(const char *name) noexcept;
+
+
+
+std::size_t parse_ipv4(const char *p, const char *end, in_addr_t& addr) noexcept
+{
+    char padded[16] {};
+
+    if (end - p < 16) {
+        std::memcpy(padded, p, std::max<std::ptrdiff_t>(end - p, 0));
+        p = padded;
+    }
+
+    // digit values follow zero bytes, so every field is read as 3 digits
+    // ending at its dot & digits of other fields are masked by its width
+    alignas(16) std::uint8_t values[32] {};
+    std::uint32_t digits, dots;
+    classify(p, values + 16, digits, dots);
+
+    // address ends at first byte which is neither digit nor dot
+    auto size = static_cast<std::uint32_t>(std::countr_zero(~(digits | dots)));
+    dots     &= (1U << size) - 1;
+
+    if (size < 7 || size > 15 || std::popcount(dots) != 3)
+        return 0;
+
+    std::uint32_t ends[4];
+
+    for (std::uint32_t i = 0; i < 3; i++) {
+        ends[i] = std::countr_zero(dots);
+        dots   &= dots - 1;
+    }
+
+    ends[3]      = size;
+    auto start   = 0U;
+    auto invalid = false;
+    std::uint8_t bytes[4];
+
+    for (std::uint32_t i = 0; i < 4; i++) {
+        auto v     = values + 16 + ends[i];
+        auto width = ends[i] - start;
+        auto value = (width > 2) * v[-3] * 100U + (width > 1) * v[-2] * 10U + v[-1];
+
+        // leading zeros are rejected as by inet_pton()
+        invalid |= (width - 1 > 2) | ((width > 1) & (p[start] == '0')) | (value > 255);
+        bytes[i] = static_cast<std::uint8_t>(value);
+        start    = ends[i] + 1;
+    }
+
+    if (invalid)
+        return 0;
+
+    std::memcpy(&addr, bytes, sizeof(addr));
+    return size;
+}
+
+void load_targets(const char *path, std::uint32_t threads, target_list& list) noexcept
+{
+    auto fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) == -1)
+        utils::error("ntool: cannot open target list");
+
+    auto size = static_cast<std::size_t>(st.st_size);
+
+    if (size == 0 || size >= NO_TAG)
+        utils::error("ntool: target list is empty or too large");
+
+    // private file mapping followed by zeroed byte, lines are edited in place
+    list.text = page_buffer(size + 1, false);
+    auto text = static_cast<char*>(mmap(list.text.data(), size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, fd, 0
+    ));
+    close(fd);
+
+    if (text == MAP_FAILED)
+        utils::error("ntool: cannot map target list");
+
+    madvise(text, size, MADV_SEQUENTIAL);
+    threads = threads ? threads : std::thread::hardware_concurrency();
+    threads = std::clamp<std::uint32_t>(threads, 1, LOADER_MAX_THREADS);
+
+    // split into chunks at line boundaries
+    auto chunks = std::min<std::size_t>(threads, std::max<std::size_t>(size >> 16, 1));
+    std::vector<std::size_t> bounds(chunks + 1, size);
+    bounds[0] = 0;
+
+    for (std::size_t i = 1; i < chunks; i++) {
+        auto pos = std::max(size * i / chunks, bounds[i - 1]);
+        auto eol = static_cast<const char*>(std::memchr(text + pos, '\n', size - pos));
+        bounds[i] = eol ? eol - text + 1 : size;
+    }
+
+    std::vector<std::vector<entry>> parsed(chunks);
+    std::vector<std::uint64_t> invalid(chunks);
+
+    utils::parallel_for(chunks, threads, [&](std::size_t i) noexcept {
+        parsed[i].reserve((bounds[i + 1] - bounds[i]) / 12);
+        invalid[i] = parse_chunk(text, bounds[i], bounds[i + 1], size, parsed[i]);
+    });
+
+    auto& counters = list.counters;
+    counters       = {};
+
+    // prefixes inside other prefixes of list add no hosts, never expand them
+    std::vector<entry*> ranges;
+
+    for (auto& chunk : parsed) {
+        for (auto& e : chunk) {
+            if (e.kind == ENTRY_PREFIX)
+                ranges.push_back(&e);
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const entry *a, const entry *b) {
+        return ntohl(a->addr) < ntohl(b->addr) || (a->addr == b->addr && a->prefix < b->prefix);
+    });
+
+    std::uint64_t covered_end = 0;
+
+    for (auto e : ranges) {
+        auto first = static_cast<std::uint64_t>(ntohl(e->addr));
+        auto last  = first + (1ULL << (32 - e->prefix));
+
+        // CIDR ranges are either nested or disjoint
+        if (last <= covered_end) {
+            e->kind              = ENTRY_COVERED;
+            counters.duplicates += last - first;
+            continue;
+        }
+
+        covered_end = last;
+    }
+
+    // names which are not address literals go to resolver once
+    std::unordered_map<std::string_view, std::uint32_t> index;
+    std::vector<const char*> names;
+    std::uint64_t hosts     = 0;
+    std::uint64_t generated = 0;
+    bool tagged             = false;
+
+    for (std::size_t i = 0; i < chunks; i++) {
+        counters.invalid += invalid[i];
+        counters.lines   += parsed[i].size() + invalid[i];
+
+        for (auto& e : parsed[i]) {
+            tagged = tagged || e.tag != NO_TAG;
+
+            if (e.kind == ENTRY_COVERED)
+                continue;
+
+            if (e.kind == ENTRY_PREFIX) {
+                hosts     += 1ULL << (32 - e.prefix);
+                generated += 1ULL << (32 - e.prefix);
+                continue;
+            }
+
+            hosts++;
+
+            if (e.kind != ENTRY_NAME)
+                continue;
+
+            auto [it, inserted] = index.try_emplace(text + e.name, names.size());
+
+            if (inserted)
+                names.push_back(text + e.name);
+
+            e.addr = it->second;
+        }
+    }
+
+    std::vector<in_addr_t> resolved(names.size());
+
+    utils::parallel_for(names.size(), threads, [&](std::size_t i) noexcept {
+        resolved[i] = resolve(names[i]);
+    });
+
+    counters.names      = names.size();
+    counters.unresolved = std::count(resolved.begin(), resolved.end(), 0);
+
+    // keep first occurrence of every address in file order
+    address_set seen(hosts);
+    list.generated = page_buffer(generated * INET_ADDRSTRLEN, false);
+    auto out       = static_cast<char*>(list.generated.data());
+
+    list.addrs.clear();
+    list.names.clear();
+    list.tags.clear();
+    list.addrs.reserve(hosts);
+    list.names.reserve(hosts);
+
+    if (tagged)
+        list.tags.reserve(hosts);
+
+    auto add = [&](in_addr_t addr, const char *name, const char *tag) noexcept {
+        if (!addr)
+            return;
+
+        if (!seen.insert(addr)) {
+            counters.duplicates++;
+            return;
+        }
+
+        list.addrs.push_back(addr);
+        list.names.push_back(name);
+
+        if (tagged)
+            list.tags.push_back(tag);
+    };
+
+    for (const auto& chunk : parsed) {
+        for (std::size_t i = 0; i < chunk.size(); i++) {
+            if (i + PREFETCH_DISTANCE < chunk.size() &&
+                chunk[i + PREFETCH_DISTANCE].kind == ENTRY_ADDRESS)
+                seen.prefetch(chunk[i + PREFETCH_DISTANCE].addr);
+
+            const auto& e = chunk[i];
+            auto tag      = (e.tag != NO_TAG) ? text + e.tag : nullptr;
+
+            if (e.kind == ENTRY_ADDRESS)
+                add(e.addr, text + e.name, tag);
+            else if (e.kind == ENTRY_NAME)
+                add(resolved[e.addr], text + e.name, tag);
+            else if (e.kind == ENTRY_PREFIX) {
+                auto first = ntohl(e.addr);
+                auto count = 1ULL << (32 - e.prefix);
+
+                for (std::uint64_t h = 0; h < count; h++) {
+                    auto addr = htonl(static_cast<std::uint32_t>(first + h));
+                    auto name = out;
+                    out       = format_ip(out, addr);
+                    *out++    = '\0';
+
+                    add(addr, name, tag);
+                }
+            }
+        }
+    }
+}
+
+static void classify(const char *p, std::uint8_t *values, std::uint32_t& digits,
+    std::uint32_t& dots) noexcept
+{
+#if defined(__SSE2__)
+    // digit if byte - '0' is at most 9 as unsigned
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto t = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    auto d = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(9)), t);
+    auto s = _mm_cmpeq_epi8(v, _mm_set1_epi8('.'));
+
+    _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_and_si128(t, d));
+    digits = static_cast<std::uint32_t>(_mm_movemask_epi8(d));
+    dots   = static_cast<std::uint32_t>(_mm_movemask_epi8(s));
+#else
+    digits = 0;
+    dots   = 0;
+
+    for (std::uint32_t i = 0; i < 16; i++) {
+        auto t    = static_cast<std::uint8_t>(p[i] - '0');
+        values[i] = (t <= 9) ? t : 0;
+        digits   |= static_cast<std::uint32_t>(t <= 9) << i;
+        dots     |= static_cast<std::uint32_t>(p[i] == '.') << i;
+    }
+#endif
+}
+
+
+static std::uint64_t parse_chunk(char *text, std::size_t begin, std::size_t end,
+    std::size_t size, std::vector<entry>& entries) noexcept
+{
+    auto is_space = [](char c) noexcept {
+        return c == ' ' || c == '\t' || c == '\r';
+    };
+
+    auto token_end = [&](char *p, char *eol) noexcept {
+        while (p < eol && !is_space(*p) && *p != '#')
+            p++;
+
+        return p;
+    };
+
+    std::uint64_t invalid = 0;
+    auto p                = text + begin;
+    auto limit            = text + end;
+
+    while (p < limit) {
+        entry e {};
+        e.name = p - text;
+        e.tag  = NO_TAG;
+        e.kind = ENTRY_ADDRESS;
+
+        // fast path, address alone on its line
+        auto length = parse_ipv4(p, text + size, e.addr);
+
+        if (length && (p + length == limit || p[length] == '\n')) {
+            p[length] = '\0';
+            p        += length + 1;
+            entries.push_back(e);
+            continue;
+        }
+
+        auto eol = static_cast<char*>(std::memchr(p, '\n', limit - p));
+        eol      = eol ? eol : limit;
+
+        while (p < eol && is_space(*p))
+            p++;
+
+        // skip empty & comment lines
+        if (p == eol || *p == '#') {
+            p = eol + 1;
+            continue;
+        }
+
+        auto name = p;
+        p         = token_end(p, eol);
+        auto last = p;
+
+        while (p < eol && is_space(*p))
+            p++;
+
+        e.name = name - text;
+
+        if (p < eol && *p != '#') {
+            e.tag = p - text;
+            *token_end(p, eol) = '\0';
+        }
+
+        *last = '\0';
+        p     = eol + 1;
+
+        length = parse_ipv4(name, text + size, e.addr);
+
+        if (length == static_cast<std::size_t>(last - name)) {
+            entries.push_back(e);
+            continue;
+        }
+
+        if (length == 0 || name[length] != '/') {
+            e.kind = ENTRY_NAME;
+            entries.push_back(e);
+            continue;
+        }
+
+        // CIDR prefix, host bits of address are ignored
+        auto digits = name + length + 1;
+        auto prefix = 0;
+
+        for (auto c = digits; c < last && prefix >= 0; c++)
+            prefix = (*c >= '0' && *c <= '9') ? prefix * 10 + (*c - '0') : -1;
+
+        if (last == digits || last - digits > 2 || prefix < LOADER_MIN_PREFIX || prefix > 32) {
+            invalid++;
+            continue;
+        }
+
+        auto mask = ~0U << (32 - prefix);
+        e.kind    = ENTRY_PREFIX;
+        e.prefix  = prefix;
+        e.addr    = htonl(ntohl(e.addr) & mask);
+        entries.push_back(e);
+    }
+
+    return invalid;
+}
+
+static in_addr_t resolve(const char *name) noexcept
+{
+    addrinfo hints {};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo *info = nullptr;
+
+    if (getaddrinfo(name, nullptr, &hints, &info) != 0 || !info)
+        return 0;
+
+    auto addr = reinterpret_cast<sockaddr_in*>(info->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(info);
+    return addr;
+}
+
+} // namespace ntool
@@ -17,8 +17,18 @@
  */
 
 #include <ntool/traceroute.hpp>
+#include <ntool/tracediff.hpp>
+#include <ntool/topology.hpp>
+#include <ntool/selftest.hpp>
+#include <ntool/recorder.hpp>
+#include <ntool/monitor.hpp>
+#include <ntool/routes.hpp>
 #include <ntool/utils.hpp>
+#include <ntool/store.hpp>
+#include <ntool/hops.hpp>
 #include <ntool/ping.hpp>
+#include <ntool/asn.hpp>
+#include <arpa/inet.h>
 #include <getopt.h>
 #include <cstring>
 
@@ -33,31 +43,191 @@ static void help(void) noexcept
         "OPTIONS\n"
         "    --ping [options] [target]    ping specific IP address/hostname\n"
         "        -n [N] [target]          ping N times\n"
+        "        -i [SEC] [target]        set interval between pings\n"
+        "        -W [SEC] [target]        set reply waiting time\n"
+        "        --quiet                  print summary only\n"
+        "        --io [raw|mmsg]          set socket I/O backend\n"
+        "        --format [FMT]           set output format\n"
+        "        --output [FILE]          write replies to FILE\n"
         "\n"
         "    -h, --help                   display list of commands\n"
         "    --tr [options] [target]      get trace route to target\n"
         "        -m [N]                   set max hops\n"
         "        -q [N]                   set max queries\n"
+        "        --format [FMT]           set output format\n"
+        "        --output [FILE]          write hops to FILE\n"
+        "        --asn [DB]               annotate routers with origin AS of\n"
+        "                                 database DB & print AS path\n"
+        "        --topology [FILE]        merge route into topology snapshot\n"
+        "\n"
+        "    output formats (FMT):\n"
+        "        human                    classic ping/traceroute lines\n"
+        "        jsonl                    JSON object per line\n"
+        "        csv                      comma separated values\n"
+        "        binary                   result log (archive format)\n"
+        "\n"
+        "    --monitor [options] [targets] probe targets continuously\n"
+        "        -n, -i, -W, --quiet, --io, --format, --output as for --ping\n"
+        "        -f [FILE]                read targets from FILE instead, line is\n"
+        "                                 IP, IP/prefix or name & optional tag\n"
+        "        --retention [SEC]        set RTT history per target (3600)\n"
+        "        --resolution [MS]        set RTT history resolution (0.01)\n"
+        "        --history-limit [MB]     cap RTT history memory, targets then\n"
+        "                                 keep shorter history (no limit)\n"
+        "        --no-detect              do not report latency & loss anomalies\n"
+        "        --cusum [N]              set latency shift alarm level in\n"
+        "                                 deviations (8, lower is more sensitive)\n"
+        "        --metrics [PORT]         serve Prometheus metrics on\n"
+        "                                 http://127.0.0.1:PORT/metrics\n"
+        "        --prefixes [FILE]        aggregate targets by longest matching\n"
+        "                                 prefix, line is IP/prefix & optional\n"
+        "                                 group (prefixes of group are merged)\n"
+        "        --rollup [LEN]           aggregate targets by /LEN networks\n"
+        "        --trace [N]              also trace targets every N rounds over\n"
+        "                                 socket of pings & print route changes\n"
+        "        -m [N]                   set max hops of traces (30)\n"
+        "\n"
+        "    --routes [options] [targets] trace targets, then probe few sampled\n"
+        "                                 TTLs per path every round & trace again\n"
+        "                                 only paths with unexpected routers\n"
+        "        -n, -i, -W, --io, -f     as for --monitor\n"
+        "        -m [N], -q [N]           set max hops & queries of full traces\n"
+        "        --samples [N]            set TTLs sampled per path & round (2)\n"
+        "    --hops [options] [targets]   probe every hop of paths to targets each\n"
+        "                                 round & print loss & RTT of hops\n"
+        "        -n [N]                   set rounds (10)\n"
+        "        -i, -W, --io, -f         as for --monitor\n"
+        "        -m [N]                   set max hops (30)\n"
+        "        --rate [N]               set max probes per second (100000)\n"
+        "        --quiet                  print summary only\n"
+        "\n"
+        "    --store [DIR]                also append ping results to segment\n"
+        "                                 store DIR (--ping, --monitor)\n"
+        "        --segment [SEC]          set time span of segment (600)\n"
+        "    --feed [NAME]                also publish results to shared memory\n"
+        "                                 feed NAME (--ping, --tr, --monitor)\n"
+        "        --feed-size [N]          set records kept in feed (65536)\n"
+        "    --tail [NAME]                print live records of feed NAME\n"
+        "        --format [FMT]           set text format\n"
+        "    --query [DIR] [options]      print loss & RTT percentiles of store\n"
+        "        --target [IP]            select target (all by default)\n"
+        "        --from [TIME]            set range start\n"
+        "        --to [TIME]              set range end\n"
+        "        --threads [N]            set scan threads (CPUs by default)\n"
+        "                                 TIME: epoch seconds, YYYY-MM-DD,\n"
+        "                                 YYYY-MM-DD HH:MM[:SS] or HH:MM[:SS]\n"
+        "\n"
+        "    --engine-stats               time engine stages & print them after\n"
+        "                                 engine counters (--ping, --tr, --monitor)\n"
+        "    --huge-pages                 back in-flight table & packet buffers\n"
+        "                                 by huge pages (--ping, --monitor)\n"
+        "    --flight-dir [DIR]           set directory of flight recorder dumps,\n"
+        "                                 written on SIGUSR1, fatal error or\n"
+        "                                 anomaly (/tmp)\n"
+        "    --flight [FILE]              convert flight recorder dump to Chrome\n"
+        "                                 trace JSON (--output to set file)\n"
+        "    --direct                     write binary output with O_DIRECT\n"
+        "    --decode [FILE]              print result log as text\n"
+        "        --format [FMT]           set text format\n"
+        "        --asn [DB]               annotate trace routers with origin AS\n"
+        "    --asn-build [FILE]           compile IP to origin AS database from\n"
+        "                                 FILE (--output to set database file),\n"
+        "                                 line is IP/prefix & AS or bgpdump -m\n"
+        "                                 routing table entry\n"
+        "    --topology [FILE] [logs]     merge trace result logs into graph of\n"
+        "                                 routers, kept in snapshot FILE\n"
+        "        --dot [FILE]             also write graph as Graphviz DOT\n"
+        "        --asn [DB]               label routers with origin AS\n"
+        "    --trace-diff [OLD] [NEW]     compare latest traces of destinations\n"
+        "                                 in two trace result logs or directories\n"
+        "                                 of logs & print changed paths\n"
+        "        --threads [N]            set scan threads (CPUs by default)\n"
+        "        --quiet                  print changes by hop only\n"
+        "\n"
+        "    --selftest-capacity [target] find highest probe rate measured\n"
+        "                                 without loss or RTT error added\n"
+        "                                 by ntool (127.0.0.1 by default)\n"
+        "        --duration [SEC]         set duration of each rate step\n"
+        "        --max-loss [PCT]         set allowed loss\n"
+        "        --max-error [MS]         set allowed RTT error\n"
+        "        -W [SEC]                 set reply waiting time\n"
         "\n"
         "EXAMPLES\n"
         "    ntool --ping 127.0.0.1       ping IP address\n"
         "    ntool --ping example.com     ping hostname\n"
         "    ntool --ping -n 6 127.0.0.1  ping 6 times\n"
         "\n"
+        "    ping 10000 times at 1000 packets per second:\n"
+        "    ntool --ping -n 10000 -i 0.001 --quiet 127.0.0.1\n"
+        "\n"
+        "    ping 1000 times at 100 packets per second, JSON lines to file:\n"
+        "    ntool --ping -n 1000 -i 0.01 --format jsonl --output ping.jsonl 127.0.0.1\n"
+        "\n"
+        "    archive replies & print them back as CSV:\n"
+        "    ntool --ping -n 1000 -i 0.01 --format binary --output ping.log 127.0.0.1\n"
+        "    ntool --decode ping.log --format csv\n"
+        "\n"
         "    ntool --tr 127.0.0.1         traceroute IP address\n"
         "    ntool --tr example.com       traceroute hostname\n"
         "\n"
         "    traceroute target with 10 max hops & 4 max queries:\n"
         "    ntool --tr -m 10 -q 4 example.com       traceroute hostname\n"
         "\n"
+        "    compile routing table dump once, then show AS path of traceroute:\n"
+        "    bgpdump -m rib.bz2 > rib.txt\n"
+        "    ntool --asn-build rib.txt --output asn.db\n"
+        "    ntool --tr --asn asn.db example.com\n"
+        "\n"
+        "    trace same targets daily, then see which paths changed:\n"
+        "    ntool --tr --format binary --output day1/example.log example.com\n"
+        "    ntool --trace-diff day1 day2\n"
+        "\n"
+        "    loss & RTT of every hop to 2 targets over 60 rounds:\n"
+        "    ntool --hops -n 60 1.1.1.1 8.8.8.8\n"
+        "\n"
+        "    monitor 3 targets every 10 s, keep 24 hours of RTT history:\n"
+        "    ntool --monitor -i 10 --retention 86400 --quiet 1.1.1.1 8.8.8.8 9.9.9.9\n"
+        "\n"
+        "    record 1000 targets for a day, then query one of them at night:\n"
+        "    ntool --monitor -i 1 --quiet --store /var/lib/ntool $(cat targets)\n"
+        "    ntool --query /var/lib/ntool --target 10.0.0.7 --from 02:00 --to 03:00\n"
+        "\n"
+        "    watch monitor results from another process:\n"
+        "    ntool --monitor -i 1 --quiet --feed ntool 1.1.1.1 8.8.8.8\n"
+        "    ntool --tail ntool --format jsonl\n"
+        "\n"
+        "    see what engine did before anomaly in chrome://tracing or Perfetto:\n"
+        "    kill -USR1 $(pidof ntool)\n"
+        "    ntool --flight /tmp/ntool-flight-PID-0.bin --output trace.json\n"
+        "\n"
+        "    measure capacity against namespace peer with 1% loss allowed:\n"
+        "    ntool --selftest-capacity --max-loss 1 10.77.0.2\n"
+        "\n"
     );
     std::exit(EXIT_SUCCESS);
 }
 
+/** Selected command.*/
+enum class command {
+    none,
+    ping,
+    traceroute,
+    selftest,
+    decode,
+    monitor,
+    query,
+    tail,
+    flight,
+    asn_build,
+    topology,
+    routes,
+    trace_diff,
+    hops,
+};
+
 int main(std::int32_t argc, char **argv)
 {
     using namespace ntool::utils;
-    terminate_if_not_root();
 
     if (argc < 2)
         help();
@@ -65,22 +235,86 @@ int main(std::int32_t argc, char **argv)
     static option long_options[] {
         {"ping", no_argument, 0, 0},
         {"tr", no_argument, 0, 1},
+        {"quiet", no_argument, 0, 2},
+        {"io", required_argument, 0, 3},
+        {"selftest-capacity", no_argument, 0, 4},
+        {"duration", required_argument, 0, 5},
+        {"max-loss", required_argument, 0, 6},
+        {"max-error", required_argument, 0, 7},
+        {"format", required_argument, 0, 8},
+        {"output", required_argument, 0, 9},
+        {"decode", required_argument, 0, 10},
+        {"direct", no_argument, 0, 11},
+        {"monitor", no_argument, 0, 12},
+        {"retention", required_argument, 0, 13},
+        {"resolution", required_argument, 0, 14},
+        {"store", required_argument, 0, 15},
+        {"segment", required_argument, 0, 16},
+        {"query", required_argument, 0, 17},
+        {"target", required_argument, 0, 18},
+        {"from", required_argument, 0, 19},
+        {"to", required_argument, 0, 20},
+        {"threads", required_argument, 0, 21},
+        {"no-detect", no_argument, 0, 22},
+        {"cusum", required_argument, 0, 23},
+        {"metrics", required_argument, 0, 24},
+        {"feed", required_argument, 0, 25},
+        {"feed-size", required_argument, 0, 26},
+        {"tail", required_argument, 0, 27},
+        {"engine-stats", no_argument, 0, 28},
+        {"flight-dir", required_argument, 0, 29},
+        {"flight", required_argument, 0, 30},
+        {"huge-pages", no_argument, 0, 31},
+        {"prefixes", required_argument, 0, 32},
+        {"rollup", required_argument, 0, 33},
+        {"asn", required_argument, 0, 34},
+        {"asn-build", required_argument, 0, 35},
+        {"topology", required_argument, 0, 36},
+        {"dot", required_argument, 0, 37},
+        {"routes", no_argument, 0, 38},
+        {"samples", required_argument, 0, 39},
+        {"trace-diff", required_argument, 0, 40},
+        {"trace", required_argument, 0, 41},
+        {"hops", no_argument, 0, 42},
+        {"history-limit", required_argument, 0, 43},
+        {"rate", required_argument, 0, 44},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     std::int32_t opt, ping_count = 0;
-    bool is_ping = false;
+    ntool::ping_options ping_options;
+
+    std::int32_t hops = 0, queries = 0;
 
-    std::int32_t hops, queries = 0;
-    bool is_tr   = false;
+    ntool::selftest_options selftest_options;
+    ntool::series_config    series_config;
+    ntool::detector_config  detector_config;
+    ntool::query_options    query_options;
+    const char *decode_path = nullptr;
+    const char *query_path  = nullptr;
+    const char *tail_name   = nullptr;
+    const char *flight_path = nullptr;
+    const char *flight_dir  = ntool::FLIGHT_DIR;
+    const char *target_file = nullptr;
+    const char *prefix_file = nullptr;
+    const char *asn_path    = nullptr;
+    const char *asn_source  = nullptr;
+    const char *diff_before = nullptr;
+    ntool::topology_options topology_options;
+    ntool::route_options    route_options;
+    std::int32_t rollup     = 0;
+    std::int32_t trace      = 0;
+    std::int64_t rate       = ntool::ROUTE_TRACE_RATE;
+    bool detect             = true;
+    std::int32_t metrics    = 0;
+    auto cmd                = command::none;
 
-    while ((opt = getopt_long(argc, argv, "hn:m:q:", long_options, 0)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hn:i:W:m:q:f:", long_options, 0)) != -1) {
         switch (opt) {
         // handle --ping
         case 0:
-            is_ping = true;
-            is_tr   = false;
+            cmd = command::ping;
             break;
 
         // handle --ping -n [N]
@@ -88,10 +322,261 @@ int main(std::int32_t argc, char **argv)
             ping_count = std::atoi(optarg);
             break;
 
+        // handle --ping -i [SEC]
+        case 'i':
+            ping_options.interval = std::abs(std::atof(optarg));
+            break;
+
+        // handle --ping -W [SEC]
+        case 'W':
+            ping_options.timeout     = std::abs(std::atof(optarg));
+            selftest_options.timeout = ping_options.timeout;
+            break;
+
+        // handle --monitor -f [FILE]
+        case 'f':
+            target_file = optarg;
+            break;
+
+        // handle --monitor --prefixes [FILE]
+        case 32:
+            prefix_file = optarg;
+            break;
+
+        // handle --monitor --rollup [LEN]
+        case 33:
+            rollup = std::atoi(optarg);
+
+            if (rollup <= 0 || rollup > 32)
+                error("ntool: invalid rollup prefix length");
+            break;
+
+        // handle --tr --asn [DB]
+        case 34:
+            asn_path = optarg;
+            break;
+
+        // handle --asn-build [FILE]
+        case 35:
+            cmd        = command::asn_build;
+            asn_source = optarg;
+            break;
+
+        // handle --topology [FILE]
+        case 36:
+            topology_options.snapshot = optarg;
+            break;
+
+        // handle --topology --dot [FILE]
+        case 37:
+            topology_options.dot = optarg;
+            break;
+
+        // handle --routes
+        case 38:
+            cmd = command::routes;
+            break;
+
+        // handle --routes --samples [N]
+        case 39:
+            route_options.samples = std::clamp(std::atoi(optarg), 1, 255);
+            break;
+
+        // handle --trace-diff [OLD] [NEW]
+        case 40:
+            cmd         = command::trace_diff;
+            diff_before = optarg;
+            break;
+
+        // handle --monitor --trace [N]
+        case 41:
+            trace = std::abs(std::atoi(optarg));
+            break;
+
+        // handle --hops
+        case 42:
+            cmd = command::hops;
+            break;
+
+        // handle --hops --rate [N]
+        case 44:
+            rate = std::max<std::int64_t>(std::abs(std::atoll(optarg)), 1);
+            break;
+
+        // handle --ping --quiet
+        case 2:
+            ping_options.quiet = true;
+            break;
+
+        // handle --ping --io [raw|mmsg]
+        case 3:
+            if (!std::strcmp(optarg, "mmsg"))
+                ping_options.io = ntool::io_backend::mmsg;
+            else if (!std::strcmp(optarg, "raw"))
+                ping_options.io = ntool::io_backend::raw;
+            else
+                error("ntool: unknown I/O backend");
+            break;
+
+        // handle --format [FMT]
+        case 8:
+            if (!ntool::parse_format(optarg, ping_options.output.format))
+                error("ntool: unknown output format");
+            break;
+
+        // handle --output [FILE]
+        case 9:
+            ping_options.output.path = optarg;
+            break;
+
+        // handle --output [FILE] --direct
+        case 11:
+            ping_options.output.direct = true;
+            break;
+
+        // handle --monitor
+        case 12:
+            cmd = command::monitor;
+            break;
+
+        // handle --monitor --retention [SEC]
+        case 13:
+            series_config.retention = std::abs(std::atof(optarg));
+            break;
+
+        // handle --monitor --resolution [MS]
+        case 14:
+            series_config.resolution = std::max(std::abs(std::atof(optarg)), 1e-6);
+            break;
+
+        // handle --monitor --history-limit [MB]
+        case 43:
+            series_config.memory = static_cast<std::size_t>(std::abs(std::atof(optarg)) * 1e6);
+            break;
+
+        // handle --monitor --no-detect
+        case 22:
+            detect = false;
+            break;
+
+        // handle --monitor --cusum [N]
+        case 23:
+            detector_config.threshold = std::max(std::abs(std::atof(optarg)), 0.5);
+            break;
+
+        // handle --monitor --metrics [PORT]
+        case 24:
+            metrics = std::atoi(optarg);
+
+            if (metrics <= 0 || metrics > UINT16_MAX)
+                error("ntool: invalid metrics port");
+            break;
+
+        // handle --engine-stats
+        case 28:
+            ping_options.engine_stats = true;
+            break;
+
+        // handle --huge-pages
+        case 31:
+            ping_options.huge_pages = true;
+            break;
+
+        // handle --flight-dir [DIR]
+        case 29:
+            flight_dir = optarg;
+            break;
+
+        // handle --flight [FILE]
+        case 30:
+            cmd         = command::flight;
+            flight_path = optarg;
+            break;
+
+        // handle --feed [NAME]
+        case 25:
+            ping_options.output.feed = optarg;
+            break;
+
+        // handle --feed [NAME] --feed-size [N]
+        case 26:
+            ping_options.output.feed_size = std::abs(std::atoi(optarg));
+            break;
+
+        // handle --tail [NAME]
+        case 27:
+            cmd       = command::tail;
+            tail_name = optarg;
+            break;
+
+        // handle --store [DIR]
+        case 15:
+            ping_options.output.store = optarg;
+            break;
+
+        // handle --store [DIR] --segment [SEC]
+        case 16:
+            ping_options.output.segment = std::max(std::atoi(optarg), 1);
+            break;
+
+        // handle --query [DIR]
+        case 17:
+            cmd        = command::query;
+            query_path = optarg;
+            break;
+
+        // handle --query --target [IP]
+        case 18:
+            if (inet_pton(AF_INET, optarg, &query_options.target) != 1)
+                error("ntool: invalid query target");
+            break;
+
+        // handle --query --from [TIME]
+        case 19:
+            if (!ntool::parse_time(optarg, query_options.from_ms))
+                error("ntool: invalid query range start");
+            break;
+
+        // handle --query --to [TIME]
+        case 20:
+            if (!ntool::parse_time(optarg, query_options.to_ms))
+                error("ntool: invalid query range end");
+            break;
+
+        // handle --query --threads [N]
+        case 21:
+            query_options.threads = std::abs(std::atoi(optarg));
+            break;
+
+        // handle --decode [FILE]
+        case 10:
+            cmd         = command::decode;
+            decode_path = optarg;
+            break;
+
         // handle --tr
         case 1:
-            is_tr   = true;
-            is_ping = false;
+            cmd = command::traceroute;
+            break;
+
+        // handle --selftest-capacity
+        case 4:
+            cmd = command::selftest;
+            break;
+
+        // handle --selftest-capacity --duration [SEC]
+        case 5:
+            selftest_options.duration = std::abs(std::atof(optarg));
+            break;
+
+        // handle --selftest-capacity --max-loss [PCT]
+        case 6:
+            selftest_options.max_loss = std::abs(std::atof(optarg));
+            break;
+
+        // handle --selftest-capacity --max-error [MS]
+        case 7:
+            selftest_options.max_error = std::abs(std::atof(optarg));
             break;
 
         // handle --tr -m [N]
@@ -120,20 +605,190 @@ int main(std::int32_t argc, char **argv)
         }
     }
 
-    if (is_ping) {
-        if (optind < argc)
-            ntool::ping(argv[optind], std::abs(ping_count));
-        else
-            error("ntool: expected target after --ping option");
+    // merging trace logs is command of its own, otherwise route is merged
+    if (cmd == command::none && topology_options.snapshot)
+        cmd = command::topology;
+
+    // reading archives, stores & feeds does not need raw sockets
+    if (cmd != command::none && cmd != command::decode && cmd != command::query &&
+        cmd != command::tail && cmd != command::flight && cmd != command::asn_build &&
+        cmd != command::topology && cmd != command::trace_diff) {
+        terminate_if_not_root();
+
+        // engine history is dumped on SIGUSR1, fatal errors & anomalies
+        ntool::flight_install(flight_dir);
+    }
+
+    // database stays mapped until exit
+    ntool::asn_db asn_db;
+
+    if (asn_path) {
+        if (!asn_db.open(asn_path))
+            error("ntool: not an AS database or cannot be read");
+
+        ping_options.output.asn = &asn_db;
+        topology_options.asn    = &asn_db;
     }
-    else if (is_tr) {
-        if (optind < argc)
-            ntool::traceroute(argv[optind], std::abs(hops), std::abs(queries));
-        else
+
+    switch (cmd) {
+    case command::ping:
+        if (optind >= argc)
+            error("ntool: expected target after --ping option");
+
+        ping_options.count = std::abs(ping_count);
+        ntool::ping(argv[optind], ping_options);
+        break;
+
+    case command::traceroute: {
+        if (optind >= argc)
             error("ntool: expected target after --tr option");
+
+        ntool::topology graph;
+
+        if (topology_options.snapshot)
+            ntool::topology_restore(graph, topology_options);
+
+        ntool::traceroute(argv[optind], std::abs(hops), std::abs(queries),
+            ping_options.output, ping_options.engine_stats,
+            topology_options.snapshot ? &graph : nullptr
+        );
+
+        if (topology_options.snapshot)
+            ntool::topology_export(graph, topology_options);
+        break;
+    }
+
+    case command::selftest:
+        ntool::selftest_capacity((optind < argc) ? argv[optind] : "127.0.0.1",
+            selftest_options
+        );
+        break;
+
+    case command::monitor: {
+        if ((optind >= argc) == !target_file)
+            error("ntool: expected targets or -f after --monitor option");
+
+        ntool::monitor_options options;
+        options.count        = std::abs(ping_count);
+        options.interval     = ping_options.interval;
+        options.timeout      = ping_options.timeout;
+        options.quiet        = ping_options.quiet;
+        options.io           = ping_options.io;
+        options.output       = ping_options.output;
+        options.series       = series_config;
+        options.detect       = detect;
+        options.detector     = detector_config;
+        options.metrics      = metrics;
+        options.engine_stats = ping_options.engine_stats;
+        options.huge_pages   = ping_options.huge_pages;
+        options.file         = target_file;
+        options.prefixes     = prefix_file;
+        options.rollup       = static_cast<std::uint8_t>(rollup);
+        options.trace        = trace;
+
+        if (hops)
+            options.hops = std::clamp<std::int32_t>(std::abs(hops), 1, ntool::ROUTE_MAX_HOPS);
+
+        ntool::monitor({argv + optind, argv + argc}, options);
+        break;
+    }
+
+    case command::decode:
+        ntool::decode_log(decode_path, ping_options.output);
+        break;
+
+    case command::tail:
+        ntool::tail_feed(tail_name, ping_options.output);
+        break;
+
+    case command::query:
+        ntool::query_store(query_path, query_options);
+        break;
+
+    case command::flight:
+        ntool::flight_convert(flight_path, ping_options.output);
+        break;
+
+    case command::routes:
+        if ((optind >= argc) == !target_file)
+            error("ntool: expected targets or -f after --routes option");
+
+        route_options.count    = std::abs(ping_count);
+        route_options.interval = ping_options.interval;
+        route_options.timeout  = ping_options.timeout;
+        route_options.io       = ping_options.io;
+        route_options.file     = target_file;
+
+        if (hops)
+            route_options.hops = std::clamp<std::int32_t>(std::abs(hops), 1, ntool::ROUTE_MAX_HOPS);
+
+        if (queries)
+            route_options.queries = std::clamp(std::abs(queries), 1, 255);
+
+        ntool::monitor_routes({argv + optind, argv + argc}, route_options);
+        break;
+
+    case command::hops: {
+        if ((optind >= argc) == !target_file)
+            error("ntool: expected targets or -f after --hops option");
+
+        ntool::hops_options options;
+        options.interval = ping_options.interval;
+        options.timeout  = ping_options.timeout;
+        options.quiet    = ping_options.quiet;
+        options.io       = ping_options.io;
+        options.file     = target_file;
+        options.rate     = rate;
+
+        if (ping_count)
+            options.count = std::abs(ping_count);
+
+        if (hops)
+            options.hops = std::clamp<std::int32_t>(std::abs(hops), 1, ntool::ROUTE_MAX_HOPS);
+
+        ntool::hop_statistics({argv + optind, argv + argc}, options);
+        break;
+    }
+
+    case command::topology:
+        ntool::merge_topology({argv + optind, argv + argc}, topology_options);
+        break;
+
+    case command::trace_diff: {
+        if (optind >= argc)
+            error("ntool: expected new trace result logs after --trace-diff option");
+
+        ntool::trace_diff_options options;
+        options.threads = query_options.threads;
+        options.quiet   = ping_options.quiet;
+
+        ntool::trace_diff(diff_before, argv[optind], options);
+        break;
+    }
+
+    case command::asn_build: {
+        if (!ping_options.output.path)
+            error("ntool: expected --output with --asn-build option");
+
+        auto stats = ntool::asn_compile(asn_source, ping_options.output.path);
+
+        std::printf("Compiled %zu prefixes into %zu ranges (%zu kB) to %s\n",
+            stats.prefixes, stats.ranges, stats.bytes / 1024, ping_options.output.path
+        );
+
+        if (stats.skipped || stats.invalid) {
+            std::printf("skipped %lu lines (comments & IPv6), %lu invalid lines\n",
+                stats.skipped, stats.invalid
+            );
+        }
+
+        break;
     }
-    else
+
+    default:
         help();
+        break;
+    }
 
     return 0;
 }
\ No newline at end of file
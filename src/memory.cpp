@@ -0,0 +1,185 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/memory.hpp>
+#include <ntool/utils.hpp>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+
+
+namespace ntool {
+
+/**
+ * @brief Round size up to multiple of given power of 2.
+ *
+ * @param [in] size - given size.
+ * @param [in] unit - given unit.
+ * @return rounded size.
+ */
+static std::size_t round_up(std::size_t size, std::size_t unit) noexcept;
+
+static std::atomic<std::uint64_t> mapped_bytes {0};
+static std::atomic<std::uint64_t> huge_bytes   {0};
+static std::atomic<std::uint64_t> arena_bytes  {0};
+static std::atomic<std::uint64_t> slab_allocs  {0};
+static std::atomic<std::uint64_t> slab_frees   {0};
+
+
+memory_counters memory_stats(void) noexcept
+{
+    return {
+        mapped_bytes.load(std::memory_order_relaxed),
+        huge_bytes.load(std::memory_order_relaxed),
+        arena_bytes.load(std::memory_order_relaxed),
+        slab_allocs.load(std::memory_order_relaxed),
+        slab_frees.load(std::memory_order_relaxed),
+    };
+}
+
+page_buffer::page_buffer(std::size_t size, bool huge) noexcept
+{
+    constexpr auto PROT  = PROT_READ | PROT_WRITE;
+    constexpr auto FLAGS = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (size == 0)
+        return;
+
+    m_size = round_up(size, huge ? HUGE_PAGE_SIZE : 4096);
+    m_data = MAP_FAILED;
+
+    // reserved huge pages are usually not configured, fall back to THP
+    if (huge) {
+        m_data = mmap(nullptr, m_size, PROT, FLAGS | MAP_HUGETLB, -1, 0);
+        m_huge = m_data != MAP_FAILED;
+    }
+
+    if (m_data == MAP_FAILED) {
+        m_data = mmap(nullptr, m_size, PROT, FLAGS, -1, 0);
+
+        if (m_data == MAP_FAILED)
+            utils::error("ntool: cannot map memory");
+
+        if (huge)
+            madvise(m_data, m_size, MADV_HUGEPAGE);
+    }
+
+    mapped_bytes.fetch_add(m_size, std::memory_order_relaxed);
+
+    if (m_huge)
+        huge_bytes.fetch_add(m_size, std::memory_order_relaxed);
+}
+
+page_buffer::~page_buffer(void) noexcept
+{
+    if (!m_data)
+        return;
+
+    munmap(m_data, m_size);
+    mapped_bytes.fetch_sub(m_size, std::memory_order_relaxed);
+
+    if (m_huge)
+        huge_bytes.fetch_sub(m_size, std::memory_order_relaxed);
+}
+
+page_buffer::page_buffer(page_buffer&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_huge(std::exchange(other.m_huge, false))
+{}
+
+page_buffer& page_buffer::operator=(page_buffer&& other) noexcept
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_huge, other.m_huge);
+    return *this;
+}
+
+arena::arena(std::size_t chunk) noexcept
+    : m_chunk(chunk)
+{}
+
+arena::~arena(void) noexcept
+{
+    reset();
+}
+
+const char *arena::copy(std::string_view str) noexcept
+{
+    auto p = static_cast<char*>(allocate(str.size() + 1, 1));
+    std::memcpy(p, str.data(), str.size());
+    return p;
+}
+
+void arena::reset(void) noexcept
+{
+    for (const auto& chunk : m_chunks)
+        arena_bytes.fetch_sub(chunk.size(), std::memory_order_relaxed);
+
+    m_chunks.clear();
+    m_pos  = 0;
+    m_end  = 0;
+    m_used = 0;
+}
+
+void arena::grow(std::size_t size) noexcept
+{
+    m_chunks.emplace_back(std::max(size, m_chunk), false);
+
+    const auto& chunk = m_chunks.back();
+    m_pos = reinterpret_cast<std::uintptr_t>(chunk.data());
+    m_end = m_pos + chunk.size();
+
+    arena_bytes.fetch_add(chunk.size(), std::memory_order_relaxed);
+}
+
+slab_pool::slab_pool(std::size_t size, std::size_t align, std::size_t objects) noexcept
+    : m_arena(round_up(size, align) * objects), m_size(round_up(size, align)),
+      m_align(align)
+{}
+
+void *slab_pool::allocate(void) noexcept
+{
+    // concurrent updates from several threads may be lost (statistics only)
+    utils::counter_add(slab_allocs, 1);
+
+    if (!m_free)
+        return m_arena.allocate(m_size, m_align);
+
+    auto object = m_free;
+    m_free      = object->next;
+    return object;
+}
+
+void slab_pool::release(void *ptr) noexcept
+{
+    utils::counter_add(slab_frees, 1);
+
+    auto object  = static_cast<node*>(ptr);
+    object->next = m_free;
+    m_free       = object;
+}
+
+static std::size_t round_up(std::size_t size, std::size_t unit) noexcept
+{
+    return (size + unit - 1) & ~(unit - 1);
+}
+
+} // namespace ntool
@@ -0,0 +1,433 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/metrics.hpp>
+#include <ntool/output.hpp>
+#include <ntool/utils.hpp>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+
+namespace ntool {
+
+/** Scrape connection state.*/
+enum client_state : std::uint8_t {
+    CLIENT_READING,     // reading request
+    CLIENT_WAITING,     // waiting for snapshot
+    CLIENT_SENDING,     // sending response
+    CLIENT_DONE,        // to be closed
+};
+
+inline const std::uint8_t NO_BODY {2};  // response without snapshot
+
+/** Histogram bucket bounds in seconds (see METRICS_BOUNDS).*/
+static const char *bucket_labels[METRICS_BUCKETS] {
+    "0.0005", "0.001", "0.002", "0.005", "0.01", "0.02", "0.05", "0.1", "0.2",
+    "0.5", "+Inf",
+};
+
+/** Engine counter names (see engine_counters).*/
+static const char *engine_names[] {
+    "sent", "received", "timeouts", "foreign", "stalls", "filtered", "truncated",
+    "send_errors",
+};
+
+static const char NOT_FOUND[] {
+    "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+};
+
+/**
+ * @brief Append exposition of per-target counter family.
+ *
+ * @param [out] out - given string to append.
+ * @param [in] name - given metric name.
+ * @param [in] help - given metric description.
+ * @param [in] targets - given target addresses.
+ * @param [in] value - given function returning value of target.
+ */
+template <typename F>
+static void render_family(std::string& out, const char *name, const char *help,
+    const std::vector<in_addr_t>& targets, F&& value) noexcept;
+
+/**
+ * @brief Write target label.
+ *
+ * @param [out] p - given output position.
+ * @param [in] name - given metric name.
+ * @param [in] addr - given target address.
+ * @return position after written characters.
+ */
+static char *format_target(char *p, const char *name, in_addr_t addr) noexcept;
+
+
+metrics_registry::metrics_registry(const std::vector<in_addr_t>& targets) noexcept
+    : m_targets(targets), m_metrics(new target_metrics[targets.size()] {})
+{}
+
+void metrics_registry::record(const probe_result& result) noexcept
+{
+    auto& m = m_metrics[result.target];
+    utils::counter_add(m.probes, 1);
+
+    if (result.timeout) {
+        utils::counter_add(m.timeouts, 1);
+        return;
+    }
+
+    if (result.type != ICMP_ECHOREPLY)
+        return;
+
+    // bucket is first one with bound >= RTT (le label of Prometheus)
+    auto rtt    = (result.recv_ns - result.send_ns + 500) / 1000;
+    auto bucket = std::lower_bound(METRICS_BOUNDS, METRICS_BOUNDS + METRICS_BUCKETS - 1,
+        rtt) - METRICS_BOUNDS;
+
+    utils::counter_add(m.replies, 1);
+    utils::counter_add(m.rtt_sum, rtt);
+    utils::counter_add(m.buckets[bucket], 1);
+}
+
+void metrics_registry::update(const engine_counters& counters) noexcept
+{
+    m_engine[0].store(counters.sent, std::memory_order_relaxed);
+    m_engine[1].store(counters.received, std::memory_order_relaxed);
+    m_engine[2].store(counters.timeouts, std::memory_order_relaxed);
+    m_engine[3].store(counters.foreign, std::memory_order_relaxed);
+    m_engine[4].store(counters.stalls, std::memory_order_relaxed);
+    m_engine[5].store(counters.filtered, std::memory_order_relaxed);
+    m_engine[6].store(counters.truncated, std::memory_order_relaxed);
+    m_engine[7].store(counters.send_errors, std::memory_order_relaxed);
+}
+
+void metrics_registry::render(std::string& out) const noexcept
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    out.clear();
+
+    render_family(out, "ntool_probes_total", "Resolved probes of target.", m_targets,
+        [this](std::size_t t) noexcept { return m_metrics[t].probes.load(relaxed); }
+    );
+    render_family(out, "ntool_replies_total", "Echo replies of target.", m_targets,
+        [this](std::size_t t) noexcept { return m_metrics[t].replies.load(relaxed); }
+    );
+    render_family(out, "ntool_timeouts_total", "Unanswered probes of target.", m_targets,
+        [this](std::size_t t) noexcept { return m_metrics[t].timeouts.load(relaxed); }
+    );
+
+    out += "# HELP ntool_rtt_seconds Round-trip time of target.\n"
+           "# TYPE ntool_rtt_seconds histogram\n";
+
+    char chunk[1 << 16];
+    auto p = chunk;
+
+    for (std::size_t t = 0; t < m_targets.size(); t++) {
+        const auto& m       = m_metrics[t];
+        std::uint64_t count = 0;
+
+        if (p - chunk > static_cast<std::ptrdiff_t>(sizeof(chunk)) - 2048) {
+            out.append(chunk, p - chunk);
+            p = chunk;
+        }
+
+        // buckets are read once, so count matches cumulative +Inf bucket
+        for (std::uint32_t b = 0; b < METRICS_BUCKETS; b++) {
+            count += m.buckets[b].load(relaxed);
+
+            p    = format_target(p, "ntool_rtt_seconds_bucket", m_targets[t]);
+            p    = format_str(p, "\",le=\"");
+            p    = format_str(p, bucket_labels[b]);
+            p    = format_str(p, "\"} ");
+            p    = format_u64(p, count);
+            *p++ = '\n';
+        }
+
+        p    = format_target(p, "ntool_rtt_seconds_sum", m_targets[t]);
+        p    = format_str(p, "\"} ");
+        p    = format_fixed(p, m.rtt_sum.load(relaxed), 6);
+        p    = format_target(p, "\nntool_rtt_seconds_count", m_targets[t]);
+        p    = format_str(p, "\"} ");
+        p    = format_u64(p, count);
+        *p++ = '\n';
+    }
+
+    out.append(chunk, p - chunk);
+
+    for (std::uint32_t i = 0; i < std::size(engine_names); i++) {
+        p = chunk;
+        p = format_str(p, "# TYPE ntool_engine_");
+        p = format_str(p, engine_names[i]);
+        p = format_str(p, "_total counter\nntool_engine_");
+        p = format_str(p, engine_names[i]);
+        p = format_str(p, "_total ");
+        p = format_u64(p, m_engine[i].load(relaxed));
+        *p++ = '\n';
+        out.append(chunk, p - chunk);
+    }
+
+    p = format_str(chunk, "# TYPE ntool_targets gauge\nntool_targets ");
+    p = format_u64(p, m_targets.size());
+    *p++ = '\n';
+    out.append(chunk, p - chunk);
+}
+
+metrics_exporter::metrics_exporter(const metrics_registry& registry, std::uint16_t port) noexcept
+    : m_registry(registry)
+{
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (m_fd < 0)
+        utils::error("ntool: metrics: socket creation error");
+
+    std::int32_t on = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+        utils::error("ntool: metrics: cannot bind metrics port");
+
+    if (listen(m_fd, METRICS_MAX_CLIENTS) == -1)
+        utils::error("ntool: metrics: listen error");
+
+    m_clients.reserve(METRICS_MAX_CLIENTS);
+    m_thread = std::thread(&metrics_exporter::serialize, this);
+}
+
+metrics_exporter::~metrics_exporter(void) noexcept
+{
+    m_running.store(false, std::memory_order_release);
+    m_request.store(true, std::memory_order_release);
+    m_request.notify_one();
+    m_thread.join();
+
+    for (auto c : m_clients) {
+        close(c->fd);
+        m_pool.destroy(c);
+    }
+
+    close(m_fd);
+}
+
+std::int32_t metrics_exporter::fd(void) const noexcept
+{
+    return m_fd;
+}
+
+void metrics_exporter::poll(void) noexcept
+{
+    for (;;) {
+        auto fd = accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+            break;
+
+        if (m_clients.size() >= METRICS_MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+
+        auto c   = m_pool.create();
+        c->fd    = fd;
+        c->state = CLIENT_READING;
+        m_clients.push_back(c);
+    }
+
+    bool waiting = false;
+
+    for (auto c : m_clients) {
+        if (c->state == CLIENT_READING)
+            read(*c);
+
+        waiting = waiting || c->state == CLIENT_WAITING;
+    }
+
+    // fresh snapshot is rendered, serve it to all waiting clients
+    if (m_rendering && m_ready.load(std::memory_order_acquire)) {
+        m_ready.store(false, std::memory_order_relaxed);
+        m_rendering = false;
+        m_front    ^= 1;
+
+        for (auto c : m_clients) {
+            if (c->state != CLIENT_WAITING)
+                continue;
+
+            c->state  = CLIENT_SENDING;
+            c->buffer = m_front;
+            c->header = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; "
+                "charset=utf-8\r\nContent-Length: " +
+                std::to_string(m_buffers[m_front].size()) + "\r\nConnection: close\r\n\r\n";
+        }
+
+        waiting = false;
+    }
+
+    // back buffer can be rendered only when nobody sends from it
+    if (waiting && !m_rendering) {
+        bool busy = std::any_of(m_clients.begin(), m_clients.end(), [this](const client *c) {
+            return c->state == CLIENT_SENDING && c->buffer == (m_front ^ 1);
+        });
+
+        if (!busy) {
+            m_rendering = true;
+            m_request.store(true, std::memory_order_release);
+            m_request.notify_one();
+        }
+    }
+
+    std::size_t budget = METRICS_SEND_BUDGET;
+
+    for (auto c : m_clients) {
+        if (c->state == CLIENT_SENDING)
+            write(*c, budget);
+    }
+
+    std::erase_if(m_clients, [this](client *c) {
+        if (c->state != CLIENT_DONE)
+            return false;
+
+        close(c->fd);
+        m_pool.destroy(c);
+        return true;
+    });
+}
+
+void metrics_exporter::serialize(void) noexcept
+{
+    for (;;) {
+        m_request.wait(false, std::memory_order_acquire);
+
+        if (!m_running.load(std::memory_order_acquire))
+            break;
+
+        m_request.store(false, std::memory_order_relaxed);
+        m_registry.render(m_buffers[m_front ^ 1]);
+        m_ready.store(true, std::memory_order_release);
+    }
+}
+
+void metrics_exporter::read(client& c) noexcept
+{
+    for (;;) {
+        auto space = sizeof(c.request) - 1 - c.received;
+        auto ret   = recv(c.fd, c.request + c.received, space, 0);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        if (ret <= 0) {
+            c.state = CLIENT_DONE;
+            return;
+        }
+
+        c.received += ret;
+        c.request[c.received] = '\0';
+
+        // headers are not needed, only request line
+        if (std::strstr(c.request, "\r\n\r\n") || c.received == sizeof(c.request) - 1)
+            break;
+    }
+
+    if (std::strncmp(c.request, "GET /metrics", 12) == 0) {
+        c.state = CLIENT_WAITING;
+        return;
+    }
+
+    c.state  = CLIENT_SENDING;
+    c.buffer = NO_BODY;
+    c.header = NOT_FOUND;
+}
+
+void metrics_exporter::write(client& c, std::size_t& budget) noexcept
+{
+    auto body  = (c.buffer == NO_BODY) ? std::string_view() : std::string_view(m_buffers[c.buffer]);
+    auto total = c.header.size() + body.size();
+
+    while (c.sent < total && budget > 0) {
+        auto header = c.sent < c.header.size();
+        auto data   = header ? c.header.data() + c.sent : body.data() + (c.sent - c.header.size());
+        auto size   = header ? c.header.size() - c.sent : total - c.sent;
+        auto ret    = send(c.fd, data, std::min(size, budget), MSG_NOSIGNAL);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        if (ret < 0) {
+            c.state = CLIENT_DONE;
+            return;
+        }
+
+        c.sent += ret;
+        budget -= ret;
+    }
+
+    if (c.sent == total)
+        c.state = CLIENT_DONE;
+}
+
+template <typename F>
+static void render_family(std::string& out, const char *name, const char *help,
+    const std::vector<in_addr_t>& targets, F&& value) noexcept
+{
+    char chunk[1 << 16];
+    auto p = chunk;
+
+    p = format_str(p, "# HELP ");
+    p = format_str(p, name);
+    *p++ = ' ';
+    p = format_str(p, help);
+    p = format_str(p, "\n# TYPE ");
+    p = format_str(p, name);
+    p = format_str(p, " counter\n");
+
+    for (std::size_t t = 0; t < targets.size(); t++) {
+        if (p - chunk > static_cast<std::ptrdiff_t>(sizeof(chunk)) - 256) {
+            out.append(chunk, p - chunk);
+            p = chunk;
+        }
+
+        p    = format_target(p, name, targets[t]);
+        p    = format_str(p, "\"} ");
+        p    = format_u64(p, value(t));
+        *p++ = '\n';
+    }
+
+    out.append(chunk, p - chunk);
+}
+
+static char *format_target(char *p, const char *name, in_addr_t addr) noexcept
+{
+    p = format_str(p, name);
+    p = format_str(p, "{target=\"");
+
+    return format_ip(p, addr);
+}
+
+} // namespace ntool
@@ -0,0 +1,443 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/monitor.hpp>
+#include <ntool/metrics.hpp>
+#include <ntool/recorder.hpp>
+#include <ntool/targets.hpp>
+#include <ntool/prefix.hpp>
+#include <ntool/engine.hpp>
+#include <ntool/demux.hpp>
+#include <ntool/utils.hpp>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <csignal>
+#include <memory>
+#include <cstdio>
+#include <cmath>
+
+
+namespace ntool {
+
+/**
+ * @brief Handle probe outcome.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given monitor options.
+ */
+static void handle_result(const probe_result& result, void *ctx) noexcept;
+
+/**
+ * @brief Handle probe outcome of trace.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given monitor options.
+ */
+static void handle_trace(const probe_result& result, void *ctx) noexcept;
+
+/**
+ * @brief Compare trace in progress of target with its stored route.
+ *
+ * @param [in] target - given target index.
+ */
+static void finish_trace(std::uint32_t target) noexcept;
+
+/**
+ * @brief Serve metrics scrapes from event loop.
+ *
+ * @param [in] ctx - given metrics exporter.
+ */
+static void poll_metrics(void *ctx) noexcept;
+
+/**
+ * @brief Load target list file or resolve given targets.
+ *
+ * @param [in] names - given targets.
+ * @param [in] file - given target list file (nullptr - none).
+ * @return targets.
+ */
+static std::unique_ptr<target_table> load(const std::vector<const char*>& names,
+    const char *file) noexcept;
+
+/** @brief Print per-target statistics.*/
+static void summary(void) noexcept;
+
+/**
+ * @brief Handle keyboard interrupt.
+ *
+ * @param [in] sig - given signal number.
+ */
+static void sigint_handler(int sig) noexcept;
+
+/** Traces of target (--trace).*/
+struct trace_path {
+    route         stored;   // last known route (fingerprint 0 - none)
+    route         current;  // trace in progress
+    std::uint32_t seq;      // round of trace in progress (0 - none)
+};
+
+static target_table     *targets   = nullptr;
+static prefix_groups    *groups    = nullptr;
+static series_store     *history   = nullptr;
+static anomaly_detector *detector  = nullptr;
+static metrics_registry *registry  = nullptr;
+static output_writer    *writer    = nullptr;
+static engine           *monitorer = nullptr;
+static engine           *tracer    = nullptr;
+static icmp_demux       *demux     = nullptr;
+static trace_path       *paths     = nullptr;
+static std::uint64_t    traces     = 0;         // finished traces
+static std::uint64_t    changes    = 0;         // reported route changes
+static volatile std::sig_atomic_t interrupted = 0;
+static std::FILE        *info      = stdout;    // banner & statistics stream
+static std::uint64_t    anomalies  = 0;         // reported anomaly events
+
+
+void monitor(const std::vector<const char*>& names, const monitor_options& options) noexcept
+{
+    const auto& output = options.output;
+    info = (output.format == output_format::human || output.path) ? stdout : stderr;
+
+    auto table        = load(names, options.file);
+    const auto& addrs = table->addrs();
+
+    // replies are also rolled up by longest matching prefix
+    std::unique_ptr<prefix_groups> prefixes;
+
+    if (options.prefixes)
+        prefixes = std::make_unique<prefix_groups>(options.prefixes, addrs);
+    else if (options.rollup)
+        prefixes = std::make_unique<prefix_groups>(options.rollup, addrs);
+
+    std::fprintf(info, "Monitoring %zu targets every %.3f s, keeping %.0f s of history\n",
+        addrs.size(), options.interval, options.series.retention
+    );
+
+    engine_config config;
+    config.count       = options.count;
+    config.interval_ns = static_cast<std::uint64_t>(options.interval * 1e9);
+    config.timeout_ns  = static_cast<std::uint64_t>(options.timeout * 1e9);
+    config.instrument  = options.engine_stats;
+    config.huge_pages  = options.huge_pages;
+
+    // every target has up to timeout / interval + 1 probes in flight
+    auto rounds         = std::ceil(options.timeout / std::max(options.interval, 1e-6)) + 1;
+    config.max_inflight = std::max<std::uint32_t>(config.max_inflight,
+        static_cast<std::uint32_t>(std::min(addrs.size() * rounds, 1e9))
+    );
+
+    series_store store(addrs.size(), options.series);
+    anomaly_detector detect(addrs.size(), options.detector);
+    auto io = make_transport(options.io, options.huge_pages);
+    icmp_demux shared(*io);
+
+    if (options.trace)
+        shared.reserve(config);
+
+    engine e(*io, config, handle_result, const_cast<monitor_options*>(&options));
+
+    for (auto addr : addrs)
+        e.add_target(addr);
+
+    // traces share socket with pings, each reply is parsed once
+    std::unique_ptr<engine> trace_engine;
+    std::vector<trace_path> trace_paths;
+
+    if (options.trace) {
+        engine_config trace_config;
+        trace_config.hops        = options.hops;
+        trace_config.interval_ns = config.interval_ns * options.trace;
+        trace_config.timeout_ns  = config.timeout_ns;
+        trace_config.count       = (options.count + options.trace - 1) / options.trace;
+
+        auto trace_rounds         = std::ceil(options.timeout /
+            std::max(options.interval * options.trace, 1e-6)) + 1;
+        trace_config.max_inflight = std::max<std::uint32_t>(trace_config.max_inflight,
+            static_cast<std::uint32_t>(std::min(addrs.size() * options.hops * trace_rounds, 1e9))
+        );
+
+        shared.reserve(trace_config);
+        trace_engine = std::make_unique<engine>(*io, trace_config, handle_trace,
+            const_cast<monitor_options*>(&options)
+        );
+
+        for (auto addr : addrs)
+            trace_engine->add_target(addr);
+
+        trace_paths.resize(addrs.size(), trace_path {});
+        shared.attach(e);
+        shared.attach(*trace_engine);
+
+        std::fprintf(info, "Tracing targets every %u rounds (%u max hops)\n", options.trace,
+            options.hops
+        );
+    }
+
+    std::unique_ptr<metrics_registry> metrics;
+    std::unique_ptr<metrics_exporter> exporter;
+
+    if (options.metrics) {
+        metrics  = std::make_unique<metrics_registry>(addrs);
+        exporter = std::make_unique<metrics_exporter>(*metrics, options.metrics);
+        e.set_poll(exporter->fd(), poll_metrics, exporter.get());
+
+        std::fprintf(info, "Serving metrics on http://127.0.0.1:%u/metrics\n",
+            options.metrics
+        );
+    }
+
+    output_writer out(output, record_kind::ping, addrs);
+
+    targets        = table.get();
+    groups         = prefixes.get();
+    history        = &store;
+    detector       = options.detect ? &detect : nullptr;
+    registry       = metrics.get();
+    anomalies      = 0;
+    writer         = &out;
+    monitorer      = &e;
+    tracer         = trace_engine.get();
+    demux          = tracer ? &shared : nullptr;
+    paths          = trace_paths.data();
+    traces         = 0;
+    changes        = 0;
+    interrupted    = 0;
+    std::signal(SIGINT, sigint_handler);
+
+    if (tracer)
+        shared.run();
+    else
+        e.run();
+
+    // interrupted traces are incomplete
+    for (std::uint32_t t = 0; tracer && !interrupted && t < addrs.size(); t++)
+        finish_trace(t);
+
+    out.close();
+
+    summary();
+    paths          = nullptr;
+    demux          = nullptr;
+    tracer         = nullptr;
+    monitorer      = nullptr;
+    writer         = nullptr;
+    detector       = nullptr;
+    registry       = nullptr;
+    history        = nullptr;
+    groups         = nullptr;
+    targets        = nullptr;
+}
+
+static void handle_result(const probe_result& result, void *ctx) noexcept
+{
+    auto options = static_cast<const monitor_options*>(ctx);
+    bool reply   = !result.timeout && result.type == ICMP_ECHOREPLY;
+    auto rtt     = reply ? (result.recv_ns - result.send_ns) / 1e6 : NAN;
+    auto addr    = targets->addrs()[result.target];
+
+    targets->update(result);
+
+    if (groups)
+        groups->update(result);
+    history->append(result.target, utils::realtime_ms(result.send_ns), rtt);
+
+    if (registry)
+        registry->record(result);
+
+    monitorer->lap(stage::stats);
+
+    // anomalies are reported even in quiet mode
+    anomaly_event event;
+
+    if (detector && detector->update(result.target, rtt, event)) {
+        anomalies++;
+        writer->push({result, addr, record_kind::event, true, false, event});
+
+        // keep engine history which has led to anomaly
+        flight_recorder::local().record(flight_event::anomaly, utils::clock_ns(), addr,
+            result.seq, result.ttl, static_cast<std::uint32_t>(event.kind)
+        );
+        writer->request_dump();
+    }
+
+    bool silent = options->quiet && !options->output.path;
+
+    if (silent && !options->output.store && !options->output.feed)
+        return;
+
+    writer->push({result, addr, record_kind::ping, true, silent});
+}
+
+static void handle_trace(const probe_result& result, void *) noexcept
+{
+    auto& path = paths[result.target];
+
+    // late outcome of finished trace
+    if (result.seq < path.seq)
+        return;
+
+    if (result.seq > path.seq) {
+        finish_trace(result.target);
+        path.seq = result.seq;
+    }
+
+    route_add(path.current, result, targets->addrs()[result.target]);
+}
+
+static void finish_trace(std::uint32_t target) noexcept
+{
+    auto& path = paths[target];
+
+    if (!path.seq)
+        return;
+
+    route_finish(path.current);
+    traces++;
+
+    if (!path.stored.fingerprint)
+        path.stored = path.current;
+    else if (route_update(info, targets->addrs()[target], path.stored, path.current))
+        changes++;
+
+    path.current = {};
+}
+
+static void poll_metrics(void *ctx) noexcept
+{
+    registry->update(monitorer->counters());
+    static_cast<metrics_exporter*>(ctx)->poll();
+}
+
+static std::unique_ptr<target_table> load(const std::vector<const char*>& names,
+    const char *file) noexcept
+{
+    if (!file)
+        return std::make_unique<target_table>(names);
+
+    auto begin = utils::clock_ns();
+    target_list list;
+    load_targets(file, 0, list);
+
+    const auto& c = list.counters;
+
+    std::fprintf(info, "Loaded %zu targets from %s in %.3f s (%lu lines, %lu duplicates, "
+        "%lu invalid, %lu names, %lu unresolved)\n", list.addrs.size(), file,
+        (utils::clock_ns() - begin) / 1e9, c.lines, c.duplicates, c.invalid, c.names,
+        c.unresolved
+    );
+
+    if (list.addrs.empty())
+        utils::error("ntool: target list has no targets");
+
+    return std::make_unique<target_table>(std::move(list));
+}
+
+static void summary(void) noexcept
+{
+    std::fprintf(info, "\n--- monitor statistics ---\n");
+    std::fprintf(info, "%-16s %10s %10s %7s %7s  %s\n", "target", "samples",
+        "received", "loss%", "errors", "rtt min/avg/max/mdev ms");
+
+    for (std::uint32_t t = 0; t < targets->size(); t++) {
+        const auto& s = targets->stats(t);
+
+        char ip_str[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &targets->addrs()[t], ip_str, sizeof(ip_str));
+
+        // group is shown for targets without tag
+        auto tag = targets->tag(t);
+
+        if (!tag && groups && groups->group(t) != PREFIX_NONE)
+            tag = groups->label(groups->group(t));
+
+        std::fprintf(info, "%-16s %10u %10u %7.2f %7u  %.3f/%.3f/%.3f/%.3f%s%s\n",
+            ip_str, s.sent, s.received,
+            s.sent ? 100.0 * (s.sent - s.received) / s.sent : 0.0, s.errors,
+            s.rtt_min, s.rtt_mean, s.rtt_max, stddev(s), tag ? "  " : "", tag ? tag : ""
+        );
+    }
+
+    if (groups) {
+        std::fprintf(info, "\n--- prefix statistics ---\n");
+        std::fprintf(info, "%-18s %8s %10s %10s %7s %7s  %s\n", "prefix", "targets",
+            "samples", "received", "loss%", "errors", "rtt min/avg/max/mdev ms");
+
+        for (std::uint32_t g = 0; g < groups->size(); g++) {
+            const auto& s = groups->stats(g);
+
+            std::fprintf(info, "%-18s %8u %10u %10u %7.2f %7u  %.3f/%.3f/%.3f/%.3f\n",
+                groups->label(g), groups->targets(g), s.sent, s.received,
+                s.sent ? 100.0 * (s.sent - s.received) / s.sent : 0.0, s.errors,
+                s.rtt_min, s.rtt_mean, s.rtt_max, stddev(s)
+            );
+        }
+
+        std::fprintf(info, "\n");
+    }
+
+    auto samples = history->samples();
+    auto bits    = history->encoded_bits();
+
+    std::fprintf(info, "history: %lu samples, %.1f bits/sample, %.2f MB allocated, "
+        "%.0f s of %.0f s retention kept by every target\n", samples,
+        samples ? static_cast<double>(bits) / samples : 0.0, history->memory() / 1e6,
+        history->coverage(), history->config().retention
+    );
+
+    // engines cost the same for any number of targets, history grows
+    // with retention
+    auto fixed = monitorer->fixed_memory() + (tracer ? tracer->fixed_memory() : 0);
+    auto state = targets->memory() + monitorer->memory() - monitorer->fixed_memory() +
+        targets->size() * (sizeof(detector_state) + sizeof(series_state)) +
+        (groups ? groups->memory() : 0) +
+        (tracer ? tracer->memory() - tracer->fixed_memory() +
+            targets->size() * sizeof(trace_path) : 0);
+
+    std::fprintf(info, "state: %.1f bytes/target, %.2f MB fixed (in-flight tables)\n",
+        static_cast<double>(state) / std::max<std::uint32_t>(targets->size(), 1),
+        fixed / 1e6
+    );
+
+    if (detector)
+        std::fprintf(info, "anomalies: %lu events\n", anomalies);
+
+    if (tracer) {
+        const auto& c = demux->counters();
+
+        std::fprintf(info, "routes: %lu traces, %lu route changes\n", traces, changes);
+        std::fprintf(info, "demux: %zu engines on one socket, %lu packets, %lu parsed, "
+            "%lu dispatched, %lu foreign, %lu filtered\n", demux->sessions(), c.received,
+            c.parsed, c.dispatched, c.foreign, c.filtered
+        );
+    }
+
+    print_engine_stats(info, *monitorer);
+}
+
+static void sigint_handler(int) noexcept
+{
+    interrupted = 1;
+
+    if (monitorer)
+        monitorer->stop();
+
+    if (tracer)
+        tracer->stop();
+}
+
+} // namespace ntool
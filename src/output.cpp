@@ -0,0 +1,683 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/output.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/usdt.hpp>
+#include <ntool/icmp.hpp>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+
+
+namespace ntool {
+
+/**
+ * @brief Get probe round-trip time.
+ *
+ * @param [in] result - given probe outcome.
+ * @return round-trip time in microseconds (rounded).
+ */
+static std::uint64_t rtt_us(const probe_result& result) noexcept;
+
+inline const std::size_t MAX_RECORD_SIZE {2048};    // incl. router hostname
+
+inline const std::chrono::milliseconds WRITER_IDLE {1};
+inline const std::chrono::microseconds FEED_IDLE   {200};
+
+inline const char CSV_HEADER[] {
+    "mode,target,seq,ttl,send_ns,timeout,from,type,code,reply_ttl,rtt_ms\n"
+};
+
+// "00" "01" ... "99"
+static const char digit_pairs[] {
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899"
+};
+
+
+bool parse_format(const char *name, output_format& format) noexcept
+{
+    static const struct {
+        const char    *name;
+        output_format format;
+    } formats[] {
+        {"human", output_format::human},
+        {"jsonl", output_format::jsonl},
+        {"csv", output_format::csv},
+        {"binary", output_format::binary},
+    };
+
+    for (const auto& f : formats) {
+        if (!std::strcmp(name, f.name)) {
+            format = f.format;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+char *format_str(char *p, const char *str) noexcept
+{
+    auto size = std::strlen(str);
+    std::memcpy(p, str, size);
+
+    return p + size;
+}
+
+char *format_u64(char *p, std::uint64_t value) noexcept
+{
+    char tmp[20];
+    char *end = tmp + sizeof(tmp);
+    char *pos = end;
+
+    // two digits per division
+    while (value >= 100) {
+        auto pair = (value % 100) * 2;
+        value /= 100;
+        *--pos = digit_pairs[pair + 1];
+        *--pos = digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        *--pos = digit_pairs[value * 2 + 1];
+        *--pos = digit_pairs[value * 2];
+    }
+    else
+        *--pos = static_cast<char>('0' + value);
+
+    std::memcpy(p, pos, end - pos);
+    return p + (end - pos);
+}
+
+char *format_fixed(char *p, std::uint64_t value, std::uint32_t digits) noexcept
+{
+    std::uint64_t scale = 1;
+
+    for (std::uint32_t i = 0; i < digits; i++)
+        scale *= 10;
+
+    p = format_u64(p, value / scale);
+
+    if (digits == 0)
+        return p;
+
+    *p++ = '.';
+    auto fraction = value % scale;
+
+    for (auto i = digits; i > 0; i--) {
+        p[i - 1]  = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+
+    return p + digits;
+}
+
+char *format_ip(char *p, in_addr_t addr) noexcept
+{
+    auto bytes = reinterpret_cast<const std::uint8_t*>(&addr);
+
+    for (std::uint32_t i = 0; i < 4; i++) {
+        if (i > 0)
+            *p++ = '.';
+
+        p = format_u64(p, bytes[i]);
+    }
+
+    return p;
+}
+
+char *format_jsonl(char *p, const output_record& record) noexcept
+{
+    const auto& r = record.result;
+
+    p = format_str(p, (record.kind == record_kind::trace)
+        ? "{\"mode\":\"trace\",\"target\":\"" : "{\"mode\":\"ping\",\"target\":\"");
+    p = format_ip(p, record.target);
+    p = format_str(p, "\",\"seq\":");
+    p = format_u64(p, r.seq);
+    p = format_str(p, ",\"ttl\":");
+    p = format_u64(p, r.ttl);
+    p = format_str(p, ",\"send_ns\":");
+    p = format_u64(p, r.send_ns);
+
+    if (r.timeout)
+        return format_str(p, ",\"timeout\":true}\n");
+
+    p = format_str(p, ",\"timeout\":false,\"from\":\"");
+    p = format_ip(p, r.from);
+    p = format_str(p, "\",\"type\":");
+    p = format_u64(p, r.type);
+    p = format_str(p, ",\"code\":");
+    p = format_u64(p, r.code);
+    p = format_str(p, ",\"reply_ttl\":");
+    p = format_u64(p, r.reply_ttl);
+    p = format_str(p, ",\"rtt_ms\":");
+    p = format_fixed(p, rtt_us(r), 3);
+
+    if (record.asn) {
+        p = format_str(p, ",\"asn\":");
+        p = format_u64(p, record.asn);
+    }
+
+    return format_str(p, "}\n");
+}
+
+char *format_event_jsonl(char *p, const output_record& record) noexcept
+{
+    const auto& e = record.event;
+
+    p = format_str(p, "{\"mode\":\"event\",\"target\":\"");
+    p = format_ip(p, record.target);
+    p = format_str(p, "\",\"event\":\"");
+    p = format_str(p, anomaly_name(e.kind));
+    p = format_str(p, "\",\"send_ns\":");
+    p = format_u64(p, record.result.send_ns);
+    p = format_str(p, ",\"value\":");
+    p = format_fixed(p, std::lround(e.value * 1e3), 3);
+    p = format_str(p, ",\"baseline\":");
+    p = format_fixed(p, std::lround(e.baseline * 1e3), 3);
+
+    return format_str(p, "}\n");
+}
+
+char *format_event(char *p, const output_record& record) noexcept
+{
+    const auto& e = record.event;
+
+    p = format_str(p, "anomaly: ");
+    p = format_ip(p, record.target);
+
+    switch (e.kind) {
+    case anomaly_kind::latency_up:
+    case anomaly_kind::latency_down:
+        p = format_str(p, (e.kind == anomaly_kind::latency_up)
+            ? " latency up, rtt " : " latency down, rtt ");
+        p = format_fixed(p, std::lround(e.value * 1e3), 3);
+        p = format_str(p, " ms (baseline ");
+        p = format_fixed(p, std::lround(e.baseline * 1e3), 3);
+        return format_str(p, " ms)\n");
+
+    case anomaly_kind::loss_burst:
+        p = format_str(p, " loss burst, ");
+        p = format_u64(p, e.value);
+        return format_str(p, " probes lost\n");
+
+    case anomaly_kind::loss_rate:
+        p = format_str(p, " loss rate ");
+        p = format_fixed(p, std::lround(e.value * 1e3), 1);
+        p = format_str(p, "% (alarm level ");
+        p = format_fixed(p, std::lround(e.baseline * 1e3), 1);
+        return format_str(p, "%)\n");
+
+    default:
+        p = format_str(p, " recovered after ");
+        p = format_u64(p, e.value);
+        return format_str(p, " lost probes\n");
+    }
+}
+
+char *format_csv(char *p, const output_record& record) noexcept
+{
+    const auto& r = record.result;
+
+    p = format_str(p, (record.kind == record_kind::trace) ? "trace," : "ping,");
+    p = format_ip(p, record.target);
+    *p++ = ',';
+    p = format_u64(p, r.seq);
+    *p++ = ',';
+    p = format_u64(p, r.ttl);
+    *p++ = ',';
+    p = format_u64(p, r.send_ns);
+
+    if (r.timeout)
+        return format_str(p, ",1,,,,,\n");
+
+    p = format_str(p, ",0,");
+    p = format_ip(p, r.from);
+    *p++ = ',';
+    p = format_u64(p, r.type);
+    *p++ = ',';
+    p = format_u64(p, r.code);
+    *p++ = ',';
+    p = format_u64(p, r.reply_ttl);
+    *p++ = ',';
+    p = format_fixed(p, rtt_us(r), 3);
+    *p++ = '\n';
+
+    return p;
+}
+
+output_writer::output_writer(const output_options& options, record_kind kind,
+    const std::vector<in_addr_t>& targets) noexcept
+    : m_options(options), m_ring(OUTPUT_RING_SIZE)
+{
+    if (options.path) {
+        m_fd = open(options.path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (m_fd < 0)
+            utils::error("ntool: output: cannot open output file");
+    }
+    else {
+        // keep lines printed with stdio before records
+        std::fflush(stdout);
+        m_fd = STDOUT_FILENO;
+    }
+
+    if (options.format == output_format::csv)
+        m_size = format_str(m_buffer, CSV_HEADER) - m_buffer;
+    else if (options.format == output_format::binary)
+        m_log = std::make_unique<log_writer>(m_fd, kind, targets, options.direct);
+
+    if (options.feed)
+        m_feed = std::make_unique<feed_writer>(options.feed, options.feed_size);
+
+    // store keeps ping results only, trace hops are not target RTTs
+    if (options.store && kind == record_kind::ping)
+        m_store = std::make_unique<segment_writer>(options.store, options.segment);
+
+    m_thread = std::thread(&output_writer::run, this);
+}
+
+output_writer::~output_writer(void) noexcept
+{
+    close();
+}
+
+bool output_writer::push(const output_record& record) noexcept
+{
+    // consumers get outcome immediately, not after writer thread drains it
+    if (m_feed && record.kind != record_kind::event)
+        m_feed->publish(record.result, record.target, record.kind);
+
+    NTOOL_USDT4(output, record.target, record.result.seq,
+        static_cast<std::uint8_t>(record.kind), m_ring.size()
+    );
+
+    if (m_ring.push(record))
+        return true;
+
+    m_dropped++;
+    return false;
+}
+
+void output_writer::push_wait(const output_record& record) noexcept
+{
+    while (!m_ring.push(record))
+        std::this_thread::yield();
+}
+
+void output_writer::request_dump(void) noexcept
+{
+    m_dump.store(true, std::memory_order_release);
+}
+
+void output_writer::close(void) noexcept
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_running.store(false, std::memory_order_release);
+    m_thread.join();
+
+    if (m_log)
+        m_log->close();
+
+    if (m_store)
+        m_store->close();
+
+    if (m_fd != STDOUT_FILENO)
+        ::close(m_fd);
+
+    if (m_dropped > 0) {
+        std::fprintf(stderr, "ntool: output: %lu records dropped "
+            "(writer could not keep up)\n", m_dropped
+        );
+    }
+}
+
+std::uint64_t output_writer::dropped(void) const noexcept
+{
+    return m_dropped;
+}
+
+void output_writer::run(void) noexcept
+{
+    output_record record;
+
+    for (;;) {
+        // read flag before draining, so records pushed before close() are kept
+        bool running = m_running.load(std::memory_order_acquire);
+        bool idle    = true;
+
+        while (m_ring.pop(record)) {
+            if (m_size + MAX_RECORD_SIZE > sizeof(m_buffer))
+                flush();
+
+            if (m_store && record.kind == record_kind::ping)
+                store(record);
+
+            if (!record.silent)
+                format(record);
+
+            idle = false;
+        }
+
+        flush();
+
+        if (m_dump.exchange(false, std::memory_order_acquire))
+            flight_dump(flight_reason::anomaly);
+
+        if (!running)
+            break;
+
+        if (idle)
+            std::this_thread::sleep_for(WRITER_IDLE);
+    }
+}
+
+void output_writer::format(const output_record& record) noexcept
+{
+    auto p = m_buffer + m_size;
+
+    if (record.kind == record_kind::event) {
+        if (m_options.format == output_format::jsonl)
+            p = format_event_jsonl(p, record);
+        else if (m_options.format == output_format::human)
+            p = format_event(p, record);
+        else {
+            // CSV & binary records have fixed layout, report events aside
+            char line[256];
+            auto size = format_event(line, record) - line;
+
+            if (::write(STDERR_FILENO, line, size) < 0)
+                return;
+        }
+
+        m_size = p - m_buffer;
+        return;
+    }
+
+    switch (m_options.format) {
+    case output_format::jsonl:
+        p = format_jsonl(p, record);
+        break;
+
+    case output_format::csv:
+        p = format_csv(p, record);
+        break;
+
+    case output_format::binary:
+        m_log->append(record.result);
+        break;
+
+    default:
+        p = format_human(p, record);
+        break;
+    }
+
+    m_size = p - m_buffer;
+}
+
+void output_writer::store(const output_record& record) noexcept
+{
+    const auto& r = record.result;
+    bool reply    = !r.timeout && r.type == ICMP_ECHOREPLY;
+    auto rtt      = reply ? std::min<std::uint64_t>(rtt_us(r), SEGMENT_LOST - 1) : SEGMENT_LOST;
+
+    m_store->append(record.target, utils::realtime_ms(r.send_ns), rtt);
+}
+
+char *output_writer::format_human(char *p, const output_record& record) noexcept
+{
+    const auto& r = record.result;
+
+    if (record.kind == record_kind::trace) {
+        if (r.seq == 1) {
+            m_prev = 0;
+            *p++   = ' ';
+
+            if (r.ttl < 10)
+                *p++ = ' ';
+
+            p    = format_u64(p, r.ttl);
+            *p++ = ' ';
+        }
+
+        if (r.timeout)
+            p = format_str(p, " *");
+        else {
+            // print router again only if it differs from previous query
+            if (r.from != m_prev) {
+                sockaddr_in addr {};
+                addr.sin_family      = AF_INET;
+                addr.sin_addr.s_addr = r.from;
+
+                char hostname[NI_MAXHOST];
+                auto sa = reinterpret_cast<const sockaddr*>(&addr);
+
+                // fall back to numeric host when resolver is unavailable
+                if (getnameinfo(sa, sizeof(addr), hostname, sizeof(hostname), 0, 0, 0) != 0 &&
+                    getnameinfo(sa, sizeof(addr), hostname, sizeof(hostname), 0, 0,
+                        NI_NUMERICHOST) != 0) {
+                    utils::error("ntool: traceroute: get hostname error");
+                }
+
+                *p++   = ' ';
+                p      = format_str(p, hostname);
+                p      = format_str(p, " (");
+                p      = format_ip(p, r.from);
+                p      = format_str(p, ")");
+
+                if (record.asn) {
+                    p    = format_str(p, " [AS");
+                    p    = format_u64(p, record.asn);
+                    *p++ = ']';
+                }
+
+                *p++   = ' ';
+                m_prev = r.from;
+            }
+
+            *p++ = ' ';
+            p    = format_fixed(p, rtt_us(r), 3);
+            p    = format_str(p, " ms");
+        }
+
+        if (record.last)
+            *p++ = '\n';
+
+        return p;
+    }
+
+    if (r.timeout) {
+        p = format_str(p, "From ");
+        p = format_ip(p, record.target);
+        p = format_str(p, ": icmp_seq=");
+        p = format_u64(p, r.seq);
+        return format_str(p, " Failed to receive packet\n");
+    }
+
+    switch (r.type) {
+    case ICMP_ECHOREPLY:
+        p = format_u64(p, ICMP_PACKET_SIZE);
+        p = format_str(p, " bytes from ");
+        p = format_ip(p, record.target);
+        p = format_str(p, ": icmp_seq=");
+        p = format_u64(p, r.seq);
+        p = format_str(p, " ttl=");
+        p = format_u64(p, r.reply_ttl);
+        p = format_str(p, " rtt=");
+        p = format_fixed(p, rtt_us(r), 3);
+        return format_str(p, " ms\n");
+
+    case ICMP_UNREACH:
+        p = format_str(p, "From ");
+        p = format_ip(p, record.target);
+        p = format_str(p, ": icmp_seq=");
+        p = format_u64(p, r.seq);
+        *p++ = ' ';
+        p = format_str(p, unreach_decription(r.code));
+        *p++ = '\n';
+        return p;
+
+    default:
+        p = format_str(p, "Received ICMP packet [type: ");
+        p = format_u64(p, r.type);
+        p = format_str(p, " code: ");
+        p = format_u64(p, r.code);
+        p = format_str(p, " seq: ");
+        p = format_u64(p, r.seq);
+        return format_str(p, "]\n");
+    }
+}
+
+void output_writer::flush(void) noexcept
+{
+    std::size_t done = 0;
+
+    while (done < m_size) {
+        auto ret = write(m_fd, m_buffer + done, m_size - done);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            utils::error("ntool: output: write error");
+        }
+
+        done += ret;
+    }
+
+    m_size = 0;
+}
+
+void decode_log(const char *path, const output_options& options) noexcept
+{
+    log_reader reader;
+
+    if (!reader.open(path))
+        utils::error("ntool: decode: not a result log or cannot be read");
+
+    const auto& header = reader.header();
+    auto targets       = reader.targets();
+    auto records       = reader.records();
+    auto kind          = static_cast<record_kind>(header.mode);
+
+    std::fprintf(stderr, "%s: version %u, %s, %u targets, %zu records\n",
+        path, le(header.version), (kind == record_kind::trace) ? "trace" : "ping",
+        le(header.targets), records.size()
+    );
+
+    output_options decode_options = options;
+    decode_options.store          = nullptr;  // probe times are of recording host
+    decode_options.feed           = nullptr;
+
+    // binary output of decoding is a plain copy, default to JSON lines
+    if (decode_options.format == output_format::binary)
+        decode_options.format = output_format::jsonl;
+
+    output_writer out(decode_options, kind,
+        std::vector<in_addr_t>(targets.begin(), targets.end())
+    );
+
+    for (std::size_t i = 0; i < records.size(); i++) {
+        output_record record {};
+        record.result = to_result(records[i]);
+        record.kind   = kind;
+        record.target = (record.result.target < targets.size())
+            ? targets[record.result.target] : 0;
+
+        if (options.asn && kind == record_kind::trace && !record.result.timeout)
+            record.asn = options.asn->lookup(record.result.from);
+
+        // trace records are stored hop by hop
+        record.last = (i + 1 == records.size()) ||
+            records[i + 1].ttl != records[i].ttl;
+
+        out.push_wait(record);
+    }
+
+    out.close();
+}
+
+void tail_feed(const char *name, const output_options& options) noexcept
+{
+    feed_reader reader;
+
+    if (!reader.open(name, false))
+        utils::error("ntool: tail: feed does not exist or cannot be read");
+
+    std::fprintf(stderr, "%s: %u records ring, tailing live records\n", name,
+        reader.header().capacity
+    );
+
+    output_options tail_options = options;
+    tail_options.store          = nullptr;
+    tail_options.feed           = nullptr;
+
+    if (tail_options.format == output_format::binary)
+        tail_options.format = output_format::jsonl;
+
+    // feed carries addresses, target table is not known in advance
+    output_writer out(tail_options, record_kind::ping, {});
+    feed_record records[256];
+
+    while (!reader.finished()) {
+        auto count = reader.read(records, std::size(records));
+
+        if (count == 0) {
+            std::this_thread::sleep_for(FEED_IDLE);
+            continue;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            output_record record {};
+            record.result = to_result(records[i]);
+            record.target = records[i].target;
+            record.kind   = static_cast<record_kind>(records[i].kind);
+            record.last   = true;
+
+            out.push_wait(record);
+        }
+    }
+
+    out.close();
+
+    if (reader.lost() > 0)
+        std::fprintf(stderr, "ntool: tail: %lu records lost (reader was lapped)\n", reader.lost());
+}
+
+static std::uint64_t rtt_us(const probe_result& result) noexcept
+{
+    return (result.recv_ns - result.send_ns + 500) / 1000;
+}
+
+} // namespace ntool
@@ -16,55 +16,27 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <ntool/output.hpp>
+#include <ntool/engine.hpp>
 #include <ntool/utils.hpp>
 #include <ntool/ping.hpp>
 #include <ntool/icmp.hpp>
 #include <arpa/inet.h>
-#include <algorithm>
-#include <unistd.h>
-#include <netdb.h>
 #include <cstring>
 #include <csignal>
+#include <cstdio>
 #include <cmath>
-#include <ctime>
 
 
 namespace ntool {
 
-/** @brief Initialize ping utility.*/
-static void init(void) noexcept;
-
-/**
- * @brief Set the ICMP packet.
- *
- * @param [out] packet - given received packet to process.
- * @param [in] header - given ICMP header.
- */
-static void set_packet(std::uint8_t *packet, const icmphdr& header) noexcept;
-
-/**
- * @brief Send ICMP packet.
- *
- * @param [in] request - given ICMP header.
- * @param [in] addr - given destination address.
- */
-static void send(const icmphdr& request, sockaddr_in& addr) noexcept;
-
-/**
- * @brief Get ICMP header from packet.
- *
- * @param [out] reply - given object to store ICMP packet.
- * @param [in] packet - given received packet to process.
- */
-static void handle_packet(icmphdr& reply, const std::uint8_t *packet) noexcept;
-
 /**
- * @brief Receive ICMP packet.
+ * @brief Handle probe outcome.
  *
- * @param [in] reply - given ICMP header.
- * @param [in] addr - given source address.
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given ping options.
  */
-static void recv(icmphdr& reply, sockaddr_in& addr) noexcept;
+static void handle_result(const probe_result& result, void *ctx) noexcept;
 
 /** @brief Get ping test statistics.*/
 static void summary(void) noexcept;
@@ -78,222 +50,117 @@ static void sigint_handler(int sig) noexcept;
 
 inline const std::uint8_t DEFAULT_PINGS_COUNT {4};
 
-static std::uint16_t transmitted_packets = 0;
-static std::uint16_t received_packets    = 0;
-static std::clock_t  begin_time;    // sending packet time
-static std::clock_t  end_time;      // receiving packet time
-static std::uint8_t  ttl;           // packet time to live
-static std::vector<double> rtt;     // round-trip time (RTT)
-
-inline const char *target_ip_str = nullptr;
-static std::int32_t sockfd       = 0;
+static utils::running_stats rtt;    // round-trip time (RTT) statistics
+static std::uint64_t begin_time;    // first packet sending time
+static std::uint64_t end_time;      // last packet resolving time
+static engine        *pinger = nullptr;
+static output_writer *writer = nullptr;
+static std::FILE     *info   = stdout;  // banner & statistics stream
+static in_addr_t     target_addr;
 
-// default ICMP payload
-inline const std::uint8_t payload[ICMP_PAYLOAD_SIZE]
-{
-    "!!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUV"
-};
+static char target_ip_str[INET_ADDRSTRLEN];
 
-static void init(void) noexcept
+void ping(const std::string_view& target, const ping_options& options) noexcept
 {
-    transmitted_packets = 0;
-    received_packets    = 0;
-    ttl                 = 0;
-    sockfd              = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
-
-    if (sockfd < 0)
-        utils::error("ntool: ping: raw socket creation error");
-
-    // add limit time for receiving packet
-    timeval timeout;
-    timeout.tv_sec  = 2;    // seconds
-    timeout.tv_usec = 0;    // milliseconds
-
-    auto ret = setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO,
-        &timeout, sizeof(timeout)
-    );
-
-    if (ret == -1)
-        utils::error("ntool: ping: error to set timeout");
-
-    std::signal(SIGINT, sigint_handler);
-}
-
-void ping(const std::string_view& target, std::uint16_t n) noexcept
-{
-    init();
-
     // set destination address
-    sockaddr_in addr;
-    addr.sin_family      = AF_INET;
-    addr.sin_addr.s_addr = utils::get_ip_address(target);
-    addr.sin_port        = 0;
+    in_addr addr;
+    addr.s_addr = utils::get_ip_address(target);
+    inet_ntop(AF_INET, &addr, target_ip_str, sizeof(target_ip_str));
+    target_addr = addr.s_addr;
 
-    std::printf("Pinging %s [%s] with %u bytes of data:\n",
-        target.data(), inet_ntoa(addr.sin_addr), ICMP_PACKET_SIZE
-    );
+    // keep structured stdout free of human readable lines
+    const auto& output = options.output;
+    info = (output.format == output_format::human || output.path) ? stdout : stderr;
 
-    icmphdr request, reply;
-    double  time;
+    std::fprintf(info, "Pinging %s [%s] with %u bytes of data:\n",
+        target.data(), target_ip_str, ICMP_PACKET_SIZE
+    );
 
-    target_ip_str   = inet_ntoa(addr.sin_addr);
-    auto ping_count = 0;
+    engine_config config;
+    config.count       = options.count;
+    config.interval_ns = static_cast<std::uint64_t>(options.interval * 1e9);
+    config.timeout_ns  = static_cast<std::uint64_t>(options.timeout * 1e9);
+    config.instrument  = options.engine_stats;
+    config.huge_pages  = options.huge_pages;
 
     // handle incorrect number of pings
-    if (n == 0)
-        n = DEFAULT_PINGS_COUNT;
-
-    rtt.reserve(n);
-
-    while (ping_count < n) {
-        // set request ICMP header
-        request.type             = ICMP_ECHO;
-        request.code             = 0;
-        request.un.echo.id       = getpid();
-        request.un.echo.sequence = ++ping_count;
-
-        send(request, addr);
-        recv(reply, addr);
-
-        // Handle received ICMP packet
-        switch (reply.type) {
-        case ICMP_ECHO:
-        case ICMP_ECHOREPLY:
-            time = static_cast<double>(end_time - begin_time);
-            rtt.push_back(time / CLOCKS_PER_SEC * 1000);
-
-            std::printf("%u bytes from %s: icmp_seq=%u ttl=%u rtt=%.3lf ms\n",
-                ICMP_PACKET_SIZE, target_ip_str, reply.un.echo.sequence,
-                ttl, rtt.back()
-            );
-            break;
-
-        case ICMP_UNREACH:
-            std::printf("From %s: icmp_seq=%u %s\n", target_ip_str,
-                reply.un.echo.sequence, unreach_decription(reply.code)
-            );
-
-            // terminate task
-            if (kill(getpid(), SIGINT) == -1)
-                utils::error("ntool: ping: fail to send SIGINT");
-            break;
-
-        default:
-            std::printf("Received ICMP packet [type: %d code: %d id: %d]\n",
-                reply.type, reply.code, reply.un.echo.id
-            );
-            break;
-        }
-
-        // Delay time for 1 second
-        sleep(1);
-    }
-
-    summary();
-    close(sockfd);
-}
-
-static void set_packet(std::uint8_t *packet, const icmphdr& header) noexcept
-{
-    icmphdr hdr  = header;
-    hdr.checksum = 0;
+    if (config.count == 0)
+        config.count = DEFAULT_PINGS_COUNT;
 
-    // copy ICMP header & payload into the packet
-    std::memcpy(packet, &hdr, sizeof(icmphdr));
-    std::memcpy(packet + sizeof(icmphdr), &payload, ICMP_PAYLOAD_SIZE);
+    auto io = make_transport(options.io, options.huge_pages);
+    engine e(*io, config, handle_result, const_cast<ping_options*>(&options));
+    e.add_target(addr.s_addr);
 
-    // calculate packet checksum
-    hdr.checksum = checksum(packet, ICMP_PACKET_SIZE);
-    packet[2]    = hdr.checksum & 0xFFFF;
-    packet[3]    = hdr.checksum >> 0x8;
-}
-
-void send(const icmphdr& request, sockaddr_in& addr) noexcept
-{
-    static std::uint8_t packet[ICMP_PACKET_SIZE];
+    output_writer out(output, record_kind::ping, {target_addr});
 
-    std::memset(packet, 0, ICMP_PACKET_SIZE);
-    set_packet(packet, request);
-
-    auto ret = sendto(sockfd, packet, ICMP_PACKET_SIZE, 0,
-        std::bit_cast<sockaddr*>(&addr), sizeof(sockaddr_in)
-    );
+    rtt    = {};
+    pinger = &e;
+    writer = &out;
+    std::signal(SIGINT, sigint_handler);
 
-    begin_time = std::clock();
+    begin_time = utils::clock_ns();
+    e.run();
+    end_time   = utils::clock_ns();
 
-    if (ret <= 0)
-        utils::error("ntool: ping: error to send ICMP packet");
+    out.close();
+    summary();
+    print_engine_stats(info, e);
 
-    transmitted_packets++;
+    pinger = nullptr;
+    writer = nullptr;
 }
 
-static void handle_packet(icmphdr& reply, const std::uint8_t *packet) noexcept
+static void handle_result(const probe_result& result, void *ctx) noexcept
 {
-    iphdr   *ip_hdr   = std::bit_cast<iphdr*>(packet);
-    icmphdr *icmp_hdr = std::bit_cast<icmphdr*>(packet + (ip_hdr->ihl * 4));
+    auto options = static_cast<const ping_options*>(ctx);
+    bool reply   = !result.timeout && result.type == ICMP_ECHOREPLY;
 
-    icmphdr header;
-    std::memcpy(&header, icmp_hdr, sizeof(header));
-    reply = header;
-    ttl   = ip_hdr->ttl;
-}
+    if (reply)
+        utils::update(rtt, (result.recv_ns - result.send_ns) / 1e6);
 
-static void recv(icmphdr& reply, sockaddr_in& addr) noexcept
-{
-    static std::uint8_t packet[ICMP_PACKET_SIZE];
+    pinger->lap(stage::stats);
 
-    auto len = static_cast<socklen_t>(sizeof(sockaddr_in));
-    auto ret = recvfrom(sockfd, packet, ICMP_PACKET_SIZE, 0,
-        std::bit_cast<sockaddr*>(&addr), &len
-    );
-
-    end_time = std::clock();
+    // terminate task
+    if (!result.timeout && result.type == ICMP_UNREACH)
+        pinger->stop();
 
-    if (ret < 0) {
-        if (errno == EWOULDBLOCK) {
-            std::printf("From %s: Failed to receive packet\n", target_ip_str);
+    // errors are reported even in quiet mode, output file gets everything
+    bool silent = options->quiet && !options->output.path && (result.timeout || reply);
 
-            // terminate task
-            if (kill(getpid(), SIGINT) == -1)
-                utils::error("ntool: ping: fail to send SIGINT");
-        }
-        else
-            utils::error("ntool: ping: error to receive ICMP packet");
-    }
+    if (silent && !options->output.store && !options->output.feed)
+        return;
 
-    received_packets++;
-    handle_packet(reply, packet);
+    writer->push({result, target_addr, record_kind::ping, true, silent});
 }
 
 static void summary(void) noexcept
 {
-    auto ratio       = received_packets / transmitted_packets;
-    auto packet_loss = std::ceil(100.0 - (ratio * 100.0));
-
-    std::printf("\n--- %s ping statistics ---\n", target_ip_str);
-    std::printf("%u packets transmitted, %u received, %u%% packet loss\n",
-        transmitted_packets, received_packets,
-        static_cast<std::uint32_t>(packet_loss)
+    const auto& counters = pinger->counters();
+    auto transmitted     = counters.sent;
+    auto received        = counters.received;
+
+    auto packet_loss = transmitted
+        ? std::ceil(100.0 - (100.0 * received / transmitted)) : 0.0;
+
+    std::fprintf(info, "\n--- %s ping statistics ---\n", target_ip_str);
+    std::fprintf(info, "%lu packets transmitted, %lu received, %u%% packet loss, "
+        "time %lums\n", transmitted, received,
+        static_cast<std::uint32_t>(packet_loss),
+        (end_time - begin_time) / 1000000
     );
 
-    if (rtt.empty())
+    if (rtt.count == 0)
         utils::error("ntool: ping: round-trip time wasn't calculated");
 
-    double rtt_min  = *(std::min_element(rtt.begin(), rtt.end()));
-    double rtt_avr  = utils::mean(rtt);
-    double rtt_max  = *(std::max_element(rtt.begin(), rtt.end()));
-    double rtt_mdev = utils::mdev(rtt);
-
-    std::printf("rtt min/avg/max/mdev = %.3f/%.3f/%.3f/%.3f ms\n",
-        rtt_min, rtt_avr, rtt_max, rtt_mdev
+    std::fprintf(info, "rtt min/avg/max/mdev = %.3f/%.3f/%.3f/%.3f ms\n",
+        rtt.min, rtt.mean, rtt.max, utils::stddev(rtt)
     );
 }
 
-static void sigint_handler(int sig) noexcept
+static void sigint_handler(int) noexcept
 {
-    summary();
-    close(sockfd);
-    std::exit(sig);
+    if (pinger)
+        pinger->stop();
 }
 
-} // namespace ntool
\ No newline at end of file
+} // namespace ntool
@@ -0,0 +1,223 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/prefix.hpp>
+#include <ntool/loader.hpp>
+#include <ntool/output.hpp>
+#include <ntool/utils.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+
+namespace ntool {
+
+inline const std::size_t TBL24_SIZE {1 << 24};  // first array entries
+
+/**
+ * @brief Get network mask of prefix length.
+ *
+ * @param [in] length - given prefix length.
+ * @return mask in host byte order.
+ */
+static std::uint32_t prefix_mask(std::uint8_t length) noexcept;
+
+
+prefix_table::prefix_table(std::vector<prefix_entry> prefixes, bool huge) noexcept
+    : m_buffer(TBL24_SIZE * sizeof(std::uint32_t), huge),
+      m_tbl24(static_cast<std::uint32_t*>(m_buffer.data()))
+{
+    for (auto& p : prefixes)
+        p.network = htonl(ntohl(p.network) & prefix_mask(p.length));
+
+    // shorter prefixes are written first & overwritten by longer ones
+    std::stable_sort(prefixes.begin(), prefixes.end(), [](const auto& a, const auto& b) {
+        return a.length < b.length || (a.length == b.length && ntohl(a.network) < ntohl(b.network));
+    });
+
+    auto last = std::unique(prefixes.begin(), prefixes.end(), [](const auto& a, const auto& b) {
+        return a.length == b.length && a.network == b.network;
+    });
+
+    prefixes.erase(last, prefixes.end());
+
+    for (const auto& p : prefixes) {
+        auto host  = ntohl(p.network);
+        auto value = p.value + 1;
+
+        if (p.length <= 24) {
+            auto count = std::size_t(1) << (24 - p.length);
+            std::fill_n(m_tbl24 + (host >> 8), count, value);
+            m_touched += count * sizeof(std::uint32_t);
+            continue;
+        }
+
+        // extend entry into group inheriting its shorter prefix
+        auto& entry = m_tbl24[host >> 8];
+
+        if (!(entry & PREFIX_EXTENDED)) {
+            auto group = static_cast<std::uint32_t>(m_tbl8.size() >> 8);
+            m_tbl8.resize(m_tbl8.size() + 256, entry);
+            entry = group | PREFIX_EXTENDED;
+        }
+
+        auto base = static_cast<std::size_t>(entry & ~PREFIX_EXTENDED) << 8;
+        std::fill_n(m_tbl8.begin() + base + (host & 0xFF), 1U << (32 - p.length), value);
+    }
+}
+
+std::size_t prefix_table::memory(void) const noexcept
+{
+    return std::min(m_touched, m_buffer.size()) + m_tbl8.capacity() * sizeof(std::uint32_t);
+}
+
+prefix_groups::prefix_groups(const char *path, const std::vector<in_addr_t>& targets) noexcept
+{
+    auto file = std::fopen(path, "r");
+
+    if (!file)
+        utils::error("ntool: cannot open prefix file");
+
+    std::unordered_map<std::string, std::uint32_t> index;
+    std::vector<prefix_entry> prefixes;
+    char *line       = nullptr;
+    std::size_t size = 0;
+
+    while (getline(&line, &size, file) != -1) {
+        char *state;
+        auto token = strtok_r(line, " \t\r\n", &state);
+
+        if (!token || token[0] == '#')
+            continue;
+
+        prefix_entry p;
+
+        if (!parse_prefix(token, p))
+            utils::error("ntool: invalid prefix in prefix file");
+
+        // prefixes of same group are aggregated together
+        auto group = strtok_r(nullptr, " \t\r\n", &state);
+        std::string label((group && group[0] != '#') ? group : token);
+
+        auto [it, inserted] = index.try_emplace(label, m_labels.size());
+
+        if (inserted)
+            m_labels.push_back(std::move(label));
+
+        p.value = it->second;
+        prefixes.push_back(p);
+    }
+
+    std::free(line);
+    std::fclose(file);
+
+    if (prefixes.empty())
+        utils::error("ntool: prefix file has no prefixes");
+
+    prefix_table table(std::move(prefixes), false);
+    m_groups.reserve(targets.size());
+
+    for (auto addr : targets)
+        m_groups.push_back(table.lookup(addr));
+
+    m_stats.resize(m_labels.size());
+    m_targets.resize(m_labels.size());
+
+    for (auto group : m_groups) {
+        if (group != PREFIX_NONE)
+            m_targets[group]++;
+    }
+}
+
+prefix_groups::prefix_groups(std::uint8_t length, const std::vector<in_addr_t>& targets) noexcept
+{
+    // fixed length networks are matched exactly, no table is needed
+    std::unordered_map<in_addr_t, std::uint32_t> index;
+    m_groups.reserve(targets.size());
+
+    for (auto addr : targets) {
+        auto network = htonl(ntohl(addr) & prefix_mask(length));
+        auto [it, inserted] = index.try_emplace(network, m_labels.size());
+
+        if (inserted) {
+            char label[32];
+            auto p = format_ip(label, network);
+            *p++   = '/';
+            p      = format_u64(p, length);
+
+            m_labels.emplace_back(label, p);
+            m_targets.push_back(0);
+        }
+
+        m_groups.push_back(it->second);
+        m_targets[it->second]++;
+    }
+
+    m_stats.resize(m_labels.size());
+}
+
+std::size_t prefix_groups::memory(void) const noexcept
+{
+    std::size_t labels = 0;
+
+    for (const auto& label : m_labels)
+        labels += sizeof(std::string) + label.capacity();
+
+    return m_groups.capacity() * sizeof(std::uint32_t) +
+        m_stats.capacity() * sizeof(target_stats) +
+        m_targets.capacity() * sizeof(std::uint32_t) + labels;
+}
+
+bool parse_prefix(const char *str, prefix_entry& prefix) noexcept
+{
+    auto size   = std::strlen(str);
+    auto length = parse_ipv4(str, str + size, prefix.network);
+
+    if (!length)
+        return false;
+
+    // address without length is host prefix
+    prefix.length = 32;
+
+    if (length == size)
+        return true;
+
+    if (str[length] != '/' || size - length < 2 || size - length > 3)
+        return false;
+
+    auto bits = 0;
+
+    for (auto p = str + length + 1; *p; p++) {
+        if (*p < '0' || *p > '9')
+            return false;
+
+        bits = bits * 10 + (*p - '0');
+    }
+
+    prefix.length = static_cast<std::uint8_t>(bits);
+    return bits <= 32;
+}
+
+static std::uint32_t prefix_mask(std::uint8_t length) noexcept
+{
+    return length ? ~0U << (32 - length) : 0;
+}
+
+} // namespace ntool
@@ -0,0 +1,483 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/recorder.hpp>
+#include <ntool/output.hpp>
+#include <ntool/detect.hpp>
+#include <ntool/utils.hpp>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <cstdio>
+#include <ctime>
+
+
+namespace ntool {
+
+/**
+ * @brief Write whole buffer (async-signal-safe).
+ *
+ * @param [in] fd - given file descriptor.
+ * @param [in] data - given buffer.
+ * @param [in] size - given buffer size in bytes.
+ * @return false in case of write error.
+ */
+static bool write_all(std::int32_t fd, const void *data, std::size_t size) noexcept;
+
+/**
+ * @brief Dump recorders on SIGUSR1.
+ *
+ * @param [in] sig - given signal number.
+ */
+static void dump_handler(int sig) noexcept;
+
+/**
+ * @brief Dump recorders & re-raise fatal signal.
+ *
+ * @param [in] sig - given signal number.
+ */
+static void crash_handler(int sig) noexcept;
+
+/** @brief Dump recorders on fatal error.*/
+static void error_hook(void) noexcept;
+
+/**
+ * @brief Get event name.
+ *
+ * @param [in] kind - given event.
+ * @return event name.
+ */
+static const char *event_name(flight_event kind) noexcept;
+
+/**
+ * @brief Get dump reason name.
+ *
+ * @param [in] reason - given dump reason.
+ * @return reason name.
+ */
+static const char *reason_name(std::uint8_t reason) noexcept;
+
+/**
+ * @brief Get time when event has started (probe send time of reply).
+ *
+ * @param [in] e - given entry.
+ * @return start time in nanoseconds.
+ */
+static std::uint64_t start_ns(const flight_entry& e) noexcept;
+
+/**
+ * @brief Write entry as Chrome trace event.
+ *
+ * @param [out] p - given output position.
+ * @param [in] e - given entry.
+ * @param [in] pid - given process identifier.
+ * @param [in] tid - given thread identifier.
+ * @param [in] base - given time of trace start in nanoseconds.
+ * @return position after written characters.
+ */
+static char *format_trace_event(char *p, const flight_entry& e, std::uint32_t pid,
+    std::uint32_t tid, std::uint64_t base) noexcept;
+
+inline const std::size_t FLIGHT_DIR_SIZE {256};
+
+static std::atomic<flight_recorder*> recorders[FLIGHT_THREADS];
+static std::atomic<std::uint32_t>    registered   {0};
+static std::atomic_flag              dumping;               // dump in progress
+static std::uint64_t                 last_anomaly {0};      // last anomaly dump time
+static std::uint32_t                 dumps        {0};      // dumps written
+static char                          dump_dir[FLIGHT_DIR_SIZE];
+
+static const std::int32_t fatal_signals[] {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+
+flight_recorder& flight_recorder::local(void) noexcept
+{
+    thread_local flight_recorder *recorder = nullptr;
+
+    if (!recorder) {
+        // never freed, signal handler may dump it at any time
+        recorder        = new flight_recorder;
+        recorder->m_tid = static_cast<std::uint32_t>(gettid());
+
+        // recorders of threads over limit are kept but not dumped
+        auto index = registered.fetch_add(1, std::memory_order_relaxed);
+
+        if (index < FLIGHT_THREADS)
+            recorders[index].store(recorder, std::memory_order_release);
+    }
+
+    return *recorder;
+}
+
+bool flight_recorder::dump(std::int32_t fd) const noexcept
+{
+    auto head  = m_head.load(std::memory_order_acquire);
+    auto count = std::min(head, FLIGHT_CAPACITY);
+    auto begin = (head - count) & (FLIGHT_CAPACITY - 1);
+
+    flight_thread_header header {};
+    header.tid   = m_tid;
+    header.count = count;
+
+    // ring is written in at most two contiguous parts
+    auto part = std::min(count, FLIGHT_CAPACITY - begin);
+
+    return write_all(fd, &header, sizeof(header)) &&
+        write_all(fd, m_entries + begin, part * sizeof(flight_entry)) &&
+        write_all(fd, m_entries, (count - part) * sizeof(flight_entry));
+}
+
+void flight_install(const char *dir) noexcept
+{
+    if (std::strlen(dir) + 1 > FLIGHT_DIR_SIZE - 64)
+        utils::error("ntool: flight recorder directory path is too long");
+
+    std::strcpy(dump_dir, dir);
+
+    struct sigaction action {};
+    action.sa_handler = dump_handler;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, nullptr);
+
+    // fatal signal is handled once, then default action terminates process
+    action.sa_handler = crash_handler;
+    action.sa_flags   = SA_RESETHAND;
+
+    for (auto sig : fatal_signals)
+        sigaction(sig, &action, nullptr);
+
+    utils::on_error(error_hook);
+}
+
+bool flight_dump(flight_reason reason) noexcept
+{
+    if (!dump_dir[0] || registered.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    auto now = utils::clock_ns();
+
+    // anomalies may fire in bursts, first dump already covers them
+    if (reason == flight_reason::anomaly) {
+        if (last_anomaly && now - last_anomaly < FLIGHT_DUMP_GAP)
+            return false;
+
+        last_anomaly = now;
+    }
+
+    if (dumping.test_and_set(std::memory_order_acquire))
+        return false;
+
+    char path[FLIGHT_DIR_SIZE];
+    auto p = format_str(path, dump_dir);
+    p      = format_str(p, "/ntool-flight-");
+    p      = format_u64(p, getpid());
+    p      = format_str(p, "-");
+    p      = format_u64(p, dumps++);
+    p      = format_str(p, ".bin");
+    *p     = '\0';
+
+    auto fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        dumping.clear(std::memory_order_release);
+        return false;
+    }
+
+    flight_file_header header {};
+    std::uint32_t count = std::min(registered.load(), FLIGHT_THREADS);
+
+    // thread may be registering right now, its slot is still empty
+    for (std::uint32_t i = 0; i < count; i++) {
+        if (recorders[i].load(std::memory_order_acquire))
+            header.threads++;
+    }
+
+    timespec wall {};
+    clock_gettime(CLOCK_REALTIME, &wall);
+
+    std::memcpy(header.magic, FLIGHT_MAGIC, sizeof(FLIGHT_MAGIC));
+    header.version    = FLIGHT_VERSION;
+    header.entry_size = sizeof(flight_entry);
+    header.reason     = static_cast<std::uint8_t>(reason);
+    header.dump_ns    = now;
+    header.wall_ns    = wall.tv_sec * 1000000000ULL + wall.tv_nsec;
+    header.pid        = getpid();
+
+    bool ok = write_all(fd, &header, sizeof(header));
+
+    for (std::uint32_t i = 0, dumped = 0; ok && i < count && dumped < header.threads; i++) {
+        if (auto recorder = recorders[i].load(std::memory_order_acquire)) {
+            ok = recorder->dump(fd);
+            dumped++;
+        }
+    }
+
+    close(fd);
+
+    char message[FLIGHT_DIR_SIZE + 64];
+    p    = format_str(message, ok ? "ntool: flight recorder dumped to " :
+        "ntool: cannot write flight recorder dump ");
+    p    = format_str(p, path);
+    *p++ = '\n';
+    write_all(STDERR_FILENO, message, p - message);
+
+    dumping.clear(std::memory_order_release);
+    return ok;
+}
+
+void flight_convert(const char *path, const output_options& options) noexcept
+{
+    auto fd = open(path, O_RDONLY);
+    struct stat st {};
+
+    if (fd < 0 || fstat(fd, &st) == -1)
+        utils::error("ntool: flight: cannot open recorder dump");
+
+    std::size_t size = st.st_size;
+    auto data        = (size >= sizeof(flight_file_header))
+        ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    if (data == MAP_FAILED)
+        utils::error("ntool: flight: not a recorder dump");
+
+    auto bytes  = static_cast<const std::uint8_t*>(data);
+    auto header = reinterpret_cast<const flight_file_header*>(bytes);
+
+    if (std::memcmp(header->magic, FLIGHT_MAGIC, sizeof(FLIGHT_MAGIC)) ||
+        header->version != FLIGHT_VERSION || header->entry_size != sizeof(flight_entry))
+        utils::error("ntool: flight: not a recorder dump");
+
+    // validate layout & find start of trace
+    std::uint64_t base   = header->dump_ns;
+    std::uint64_t events = 0;
+    std::size_t offset   = sizeof(flight_file_header);
+
+    for (std::uint32_t i = 0; i < header->threads; i++) {
+        if (offset + sizeof(flight_thread_header) > size)
+            utils::error("ntool: flight: truncated recorder dump");
+
+        auto thread = reinterpret_cast<const flight_thread_header*>(bytes + offset);
+        offset     += sizeof(flight_thread_header);
+
+        if (thread->count > (size - offset) / sizeof(flight_entry))
+            utils::error("ntool: flight: truncated recorder dump");
+
+        auto entries = reinterpret_cast<const flight_entry*>(bytes + offset);
+
+        for (std::uint64_t j = 0; j < thread->count; j++)
+            base = std::min(base, start_ns(entries[j]));
+
+        events += thread->count;
+        offset += thread->count * sizeof(flight_entry);
+    }
+
+    auto out = options.path ? std::fopen(options.path, "w") : stdout;
+
+    if (!out)
+        utils::error("ntool: flight: cannot open output file");
+
+    static char buffer[OUTPUT_BUFFER_SIZE];
+    char *p = format_str(buffer, "{\"traceEvents\":[\n");
+
+    offset = sizeof(flight_file_header);
+
+    for (std::uint32_t i = 0; i < header->threads; i++) {
+        auto thread  = reinterpret_cast<const flight_thread_header*>(bytes + offset);
+        auto entries = reinterpret_cast<const flight_entry*>(thread + 1);
+        offset      += sizeof(flight_thread_header) + thread->count * sizeof(flight_entry);
+
+        p = format_str(p, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+        p = format_u64(p, header->pid);
+        p = format_str(p, ",\"tid\":");
+        p = format_u64(p, thread->tid);
+        p = format_str(p, ",\"args\":{\"name\":\"engine ");
+        p = format_u64(p, thread->tid);
+        p = format_str(p, "\"}}");
+
+        for (std::uint64_t j = 0; j < thread->count; j++) {
+            // flush before buffer could overflow with next event
+            if (p - buffer > static_cast<std::ptrdiff_t>(sizeof(buffer) - 512)) {
+                std::fwrite(buffer, 1, p - buffer, out);
+                p = buffer;
+            }
+
+            *p++ = ',';
+            *p++ = '\n';
+            p    = format_trace_event(p, entries[j], header->pid, thread->tid, base);
+        }
+
+        if (i + 1 < header->threads) {
+            *p++ = ',';
+            *p++ = '\n';
+        }
+    }
+
+    p = format_str(p, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"reason\":\"");
+    p = format_str(p, reason_name(header->reason));
+    p = format_str(p, "\",\"wall_ns\":");
+    p = format_u64(p, header->wall_ns);
+    p = format_str(p, "}}\n");
+
+    std::fwrite(buffer, 1, p - buffer, out);
+
+    if (out != stdout)
+        std::fclose(out);
+    else
+        std::fflush(out);
+
+    std::fprintf(stderr, "%s: %s dump, %u threads, %lu events\n", path,
+        reason_name(header->reason), header->threads, events
+    );
+
+    munmap(data, size);
+}
+
+static bool write_all(std::int32_t fd, const void *data, std::size_t size) noexcept
+{
+    auto p = static_cast<const std::uint8_t*>(data);
+
+    while (size > 0) {
+        auto written = write(fd, p, size);
+
+        if (written <= 0)
+            return false;
+
+        p    += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static void dump_handler(int) noexcept
+{
+    auto saved = errno;
+    flight_dump(flight_reason::signal);
+    errno = saved;
+}
+
+static void crash_handler(int sig) noexcept
+{
+    flight_dump(flight_reason::crash);
+    raise(sig);
+}
+
+static void error_hook(void) noexcept
+{
+    flight_dump(flight_reason::error);
+}
+
+static const char *event_name(flight_event kind) noexcept
+{
+    switch (kind) {
+    case flight_event::sent:
+        return "sent";
+
+    case flight_event::reply:
+        return "reply";
+
+    case flight_event::timeout:
+        return "timeout";
+
+    case flight_event::send_error:
+        return "send error";
+
+    case flight_event::foreign:
+        return "foreign reply";
+
+    case flight_event::stall:
+        return "stall";
+
+    default:
+        return "anomaly";
+    }
+}
+
+static const char *reason_name(std::uint8_t reason) noexcept
+{
+    switch (static_cast<flight_reason>(reason)) {
+    case flight_reason::signal:
+        return "signal";
+
+    case flight_reason::error:
+        return "error";
+
+    case flight_reason::crash:
+        return "crash";
+
+    default:
+        return "anomaly";
+    }
+}
+
+static std::uint64_t start_ns(const flight_entry& e) noexcept
+{
+    if (e.kind != flight_event::reply)
+        return e.time_ns;
+
+    return e.time_ns - std::min<std::uint64_t>(e.value * 1000ULL, e.time_ns);
+}
+
+static char *format_trace_event(char *p, const flight_entry& e, std::uint32_t pid,
+    std::uint32_t tid, std::uint64_t base) noexcept
+{
+    p = format_str(p, "{\"name\":\"");
+    p = format_str(p, event_name(e.kind));
+
+    // reply spans probe round trip, other events are instant
+    if (e.kind == flight_event::reply) {
+        p = format_str(p, "\",\"ph\":\"X\",\"dur\":");
+        p = format_u64(p, e.value);
+    }
+    else {
+        p = format_str(p, "\",\"ph\":\"i\",\"s\":\"t\"");
+    }
+
+    p = format_str(p, ",\"ts\":");
+    p = format_fixed(p, start_ns(e) - base, 3);
+    p = format_str(p, ",\"pid\":");
+    p = format_u64(p, pid);
+    p = format_str(p, ",\"tid\":");
+    p = format_u64(p, tid);
+    p = format_str(p, ",\"args\":{\"addr\":\"");
+    p = format_ip(p, e.addr);
+    p = format_str(p, "\",\"seq\":");
+    p = format_u64(p, e.seq);
+    p = format_str(p, ",\"ttl\":");
+    p = format_u64(p, e.ttl);
+
+    if (e.kind == flight_event::send_error) {
+        p = format_str(p, ",\"errno\":");
+        p = format_u64(p, e.value);
+    }
+    else if (e.kind == flight_event::anomaly) {
+        p = format_str(p, ",\"anomaly\":\"");
+        p = format_str(p, anomaly_name(static_cast<anomaly_kind>(e.value)));
+        *p++ = '"';
+    }
+
+    return format_str(p, "}}");
+}
+
+} // namespace ntool
@@ -0,0 +1,294 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/resultlog.hpp>
+#include <ntool/utils.hpp>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+
+
+namespace ntool {
+
+/**
+ * @brief Round up to multiple of given alignment.
+ *
+ * @param [in] value - given value.
+ * @param [in] alignment - given power of two alignment.
+ * @return aligned value.
+ */
+static std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment) noexcept;
+
+/**
+ * @brief Write whole buffer to file.
+ *
+ * @param [in] fd - given file descriptor.
+ * @param [in] data - given data to write.
+ * @param [in] size - given data size in bytes.
+ */
+static void write_all(std::int32_t fd, const std::uint8_t *data, std::size_t size) noexcept;
+
+
+log_record to_record(const probe_result& result) noexcept
+{
+    log_record record {};
+    record.send_ns   = le(result.send_ns);
+    record.recv_ns   = result.timeout ? 0 : le(result.recv_ns);
+    record.target    = le(result.target);
+    record.seq       = le(result.seq);
+    record.from      = result.timeout ? 0 : result.from;
+    record.ttl       = result.ttl;
+    record.reply_ttl = result.reply_ttl;
+    record.type      = result.type;
+    record.code      = result.code;
+
+    return record;
+}
+
+probe_result to_result(const log_record& record) noexcept
+{
+    probe_result result {};
+    result.target    = le(record.target);
+    result.seq       = le(record.seq);
+    result.ttl       = record.ttl;
+    result.reply_ttl = record.reply_ttl;
+    result.type      = record.type;
+    result.code      = record.code;
+    result.timeout   = record.recv_ns == 0;
+    result.from      = record.from;
+    result.send_ns   = le(record.send_ns);
+    result.recv_ns   = le(record.recv_ns);
+
+    return result;
+}
+
+log_writer::log_writer(std::int32_t fd, record_kind mode,
+    const std::vector<in_addr_t>& targets, bool direct) noexcept
+    : m_fd(fd)
+{
+    m_buffer = static_cast<std::uint8_t*>(
+        std::aligned_alloc(LOG_BLOCK_SIZE, LOG_BUFFER_SIZE)
+    );
+
+    if (!m_buffer)
+        utils::error("ntool: log: buffer allocation error");
+
+    // bypass page cache for archives much larger than memory (best effort)
+    if (direct) {
+        auto flags = fcntl(fd, F_GETFL);
+        m_direct   = flags != -1 && fcntl(fd, F_SETFL, flags | O_DIRECT) != -1;
+
+        if (!m_direct)
+            std::fputs("ntool: log: O_DIRECT is not supported, using page cache\n", stderr);
+    }
+
+    timespec now {};
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    std::uint64_t table_size = targets.size() * sizeof(in_addr_t);
+
+    log_header header {};
+    std::memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+    header.version        = le(LOG_VERSION);
+    header.header_size    = le<std::uint16_t>(sizeof(log_header));
+    header.record_size    = le<std::uint16_t>(sizeof(log_record));
+    header.mode           = static_cast<std::uint8_t>(mode);
+    header.targets        = le<std::uint32_t>(targets.size());
+    header.records_offset = le(align_up(sizeof(log_header) + table_size, LOG_ALIGNMENT));
+    header.created_ns     = le<std::uint64_t>(now.tv_sec * 1000000000ULL + now.tv_nsec);
+    header.clock_ns       = le(utils::clock_ns());
+
+    // header & target table go through the same buffer as records
+    auto put = [this](const void *data, std::size_t size) noexcept {
+        auto bytes = static_cast<const std::uint8_t*>(data);
+
+        while (size > 0) {
+            if (m_size == LOG_BUFFER_SIZE)
+                write_buffer(m_size);
+
+            auto chunk = std::min(size, LOG_BUFFER_SIZE - m_size);
+            std::memcpy(m_buffer + m_size, bytes, chunk);
+
+            m_size += chunk;
+            bytes  += chunk;
+            size   -= chunk;
+        }
+    };
+
+    put(&header, sizeof(header));
+
+    for (auto addr : targets)
+        put(&addr, sizeof(addr));
+
+    static const std::uint8_t padding[LOG_ALIGNMENT] {};
+    put(padding, le(header.records_offset) - sizeof(header) - table_size);
+}
+
+log_writer::~log_writer(void) noexcept
+{
+    close();
+}
+
+void log_writer::append(const probe_result& result) noexcept
+{
+    // records offset & buffer size are multiples of record size
+    if (m_size == LOG_BUFFER_SIZE)
+        write_buffer(m_size);
+
+    auto record = to_record(result);
+    std::memcpy(m_buffer + m_size, &record, sizeof(record));
+
+    m_size += sizeof(record);
+    m_records++;
+}
+
+void log_writer::close(void) noexcept
+{
+    if (m_closed)
+        return;
+
+    m_closed = true;
+
+    // O_DIRECT requires block sized writes, so tail & record count are
+    // written with page cache
+    if (m_direct) {
+        auto flags = fcntl(m_fd, F_GETFL);
+        fcntl(m_fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+    write_buffer(m_size);
+
+    // record count is optional, readers of pipes rely on file size
+    auto count = le(m_records);
+    auto ret   = pwrite(m_fd, &count, sizeof(count), offsetof(log_header, records));
+
+    if (ret != sizeof(count) && errno != ESPIPE)
+        utils::error("ntool: log: error to write record count");
+
+    std::free(m_buffer);
+    m_buffer = nullptr;
+}
+
+std::uint64_t log_writer::records(void) const noexcept
+{
+    return m_records;
+}
+
+void log_writer::write_buffer(std::size_t size) noexcept
+{
+    write_all(m_fd, m_buffer, size);
+    m_size = 0;
+}
+
+log_reader::~log_reader(void) noexcept
+{
+    if (m_data)
+        munmap(const_cast<std::uint8_t*>(m_data), m_size);
+}
+
+bool log_reader::open(const char *path) noexcept
+{
+    auto fd = ::open(path, O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(log_header)) {
+        ::close(fd);
+        return false;
+    }
+
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const std::uint8_t*>(data);
+    m_size = st.st_size;
+
+    const auto& h = header();
+    auto table    = sizeof(log_header) + std::uint64_t {le(h.targets)} * sizeof(in_addr_t);
+
+    return !std::memcmp(h.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) &&
+        le(h.version) == LOG_VERSION &&
+        le(h.record_size) == sizeof(log_record) &&
+        le(h.records_offset) >= table &&
+        le(h.records_offset) % LOG_ALIGNMENT == 0 &&
+        le(h.records_offset) <= m_size;
+}
+
+const log_header& log_reader::header(void) const noexcept
+{
+    return *reinterpret_cast<const log_header*>(m_data);
+}
+
+std::span<const in_addr_t> log_reader::targets(void) const noexcept
+{
+    auto table = reinterpret_cast<const in_addr_t*>(m_data + sizeof(log_header));
+    return {table, le(header().targets)};
+}
+
+std::span<const log_record> log_reader::records(void) const noexcept
+{
+    auto offset = le(header().records_offset);
+    auto count  = (m_size - offset) / sizeof(log_record);
+
+    // header count is missing in logs written to pipes or interrupted runs
+    if (header().records)
+        count = std::min<std::uint64_t>(count, le(header().records));
+
+    return {reinterpret_cast<const log_record*>(m_data + offset), count};
+}
+
+static std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment) noexcept
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void write_all(std::int32_t fd, const std::uint8_t *data, std::size_t size) noexcept
+{
+    std::size_t done = 0;
+
+    while (done < size) {
+        auto ret = write(fd, data + done, size - done);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            utils::error("ntool: log: write error");
+        }
+
+        done += ret;
+    }
+}
+
+} // namespace ntool
@@ -0,0 +1,428 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/targets.hpp>
+#include <ntool/routes.hpp>
+#include <ntool/loader.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/icmp.hpp>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <csignal>
+#include <memory>
+#include <cstdio>
+
+
+namespace ntool {
+
+inline const std::uint64_t FNV_OFFSET     {0xcbf29ce484222325ULL};
+inline const std::uint64_t FNV_PRIME      {0x100000001b3ULL};
+inline const std::uint64_t TRACE_SPACING  {50000000};  // min delay between queries
+
+/** Routes being traced & their targets.*/
+struct trace_state {
+    std::vector<route>     routes;  // per engine target
+    std::vector<in_addr_t> addrs;
+};
+
+/** Stored routes checked by sampled probes.*/
+struct sample_state {
+    const std::vector<route>     *routes;
+    const std::vector<in_addr_t> *addrs;
+    std::vector<std::uint8_t>    suspect;   // replier was not expected
+};
+
+/**
+ * @brief Trace given targets in parallel.
+ *
+ * @param [in] addrs - given target addresses.
+ * @param [in] options - given route monitor options.
+ * @param [out] sent - given object to add sent probes to.
+ * @return traced routes.
+ */
+static std::vector<route> trace_all(const std::vector<in_addr_t>& addrs,
+    const route_options& options, std::uint64_t& sent) noexcept;
+
+/**
+ * @brief Handle probe outcome of full trace.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given trace state.
+ */
+static void handle_trace(const probe_result& result, void *ctx) noexcept;
+
+/**
+ * @brief Handle probe outcome of sampled probe.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given sample state.
+ */
+static void handle_sample(const probe_result& result, void *ctx) noexcept;
+
+/**
+ * @brief Compare routes hop by hop.
+ *
+ * @param [in] old - given stored route.
+ * @param [in] now - given new route.
+ * @return first hop with disjoint routers, length + 1 if only length
+ * differs or 0 if routes agree.
+ */
+static std::uint8_t first_change(const route& old, const route& now) noexcept;
+
+/**
+ * @brief Add routers of other route to hops of route.
+ *
+ * @param [in,out] r - given route.
+ * @param [in] other - given route of the same path.
+ */
+static void merge(route& r, const route& other) noexcept;
+
+/**
+ * @brief Add router to hop.
+ *
+ * @param [in,out] r - given route.
+ * @param [in] hop - given hop index (from 0).
+ * @param [in] addr - given router address.
+ */
+static void add_router(route& r, std::uint8_t hop, in_addr_t addr) noexcept;
+
+/**
+ * @brief Handle keyboard interrupt.
+ *
+ * @param [in] sig - given signal number.
+ */
+static void sigint_handler(int sig) noexcept;
+
+static engine *active = nullptr;
+static volatile std::sig_atomic_t stopped = 0;
+
+
+void route_add(route& r, const probe_result& result, in_addr_t target) noexcept
+{
+    if (result.timeout || result.ttl == 0 || result.ttl > ROUTE_MAX_HOPS)
+        return;
+
+    add_router(r, result.ttl - 1, result.from);
+
+    // path ends at first hop where destination replied
+    if (result.from == target || result.type == ICMP_DEST_UNREACH) {
+        r.length  = r.reached ? std::min(r.length, result.ttl) : result.ttl;
+        r.reached = true;
+    }
+}
+
+void route_finish(route& r) noexcept
+{
+    // unreached path ends with last hop which replied
+    if (!r.reached) {
+        r.length = 0;
+
+        for (std::uint8_t hop = 0; hop < ROUTE_MAX_HOPS; hop++) {
+            if (r.hops[hop][0])
+                r.length = hop + 1;
+        }
+    }
+
+    for (auto hop = r.length; hop < ROUTE_MAX_HOPS; hop++)
+        std::fill(r.hops[hop], r.hops[hop] + ROUTE_WIDTH, 0);
+
+    r.fingerprint = route_fingerprint(r);
+}
+
+std::uint64_t route_fingerprint(const route& r) noexcept
+{
+    std::uint64_t hash = FNV_OFFSET;
+
+    for (std::uint8_t hop = 0; hop < r.length; hop++) {
+        // routers of hop are sorted, so order of replies does not matter
+        in_addr_t routers[ROUTE_WIDTH];
+        std::copy(r.hops[hop], r.hops[hop] + ROUTE_WIDTH, routers);
+        std::sort(routers, routers + ROUTE_WIDTH);
+
+        for (auto addr : routers)
+            hash = (hash ^ addr) * FNV_PRIME;
+
+        hash = (hash ^ (hop + 1)) * FNV_PRIME;
+    }
+
+    return (hash ^ r.reached) * FNV_PRIME;
+}
+
+bool route_expects(const route& r, std::uint8_t ttl, in_addr_t from, in_addr_t target) noexcept
+{
+    // beyond reached destination only destination may reply
+    if (ttl > r.length)
+        return !r.reached || from == target;
+
+    const auto *routers = r.hops[ttl - 1];
+    bool anonymous      = std::all_of(routers, routers + ROUTE_WIDTH, [](auto a) { return !a; });
+
+    return anonymous || std::find(routers, routers + ROUTE_WIDTH, from) != routers + ROUTE_WIDTH;
+}
+
+bool route_update(std::FILE *stream, in_addr_t target, route& old, const route& now) noexcept
+{
+    auto hop = first_change(old, now);
+
+    if (!hop) {
+        // load balanced or anonymous hop, remember its routers
+        merge(old, now);
+        return false;
+    }
+
+    char target_str[INET_ADDRSTRLEN], before[INET_ADDRSTRLEN], after[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &target, target_str, sizeof(target_str));
+
+    if (hop <= std::min(old.length, now.length)) {
+        inet_ntop(AF_INET, &old.hops[hop - 1][0], before, sizeof(before));
+        inet_ntop(AF_INET, &now.hops[hop - 1][0], after, sizeof(after));
+
+        std::fprintf(stream, "route change %s: hop %u %s -> %s, %u -> %u hops "
+            "(fingerprint %016lx -> %016lx)\n", target_str, hop, before, after,
+            old.length, now.length, old.fingerprint, now.fingerprint
+        );
+    }
+    else {
+        std::fprintf(stream, "route change %s: %u -> %u hops (fingerprint %016lx -> %016lx)\n",
+            target_str, old.length, now.length, old.fingerprint, now.fingerprint
+        );
+    }
+
+    std::fflush(stream);
+    old = now;
+    return true;
+}
+
+void monitor_routes(const std::vector<const char*>& names, const route_options& options) noexcept
+{
+    std::unique_ptr<target_table> table;
+
+    if (options.file) {
+        target_list list;
+        load_targets(options.file, 0, list);
+
+        if (list.addrs.empty())
+            utils::error("ntool: target list has no targets");
+
+        table = std::make_unique<target_table>(std::move(list));
+    }
+    else
+        table = std::make_unique<target_table>(names);
+
+    const auto& addrs = table->addrs();
+    stopped           = 0;
+    std::signal(SIGINT, sigint_handler);
+
+    std::uint64_t initial = 0, traced = 0, sampled = 0, escalations = 0, changes = 0;
+
+    auto begin  = utils::clock_ns();
+    auto routes = trace_all(addrs, options, initial);
+    auto reached = std::count_if(routes.begin(), routes.end(), [](const auto& r) { return r.reached; });
+
+    std::printf("Traced %zu paths in %.3f s (%ld reached), sampling %u TTLs per path every %.3f s\n",
+        addrs.size(), (utils::clock_ns() - begin) / 1e9, reached, options.samples,
+        options.interval
+    );
+
+    engine_config config;
+    config.interval_ns = static_cast<std::uint64_t>(options.interval * 1e9);
+    config.timeout_ns  = static_cast<std::uint64_t>(options.timeout * 1e9);
+    config.count       = 1;
+    config.hops        = options.hops;
+    config.samples     = options.samples;
+
+    sample_state state {&routes, &addrs, {}};
+    std::uint32_t round = 0;
+
+    while (!stopped && (options.count == 0 || round < options.count)) {
+        state.suspect.assign(addrs.size(), 0);
+        config.first_round = round++;
+
+        // new socket per round, late replies of previous round are not read
+        auto io = make_transport(options.io, false);
+        engine e(*io, config, handle_sample, &state);
+
+        for (std::size_t t = 0; t < addrs.size(); t++)
+            e.add_target(addrs[t], routes[t].length);
+
+        active = &e;
+        e.run();
+        active = nullptr;
+        sampled += e.counters().sent;
+
+        std::vector<std::uint32_t> suspects;
+        std::vector<in_addr_t> suspect_addrs;
+
+        for (std::uint32_t t = 0; t < addrs.size(); t++) {
+            if (state.suspect[t]) {
+                suspects.push_back(t);
+                suspect_addrs.push_back(addrs[t]);
+            }
+        }
+
+        if (suspects.empty() || stopped)
+            continue;
+
+        // only paths with unexpected repliers are traced again
+        escalations += suspects.size();
+        auto fresh   = trace_all(suspect_addrs, options, traced);
+
+        for (std::size_t i = 0; i < suspects.size(); i++) {
+            if (route_update(stdout, addrs[suspects[i]], routes[suspects[i]], fresh[i]))
+                changes++;
+        }
+    }
+
+    // budget of sampling compared to full traces every round
+    auto full = std::uint64_t(round) * addrs.size() * options.hops * options.queries;
+
+    std::printf("\n--- route statistics ---\n");
+    std::printf("%u rounds, %lu sampled probes, %lu escalations (%lu probes), "
+        "%lu route changes\n", round, sampled, escalations, traced, changes
+    );
+
+    if (full) {
+        std::printf("probes sent: %.2f%% of full traces every round (initial trace %lu probes)\n",
+            100.0 * (sampled + traced) / full, initial
+        );
+    }
+}
+
+static std::vector<route> trace_all(const std::vector<in_addr_t>& addrs,
+    const route_options& options, std::uint64_t& sent) noexcept
+{
+    trace_state state {std::vector<route>(addrs.size(), route {}), addrs};
+
+    // queries of all targets are spread to keep probe rate bounded
+    auto probes = std::uint64_t(addrs.size()) * options.hops;
+
+    engine_config config;
+    config.count        = options.queries;
+    config.hops         = options.hops;
+    config.timeout_ns   = static_cast<std::uint64_t>(options.timeout * 1e9);
+    config.interval_ns  = std::max(TRACE_SPACING, probes * 1000000000 / ROUTE_TRACE_RATE);
+    config.max_inflight = std::max<std::uint64_t>(config.max_inflight,
+        std::min<std::uint64_t>(probes * options.queries, 1 << 22)
+    );
+
+    auto io = make_transport(options.io, false);
+    engine e(*io, config, handle_trace, &state);
+
+    for (auto addr : addrs)
+        e.add_target(addr);
+
+    active = &e;
+    e.run();
+    active = nullptr;
+    sent  += e.counters().sent;
+
+    for (auto& r : state.routes)
+        route_finish(r);
+
+    return std::move(state.routes);
+}
+
+static void handle_trace(const probe_result& result, void *ctx) noexcept
+{
+    auto& state = *static_cast<trace_state*>(ctx);
+    route_add(state.routes[result.target], result, state.addrs[result.target]);
+}
+
+static void handle_sample(const probe_result& result, void *ctx) noexcept
+{
+    if (result.timeout)
+        return;
+
+    auto& state = *static_cast<sample_state*>(ctx);
+    auto target = (*state.addrs)[result.target];
+
+    if (!route_expects((*state.routes)[result.target], result.ttl, result.from, target))
+        state.suspect[result.target] = 1;
+}
+
+static std::uint8_t first_change(const route& old, const route& now) noexcept
+{
+    if (old.fingerprint == now.fingerprint)
+        return 0;
+
+    auto length = std::min(old.length, now.length);
+
+    for (std::uint8_t hop = 0; hop < length; hop++) {
+        const auto *a = old.hops[hop];
+        const auto *b = now.hops[hop];
+
+        if (!a[0] || !b[0])
+            continue;
+
+        bool shared = std::any_of(b, b + ROUTE_WIDTH, [a](auto addr) {
+            return addr && std::find(a, a + ROUTE_WIDTH, addr) != a + ROUTE_WIDTH;
+        });
+
+        if (!shared)
+            return hop + 1;
+    }
+
+    // destination moved closer or further
+    if (old.reached && now.reached && old.length != now.length)
+        return length + 1;
+
+    return 0;
+}
+
+static void merge(route& r, const route& other) noexcept
+{
+    // destination became reachable, newer route is more complete
+    if (!r.reached && other.reached) {
+        r = other;
+        return;
+    }
+
+    for (std::uint8_t hop = 0; hop < std::min(r.length, other.length); hop++) {
+        for (auto addr : other.hops[hop]) {
+            if (addr)
+                add_router(r, hop, addr);
+        }
+    }
+
+    r.fingerprint = route_fingerprint(r);
+}
+
+static void add_router(route& r, std::uint8_t hop, in_addr_t addr) noexcept
+{
+    auto *routers = r.hops[hop];
+
+    for (std::uint8_t i = 0; i < ROUTE_WIDTH; i++) {
+        if (routers[i] == addr)
+            return;
+
+        if (!routers[i]) {
+            routers[i] = addr;
+            return;
+        }
+    }
+}
+
+static void sigint_handler(int) noexcept
+{
+    stopped = 1;
+
+    if (active)
+        active->stop();
+}
+
+} // namespace ntool
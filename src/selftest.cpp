@@ -0,0 +1,244 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/transport.hpp>
+#include <ntool/selftest.hpp>
+#include <ntool/engine.hpp>
+#include <ntool/utils.hpp>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdio>
+
+
+namespace ntool {
+
+/** Single rate step measurement.*/
+struct step_result {
+    double        rate;         // requested probes per second
+    std::uint64_t sent;         // sent probes
+    std::uint64_t received;     // echo replies
+    double        pps;          // achieved probes per second
+    double        loss;         // loss in percents
+    double        rtt;          // average RTT in milliseconds
+    double        error;        // RTT above baseline in milliseconds
+    double        syscalls;     // system calls per probe
+    double        cpu_us;       // CPU time per probe in microseconds
+    bool          passed;       // true if step is within limits
+};
+
+/** Probe outcomes of single step.*/
+struct step_stats {
+    utils::running_stats rtt;
+    std::uint64_t        first_send {UINT64_MAX};
+    std::uint64_t        last_send  {0};
+};
+
+/**
+ * @brief Handle probe outcome.
+ *
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given step statistics.
+ */
+static void handle_result(const probe_result& result, void *ctx) noexcept;
+
+/**
+ * @brief Probe target at given rate.
+ *
+ * @param [in] backend - given I/O backend.
+ * @param [in] addr - given target address.
+ * @param [in] rate - given probes per second.
+ * @param [in] duration - given step duration in seconds.
+ * @param [in] timeout - given reply waiting time in seconds.
+ * @return step measurement.
+ */
+static step_result run_step(io_backend backend, in_addr_t addr, double rate,
+    double duration, double timeout) noexcept;
+
+/**
+ * @brief Get consumed CPU time.
+ *
+ * @return user & system CPU time in microseconds.
+ */
+static std::uint64_t cpu_time(void) noexcept;
+
+inline const double SELFTEST_RATES[] {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000
+};
+
+inline const double BASELINE_RATE     {100};    // unloaded RTT measurement
+inline const double BASELINE_DURATION {0.5};
+inline const double RATE_MARGIN       {0.95};   // achieved / requested rate
+inline const double RECOMMENDED_SHARE {0.7};    // of measured capacity
+
+inline const io_backend SELFTEST_BACKENDS[] {io_backend::raw, io_backend::mmsg};
+
+
+void selftest_capacity(const char *target, const selftest_options& options) noexcept
+{
+    char ip_str[INET_ADDRSTRLEN];
+    in_addr addr;
+    addr.s_addr = utils::get_ip_address(target);
+    inet_ntop(AF_INET, &addr, ip_str, sizeof(ip_str));
+
+    std::printf("Capacity self test to %s [%s], %.1f s per step, "
+        "max loss %.2f%%, max error %.3f ms\n", target, ip_str,
+        options.duration, options.max_loss, options.max_error
+    );
+
+    auto baseline = run_step(io_backend::raw, addr.s_addr, BASELINE_RATE,
+        BASELINE_DURATION, options.timeout
+    );
+
+    if (baseline.received == 0)
+        utils::error("ntool: selftest: target does not answer");
+
+    std::printf("baseline rtt %.3f ms at %.0f pps\n\n", baseline.rtt, BASELINE_RATE);
+    std::printf("%-8s %9s %9s %7s %8s %8s %9s %8s\n", "backend", "rate",
+        "pps", "loss%", "rtt ms", "error ms", "sys/probe", "cpu us");
+
+    double capacity[std::size(SELFTEST_BACKENDS)] {};
+    double cpu_us[std::size(SELFTEST_BACKENDS)] {};
+
+    for (std::size_t b = 0; b < std::size(SELFTEST_BACKENDS); b++) {
+        auto backend = SELFTEST_BACKENDS[b];
+
+        // stop at first rate ntool cannot sustain within limits
+        for (auto rate : SELFTEST_RATES) {
+            auto step  = run_step(backend, addr.s_addr, rate,
+                options.duration, options.timeout
+            );
+            step.error  = step.rtt - baseline.rtt;
+            step.passed = step.loss <= options.max_loss &&
+                step.error <= options.max_error &&
+                step.pps >= rate * RATE_MARGIN;
+
+            std::printf("%-8s %9.0f %9.0f %7.2f %8.3f %8.3f %9.2f %8.2f %s\n",
+                backend_name(backend), rate, step.pps, step.loss, step.rtt,
+                step.error, step.syscalls, step.cpu_us,
+                step.passed ? "ok" : "FAIL"
+            );
+
+            if (!step.passed)
+                break;
+
+            capacity[b] = rate;
+            cpu_us[b]   = step.cpu_us;
+        }
+    }
+
+    std::putchar('\n');
+
+    // prefer highest capacity, then lowest CPU cost per probe
+    std::size_t best = 0;
+
+    for (std::size_t b = 0; b < std::size(SELFTEST_BACKENDS); b++) {
+        std::printf("capacity %-5s %.0f pps\n",
+            backend_name(SELFTEST_BACKENDS[b]), capacity[b]
+        );
+
+        if (capacity[b] > capacity[best] ||
+            (capacity[b] == capacity[best] && cpu_us[b] < cpu_us[best]))
+            best = b;
+    }
+
+    if (capacity[best] == 0) {
+        std::puts("no backend sustains lowest rate within limits, "
+            "increase --max-loss or --max-error");
+        return;
+    }
+
+    auto rate     = capacity[best] * RECOMMENDED_SHARE;
+    auto inflight = static_cast<std::uint64_t>(rate * options.timeout);
+
+    std::printf("\nrecommended settings (%.0f%% of capacity):\n"
+        "    rate        %.0f pps\n"
+        "    in-flight   %lu probes (table capacity %u)\n"
+        "    ntool --ping --io %s -i %.6f -W %.1f %s\n",
+        RECOMMENDED_SHARE * 100, rate, inflight, engine_config {}.max_inflight,
+        backend_name(SELFTEST_BACKENDS[best]), 1.0 / rate, options.timeout,
+        ip_str
+    );
+}
+
+static void handle_result(const probe_result& result, void *ctx) noexcept
+{
+    auto stats = static_cast<step_stats*>(ctx);
+
+    stats->first_send = std::min(stats->first_send, result.send_ns);
+    stats->last_send  = std::max(stats->last_send, result.send_ns);
+
+    if (!result.timeout && result.type == ICMP_ECHOREPLY)
+        utils::update(stats->rtt, (result.recv_ns - result.send_ns) / 1e6);
+}
+
+static step_result run_step(io_backend backend, in_addr_t addr, double rate,
+    double duration, double timeout) noexcept
+{
+    auto count = std::max(static_cast<std::uint32_t>(rate * duration), 2U);
+
+    engine_config config;
+    config.count       = count;
+    config.interval_ns = static_cast<std::uint64_t>(1e9 / rate);
+    config.timeout_ns  = static_cast<std::uint64_t>(timeout * 1e9);
+
+    auto io = make_transport(backend, false);
+    step_stats stats;
+
+    engine e(*io, config, handle_result, &stats);
+    e.add_target(addr);
+
+    auto cpu_begin      = cpu_time();
+    auto syscalls_begin = io->syscalls();
+    e.run();
+    auto syscalls_end   = io->syscalls();
+    auto cpu_end        = cpu_time();
+
+    const auto& counters = e.counters();
+
+    step_result step {};
+    step.rate     = rate;
+    step.sent     = counters.sent;
+    step.received = stats.rtt.count;
+    step.rtt      = stats.rtt.mean;
+
+    if (step.sent > 0) {
+        step.loss     = 100.0 * (step.sent - step.received) / step.sent;
+        step.syscalls = static_cast<double>(syscalls_end - syscalls_begin) / step.sent;
+        step.cpu_us   = static_cast<double>(cpu_end - cpu_begin) / step.sent;
+    }
+
+    if (stats.last_send > stats.first_send)
+        step.pps = (step.sent - 1) * 1e9 / (stats.last_send - stats.first_send);
+
+    return step;
+}
+
+static std::uint64_t cpu_time(void) noexcept
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    auto us = [](const timeval& tv) noexcept {
+        return static_cast<std::uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+    };
+
+    return us(usage.ru_utime) + us(usage.ru_stime);
+}
+
+} // namespace ntool
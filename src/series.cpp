@@ -0,0 +1,383 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/series.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <bit>
+
+
+namespace ntool {
+
+/**
+ * @brief Append bits to block.
+ *
+ * @param [in,out] block - given block with enough free bits.
+ * @param [in] value - given bits (lower count bits are used).
+ * @param [in] count - given number of bits (up to 64).
+ */
+static void write_bits(series_block& block, std::uint64_t value, std::uint32_t count) noexcept;
+
+/**
+ * @brief Get size of delta-of-delta encoding.
+ *
+ * @param [in] dod - given delta-of-delta.
+ * @return number of bits or 0 if it does not fit in 32 bits.
+ */
+static std::uint32_t time_bits(std::int64_t dod) noexcept;
+
+inline const std::uint32_t SERIES_BLOCK_BITS {SERIES_BLOCK_WORDS * 64};
+inline const std::uint8_t  NO_WINDOW         {0xff};   // XOR window is not set
+
+
+series_store::series_store(std::uint32_t targets, const series_config& config) noexcept
+    : m_config(config),
+      m_pool(sizeof(series_block), alignof(series_block), SERIES_SLAB_BLOCKS),
+      m_limit(config.memory / sizeof(series_block))
+{
+    m_states.assign(targets, series_state {});
+}
+
+void series_store::append(std::uint32_t target, std::int64_t time_ms, double rtt) noexcept
+{
+    auto& state = m_states[target];
+    auto value  = std::bit_cast<std::uint64_t>(std::round(rtt / m_config.resolution));
+
+    if (state.last) {
+        auto& b    = *state.last;
+        auto delta = time_ms - state.prev_time;
+        auto dod   = delta - state.prev_delta;
+        auto tbits = time_bits(dod);
+        auto x     = value ^ state.prev_value;
+
+        std::uint8_t leading  = state.leading;
+        std::uint8_t trailing = state.trailing;
+        std::uint32_t vbits   = 1;
+
+        if (x != 0) {
+            auto lz = std::min(std::countl_zero(x), 31);
+            auto tz = std::countr_zero(x);
+
+            // reuse previous window if meaningful bits fit into it
+            if (state.leading != NO_WINDOW && lz >= state.leading && tz >= state.trailing)
+                vbits = 2 + (64 - state.leading - state.trailing);
+            else {
+                leading  = static_cast<std::uint8_t>(lz);
+                trailing = static_cast<std::uint8_t>(tz);
+                vbits    = 2 + 5 + 6 + (64 - lz - tz);
+            }
+        }
+
+        if (tbits != 0 && b.bits + tbits + vbits <= SERIES_BLOCK_BITS) {
+            if (dod == 0)
+                write_bits(b, 0b0, 1);
+            else if (tbits == 9)
+                write_bits(b, (0b10ULL << 7) | (dod + 63), 9);
+            else if (tbits == 12)
+                write_bits(b, (0b110ULL << 9) | (dod + 255), 12);
+            else if (tbits == 16)
+                write_bits(b, (0b1110ULL << 12) | (dod + 2047), 16);
+            else {
+                write_bits(b, 0b1111, 4);
+                write_bits(b, static_cast<std::uint32_t>(dod), 32);
+            }
+
+            if (x == 0)
+                write_bits(b, 0b0, 1);
+            else if (leading == state.leading && trailing == state.trailing) {
+                write_bits(b, 0b10, 2);
+                write_bits(b, x >> trailing, 64 - leading - trailing);
+            }
+            else {
+                auto length = 64 - leading - trailing;
+                write_bits(b, 0b11, 2);
+                write_bits(b, leading, 5);
+                write_bits(b, length & 63, 6);     // 64 is stored as 0
+                write_bits(b, x >> trailing, length);
+            }
+
+            b.count++;
+            state.prev_time  = time_ms;
+            state.prev_delta = delta;
+            state.prev_value = value;
+            state.leading    = leading;
+            state.trailing   = trailing;
+            return;
+        }
+    }
+
+    auto& b    = start_block(state, time_ms);
+    b.start_ms = time_ms;
+    b.count    = 1;
+    write_bits(b, value, 64);
+
+    state.prev_time  = time_ms;
+    state.prev_delta = 0;
+    state.prev_value = value;
+    state.leading    = NO_WINDOW;
+    state.trailing   = 0;
+}
+
+const series_config& series_store::config(void) const noexcept
+{
+    return m_config;
+}
+
+std::size_t series_store::memory(void) const noexcept
+{
+    return m_peak * sizeof(series_block) + m_states.size() * sizeof(series_state);
+}
+
+double series_store::coverage(void) const noexcept
+{
+    auto retention = static_cast<std::int64_t>(m_config.retention * 1000);
+    auto shortest  = retention;
+    bool any       = false;
+
+    for (const auto& state : m_states) {
+        if (!state.last)
+            continue;
+
+        // samples of oldest block before retention are not decoded
+        auto kept = std::min(state.prev_time - state.last->next->start_ms, retention);
+        shortest  = std::min(shortest, kept);
+        any       = true;
+    }
+
+    return any ? shortest / 1e3 : 0.0;
+}
+
+std::uint64_t series_store::samples(void) const noexcept
+{
+    std::uint64_t count = 0;
+
+    for (const auto& state : m_states) {
+        if (!state.last)
+            continue;
+
+        auto b = state.last;
+
+        do {
+            b      = b->next;
+            count += b->count;
+        } while (b != state.last);
+    }
+
+    return count;
+}
+
+std::uint64_t series_store::encoded_bits(void) const noexcept
+{
+    std::uint64_t bits = 0;
+
+    for (const auto& state : m_states) {
+        if (!state.last)
+            continue;
+
+        auto b = state.last;
+
+        do {
+            b     = b->next;
+            bits += b->bits;
+        } while (b != state.last);
+    }
+
+    return bits;
+}
+
+series_block& series_store::start_block(series_state& state, std::int64_t time_ms) noexcept
+{
+    auto cutoff = time_ms - static_cast<std::int64_t>(m_config.retention * 1000);
+
+    // oldest block expires when the next one starts before retention,
+    // so its samples are all older than retention
+    while (state.last && state.last->next != state.last &&
+           state.last->next->next->start_ms <= cutoff)
+        release_oldest(state);
+
+    // at memory limit target reuses its own oldest block, shortening
+    // its history instead of growing
+    if (m_limit && m_blocks >= m_limit && state.last)
+        release_oldest(state);
+
+    auto b = static_cast<series_block*>(m_pool.allocate());
+    std::memset(b, 0, sizeof(*b));
+
+    if (state.last) {
+        b->next          = state.last->next;
+        state.last->next = b;
+    }
+    else
+        b->next = b;
+
+    state.last = b;
+    m_blocks++;
+    m_peak = std::max(m_peak, m_blocks);
+
+    return *b;
+}
+
+void series_store::release_oldest(series_state& state) noexcept
+{
+    auto oldest = state.last->next;
+
+    if (oldest == state.last)
+        state.last = nullptr;
+    else
+        state.last->next = oldest->next;
+
+    m_pool.release(oldest);
+    m_blocks--;
+}
+
+series_decoder::series_decoder(const series_store& store, std::uint32_t target) noexcept
+    : m_store(store), m_target(target)
+{}
+
+bool series_decoder::next(series_point& point) noexcept
+{
+    const auto& state  = m_store.m_states[m_target];
+    const auto& config = m_store.m_config;
+
+    // oldest block may start before retention
+    auto cutoff = state.prev_time - static_cast<std::int64_t>(config.retention * 1000);
+
+    for (;;) {
+        if (m_remaining == 0) {
+            if (!state.last || m_block == state.last)
+                return false;
+
+            // list goes from newest block to oldest one
+            m_block = m_block ? m_block->next : state.last->next;
+
+            m_pos        = 0;
+            m_remaining  = m_block->count - 1;
+            m_prev_time  = m_block->start_ms;
+            m_prev_delta = 0;
+            m_prev_value = read(64);
+            m_leading    = NO_WINDOW;
+            m_trailing   = 0;
+        }
+        else {
+            std::int64_t dod;
+
+            if (read(1) == 0)
+                dod = 0;
+            else if (read(1) == 0)
+                dod = static_cast<std::int64_t>(read(7)) - 63;
+            else if (read(1) == 0)
+                dod = static_cast<std::int64_t>(read(9)) - 255;
+            else if (read(1) == 0)
+                dod = static_cast<std::int64_t>(read(12)) - 2047;
+            else
+                dod = static_cast<std::int32_t>(read(32));
+
+            m_prev_delta += dod;
+            m_prev_time  += m_prev_delta;
+
+            if (read(1) != 0) {
+                if (read(1) != 0) {
+                    m_leading = static_cast<std::uint8_t>(read(5));
+                    auto length = static_cast<std::uint32_t>(read(6));
+
+                    if (length == 0)
+                        length = 64;
+
+                    m_trailing = static_cast<std::uint8_t>(64 - m_leading - length);
+                }
+
+                auto meaningful = 64 - m_leading - m_trailing;
+                m_prev_value   ^= read(meaningful) << m_trailing;
+            }
+
+            m_remaining--;
+        }
+
+        if (m_prev_time < cutoff)
+            continue;
+
+        point.time_ms = m_prev_time;
+        point.rtt     = std::bit_cast<double>(m_prev_value) * config.resolution;
+        return true;
+    }
+}
+
+std::uint64_t series_decoder::read(std::uint32_t count) noexcept
+{
+    auto word   = m_pos / 64;
+    auto offset = m_pos % 64;
+    auto space  = 64 - offset;
+    auto mask   = (count == 64) ? ~0ULL : (1ULL << count) - 1;
+
+    m_pos += count;
+
+    if (count <= space)
+        return (m_block->words[word] >> (space - count)) & mask;
+
+    auto rest = count - space;
+    auto high = m_block->words[word] & ((1ULL << space) - 1);
+
+    return ((high << rest) | (m_block->words[word + 1] >> (64 - rest))) & mask;
+}
+
+static void write_bits(series_block& block, std::uint64_t value, std::uint32_t count) noexcept
+{
+    if (count == 0)
+        return;
+
+    std::uint32_t word   = block.bits / 64;
+    std::uint32_t offset = block.bits % 64;
+    std::uint32_t space  = 64 - offset;
+
+    if (count < 64)
+        value &= (1ULL << count) - 1;
+
+    block.bits += count;
+
+    if (count <= space) {
+        block.words[word] |= value << (space - count);
+        return;
+    }
+
+    auto rest = count - space;
+    block.words[word]     |= value >> rest;
+    block.words[word + 1] |= value << (64 - rest);
+}
+
+static std::uint32_t time_bits(std::int64_t dod) noexcept
+{
+    if (dod == 0)
+        return 1;
+
+    if (dod >= -63 && dod <= 64)
+        return 2 + 7;
+
+    if (dod >= -255 && dod <= 256)
+        return 3 + 9;
+
+    if (dod >= -2047 && dod <= 2048)
+        return 4 + 12;
+
+    if (dod >= INT32_MIN && dod <= INT32_MAX)
+        return 4 + 32;
+
+    return 0;
+}
+
+} // namespace ntool
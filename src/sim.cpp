@@ -0,0 +1,282 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/utils.hpp>
+#include <ntool/sim.hpp>
+#include <netinet/ip_icmp.h>
+#include <netinet/ip.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+
+namespace ntool {
+
+inline const std::uint8_t  SIM_INITIAL_TTL {64};
+inline const in_addr_t     SIM_LOCAL_ADDR  {0x0100000A};   // 10.0.0.1
+
+/**
+ * @brief Compare deliveries by arrival (min-heap order).
+ *
+ * @param [in] a - given first delivery.
+ * @param [in] b - given second delivery.
+ * @return true if a arrives later than b.
+ */
+static inline bool later(const auto& a, const auto& b) noexcept
+{
+    return (a.time != b.time) ? a.time > b.time : a.order > b.order;
+}
+
+/**
+ * @brief Mix bits of given value.
+ *
+ * @param [in] x - given value.
+ * @return hash of value.
+ */
+static inline std::uint64_t mix(std::uint64_t x) noexcept
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+std::vector<in_addr_t> generate_topology(sim_transport& sim,
+    const sim_topology& topology) noexcept
+{
+    constexpr std::uint32_t LEVEL_WIDTH {1 << 16};
+
+    std::unordered_map<std::uint32_t, std::uint32_t> routers;
+    std::vector<in_addr_t>     targets;
+    std::vector<std::uint32_t> path;
+
+    auto hop_range = topology.max_hops - topology.min_hops + 1;
+    auto rtt_range = topology.max_rtt_ns - topology.min_rtt_ns + 1;
+
+    targets.reserve(topology.targets);
+
+    for (std::uint32_t i = 0; i < topology.targets; i++) {
+        auto h    = mix(topology.seed ^ (i * 0x9E3779B97F4A7C15ULL));
+        auto hops = topology.min_hops + h % hop_range;
+
+        // level k has 4 << k routers, so paths branch with distance
+        path.clear();
+        for (std::uint32_t k = 0; k < hops; k++) {
+            auto width = std::min<std::uint32_t>(4U << std::min(k, 14U), LEVEL_WIDTH);
+            auto index = static_cast<std::uint32_t>((h >> (k % 8)) % width);
+            auto addr  = htonl((172U << 24) | ((16 + k) << 16) | index);
+
+            auto [it, inserted] = routers.try_emplace(addr, 0);
+            if (inserted)
+                it->second = sim.add_router(addr);
+
+            path.push_back(it->second);
+        }
+
+        sim_model model = topology.model;
+        model.rtt_ns    = topology.min_rtt_ns + mix(h) % rtt_range;
+
+        auto addr = htonl((10U << 24) + i + 1);
+        sim.add_target(addr, model, path.data(), path.size());
+        targets.push_back(addr);
+    }
+
+    return targets;
+}
+
+sim_transport::sim_transport(std::uint64_t seed) noexcept
+    : m_state(seed ? seed : 1)
+{}
+
+std::uint32_t sim_transport::add_router(in_addr_t addr) noexcept
+{
+    m_routers.push_back(addr);
+    return m_routers.size() - 1;
+}
+
+void sim_transport::add_target(in_addr_t addr, const sim_model& model,
+    const std::uint32_t *path, std::size_t hops) noexcept
+{
+    sim_target target;
+    target.addr  = addr;
+    target.model = model;
+    target.path  = m_paths.size();
+    target.hops  = hops;
+
+    m_paths.insert(m_paths.end(), path, path + hops);
+    m_index[addr] = m_targets.size();
+    m_targets.push_back(target);
+}
+
+const sim_counters& sim_transport::counters(void) const noexcept
+{
+    return m_counters;
+}
+
+std::uint64_t sim_transport::now(void) noexcept
+{
+    return m_now;
+}
+
+bool sim_transport::send(in_addr_t dst, std::uint8_t ttl,
+    const std::uint8_t *packet, std::size_t size) noexcept
+{
+    m_counters.probes++;
+
+    auto it = m_index.find(dst);
+
+    if (it == m_index.end() || size < sizeof(icmphdr)) {
+        m_counters.dropped++;
+        return true;
+    }
+
+    const auto& target = m_targets[it->second];
+    const auto& model  = target.model;
+
+    if (model.loss > 0.0 && uniform() < model.loss) {
+        m_counters.dropped++;
+        return true;
+    }
+
+    delivery d {};
+    d.dst = dst;
+    std::memcpy(d.probe, packet, sizeof(d.probe));
+
+    // expired probe is answered by router at distance ttl
+    std::uint64_t distance = target.hops + 1;
+
+    if (ttl <= target.hops) {
+        distance = ttl;
+        d.from   = m_routers[m_paths[target.path + ttl - 1]];
+        d.type   = ICMP_TIME_EXCEEDED;
+        d.ttl    = SIM_INITIAL_TTL - (ttl - 1);
+    }
+    else {
+        d.from = dst;
+        d.type = ICMP_ECHOREPLY;
+        d.ttl  = SIM_INITIAL_TTL - target.hops;
+    }
+
+    auto rtt = model.rtt_ns * distance / (target.hops + 1);
+
+    if (model.jitter_ns)
+        rtt += static_cast<std::uint64_t>(-std::log1p(-uniform()) * model.jitter_ns);
+
+    if (model.reorder > 0.0 && uniform() < model.reorder)
+        rtt += model.rtt_ns;
+
+    d.time = m_now + rtt;
+    schedule(d);
+
+    if (model.duplicate > 0.0 && uniform() < model.duplicate) {
+        d.time += model.jitter_ns + 1;
+        schedule(d);
+    }
+
+    return true;
+}
+
+std::ptrdiff_t sim_transport::recv(std::uint8_t *buffer, std::size_t size,
+    std::uint64_t& time) noexcept
+{
+    if (m_queue.empty() || m_queue.front().time > m_now)
+        return -1;
+
+    std::pop_heap(m_queue.begin(), m_queue.end(), later<delivery, delivery>);
+    auto d = m_queue.back();
+    m_queue.pop_back();
+
+    m_counters.replies++;
+    time = d.time;
+
+    // reply IP header
+    iphdr ip {};
+    ip.ihl      = 5;
+    ip.version  = 4;
+    ip.ttl      = d.ttl;
+    ip.protocol = IPPROTO_ICMP;
+    ip.saddr    = d.from;
+    ip.daddr    = SIM_LOCAL_ADDR;
+
+    std::uint8_t packet[sizeof(iphdr) * 2 + sizeof(icmphdr) * 2] {};
+    std::size_t  length = 0;
+
+    std::memcpy(packet, &ip, sizeof(ip));
+    length += sizeof(ip);
+
+    if (d.type == ICMP_ECHOREPLY) {
+        // echo reply repeats probe header with changed type
+        std::memcpy(packet + length, d.probe, sizeof(d.probe));
+        packet[length] = ICMP_ECHOREPLY;
+        length += sizeof(d.probe);
+    }
+    else {
+        // time exceeded quotes expired probe header
+        icmphdr icmp {};
+        icmp.type = d.type;
+        std::memcpy(packet + length, &icmp, sizeof(icmp));
+        length += sizeof(icmp);
+
+        iphdr quoted {};
+        quoted.ihl      = 5;
+        quoted.version  = 4;
+        quoted.ttl      = 1;
+        quoted.protocol = IPPROTO_ICMP;
+        quoted.saddr    = SIM_LOCAL_ADDR;
+        quoted.daddr    = d.dst;
+
+        std::memcpy(packet + length, &quoted, sizeof(quoted));
+        length += sizeof(quoted);
+        std::memcpy(packet + length, d.probe, sizeof(d.probe));
+        length += sizeof(d.probe);
+    }
+
+    length = std::min(length, size);
+    std::memcpy(buffer, packet, length);
+
+    return length;
+}
+
+void sim_transport::wait(std::uint64_t deadline) noexcept
+{
+    // jump virtual clock to next event
+    if (!m_queue.empty() && m_queue.front().time <= deadline)
+        m_now = std::max(m_now, m_queue.front().time);
+    else if (deadline != UINT64_MAX)
+        m_now = std::max(m_now, deadline);
+}
+
+void sim_transport::schedule(delivery d) noexcept
+{
+    d.order = m_order++;
+    m_queue.push_back(d);
+    std::push_heap(m_queue.begin(), m_queue.end(), later<delivery, delivery>);
+}
+
+double sim_transport::uniform(void) noexcept
+{
+    // splitmix64
+    auto z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    return static_cast<double>(z >> 11) * 0x1.0p-53;
+}
+
+} // namespace ntool
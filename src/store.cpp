@@ -0,0 +1,627 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/histogram.hpp>
+#include <ntool/store.hpp>
+#include <ntool/utils.hpp>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <dirent.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <ctime>
+
+
+namespace ntool {
+
+/** Mapped segment file.*/
+struct mapped_segment {
+    const std::uint8_t   *data;
+    std::size_t          size;
+    const segment_header *header;
+    std::int64_t         target;    // dictionary index of queried target (-1 - all)
+};
+
+/** Part of segment scanned by single worker.*/
+struct scan_unit {
+    std::uint32_t segment;
+    std::uint32_t block;
+};
+
+/** Partial query result of worker.*/
+struct query_result {
+    std::uint64_t rows     {0};     // scanned rows
+    std::uint64_t count    {0};     // matching probes
+    std::uint64_t received {0};     // matching replies
+    std::uint64_t sum      {0};     // RTT sum in microseconds
+    std::uint32_t min      {UINT32_MAX};
+    std::uint32_t max      {0};
+    log_histogram rtt;
+};
+
+/**
+ * @brief Scan index block of segment.
+ *
+ * @param [in] seg - given segment.
+ * @param [in] block - given block index.
+ * @param [in] options - given query options.
+ * @param [in,out] result - given partial result.
+ */
+template <typename T, typename R>
+static void scan(const mapped_segment& seg, std::uint32_t block,
+    const query_options& options, query_result& result) noexcept;
+
+/**
+ * @brief Scan index block with column widths of segment.
+ *
+ * @param [in] seg - given segment.
+ * @param [in] block - given block index.
+ * @param [in] options - given query options.
+ * @param [in,out] result - given partial result.
+ */
+static void scan_block(const mapped_segment& seg, std::uint32_t block,
+    const query_options& options, query_result& result) noexcept;
+
+/**
+ * @brief Map segment file & validate header.
+ *
+ * @param [in] path - given segment path.
+ * @param [out] seg - given object to store mapping.
+ * @return false if file is not a valid segment.
+ */
+static bool map_segment(const std::string& path, mapped_segment& seg) noexcept;
+
+/**
+ * @brief Check segment header against segment size.
+ *
+ * @param [in] h - given segment header.
+ * @param [in] size - given segment file size in bytes.
+ * @return false if header is corrupt or any column is out of file.
+ */
+static bool valid_segment(const segment_header& h, std::size_t size) noexcept;
+
+/**
+ * @brief Check that column lies within segment file.
+ *
+ * @param [in] offset - given column offset.
+ * @param [in] count - given number of values.
+ * @param [in] width - given value size in bytes.
+ * @param [in] size - given segment file size in bytes.
+ * @return false if column is misaligned or out of file.
+ */
+static bool column_fits(std::uint64_t offset, std::uint64_t count, std::uint64_t width,
+    std::size_t size) noexcept;
+
+/**
+ * @brief Format time as local date & time.
+ *
+ * @param [in] time_ms - given milliseconds since epoch.
+ * @return formatted time.
+ */
+static std::string format_time(std::int64_t time_ms) noexcept;
+
+/**
+ * @brief Round up to multiple of 64.
+ *
+ * @param [in] value - given value.
+ * @return aligned value.
+ */
+static std::uint64_t align64(std::uint64_t value) noexcept;
+
+
+segment_writer::segment_writer(const char *dir, std::uint32_t span) noexcept
+    : m_dir(dir), m_span_ms(std::max<std::int64_t>(span, 1) * 1000)
+{
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST)
+        utils::error("ntool: store: cannot create store directory");
+
+    m_rows.reserve(SEGMENT_BLOCK_ROWS);
+}
+
+segment_writer::~segment_writer(void) noexcept
+{
+    close();
+}
+
+void segment_writer::append(in_addr_t target, std::int64_t time_ms, std::uint32_t rtt_us) noexcept
+{
+    auto partition = time_ms - time_ms % m_span_ms;
+
+    // late results (timeouts) stay in current segment, its range covers them
+    if (m_rows.empty())
+        m_partition = partition;
+    else if (time_ms >= m_partition + m_span_ms || m_rows.size() >= SEGMENT_MAX_ROWS) {
+        flush();
+        m_partition = partition;
+    }
+
+    m_rows.push_back({time_ms, target, rtt_us});
+}
+
+void segment_writer::close(void) noexcept
+{
+    flush();
+}
+
+void segment_writer::flush(void) noexcept
+{
+    if (m_rows.empty())
+        return;
+
+    std::stable_sort(m_rows.begin(), m_rows.end(),
+        [](const row& a, const row& b) { return a.time_ms < b.time_ms; }
+    );
+
+    std::vector<in_addr_t> dict;
+    dict.reserve(m_rows.size());
+
+    for (const auto& r : m_rows)
+        dict.push_back(r.target);
+
+    std::sort(dict.begin(), dict.end());
+    dict.erase(std::unique(dict.begin(), dict.end()), dict.end());
+
+    bool short_rtt = std::all_of(m_rows.begin(), m_rows.end(), [](const row& r) {
+        return r.rtt_us == SEGMENT_LOST || r.rtt_us < UINT16_MAX;
+    });
+
+    std::uint64_t rows = m_rows.size();
+    std::uint32_t blocks = (rows + SEGMENT_BLOCK_ROWS - 1) / SEGMENT_BLOCK_ROWS;
+
+    segment_header header {};
+    std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version       = SEGMENT_VERSION;
+    header.target_width  = (dict.size() <= 256) ? 1 : (dict.size() <= 65536) ? 2 : 4;
+    header.rtt_width     = short_rtt ? 2 : 4;
+    header.block_rows    = SEGMENT_BLOCK_ROWS;
+    header.rows          = rows;
+    header.targets       = dict.size();
+    header.blocks        = blocks;
+    header.start_ms      = m_rows.front().time_ms;
+    header.end_ms        = m_rows.back().time_ms;
+    header.dict_offset   = align64(sizeof(header));
+    header.index_offset  = align64(header.dict_offset + dict.size() * sizeof(in_addr_t));
+    header.time_offset   = align64(header.index_offset + blocks * sizeof(segment_block));
+    header.target_offset = align64(header.time_offset + rows * sizeof(std::uint32_t));
+    header.rtt_offset    = align64(header.target_offset + rows * header.target_width);
+
+    std::vector<std::uint8_t> file(header.rtt_offset + rows * header.rtt_width);
+    auto data = file.data();
+
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + header.dict_offset, dict.data(), dict.size() * sizeof(in_addr_t));
+
+    auto index = reinterpret_cast<segment_block*>(data + header.index_offset);
+    auto times = reinterpret_cast<std::uint32_t*>(data + header.time_offset);
+
+    for (std::uint64_t i = 0; i < rows; i++) {
+        const auto& r = m_rows[i];
+        auto target   = static_cast<std::uint32_t>(
+            std::lower_bound(dict.begin(), dict.end(), r.target) - dict.begin()
+        );
+
+        times[i] = static_cast<std::uint32_t>(r.time_ms - header.start_ms);
+
+        switch (header.target_width) {
+        case 1:
+            data[header.target_offset + i] = static_cast<std::uint8_t>(target);
+            break;
+
+        case 2:
+            reinterpret_cast<std::uint16_t*>(data + header.target_offset)[i] = target;
+            break;
+
+        default:
+            reinterpret_cast<std::uint32_t*>(data + header.target_offset)[i] = target;
+            break;
+        }
+
+        if (short_rtt) {
+            reinterpret_cast<std::uint16_t*>(data + header.rtt_offset)[i] =
+                (r.rtt_us == SEGMENT_LOST) ? UINT16_MAX : r.rtt_us;
+        }
+        else
+            reinterpret_cast<std::uint32_t*>(data + header.rtt_offset)[i] = r.rtt_us;
+
+        auto& block = index[i / SEGMENT_BLOCK_ROWS];
+
+        if (i % SEGMENT_BLOCK_ROWS == 0)
+            block.min_ms = r.time_ms;
+
+        block.max_ms = r.time_ms;
+    }
+
+    // readers see only complete segments
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%013ld-%013ld-%u.nts",
+        header.start_ms, header.end_ms, m_sequence++
+    );
+
+    auto path = m_dir + name;
+    auto tmp  = m_dir + "/.segment-" + std::to_string(getpid()) + ".tmp";
+    auto fd   = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+        utils::error("ntool: store: cannot create segment");
+
+    std::size_t done = 0;
+
+    while (done < file.size()) {
+        auto ret = write(fd, data + done, file.size() - done);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        if (ret < 0)
+            utils::error("ntool: store: segment write error");
+
+        done += ret;
+    }
+
+    ::close(fd);
+
+    if (rename(tmp.c_str(), path.c_str()) == -1)
+        utils::error("ntool: store: cannot rename segment");
+
+    m_rows.clear();
+}
+
+bool parse_time(const char *str, std::int64_t& time_ms) noexcept
+{
+    char *end = nullptr;
+    auto seconds = std::strtoll(str, &end, 10);
+
+    if (*str && end && *end == '\0') {
+        time_ms = seconds * 1000;
+        return true;
+    }
+
+    static const char *formats[] {
+        "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M",
+        "%Y-%m-%dT%H:%M", "%Y-%m-%d", "%H:%M:%S", "%H:%M",
+    };
+
+    for (auto format : formats) {
+        auto now = std::time(nullptr);
+        tm local {};
+        localtime_r(&now, &local);
+
+        // time without date means today
+        local.tm_hour = local.tm_min = local.tm_sec = 0;
+        auto rest     = strptime(str, format, &local);
+
+        if (rest && *rest == '\0') {
+            local.tm_isdst = -1;
+            time_ms = static_cast<std::int64_t>(std::mktime(&local)) * 1000;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void query_store(const char *dir, const query_options& options) noexcept
+{
+    auto begin = utils::clock_ns();
+    auto d     = opendir(dir);
+
+    if (!d)
+        utils::error("ntool: query: cannot open store directory");
+
+    std::vector<mapped_segment> segments;
+    std::uint32_t total = 0;
+
+    // prune by time range in file name, without opening files
+    while (auto entry = readdir(d)) {
+        long long first, last;
+        std::uint32_t sequence;
+        char tail[8] {};
+
+        if (std::sscanf(entry->d_name, "%lld-%lld-%u.%4s", &first, &last,
+            &sequence, tail) != 4 || std::strcmp(tail, "nts") != 0)
+            continue;
+
+        total++;
+
+        if (last < options.from_ms || first >= options.to_ms)
+            continue;
+
+        mapped_segment seg {};
+
+        if (!map_segment(std::string(dir) + "/" + entry->d_name, seg))
+            continue;
+
+        const auto& h = *seg.header;
+        seg.target    = -1;
+
+        if (options.target) {
+            auto dict = reinterpret_cast<const in_addr_t*>(seg.data + h.dict_offset);
+            auto it   = std::lower_bound(dict, dict + h.targets, options.target);
+
+            if (it == dict + h.targets || *it != options.target) {
+                munmap(const_cast<std::uint8_t*>(seg.data), seg.size);
+                continue;
+            }
+
+            seg.target = it - dict;
+        }
+
+        segments.push_back(seg);
+    }
+
+    closedir(d);
+
+    // select blocks overlapping time range using sparse index
+    std::vector<scan_unit> units;
+
+    for (std::uint32_t s = 0; s < segments.size(); s++) {
+        const auto& seg = segments[s];
+        auto index = reinterpret_cast<const segment_block*>(seg.data + seg.header->index_offset);
+
+        for (std::uint32_t b = 0; b < seg.header->blocks; b++) {
+            if (index[b].max_ms >= options.from_ms && index[b].min_ms < options.to_ms)
+                units.push_back({s, b});
+        }
+    }
+
+    auto threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    threads      = std::clamp<std::uint32_t>(threads, 1, std::max<std::size_t>(units.size(), 1));
+
+    std::vector<query_result> results(threads);
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> next {0};
+
+    auto work = [&](std::uint32_t id) noexcept {
+        for (;;) {
+            auto i = next.fetch_add(1, std::memory_order_relaxed);
+
+            if (i >= units.size())
+                break;
+
+            scan_block(segments[units[i].segment], units[i].block, options, results[id]);
+        }
+    };
+
+    for (std::uint32_t i = 1; i < threads; i++)
+        workers.emplace_back(work, i);
+
+    work(0);
+
+    for (auto& w : workers)
+        w.join();
+
+    auto& r = results[0];
+
+    for (std::uint32_t i = 1; i < threads; i++) {
+        r.rows     += results[i].rows;
+        r.count    += results[i].count;
+        r.received += results[i].received;
+        r.sum      += results[i].sum;
+        r.min       = std::min(r.min, results[i].min);
+        r.max       = std::max(r.max, results[i].max);
+        r.rtt.merge(results[i].rtt);
+    }
+
+    auto elapsed = (utils::clock_ns() - begin) / 1e6;
+
+    for (const auto& seg : segments)
+        munmap(const_cast<std::uint8_t*>(seg.data), seg.size);
+
+    char target_str[INET_ADDRSTRLEN] {"all"};
+
+    if (options.target)
+        inet_ntop(AF_INET, &options.target, target_str, sizeof(target_str));
+
+    std::printf("target   %s\n", target_str);
+    std::printf("range    %s - %s\n",
+        (options.from_ms == INT64_MIN) ? "begin" : format_time(options.from_ms).c_str(),
+        (options.to_ms == INT64_MAX) ? "end" : format_time(options.to_ms).c_str()
+    );
+    std::printf("probes   %lu sent, %lu received, %.2f%% loss\n", r.count, r.received,
+        r.count ? 100.0 * (r.count - r.received) / r.count : 0.0
+    );
+
+    if (r.received) {
+        std::printf("rtt      min/avg/max = %.3f/%.3f/%.3f ms\n", r.min / 1e3,
+            static_cast<double>(r.sum) / r.received / 1e3, r.max / 1e3
+        );
+        std::printf("         p50/p90/p99/p99.9 = %.3f/%.3f/%.3f/%.3f ms\n",
+            r.rtt.percentile(0.5) / 1e3, r.rtt.percentile(0.9) / 1e3,
+            r.rtt.percentile(0.99) / 1e3, r.rtt.percentile(0.999) / 1e3
+        );
+    }
+
+    std::printf("scanned  %zu of %u segments, %lu rows in %.1f ms (%u threads)\n",
+        segments.size(), total, r.rows, elapsed, threads
+    );
+}
+
+template <typename T, typename R>
+static void scan(const mapped_segment& seg, std::uint32_t block,
+    const query_options& options, query_result& result) noexcept
+{
+    const auto& h = *seg.header;
+    auto times    = reinterpret_cast<const std::uint32_t*>(seg.data + h.time_offset);
+    auto targets  = reinterpret_cast<const T*>(seg.data + h.target_offset);
+    auto rtts     = reinterpret_cast<const R*>(seg.data + h.rtt_offset);
+
+    std::uint64_t begin = static_cast<std::uint64_t>(block) * h.block_rows;
+    std::uint64_t end   = std::min<std::uint64_t>(begin + h.block_rows, h.rows);
+
+    // time range relative to segment start, clamped to column range
+    auto from = std::clamp<std::int64_t>(
+        (options.from_ms == INT64_MIN) ? 0 : options.from_ms - h.start_ms, 0, UINT32_MAX
+    );
+    auto to = std::clamp<std::int64_t>(
+        (options.to_ms == INT64_MAX) ? INT64_MAX / 2 : options.to_ms - h.start_ms,
+        0, static_cast<std::int64_t>(UINT32_MAX) + 1
+    );
+
+    bool all    = seg.target < 0;
+    auto target = static_cast<T>(seg.target);
+    auto lost   = static_cast<R>(~R {0});
+
+    std::uint64_t count = 0, received = 0, sum = 0;
+    std::uint32_t min = result.min, max = result.max;
+
+    for (auto i = begin; i < end; i++) {
+        std::int64_t time = times[i];
+
+        if (time < from || time >= to || (!all && targets[i] != target))
+            continue;
+
+        count++;
+        auto rtt = rtts[i];
+
+        if (rtt == lost)
+            continue;
+
+        received++;
+        sum += rtt;
+        min  = std::min<std::uint32_t>(min, rtt);
+        max  = std::max<std::uint32_t>(max, rtt);
+        result.rtt.add(rtt);
+    }
+
+    result.rows     += end - begin;
+    result.count    += count;
+    result.received += received;
+    result.sum      += sum;
+    result.min       = min;
+    result.max       = max;
+}
+
+static void scan_block(const mapped_segment& seg, std::uint32_t block,
+    const query_options& options, query_result& result) noexcept
+{
+    bool short_rtt = seg.header->rtt_width == 2;
+
+    switch (seg.header->target_width) {
+    case 1:
+        if (short_rtt)
+            scan<std::uint8_t, std::uint16_t>(seg, block, options, result);
+        else
+            scan<std::uint8_t, std::uint32_t>(seg, block, options, result);
+        break;
+
+    case 2:
+        if (short_rtt)
+            scan<std::uint16_t, std::uint16_t>(seg, block, options, result);
+        else
+            scan<std::uint16_t, std::uint32_t>(seg, block, options, result);
+        break;
+
+    default:
+        if (short_rtt)
+            scan<std::uint32_t, std::uint16_t>(seg, block, options, result);
+        else
+            scan<std::uint32_t, std::uint32_t>(seg, block, options, result);
+        break;
+    }
+}
+
+static bool map_segment(const std::string& path, mapped_segment& seg) noexcept
+{
+    auto fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+
+    if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(segment_header)) {
+        ::close(fd);
+        return false;
+    }
+
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    seg.data   = static_cast<const std::uint8_t*>(data);
+    seg.size   = st.st_size;
+    seg.header = reinterpret_cast<const segment_header*>(data);
+
+    if (!valid_segment(*seg.header, seg.size)) {
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    return true;
+}
+
+static bool valid_segment(const segment_header& h, std::size_t size) noexcept
+{
+    if (std::memcmp(h.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 ||
+        h.version != SEGMENT_VERSION)
+        return false;
+
+    if ((h.target_width != 1 && h.target_width != 2 && h.target_width != 4) ||
+        (h.rtt_width != 2 && h.rtt_width != 4) || h.block_rows == 0)
+        return false;
+
+    // scan reads block_rows rows per index block, last one may be partial
+    std::uint64_t blocks = h.rows / h.block_rows + (h.rows % h.block_rows != 0);
+
+    if (h.blocks != blocks)
+        return false;
+
+    return column_fits(h.dict_offset, h.targets, sizeof(in_addr_t), size) &&
+        column_fits(h.index_offset, h.blocks, sizeof(segment_block), size) &&
+        column_fits(h.time_offset, h.rows, sizeof(std::uint32_t), size) &&
+        column_fits(h.target_offset, h.rows, h.target_width, size) &&
+        column_fits(h.rtt_offset, h.rows, h.rtt_width, size);
+}
+
+static bool column_fits(std::uint64_t offset, std::uint64_t count, std::uint64_t width,
+    std::size_t size) noexcept
+{
+    // columns are read in place, so their values must be aligned
+    if (offset < sizeof(segment_header) || offset > size || offset % width != 0)
+        return false;
+
+    return count <= (size - offset) / width;
+}
+
+static std::string format_time(std::int64_t time_ms) noexcept
+{
+    time_t seconds = time_ms / 1000;
+    tm local {};
+    localtime_r(&seconds, &local);
+
+    char str[32];
+    std::strftime(str, sizeof(str), "%Y-%m-%d %H:%M:%S", &local);
+
+    return str;
+}
+
+static std::uint64_t align64(std::uint64_t value) noexcept
+{
+    return (value + 63) & ~63ULL;
+}
+
+} // namespace ntool
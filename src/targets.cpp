@@ -0,0 +1,94 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/targets.hpp>
+#include <ntool/utils.hpp>
+#include <ntool/icmp.hpp>
+#include <algorithm>
+#include <cmath>
+
+
+namespace ntool {
+
+target_table::target_table(const std::vector<const char*>& names) noexcept
+    : m_stats(names.size())
+{
+    m_addrs.reserve(names.size());
+    m_names.reserve(names.size());
+
+    for (auto name : names) {
+        m_addrs.push_back(utils::get_ip_address(name));
+        m_names.push_back(m_arena.copy(name));
+    }
+}
+
+target_table::target_table(target_list&& list) noexcept
+    : m_stats(list.addrs.size()), m_addrs(std::move(list.addrs)),
+      m_names(std::move(list.names)), m_tags(std::move(list.tags)),
+      m_text(std::move(list.text)), m_hosts(std::move(list.generated))
+{}
+
+void target_table::update(const probe_result& result) noexcept
+{
+    ntool::update(m_stats[result.target], result);
+}
+
+std::size_t target_table::memory(void) const noexcept
+{
+    return m_stats.capacity() * sizeof(target_stats) +
+        m_addrs.capacity() * sizeof(in_addr_t) +
+        (m_names.capacity() + m_tags.capacity()) * sizeof(const char*) + m_arena.used() +
+        m_text.size() + m_hosts.size();
+}
+
+void update(target_stats& s, const probe_result& result) noexcept
+{
+    s.sent++;
+    s.last_seq = result.seq;
+
+    if (result.timeout)
+        return;
+
+    if (result.type != ICMP_ECHOREPLY) {
+        s.errors++;
+        return;
+    }
+
+    auto rtt = static_cast<float>((result.recv_ns - result.send_ns) / 1e6);
+
+    if (s.received++ == 0) {
+        s.rtt_min = rtt;
+        s.rtt_max = rtt;
+    }
+    else {
+        s.rtt_min = std::min(s.rtt_min, rtt);
+        s.rtt_max = std::max(s.rtt_max, rtt);
+    }
+
+    // Welford's algorithm (see utils::update())
+    auto delta  = rtt - s.rtt_mean;
+    s.rtt_mean += delta / s.received;
+    s.rtt_m2   += delta * (rtt - s.rtt_mean);
+}
+
+double stddev(const target_stats& stats) noexcept
+{
+    return stats.received ? std::sqrt(stats.rtt_m2 / stats.received) : 0.0;
+}
+
+} // namespace ntool
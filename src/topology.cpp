@@ -0,0 +1,426 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/resultlog.hpp>
+#include <ntool/topology.hpp>
+#include <ntool/output.hpp>
+#include <ntool/utils.hpp>
+#include <sys/stat.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <bit>
+
+
+namespace ntool {
+
+inline const std::uint64_t HASH_MULTIPLIER {0x9e3779b97f4a7c15ULL};
+inline const std::size_t   MIN_SLOTS       {16};
+
+/**
+ * @brief Get index size for given number of entries (half full at most).
+ *
+ * @param [in] count - given number of entries.
+ * @return number of slots (power of 2).
+ */
+static std::size_t slots_for(std::size_t count) noexcept;
+
+/**
+ * @brief Get home slot of key.
+ *
+ * @param [in] key - given key.
+ * @param [in] slots - given number of slots (power of 2).
+ * @return slot index.
+ */
+static std::size_t home_slot(std::uint64_t key, std::size_t slots) noexcept;
+
+
+topology::topology(void) noexcept
+{
+    reindex(0, 0);
+}
+
+void topology::begin(void) noexcept
+{
+    m_traces++;
+
+    for (auto& path : m_paths)
+        path.ttl = 0;
+}
+
+void topology::add(const probe_result& result) noexcept
+{
+    if (result.timeout || result.seq == 0)
+        return;
+
+    if (result.seq > m_paths.size())
+        m_paths.resize(result.seq, path_state {});
+
+    auto& path = m_paths[result.seq - 1];
+    auto to    = node(result.from);
+    auto rtt   = result.recv_ns - result.send_ns;
+
+    // only replies of consecutive hops are known to be adjacent
+    if (path.ttl && path.ttl + 1 == result.ttl && path.node != to) {
+        auto growth = (rtt > path.rtt_ns) ? (rtt - path.rtt_ns) / 1000 : 0;
+        auto us     = static_cast<std::uint32_t>(std::min<std::uint64_t>(growth, UINT32_MAX));
+        auto& e     = edge(path.node, to);
+
+        e.samples++;
+        e.sum_us += us;
+        e.min_us  = std::min(e.min_us, us);
+        e.max_us  = std::max(e.max_us, us);
+    }
+
+    path = {result.ttl, to, rtt};
+}
+
+void topology::prefetch(in_addr_t addr) const noexcept
+{
+    __builtin_prefetch(&m_node_slots[home_slot(addr, m_node_slots.size())]);
+}
+
+bool topology::merge_log(const char *path) noexcept
+{
+    log_reader reader;
+
+    if (!reader.open(path) || static_cast<record_kind>(reader.header().mode) != record_kind::trace)
+        return false;
+
+    auto records = reader.records();
+
+    for_each_trace_record(reader, [&](std::uint64_t i, const probe_result& result,
+        bool first) noexcept {
+        if (i + TOPOLOGY_PREFETCH < records.size())
+            prefetch(records[i + TOPOLOGY_PREFETCH].from);
+
+        if (first)
+            begin();
+
+        add(result);
+    });
+
+    return true;
+}
+
+bool topology::load(const char *path) noexcept
+{
+    auto file = std::fopen(path, "r");
+
+    if (!file)
+        return false;
+
+    struct stat st {};
+    topology_header header {};
+    bool valid = fstat(fileno(file), &st) == 0 &&
+        std::fread(&header, sizeof(header), 1, file) == 1 &&
+        std::memcmp(header.magic, TOPOLOGY_MAGIC, sizeof(TOPOLOGY_MAGIC)) == 0 &&
+        header.version == TOPOLOGY_VERSION && header.edge_size == sizeof(topology_edge);
+
+    // counts of corrupted header must not allocate more than file holds
+    if (valid) {
+        std::uint64_t size  = st.st_size;
+        std::uint64_t nodes = sizeof(header) + header.nodes * sizeof(in_addr_t) +
+            (header.nodes + 1ULL) * sizeof(std::uint64_t);
+
+        valid = nodes <= size && header.edges <= (size - nodes) / sizeof(topology_edge);
+    }
+
+    std::vector<in_addr_t> addrs;
+    std::vector<std::uint64_t> offsets;
+    std::vector<topology_edge> edges;
+
+    if (valid) {
+        addrs.resize(header.nodes);
+        offsets.resize(header.nodes + 1);
+        edges.resize(header.edges);
+
+        valid = std::fread(addrs.data(), sizeof(in_addr_t), addrs.size(), file) == addrs.size() &&
+            std::fread(offsets.data(), sizeof(std::uint64_t), offsets.size(), file) == offsets.size() &&
+            std::fread(edges.data(), sizeof(topology_edge), edges.size(), file) == edges.size();
+    }
+
+    std::fclose(file);
+
+    for (std::size_t i = 0; valid && i < edges.size(); i++)
+        valid = edges[i].from < header.nodes && edges[i].to < header.nodes;
+
+    if (!valid)
+        return false;
+
+    m_addrs  = std::move(addrs);
+    m_edges  = std::move(edges);
+    m_traces = header.traces;
+
+    m_paths.clear();
+    m_node_slots.clear();
+    m_edge_slots.clear();
+    reindex(m_addrs.size(), m_edges.size());
+
+    return true;
+}
+
+void topology::save(const char *path) const noexcept
+{
+    // CSR order: edges grouped by source node
+    auto edges = m_edges;
+
+    std::sort(edges.begin(), edges.end(), [](const auto& a, const auto& b) {
+        return a.from < b.from || (a.from == b.from && a.to < b.to);
+    });
+
+    std::vector<std::uint64_t> offsets(m_addrs.size() + 1, 0);
+
+    for (const auto& e : edges)
+        offsets[e.from + 1]++;
+
+    for (std::size_t i = 1; i < offsets.size(); i++)
+        offsets[i] += offsets[i - 1];
+
+    topology_header header {};
+    std::memcpy(header.magic, TOPOLOGY_MAGIC, sizeof(TOPOLOGY_MAGIC));
+    header.version   = TOPOLOGY_VERSION;
+    header.edge_size = sizeof(topology_edge);
+    header.nodes     = m_addrs.size();
+    header.edges     = edges.size();
+    header.traces    = m_traces;
+
+    auto out = std::fopen(path, "w");
+
+    if (!out)
+        utils::error("ntool: topology: cannot open snapshot file");
+
+    bool written = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+        std::fwrite(m_addrs.data(), sizeof(in_addr_t), m_addrs.size(), out) == m_addrs.size() &&
+        std::fwrite(offsets.data(), sizeof(std::uint64_t), offsets.size(), out) == offsets.size() &&
+        std::fwrite(edges.data(), sizeof(topology_edge), edges.size(), out) == edges.size();
+
+    if (std::fclose(out) != 0 || !written)
+        utils::error("ntool: topology: cannot write snapshot");
+}
+
+void topology::write_dot(const char *path, const asn_db *asn) const noexcept
+{
+    auto out = path ? std::fopen(path, "w") : stdout;
+
+    if (!out)
+        utils::error("ntool: topology: cannot open DOT file");
+
+    static char buffer[OUTPUT_BUFFER_SIZE];
+    char *p = format_str(buffer, "digraph topology {\n    node [shape=box];\n");
+
+    auto flush = [&p, out]() noexcept {
+        // flush before buffer could overflow with next line
+        if (p - buffer > static_cast<std::ptrdiff_t>(sizeof(buffer) - 256)) {
+            std::fwrite(buffer, 1, p - buffer, out);
+            p = buffer;
+        }
+    };
+
+    for (std::uint32_t i = 0; i < m_addrs.size(); i++) {
+        p = format_str(p, "    n");
+        p = format_u64(p, i);
+        p = format_str(p, " [label=\"");
+        p = format_ip(p, m_addrs[i]);
+
+        auto origin = asn ? asn->lookup(m_addrs[i]) : ASN_UNKNOWN;
+
+        if (origin != ASN_UNKNOWN) {
+            p = format_str(p, "\\nAS");
+            p = format_u64(p, origin);
+        }
+
+        p = format_str(p, "\"];\n");
+        flush();
+    }
+
+    // edge label is mean RTT growth & number of queries which crossed it
+    for (const auto& e : m_edges) {
+        p = format_str(p, "    n");
+        p = format_u64(p, e.from);
+        p = format_str(p, " -> n");
+        p = format_u64(p, e.to);
+        p = format_str(p, " [label=\"");
+        p = format_fixed(p, e.sum_us / e.samples, 3);
+        p = format_str(p, " ms (");
+        p = format_u64(p, e.samples);
+        p = format_str(p, ")\"];\n");
+        flush();
+    }
+
+    p = format_str(p, "}\n");
+    std::fwrite(buffer, 1, p - buffer, out);
+
+    if (out != stdout && std::fclose(out) != 0)
+        utils::error("ntool: topology: cannot write DOT file");
+}
+
+in_addr_t topology::address(std::uint32_t node) const noexcept
+{
+    return m_addrs[node];
+}
+
+const std::vector<topology_edge>& topology::edges(void) const noexcept
+{
+    return m_edges;
+}
+
+std::uint32_t topology::nodes(void) const noexcept
+{
+    return m_addrs.size();
+}
+
+std::uint64_t topology::traces(void) const noexcept
+{
+    return m_traces;
+}
+
+std::uint32_t topology::node(in_addr_t addr) noexcept
+{
+    if (m_recent_node < m_addrs.size() && m_addrs[m_recent_node] == addr)
+        return m_recent_node;
+
+    if ((m_addrs.size() + 1) * 2 > m_node_slots.size())
+        reindex(m_addrs.size() + 1, m_edges.size());
+
+    auto mask = m_node_slots.size() - 1;
+
+    for (auto i = home_slot(addr, m_node_slots.size());; i = (i + 1) & mask) {
+        auto& slot = m_node_slots[i];
+
+        if (slot.node && slot.addr == addr)
+            return m_recent_node = slot.node - 1;
+
+        if (!slot.node) {
+            m_addrs.push_back(addr);
+            slot = {addr, static_cast<std::uint32_t>(m_addrs.size())};
+            return m_recent_node = slot.node - 1;
+        }
+    }
+}
+
+topology_edge& topology::edge(std::uint32_t from, std::uint32_t to) noexcept
+{
+    if (m_recent_edge < m_edges.size() && m_edges[m_recent_edge].from == from &&
+        m_edges[m_recent_edge].to == to)
+        return m_edges[m_recent_edge];
+
+    if ((m_edges.size() + 1) * 2 > m_edge_slots.size())
+        reindex(m_addrs.size(), m_edges.size() + 1);
+
+    auto mask = m_edge_slots.size() - 1;
+    auto key  = (std::uint64_t(from) << 32) | to;
+
+    for (auto i = home_slot(key, m_edge_slots.size());; i = (i + 1) & mask) {
+        auto& slot = m_edge_slots[i];
+
+        if (slot.edge && slot.from == from && slot.to == to) {
+            m_recent_edge = slot.edge - 1;
+            return m_edges[m_recent_edge];
+        }
+
+        if (!slot.edge) {
+            m_edges.push_back({from, to, UINT32_MAX, 0, 0, 0});
+            slot          = {from, to, static_cast<std::uint32_t>(m_edges.size())};
+            m_recent_edge = slot.edge - 1;
+            return m_edges.back();
+        }
+    }
+}
+
+void topology::reindex(std::size_t nodes, std::size_t edges) noexcept
+{
+    // indexes double when they get half full, entries are inserted again
+    if (slots_for(nodes) != m_node_slots.size()) {
+        m_node_slots.assign(slots_for(nodes), node_slot {});
+        auto mask = m_node_slots.size() - 1;
+
+        for (std::uint32_t n = 0; n < m_addrs.size(); n++) {
+            auto i = home_slot(m_addrs[n], m_node_slots.size());
+
+            while (m_node_slots[i].node)
+                i = (i + 1) & mask;
+
+            m_node_slots[i] = {m_addrs[n], n + 1};
+        }
+    }
+
+    if (slots_for(edges) != m_edge_slots.size()) {
+        m_edge_slots.assign(slots_for(edges), edge_slot {});
+        auto mask = m_edge_slots.size() - 1;
+
+        for (std::uint32_t e = 0; e < m_edges.size(); e++) {
+            const auto& edge = m_edges[e];
+            auto key         = (std::uint64_t(edge.from) << 32) | edge.to;
+            auto i           = home_slot(key, m_edge_slots.size());
+
+            while (m_edge_slots[i].edge)
+                i = (i + 1) & mask;
+
+            m_edge_slots[i] = {edge.from, edge.to, e + 1};
+        }
+    }
+}
+
+void topology_restore(topology& graph, const topology_options& options) noexcept
+{
+    if (access(options.snapshot, F_OK) == 0 && !graph.load(options.snapshot))
+        utils::error("ntool: topology: not a topology snapshot or cannot be read");
+}
+
+void topology_export(const topology& graph, const topology_options& options) noexcept
+{
+    graph.save(options.snapshot);
+
+    if (options.dot)
+        graph.write_dot(options.dot, options.asn);
+}
+
+void merge_topology(const std::vector<const char*>& logs, const topology_options& options) noexcept
+{
+    topology graph;
+    topology_restore(graph, options);
+
+    auto begin  = utils::clock_ns();
+    auto traces = graph.traces();
+
+    for (auto path : logs) {
+        if (!graph.merge_log(path))
+            utils::error("ntool: topology: not a trace result log or cannot be read");
+    }
+
+    std::printf("Merged %lu traces of %zu logs in %.3f s: %u nodes, %zu edges (%lu traces total)\n",
+        graph.traces() - traces, logs.size(), (utils::clock_ns() - begin) / 1e9,
+        graph.nodes(), graph.edges().size(), graph.traces()
+    );
+
+    topology_export(graph, options);
+}
+
+static std::size_t slots_for(std::size_t count) noexcept
+{
+    return std::bit_ceil(std::max(count * 2, MIN_SLOTS));
+}
+
+static std::size_t home_slot(std::uint64_t key, std::size_t slots) noexcept
+{
+    return (key * HASH_MULTIPLIER) >> (64 - std::countr_zero(slots));
+}
+
+} // namespace ntool
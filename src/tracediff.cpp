@@ -0,0 +1,473 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/tracediff.hpp>
+#include <ntool/resultlog.hpp>
+#include <ntool/output.hpp>
+#include <ntool/utils.hpp>
+#include <unordered_map>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <vector>
+#include <mutex>
+#include <tuple>
+
+
+namespace ntool {
+
+/** Trace of destination in set of logs.*/
+struct trace_entry {
+    in_addr_t     target;       // destination
+    std::uint32_t file;         // log index in set
+    std::uint64_t fingerprint;  // path fingerprint
+    std::uint64_t time_ns;      // first probe send time (CLOCK_REALTIME)
+    std::uint64_t first;        // first record index
+    std::uint64_t records;      // number of records
+};
+
+/** Mapped result logs & their latest trace per destination.*/
+struct trace_set {
+    std::vector<std::string>                 paths;
+    std::vector<std::unique_ptr<log_reader>> logs;
+    std::vector<trace_entry>                 entries;   // sorted by destination
+    std::uint64_t                            traces  {0};
+    std::uint64_t                            skipped {0};   // not trace logs
+};
+
+/** Divergence of paths: router before run & first routers of run.*/
+struct change_key {
+    in_addr_t last;     // last router before run (0 - source or anonymous)
+    in_addr_t before;   // first old router of run (0 - none)
+    in_addr_t after;    // first new router of run (0 - none)
+
+    auto operator<=>(const change_key&) const noexcept = default;
+};
+
+/** Changed destination.*/
+struct changed_trace {
+    const trace_entry       *before;
+    const trace_entry       *after;
+    std::string             line;       // printed change
+    std::vector<change_key> keys;
+};
+
+/**
+ * @brief Map result logs & reduce their traces to fingerprints.
+ *
+ * @param [in] path - given result log or directory of result logs.
+ * @param [in] threads - given max number of threads.
+ * @param [out] set - given object to store logs & latest traces.
+ */
+static void scan_set(const char *path, std::uint32_t threads, trace_set& set) noexcept;
+
+/**
+ * @brief Rebuild route of trace from its records.
+ *
+ * @param [in] set - given set of logs.
+ * @param [in] entry - given trace.
+ * @param [out] r - given object to store route.
+ */
+static void load_route(const trace_set& set, const trace_entry& entry, route& r) noexcept;
+
+/**
+ * @brief Keep trace if it is later than kept trace of its destination.
+ *
+ * @param [in,out] latest - given latest trace per destination.
+ * @param [in] entry - given trace.
+ */
+static void keep_latest(std::unordered_map<in_addr_t, trace_entry>& latest,
+    const trace_entry& entry) noexcept;
+
+/**
+ * @brief Check whether hops match.
+ *
+ * @param [in] a - given routers of hop.
+ * @param [in] b - given routers of hop.
+ * @return true if either hop is anonymous or hops share router.
+ */
+static bool same_hop(const in_addr_t *a, const in_addr_t *b) noexcept;
+
+/**
+ * @brief Write first routers of run of hops.
+ *
+ * @param [out] p - given output position.
+ * @param [in] r - given route.
+ * @param [in] hop - given first hop (from 1).
+ * @param [in] count - given number of hops.
+ * @return position after written characters.
+ */
+static char *format_hops(char *p, const route& r, std::uint8_t hop, std::uint8_t count) noexcept;
+
+
+std::size_t align_routes(const route& before, const route& after, hop_change *changes) noexcept
+{
+    const auto n = before.length, m = after.length;
+
+    // lcs[i][j] - longest common subsequence of hops from i & j onwards
+    std::uint8_t lcs[ROUTE_MAX_HOPS + 1][ROUTE_MAX_HOPS + 1];
+
+    for (std::int32_t i = n; i >= 0; i--) {
+        for (std::int32_t j = m; j >= 0; j--) {
+            if (i == n || j == m)
+                lcs[i][j] = 0;
+            else if (same_hop(before.hops[i], after.hops[j]))
+                lcs[i][j] = lcs[i + 1][j + 1] + 1;
+            else
+                lcs[i][j] = std::max(lcs[i + 1][j], lcs[i][j + 1]);
+        }
+    }
+
+    std::size_t count = 0;
+    std::uint8_t i = 0, j = 0;
+    hop_change *run = nullptr;  // current run of differing hops
+
+    while (i < n || j < m) {
+        if (i < n && j < m && same_hop(before.hops[i], after.hops[j]) &&
+            lcs[i][j] == lcs[i + 1][j + 1] + 1) {
+            run = nullptr;
+            i++;
+            j++;
+            continue;
+        }
+
+        if (!run) {
+            run  = &changes[count++];
+            *run = {static_cast<std::uint8_t>(i + 1), 0, static_cast<std::uint8_t>(j + 1), 0};
+        }
+
+        if (j == m || (i < n && lcs[i + 1][j] >= lcs[i][j + 1])) {
+            run->old_count++;
+            i++;
+        }
+        else {
+            run->new_count++;
+            j++;
+        }
+    }
+
+    return count;
+}
+
+void trace_diff(const char *before, const char *after, const trace_diff_options& options) noexcept
+{
+    auto begin   = utils::clock_ns();
+    auto threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+
+    trace_set old_set, new_set;
+    scan_set(before, threads, old_set);
+    scan_set(after, threads, new_set);
+
+    // join latest traces of destinations, both sets are sorted
+    std::vector<changed_trace> changed;
+    std::uint64_t same = 0, removed = 0, added = 0;
+
+    auto a = old_set.entries.begin(), a_end = old_set.entries.end();
+    auto b = new_set.entries.begin(), b_end = new_set.entries.end();
+
+    while (a != a_end || b != b_end) {
+        if (b == b_end || (a != a_end && ntohl(a->target) < ntohl(b->target))) {
+            removed++;
+            a++;
+        }
+        else if (a == a_end || ntohl(b->target) < ntohl(a->target)) {
+            added++;
+            b++;
+        }
+        else {
+            if (a->fingerprint == b->fingerprint)
+                same++;
+            else
+                changed.push_back({&*a, &*b, {}, {}});
+
+            a++;
+            b++;
+        }
+    }
+
+    // only changed paths are rebuilt from records & aligned
+    utils::parallel_for(changed.size(), threads, [&](std::size_t i) noexcept {
+        auto& c = changed[i];
+        route old_route {}, new_route {};
+        hop_change runs[ROUTE_MAX_HOPS + 1];
+
+        load_route(old_set, *c.before, old_route);
+        load_route(new_set, *c.after, new_route);
+
+        auto count = align_routes(old_route, new_route, runs);
+
+        if (!count)
+            return;
+
+        char buffer[4096];
+        char *p = format_ip(buffer, c.before->target);
+        *p++    = ':';
+
+        for (std::size_t r = 0; r < count; r++) {
+            const auto& run = runs[r];
+
+            p = format_str(p, " hop ");
+            p = format_u64(p, run.old_hop);
+            p = format_hops(p, old_route, run.old_hop, run.old_count);
+            p = format_str(p, " ->");
+            p = format_hops(p, new_route, run.new_hop, run.new_count);
+            *p++ = ';';
+
+            auto prev = (run.old_hop > 1) ? old_route.hops[run.old_hop - 2][0] : 0;
+            auto from = run.old_count ? old_route.hops[run.old_hop - 1][0] : 0;
+            auto to   = run.new_count ? new_route.hops[run.new_hop - 1][0] : 0;
+            c.keys.push_back({prev, from, to});
+        }
+
+        p = format_str(p, " ");
+        p = format_u64(p, old_route.length);
+        p = format_str(p, " -> ");
+        p = format_u64(p, new_route.length);
+        p = format_str(p, " hops");
+
+        c.line.assign(buffer, p);
+    });
+
+    std::uint64_t anonymous = 0;
+    std::vector<change_key> keys;
+
+    for (const auto& c : changed) {
+        if (c.line.empty()) {
+            anonymous++;
+            continue;
+        }
+
+        if (!options.quiet)
+            std::printf("%s\n", c.line.c_str());
+
+        keys.insert(keys.end(), c.keys.begin(), c.keys.end());
+    }
+
+    std::printf("\n--- trace diff ---\n");
+    std::printf("before   %lu traces, %zu destinations in %zu logs\n", old_set.traces,
+        old_set.entries.size(), old_set.logs.size() - old_set.skipped
+    );
+    std::printf("after    %lu traces, %zu destinations in %zu logs\n", new_set.traces,
+        new_set.entries.size(), new_set.logs.size() - new_set.skipped
+    );
+    std::printf("paths    %lu same, %lu changed, %lu differ in anonymous hops only, "
+        "%lu only before, %lu only after\n", same, changed.size() - anonymous, anonymous,
+        removed, added
+    );
+
+    if (old_set.skipped || new_set.skipped) {
+        std::printf("skipped  %lu files which are not trace result logs\n",
+            old_set.skipped + new_set.skipped
+        );
+    }
+
+    std::printf("compared in %.1f ms (%u threads)\n", (utils::clock_ns() - begin) / 1e6, threads);
+
+    if (keys.empty())
+        return;
+
+    // changes are aggregated by point where paths diverge
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::pair<std::uint64_t, change_key>> counts;
+
+    for (std::size_t i = 0; i < keys.size();) {
+        auto j = i;
+
+        while (j < keys.size() && keys[j] == keys[i])
+            j++;
+
+        counts.push_back({j - i, keys[i]});
+        i = j;
+    }
+
+    std::stable_sort(counts.begin(), counts.end(), [](const auto& x, const auto& y) {
+        return x.first > y.first;
+    });
+
+    std::printf("\n--- changes by hop ---\n");
+    std::printf("%10s  %-16s %-16s    %s\n", "paths", "after", "before", "now");
+
+    for (std::size_t i = 0; i < std::min<std::size_t>(counts.size(), options.top); i++) {
+        const auto& [count, key] = counts[i];
+        char last[INET_ADDRSTRLEN] = "*", from[INET_ADDRSTRLEN] = "-", to[INET_ADDRSTRLEN] = "-";
+
+        if (key.last)
+            inet_ntop(AF_INET, &key.last, last, sizeof(last));
+
+        if (key.before)
+            inet_ntop(AF_INET, &key.before, from, sizeof(from));
+
+        if (key.after)
+            inet_ntop(AF_INET, &key.after, to, sizeof(to));
+
+        std::printf("%10lu  %-16s %-16s -> %s\n", count, last, from, to);
+    }
+}
+
+static void scan_set(const char *path, std::uint32_t threads, trace_set& set) noexcept
+{
+    struct stat st {};
+
+    if (stat(path, &st) == -1)
+        utils::error("ntool: trace diff: cannot open result log or directory");
+
+    if (S_ISDIR(st.st_mode)) {
+        auto d = opendir(path);
+
+        if (!d)
+            utils::error("ntool: trace diff: cannot open result log directory");
+
+        while (auto entry = readdir(d)) {
+            if (entry->d_name[0] != '.')
+                set.paths.push_back(std::string(path) + "/" + entry->d_name);
+        }
+
+        closedir(d);
+        std::sort(set.paths.begin(), set.paths.end());
+    }
+    else
+        set.paths.push_back(path);
+
+    set.logs.resize(set.paths.size());
+
+    // latest trace per destination, logs are merged into it as they finish
+    std::unordered_map<in_addr_t, trace_entry> latest;
+    std::mutex latest_lock;
+
+    // logs are reduced to fingerprints independently
+    utils::parallel_for(set.paths.size(), threads, [&](std::size_t i) noexcept {
+        auto log = std::make_unique<log_reader>();
+
+        if (!log->open(set.paths[i].c_str()) ||
+            static_cast<record_kind>(log->header().mode) != record_kind::trace)
+            return;
+
+        const auto& header = log->header();
+        auto targets       = log->targets();
+        auto records       = log->records();
+
+        std::unordered_map<in_addr_t, trace_entry> out;
+        std::uint64_t traces = 0;
+
+        route r {};
+        trace_entry entry {};
+        bool started = false;
+
+        auto finish = [&](std::uint64_t end) noexcept {
+            route_finish(r);
+            entry.fingerprint = r.fingerprint;
+            entry.records     = end - entry.first;
+            keep_latest(out, entry);
+            traces++;
+        };
+
+        for_each_trace_record(*log, [&](std::uint64_t j, const probe_result& result,
+            bool first) noexcept {
+            auto target = targets[result.target];
+
+            if (first) {
+                if (started)
+                    finish(j);
+
+                r       = {};
+                entry   = {target, static_cast<std::uint32_t>(i), 0,
+                    le(header.created_ns) + result.send_ns - le(header.clock_ns), j, 0};
+                started = true;
+            }
+
+            route_add(r, result, target);
+        });
+
+        if (started)
+            finish(records.size());
+
+        set.logs[i] = std::move(log);
+
+        std::lock_guard<std::mutex> guard(latest_lock);
+        set.traces += traces;
+
+        for (const auto& [target, e] : out)
+            keep_latest(latest, e);
+    });
+
+    for (const auto& log : set.logs) {
+        if (!log)
+            set.skipped++;
+    }
+
+    set.entries.reserve(latest.size());
+
+    for (const auto& [target, entry] : latest)
+        set.entries.push_back(entry);
+
+    std::sort(set.entries.begin(), set.entries.end(), [](const auto& a, const auto& b) {
+        return ntohl(a.target) < ntohl(b.target);
+    });
+}
+
+static void keep_latest(std::unordered_map<in_addr_t, trace_entry>& latest,
+    const trace_entry& entry) noexcept
+{
+    auto [it, added] = latest.try_emplace(entry.target, entry);
+    const auto& kept = it->second;
+
+    // equal times are ordered by log & position in it, as logs are sorted
+    if (!added && std::tie(kept.time_ns, kept.file, kept.first) <
+        std::tie(entry.time_ns, entry.file, entry.first))
+        it->second = entry;
+}
+
+static void load_route(const trace_set& set, const trace_entry& entry, route& r) noexcept
+{
+    auto records = set.logs[entry.file]->records();
+
+    for (auto i = entry.first; i < entry.first + entry.records; i++)
+        route_add(r, to_result(records[i]), entry.target);
+
+    route_finish(r);
+}
+
+static bool same_hop(const in_addr_t *a, const in_addr_t *b) noexcept
+{
+    if (!a[0] || !b[0])
+        return true;
+
+    return std::any_of(b, b + ROUTE_WIDTH, [a](auto addr) {
+        return addr && std::find(a, a + ROUTE_WIDTH, addr) != a + ROUTE_WIDTH;
+    });
+}
+
+static char *format_hops(char *p, const route& r, std::uint8_t hop, std::uint8_t count) noexcept
+{
+    if (!count)
+        return format_str(p, " -");
+
+    for (std::uint8_t i = 0; i < count; i++) {
+        auto addr = r.hops[hop - 1 + i][0];
+        *p++      = ' ';
+        p         = addr ? format_ip(p, addr) : format_str(p, "*");
+    }
+
+    return p;
+}
+
+} // namespace ntool
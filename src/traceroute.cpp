@@ -17,16 +17,18 @@
  */
 
 #include <ntool/traceroute.hpp>
+#include <ntool/output.hpp>
+#include <ntool/engine.hpp>
 #include <ntool/utils.hpp>
 #include <ntool/icmp.hpp>
+#include <ntool/asn.hpp>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <sys/time.h>
-#include <unistd.h>
-#include <cstring>
+#include <algorithm>
 #include <csignal>
 #include <netdb.h>
+#include <vector>
 
 
 namespace ntool {
@@ -40,21 +42,27 @@ namespace ntool {
 addrinfo *init(const char *target) noexcept;
 
 /**
- * @brief Calculate round trip time.
+ * @brief Handle probe outcome.
  *
- * @param [in] begin - given begin time.
- * @param [in] end - given end time.
- * @return round trip time in milliseconds.
+ * @param [in] result - given probe outcome.
+ * @param [in] ctx - given user context.
  */
-inline std::uint32_t rtt(const timeval& begin, const timeval& end) noexcept;
+static void handle_result(const probe_result& result, void *ctx) noexcept;
 
 /**
- * @brief Print router info.
+ * @brief Output hop with all queries resolved.
  *
- * @param [in] addr - given router address structure.
- * @param [in] size - given router address size.
+ * @param [in] hop - given hop number (from 1).
+ * @return true if destination was reached at this hop.
  */
-inline void print_entry(const sockaddr_in& addr, std::size_t size) noexcept;
+static bool print_hop(std::uint32_t hop) noexcept;
+
+/**
+ * @brief Print origin ASes of printed hops, repeated & unknown ones omitted.
+ *
+ * @param [in] db - given IP to origin AS database.
+ */
+static void print_as_path(const asn_db& db) noexcept;
 
 /**
  * @brief Handle keyboard interrupt.
@@ -63,12 +71,23 @@ inline void print_entry(const sockaddr_in& addr, std::size_t size) noexcept;
  */
 static void sigint_handler(int sig) noexcept;
 
-inline const std::uint8_t MAX_HOPS      {30};
-inline const std::uint8_t MAX_QUERIES   {3};
+inline const std::uint8_t  MAX_HOPS       {30};
+inline const std::uint8_t  MAX_QUERIES    {3};
+inline const std::uint64_t TRACE_INTERVAL {50000000};      // between queries
+inline const std::uint64_t TRACE_TIMEOUT  {1000000000};    // reply waiting
 
 static std::int32_t max_hops    {MAX_HOPS};
 static std::int32_t max_queries {MAX_QUERIES};
-static std::int32_t sockfd      {0};
+
+static std::vector<probe_result>  results;     // hop-major probe outcomes
+static std::vector<std::int32_t>  resolved;    // resolved queries per hop
+static std::int32_t  next_hop  {1};            // next hop to print
+static std::int32_t  last_hop  {0};            // last printed hop
+static const asn_db  *asn      {nullptr};      // router annotation
+static in_addr_t     dest_addr {0};
+static engine        *tracer   {nullptr};
+static output_writer *writer   {nullptr};
+static std::FILE     *info     {stdout};       // banner stream
 
 
 addrinfo *init(const char *target) noexcept
@@ -84,11 +103,6 @@ addrinfo *init(const char *target) noexcept
         std::exit(EXIT_FAILURE);
     }
 
-    sockfd = socket(hints.ai_family, hints.ai_socktype, IPPROTO_ICMP);
-
-    if (sockfd < 0)
-        utils::error("ntool: traceroute: raw socket creation error");
-
     // Convert the IP to a string and print it
     char ip_str[INET_ADDRSTRLEN];
 
@@ -97,7 +111,7 @@ addrinfo *init(const char *target) noexcept
 
     inet_ntop(result->ai_family, addr, ip_str, sizeof(ip_str));
 
-    std::printf("traceroute to %s (%s), %u hops max, %d byte packets\n",
+    std::fprintf(info, "traceroute to %s (%s), %u hops max, %d byte packets\n",
         target, ip_str, max_hops, ICMP_PACKET_SIZE
     );
 
@@ -106,139 +120,142 @@ addrinfo *init(const char *target) noexcept
     return result;
 }
 
-void traceroute(const char *target, std::int32_t h, std::int32_t q) noexcept
+void traceroute(const char *target, std::int32_t h, std::int32_t q,
+    const output_options& output, bool stats, topology *graph) noexcept
 {
-    std::uint8_t reply[ICMP_PACKET_SIZE]    {};
-    std::uint8_t packet[ICMP_PACKET_SIZE]   {};
-
-    timeval     timeout, begin_time, end_time;
-    sockaddr_in router_addr, prev_addr;
-    socklen_t   addr_len = sizeof(router_addr);
-    fd_set      readfds {};
-
     if (h == 0)
         h = MAX_HOPS;
 
     if (q == 0)
         q = MAX_QUERIES;
 
-    max_hops    = h;
+    max_hops    = std::min(h, 255);
     max_queries = q;
 
+    // keep structured stdout free of human readable lines
+    info = (output.format == output_format::human || output.path) ? stdout : stderr;
+
     addrinfo *result = init(target);
+    dest_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(result);
 
-    // set request ICMP header
-    auto request        = reinterpret_cast<icmphdr*>(packet);
-    request->type       = ICMP_ECHO;
-    request->code       = 0;
-    request->un.echo.id = getpid();
+    results.assign(max_hops * max_queries, probe_result {});
+    resolved.assign(max_hops, 0);
+    next_hop = 1;
+    last_hop = 0;
+    asn      = output.asn;
 
-    bool reached = false;
-    auto dest_ip = reinterpret_cast<sockaddr_in*>(result->ai_addr);
+    // every query sends probes with TTL 1..max_hops at once
+    engine_config config;
+    config.count       = max_queries;
+    config.hops        = max_hops;
+    config.interval_ns = TRACE_INTERVAL;
+    config.timeout_ns  = TRACE_TIMEOUT;
+    config.instrument  = stats;
 
-    std::int32_t activity {0};
+    raw_transport io;
+    engine e(io, config, handle_result, nullptr);
+    e.add_target(dest_addr);
 
-    for (std::uint8_t ttl = 1; ttl <= max_hops; ttl++) {
-        // set packet time to live (TTL)
-        if (setsockopt(sockfd, IPPROTO_IP, IP_TTL, &ttl, sizeof(ttl)) == -1)
-            utils::error("ntool: traceroute: error to set TTL");
+    output_writer out(output, record_kind::trace, {dest_addr});
 
-        if (reached)
-            break;
+    tracer = &e;
+    writer = &out;
+    e.run();
+    out.close();
 
-        std::printf(" %2u ", ttl);
+    if (asn)
+        print_as_path(*asn);
 
-        // send several probe packets
-        for (std::uint16_t seq = 1; seq <= max_queries; seq++) {
-            // update ICMP header
-            request->un.echo.sequence = seq;
-            request->checksum         = 0;
-            request->checksum         = checksum(packet, ICMP_PACKET_SIZE);
+    if (graph) {
+        graph->begin();
 
-            // sending packet
-            if (sendto(sockfd, packet, ICMP_PACKET_SIZE, 0,
-                result->ai_addr, result->ai_addrlen) < 0)
-                utils::error("ntool: traceroute: error to send ICMP packet");
+        for (std::int32_t i = 0; i < last_hop * max_queries; i++)
+            graph->add(results[i]);
+    }
 
-            gettimeofday(&begin_time, nullptr);
+    print_engine_stats(info, e);
 
-            FD_ZERO(&readfds);
-            FD_SET(sockfd, &readfds);
+    tracer = nullptr;
+    writer = nullptr;
+}
 
-            timeout.tv_sec  = 1;
-            timeout.tv_usec = 0;
-            activity        = select(sockfd + 1, &readfds, 0, 0, &timeout);
+static void handle_result(const probe_result& result, void *) noexcept
+{
+    auto hop = result.ttl - 1;
 
-            if (activity > 0) {
-                if(recvfrom(sockfd, reply, ICMP_PACKET_SIZE, 0,
-                    std::bit_cast<sockaddr*>(&router_addr), &addr_len) < 0) {
-                    utils::error("ntool: traceroute: error to receive reply");
-                }
+    results[hop * max_queries + result.seq - 1] = result;
+    resolved[hop]++;
 
-                gettimeofday(&end_time, nullptr);
+    // print hops in order as soon as all their queries are resolved
+    while (next_hop <= max_hops && resolved[next_hop - 1] == max_queries) {
+        if (print_hop(next_hop)) {
+            tracer->stop();
+            next_hop = max_hops + 1;
+            break;
+        }
+        next_hop++;
+    }
+}
 
-                if (seq == 1) {
-                    // handle case when previous & current
-                    // router addresses are equal
-                    auto& r_addr = router_addr.sin_addr.s_addr;
-                    auto& p_addr = prev_addr.sin_addr.s_addr;
+static bool print_hop(std::uint32_t hop) noexcept
+{
+    const auto *queries = &results[(hop - 1) * max_queries];
+    bool reached        = false;
+    last_hop            = hop;
 
-                    if (r_addr == p_addr) {
-                        reached = true;
-                        break;
-                    }
+    // router names are resolved by writer thread, off the probe path
+    for (std::int32_t i = 0; i < max_queries; i++) {
+        const auto& r = queries[i];
 
-                    print_entry(router_addr, sizeof(router_addr));
-                }
+        output_record record {r, dest_addr, record_kind::trace, i + 1 == max_queries, false};
 
-                std::printf(" %u ms", rtt(begin_time, end_time));
+        if (asn && !r.timeout)
+            record.asn = asn->lookup(r.from);
 
-                // finish traceroute when destination IP was reached
-                if (router_addr.sin_addr.s_addr == dest_ip->sin_addr.s_addr)
-                    reached = true;
+        writer->push(record);
 
-                prev_addr = router_addr;
-            }
-            else {
-                for (std::uint16_t i = seq; i <= max_queries; i++) {
-                    std::putchar(' ');
-                    std::putchar('*');
-                }
-                break;
-            }
-        }
-        std::putchar('\n');
+        // finish traceroute when destination IP was reached
+        if (!r.timeout && (r.from == dest_addr || r.type == ICMP_DEST_UNREACH))
+            reached = true;
     }
 
-    freeaddrinfo(result);
-    close(sockfd);
+    return reached;
 }
 
-inline std::uint32_t rtt(const timeval& begin, const timeval& end) noexcept
+static void print_as_path(const asn_db& db) noexcept
 {
-    auto sec      = (end.tv_sec - begin.tv_sec);
-    auto microsec = (end.tv_usec - begin.tv_usec);
+    std::uint32_t prev = ASN_UNKNOWN;
+    bool known         = false;
 
-    return (sec * 1000) + (microsec / 1000);
-}
+    std::fputs("AS path:", info);
 
-inline void print_entry(const sockaddr_in& addr, std::size_t size) noexcept
-{
-    // Get the hostname
-    static char hostname[NI_MAXHOST];
+    for (std::int32_t hop = 0; hop < last_hop; hop++) {
+        const auto *queries = &results[hop * max_queries];
+
+        // hop belongs to origin AS of first router that replied
+        for (std::int32_t i = 0; i < max_queries; i++) {
+            if (queries[i].timeout)
+                continue;
+
+            auto origin = db.lookup(queries[i].from);
 
-    if (getnameinfo(std::bit_cast<sockaddr*>(&addr), size, hostname,
-        sizeof(hostname), 0, 0, 0) != 0) {
-        utils::error("ntool: traceroute: get hostname error");
+            if (origin != ASN_UNKNOWN && origin != prev) {
+                std::fprintf(info, " AS%u", origin);
+                prev  = origin;
+                known = true;
+            }
+            break;
+        }
     }
 
-    std::printf(" %s (%s) ", hostname, inet_ntoa(addr.sin_addr));
+    std::fputs(known ? "\n" : " unknown\n", info);
 }
 
-static void sigint_handler(int sig) noexcept
+static void sigint_handler(int) noexcept
 {
-    close(sockfd);
-    std::exit(sig);
+    if (tracer)
+        tracer->stop();
 }
 
-} // namespace ntool
\ No newline at end of file
+} // namespace ntool
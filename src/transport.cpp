@@ -0,0 +1,368 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/transport.hpp>
+#include <ntool/utils.hpp>
+#include <linux/icmp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstring>
+#include <fcntl.h>
+#include <cerrno>
+#include <poll.h>
+
+
+namespace ntool {
+
+inline const std::int32_t SOCKET_BUFFER {1 << 22};  // kernel buffer size
+
+/**
+ * @brief Open non-blocking raw ICMP socket.
+ *
+ * @return socket file descriptor.
+ */
+static std::int32_t open_socket(void) noexcept
+{
+    auto sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+
+    if (sockfd < 0)
+        utils::error("ntool: transport: raw socket creation error");
+
+    if (fcntl(sockfd, F_SETFL, O_NONBLOCK) == -1)
+        utils::error("ntool: transport: error to set non-blocking mode");
+
+    // only replies are passed, other ICMP traffic is dropped by kernel
+    icmp_filter filter {};
+    filter.data = ~((1U << ICMP_ECHOREPLY) | (1U << ICMP_DEST_UNREACH) | (1U << ICMP_TIME_EXCEEDED));
+
+    if (setsockopt(sockfd, SOL_RAW, ICMP_FILTER, &filter, sizeof(filter)) == -1)
+        utils::error("ntool: transport: error to set ICMP filter");
+
+    // large buffer absorbs reply bursts at high rates (best effort)
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUFFORCE,
+        &SOCKET_BUFFER, sizeof(SOCKET_BUFFER)) == -1) {
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF,
+            &SOCKET_BUFFER, sizeof(SOCKET_BUFFER)
+        );
+    }
+
+    return sockfd;
+}
+
+/**
+ * @brief Set message control data to given TTL.
+ *
+ * @param [in,out] msg - given message with control buffer set.
+ * @param [in] ttl - given packet time to live.
+ */
+static void set_ttl(msghdr& msg, std::uint8_t ttl) noexcept
+{
+    std::int32_t value = ttl;
+    msg.msg_controllen = CMSG_SPACE(sizeof(value));
+
+    auto cmsg        = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type  = IP_TTL;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(value));
+    std::memcpy(CMSG_DATA(cmsg), &value, sizeof(value));
+}
+
+/**
+ * @brief Check whether send error means that socket itself is broken.
+ * Other errors (unreachable or filtered destination, full device queue)
+ * lose only the probe.
+ *
+ * @param [in] error - given errno of failed send.
+ * @return true if socket is unusable.
+ */
+static bool socket_broken(std::int32_t error) noexcept
+{
+    return error == EBADF || error == ENOTSOCK || error == EFAULT;
+}
+
+/**
+ * @brief Wait for socket activity until deadline.
+ *
+ * @param [in] sockfd - given socket.
+ * @param [in] watch_fd - given additional descriptor (-1 - none).
+ * @param [out] watch_ready - given object to store readiness of watch_fd.
+ * @param [in] deadline - given wake up time.
+ * @return true if system call was made.
+ */
+static bool wait_socket(std::int32_t sockfd, std::int32_t watch_fd,
+    bool& watch_ready, std::uint64_t deadline) noexcept
+{
+    auto now = utils::clock_ns();
+
+    if (deadline <= now)
+        return false;
+
+    timespec timeout {};
+    auto delta = deadline - now;
+
+    timeout.tv_sec  = delta / 1000000000;
+    timeout.tv_nsec = delta % 1000000000;
+
+    pollfd fds[] {{sockfd, POLLIN, 0}, {watch_fd, POLLIN, 0}};
+    ppoll(fds, (watch_fd < 0) ? 1 : 2,
+        (deadline == UINT64_MAX) ? nullptr : &timeout, nullptr
+    );
+
+    watch_ready = watch_ready || (fds[1].revents & POLLIN);
+    return true;
+}
+
+raw_transport::raw_transport(void) noexcept
+    : m_sockfd(open_socket())
+{}
+
+raw_transport::~raw_transport(void) noexcept
+{
+    if (m_sockfd >= 0)
+        close(m_sockfd);
+}
+
+std::uint64_t raw_transport::now(void) noexcept
+{
+    return utils::clock_ns();
+}
+
+bool raw_transport::send(in_addr_t dst, std::uint8_t ttl,
+    const std::uint8_t *packet, std::size_t size) noexcept
+{
+    sockaddr_in addr {};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = dst;
+
+    // pass TTL as ancillary data, so probes may differ without setsockopt()
+    alignas(cmsghdr) std::uint8_t control[CMSG_SPACE(sizeof(std::int32_t))] {};
+
+    iovec  iov {const_cast<std::uint8_t*>(packet), size};
+    msghdr msg {};
+    msg.msg_name    = &addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov     = &iov;
+    msg.msg_iovlen  = 1;
+    msg.msg_control = control;
+    set_ttl(msg, ttl);
+
+    m_syscalls++;
+
+    if (sendmsg(m_sockfd, &msg, 0) >= 0)
+        return true;
+
+    // full device queue, unreachable or filtered destination lose probe
+    if (socket_broken(errno))
+        utils::error("ntool: transport: error to send ICMP packet");
+
+    return false;
+}
+
+std::ptrdiff_t raw_transport::recv(std::uint8_t *buffer, std::size_t size,
+    std::uint64_t& time) noexcept
+{
+    for (;;) {
+        auto ret = ::recv(m_sockfd, buffer, size, 0);
+        m_syscalls++;
+
+        if (ret >= 0) {
+            time = utils::clock_ns();
+            return ret;
+        }
+
+        if (errno == EINTR)
+            continue;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return -1;
+
+        utils::error("ntool: transport: error to receive ICMP packet");
+    }
+}
+
+void raw_transport::wait(std::uint64_t deadline) noexcept
+{
+    m_syscalls += wait_socket(m_sockfd, m_watch_fd, m_watch_ready, deadline);
+}
+
+std::uint64_t raw_transport::syscalls(void) const noexcept
+{
+    return m_syscalls;
+}
+
+mmsg_transport::mmsg_transport(bool huge) noexcept
+    : m_sockfd(open_socket()), m_pages(sizeof(batch), huge),
+      m_batch(*new (m_pages.data()) batch)
+{
+    auto& b = m_batch;
+
+    for (std::uint32_t i = 0; i < MMSG_BATCH_SIZE; i++) {
+        b.tx_iov[i] = {b.tx[i].packet, 0};
+        b.rx_iov[i] = {b.rx[i], PACKET_SIZE};
+
+        b.tx_msgs[i].msg_hdr.msg_name    = &b.tx[i].addr;
+        b.tx_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        b.tx_msgs[i].msg_hdr.msg_iov     = &b.tx_iov[i];
+        b.tx_msgs[i].msg_hdr.msg_iovlen  = 1;
+        b.tx_msgs[i].msg_hdr.msg_control = b.tx[i].control;
+
+        b.rx_msgs[i].msg_hdr.msg_iov    = &b.rx_iov[i];
+        b.rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+mmsg_transport::~mmsg_transport(void) noexcept
+{
+    // owner of drop handler may be already destroyed
+    m_drop = nullptr;
+    flush();
+
+    if (m_sockfd >= 0)
+        close(m_sockfd);
+}
+
+std::uint64_t mmsg_transport::now(void) noexcept
+{
+    return utils::clock_ns();
+}
+
+bool mmsg_transport::send(in_addr_t dst, std::uint8_t ttl,
+    const std::uint8_t *packet, std::size_t size) noexcept
+{
+    if (size > PACKET_SIZE)
+        return false;
+
+    auto& slot = m_batch.tx[m_tx_count];
+    slot.addr  = {};
+    slot.addr.sin_family      = AF_INET;
+    slot.addr.sin_addr.s_addr = dst;
+
+    std::memcpy(slot.packet, packet, size);
+    m_batch.tx_iov[m_tx_count].iov_len = size;
+    set_ttl(m_batch.tx_msgs[m_tx_count].msg_hdr, ttl);
+
+    if (++m_tx_count == MMSG_BATCH_SIZE)
+        flush();
+
+    return true;
+}
+
+std::ptrdiff_t mmsg_transport::recv(std::uint8_t *buffer, std::size_t size,
+    std::uint64_t& time) noexcept
+{
+    flush();
+
+    if (m_rx_pos == m_rx_count) {
+        std::int32_t ret;
+
+        do {
+            ret = recvmmsg(m_sockfd, m_batch.rx_msgs, MMSG_BATCH_SIZE,
+                MSG_DONTWAIT, nullptr
+            );
+            m_syscalls++;
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return -1;
+
+            utils::error("ntool: transport: error to receive ICMP packets");
+        }
+
+        m_rx_count = ret;
+        m_rx_pos   = 0;
+        m_rx_time  = utils::clock_ns();
+
+        if (ret == 0)
+            return -1;
+    }
+
+    auto length = std::min<std::size_t>(m_batch.rx_msgs[m_rx_pos].msg_len, size);
+    std::memcpy(buffer, m_batch.rx[m_rx_pos], length);
+
+    m_rx_pos++;
+    time = m_rx_time;
+
+    return length;
+}
+
+void mmsg_transport::wait(std::uint64_t deadline) noexcept
+{
+    flush();
+    m_syscalls += wait_socket(m_sockfd, m_watch_fd, m_watch_ready, deadline);
+}
+
+std::uint64_t mmsg_transport::syscalls(void) const noexcept
+{
+    return m_syscalls;
+}
+
+void mmsg_transport::flush(void) noexcept
+{
+    std::uint32_t sent = 0;
+    std::int32_t error = 0;
+
+    while (sent < m_tx_count) {
+        auto ret = sendmmsg(m_sockfd, m_batch.tx_msgs + sent, m_tx_count - sent, 0);
+        m_syscalls++;
+
+        if (ret > 0) {
+            sent += ret;
+            continue;
+        }
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+
+        error = (ret < 0) ? errno : ENOBUFS;
+
+        if (socket_broken(error))
+            utils::error("ntool: transport: error to send ICMP packets");
+
+        // full device queue loses rest of batch
+        if (error == EAGAIN || error == ENOBUFS)
+            break;
+
+        // unreachable or filtered destination loses its probe only
+        dropped(m_batch.tx[sent].packet, m_batch.tx_iov[sent].iov_len, error);
+        sent++;
+    }
+
+    auto count = m_tx_count;
+    m_tx_count = 0;
+
+    // lost probes are reported like failed sendmsg() of raw transport
+    for (auto i = sent; i < count; i++)
+        dropped(m_batch.tx[i].packet, m_batch.tx_iov[i].iov_len, error);
+}
+
+std::unique_ptr<transport> make_transport(io_backend backend, bool huge) noexcept
+{
+    if (backend == io_backend::mmsg)
+        return std::make_unique<mmsg_transport>(huge);
+
+    return std::make_unique<raw_transport>();
+}
+
+const char *backend_name(io_backend backend) noexcept
+{
+    return (backend == io_backend::mmsg) ? "mmsg" : "raw";
+}
+
+} // namespace ntool
@@ -0,0 +1,29 @@
+/**
+ * Multifunctional network analyser tool.
+ * Copyright (C) 2024  Alexander (@alkuzin).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <ntool/usdt.hpp>
+
+
+// tracers find semaphores of probes in .probes section
+#define _NTOOL_USDT_DEFINE(name) \
+    __attribute__((section(".probes"), used)) \
+        volatile unsigned short _NTOOL_USDT_SEMAPHORE(name) = 0;
+
+extern "C" {
+NTOOL_USDT_PROBES(_NTOOL_USDT_DEFINE)
+}
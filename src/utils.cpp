@@ -19,16 +19,21 @@
 #include <ntool/utils.hpp>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <algorithm>
 #include <unistd.h>
 #include <numeric>
 #include <netdb.h>
 #include <cstring>
 #include <cstdio>
+#include <cmath>
+#include <ctime>
 
 
 namespace ntool {
 namespace utils {
 
+static void (*error_hook)(void) noexcept = nullptr;  // see on_error()
+
 void terminate_if_not_root(void) noexcept
 {
     if (geteuid() != 0)
@@ -38,9 +43,40 @@ void terminate_if_not_root(void) noexcept
 void error(const std::string_view& msg)
 {
     std::puts(msg.data());
+
+    if (error_hook)
+        error_hook();
+
     std::exit(EXIT_FAILURE);
 }
 
+void on_error(void (*hook)(void) noexcept) noexcept
+{
+    error_hook = hook;
+}
+
+std::uint64_t clock_ns(void) noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+std::int64_t realtime_ms(std::uint64_t ns) noexcept
+{
+    // offset is taken once, so wall clock steps do not reorder samples
+    static const std::int64_t offset_ms = [] {
+        timespec real;
+        clock_gettime(CLOCK_REALTIME, &real);
+
+        return real.tv_sec * 1000LL + real.tv_nsec / 1000000 -
+            static_cast<std::int64_t>(clock_ns() / 1000000);
+    }();
+
+    return offset_ms + static_cast<std::int64_t>(ns / 1000000);
+}
+
 double mean(const std::vector<double>& vec) noexcept
 {
     auto begin = vec.begin();
@@ -61,6 +97,32 @@ double mdev(const std::vector<double>& vec) noexcept
     return dev / std::distance(begin, end);
 }
 
+void update(running_stats& stats, double value) noexcept
+{
+    if (stats.count == 0) {
+        stats.min = value;
+        stats.max = value;
+    }
+    else {
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+    }
+
+    stats.count++;
+
+    auto delta  = value - stats.mean;
+    stats.mean += delta / static_cast<double>(stats.count);
+    stats.m2   += delta * (value - stats.mean);
+}
+
+double stddev(const running_stats& stats) noexcept
+{
+    if (stats.count == 0)
+        return 0.0;
+
+    return std::sqrt(stats.m2 / static_cast<double>(stats.count));
+}
+
 /**
  * @brief Convert byte to ASCII.
  *